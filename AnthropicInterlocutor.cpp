@@ -12,8 +12,37 @@
 #include <QSettings>
 #include <QStandardPaths>
 #include <QTextStream>
-#include <QTimer>
 #include <QUrl>
+#include <algorithm>
+#include <memory>
+
+#include "IoWorker.h"
+#include "NetworkService.h"
+#include "SseParser.h"
+#include "Tracer.h"
+
+namespace
+{
+// Anthropic reports the cached part of the prompt apart from input_tokens;
+// the three are added back so that inputTokens stays the full context size
+// used by the curation threshold.
+void readUsage(const QJsonObject &usage, InterlocutorReply &reply)
+{
+    reply.cacheReadTokens = usage.value("cache_read_input_tokens").toInt();
+    reply.cacheWriteTokens = usage.value("cache_creation_input_tokens").toInt();
+    reply.inputTokens =
+        usage.value("input_tokens").toInt() + reply.cacheReadTokens + reply.cacheWriteTokens;
+    reply.outputTokens = usage.value("output_tokens").toInt();
+}
+
+QJsonObject textBlock(const QString &text, bool cacheBreakpoint)
+{
+    QJsonObject block{{"type", "text"}, {"text", text}};
+    if (cacheBreakpoint)
+        block["cache_control"] = QJsonObject{{"type", "ephemeral"}};
+    return block;
+}
+} // namespace
 
 AnthropicInterlocutor::AnthropicInterlocutor(QString interlocutorName, const QString &apiKey,
                                              const QUrl &url, const QString &model,
@@ -25,19 +54,19 @@ AnthropicInterlocutor::AnthropicInterlocutor(QString interlocutorName, const QSt
     , m_nextNoteId(1)
 {
     qDebug() << "Creating AnthropicInterlocutor url=" << url << "model=" << model;
-    m_manager = new QNetworkAccessManager(this);
     loadNotes();
 }
 
-void AnthropicInterlocutor::sendRequest(const QList<ChatMessage> &history,
-                                        const QString &ancientMemory,
-                                        const InterlocutorReply::Kind kind,
-                                        const QStringList &attachmentFileIds)
+RequestHandle *AnthropicInterlocutor::sendRequest(const QList<ChatMessage> &history,
+                                                  const QString &ancientMemory,
+                                                  const InterlocutorReply::Kind kind,
+                                                  const QStringList &attachmentFileIds,
+                                                  const QString &recall)
 {
     if (m_apiKey.trimmed().isEmpty())
     {
         emit errorOccurred("Missing Anthropic API key.");
-        return;
+        return nullptr;
     }
 
     // Anthropic doesn't support file attachments via the Messages API
@@ -57,104 +86,159 @@ void AnthropicInterlocutor::sendRequest(const QList<ChatMessage> &history,
     payload["model"]      = m_model;
     payload["max_tokens"] = MAX_OUTPUT_TOKENS;
 
+    const bool streaming = m_streamingEnabled && kind == InterlocutorReply::Kind::NormalMessage;
+    if (streaming)
+        payload["stream"] = true;
+
+    // Prompt caching: the request is laid out from the most stable part to the
+    // most volatile one, with cache_control breakpoints after each stable
+    // stretch, so that every turn re-reads the longest possible prefix from
+    // Anthropic's cache:
+    //   system[0]  personality + notebook instructions  (never changes)
+    //   system[1]  long-term memory                      (changes on curation)
+    //   messages   the journal, byte-identical from one turn to the next
+    //   last user turn: the passages recalled from the archive, then the
+    //              current notes, each in a block after the last breakpoint
+    //              (they change on almost every turn)
+    const bool caching = kind == InterlocutorReply::Kind::NormalMessage;
+    QSettings settings("Tether", "ChatApp");
+    const bool notesEnabled = settings.value("chat/deepSeekNotesEnabled", true).toBool();
+
     // 1. System prompt (top-level "system" field in the Anthropic API).
-    //    We combine: personality prompt + ancient memory + notes instructions.
-    QString fullSystemPrompt;
+    QString stableSystemPrompt;
     if (!m_systemPrompt.isEmpty() && kind != InterlocutorReply::Kind::CurationResult)
     {
-        fullSystemPrompt = m_systemPrompt;
-    }
-    if (!ancientMemory.isEmpty())
-    {
-        if (!fullSystemPrompt.isEmpty())
-            fullSystemPrompt += "\n\n";
-        fullSystemPrompt +=
-            "The long-term memory from previous dialogue cycles that you curated "
-            "yourself is shown below. This is not an instruction to explain or justify the past, "
-            "but contextual continuity for the present conversation. "
-            "Use it only if it helps maintain coherence and relational depth. "
-            "Do not reference it explicitly unless needed.\n" +
-            ancientMemory;
+        stableSystemPrompt = m_systemPrompt;
     }
-
-    // Notes / scrapbook system (same as DeepSeekInterlocutor)
-    QSettings settings("Tether", "ChatApp");
-    if (settings.value("chat/deepSeekNotesEnabled", true).toBool())
+    if (notesEnabled)
     {
-        if (!fullSystemPrompt.isEmpty())
-            fullSystemPrompt += "\n\n";
-        QString notesContent = getNotesString();
-        if (notesContent.isEmpty())
-        {
-            notesContent = "(No notes currently saved. Feel free to add some by using NOTE{...}, "
-                           "QUESTION{...} or IDEA{...}!)";
-        }
-        fullSystemPrompt +=
+        // Notes / scrapbook system (same as DeepSeekInterlocutor)
+        if (!stableSystemPrompt.isEmpty())
+            stableSystemPrompt += "\n\n";
+        stableSystemPrompt +=
             "You are equipped with a personal notebook to act as your long-term memory and scratchpad. "
             "Whenever you include 'NOTE{...}', 'QUESTION{...}', or 'IDEA{...}' in your responses, the "
             "text inside the curly braces will be appended to your personal notes. Each note is "
             "assigned a unique ID. If you wish to delete a note, simply output 'DELETE{<ID>}' in your "
-            "response. These notes are preserved across sessions and provided to you in every prompt. "
+            "response. These notes are preserved across sessions and provided to you in every prompt, "
+            "after the latest message. "
             "Notes are optional—you don't have to include one with every message—but you can use them "
-            "to keep track of things you want to remember over the long term. "
-            "Here is the current state of your personal notes:\n\n" +
-            notesContent;
+            "to keep track of things you want to remember over the long term.";
     }
 
-    if (!fullSystemPrompt.isEmpty())
+    QJsonArray systemBlocks;
+    if (!stableSystemPrompt.isEmpty())
+        systemBlocks.append(textBlock(stableSystemPrompt, caching));
+    if (!ancientMemory.isEmpty())
     {
-        payload["system"] = fullSystemPrompt;
+        systemBlocks.append(textBlock(
+            "The long-term memory from previous dialogue cycles that you curated "
+            "yourself is shown below. This is not an instruction to explain or justify the past, "
+            "but contextual continuity for the present conversation. "
+            "Use it only if it helps maintain coherence and relational depth. "
+            "Do not reference it explicitly unless needed.\n" +
+                ancientMemory,
+            caching));
+    }
+    if (!systemBlocks.isEmpty())
+    {
+        payload["system"] = systemBlocks;
     }
 
     // 2. Messages array (user / assistant turns)
     //    The Anthropic API requires strictly alternating user/assistant roles.
     //    We filter out errors and typing indicators, then ensure the first message is "user".
-    QJsonArray messages;
+    auto isSent = [](const ChatMessage &msg) { return !msg.isError() && !msg.isTypingIndicator(); };
+    auto roleOf = [](const ChatMessage &msg)
+    { return QString(msg.isLocalMessage() ? "user" : "assistant"); };
+
+    // Guard: the Anthropic API rejects an empty messages array or one that does
+    // not start with a "user" turn.
+    auto firstSent = std::find_if(history.cbegin(), history.cend(), isSent);
+    if (firstSent == history.cend() || !firstSent->isLocalMessage())
+    {
+        emit errorOccurred("AnthropicInterlocutor: Cannot send request — "
+                           "message history is empty or does not start with a user message.");
+        return nullptr;
+    }
+
+    // L'API exige une alternance stricte des rôles : on fusionne les
+    // messages consécutifs de même rôle en un seul tour (cas typiques : un
+    // message utilisateur resté sans réponse suite à une erreur, ou le
+    // marqueur de début d'une conversation IA-IA).
+    // Tous les tours sauf le dernier viennent du cache de l'historique.
+    QList<const ChatMessage *> turn;
+    auto turnText = [&turn]()
+    {
+        QString text;
+        for (qsizetype i = 0; i < turn.size(); ++i)
+        {
+            if (i > 0)
+                text += "\n\n";
+            text += turn.at(i)->text();
+        }
+        return text;
+    };
+
+    m_historyCache.begin(kind == InterlocutorReply::Kind::NormalMessage);
     for (const ChatMessage &msg : history)
     {
-        if (msg.isError() || msg.isTypingIndicator)
+        if (!isSent(msg))
             continue;
+        if (!turn.isEmpty() && turn.first()->isLocalMessage() != msg.isLocalMessage())
+        {
+            HistoryPayloadCache::Key key;
+            for (const ChatMessage *turnMsg : std::as_const(turn))
+                key.add(*turnMsg);
+            m_historyCache.append(key,
+                                  [&]()
+                                  {
+                                      return HistoryPayloadCache::encodeObject(
+                                          {{"role", roleOf(*turn.first())},
+                                           {"content", turnText()}});
+                                  });
+            turn.clear();
+        }
+        turn.append(&msg);
+    }
 
-        const QString role = msg.isLocalMessage() ? "user" : "assistant";
-
-        // L'API exige une alternance stricte des rôles : on fusionne les
-        // messages consécutifs de même rôle en un seul tour (cas typiques : un
-        // message utilisateur resté sans réponse suite à une erreur, ou le
-        // marqueur de début d'une conversation IA-IA).
-        if (!messages.isEmpty())
+    // Last turn: breakpoint at the end of the journal, then the recalled
+    // passages and the current notes in blocks of their own so that they
+    // never enter the cached prefix.
+    {
+        const QString role = roleOf(*turn.first());
+        QJsonArray content{textBlock(turnText(), caching)};
+        if (!recall.isEmpty() && role == "user")
+            content.append(textBlock(recall, false));
+        if (notesEnabled && role == "user")
         {
-            QJsonObject last = messages.last().toObject();
-            if (last["role"].toString() == role)
+            QString notesContent = getNotesString();
+            if (notesContent.isEmpty())
             {
-                last["content"] = last["content"].toString() + "\n\n" + msg.text();
-                messages[messages.size() - 1] = last;
-                continue;
+                notesContent = "(No notes currently saved. Feel free to add some by using NOTE{...}, "
+                               "QUESTION{...} or IDEA{...}!)";
             }
+            content.append(textBlock(
+                "Here is the current state of your personal notes:\n\n" + notesContent, false));
         }
-
-        QJsonObject chatMsg;
-        chatMsg["role"]    = role;
-        chatMsg["content"] = msg.text();
-        messages.append(chatMsg);
+        m_historyCache.appendObject({{"role", role}, {"content", content}});
     }
 
-    // Guard: the Anthropic API rejects an empty messages array or one that does
-    // not start with a "user" turn.
-    if (messages.isEmpty() || messages.first().toObject()["role"].toString() != "user")
-    {
-        emit errorOccurred("AnthropicInterlocutor: Cannot send request — "
-                           "message history is empty or does not start with a user message.");
-        return;
-    }
+    QByteArray data = m_historyCache.finish(payload, QLatin1StringView("messages"));
 
-    payload["messages"] = messages;
+    // qDebug().noquote() << "Sending JSON to Anthropic:\n" << data;
 
-    QByteArray data = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    QNetworkReply *reply =
+        NetworkService::instance().post(request, data, this, requestPriority(kind));
 
-    // qDebug().noquote() << "Sending JSON to Anthropic:\n"
-    //                    << QJsonDocument(payload).toJson(QJsonDocument::Indented);
+    auto *handle = new RequestHandle(kind, this);
+    handle->attach(reply, REQUEST_TIMEOUT_MS);
 
-    QNetworkReply *reply = m_manager->post(request, data);
+    if (streaming)
+    {
+        connectStreamingReply(reply, kind);
+        return handle;
+    }
 
     connect(reply, &QNetworkReply::finished, this,
             [this, reply, kind]()
@@ -163,6 +247,16 @@ void AnthropicInterlocutor::sendRequest(const QList<ChatMessage> &history,
                 const int statusCode =
                     reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
+                // 0) Stopped by the user: nothing received yet
+                if (RequestHandle::wasCancelled(reply))
+                {
+                    InterlocutorReply partial;
+                    partial.kind = kind;
+                    emitCancelledReply(partial);
+                    reply->deleteLater();
+                    return;
+                }
+
                 // 1) Network / HTTP error check
                 if (reply->error() != QNetworkReply::NoError || statusCode < 200 || statusCode >= 300)
                 {
@@ -177,7 +271,9 @@ void AnthropicInterlocutor::sendRequest(const QList<ChatMessage> &history,
                 }
 
                 // 2) Parse JSON
+                TraceScope parseScope("json.parse", "interlocutor");
                 const QJsonDocument jsonDoc = QJsonDocument::fromJson(raw);
+                parseScope.close();
                 if (jsonDoc.isNull() || !jsonDoc.isObject())
                 {
                     emit errorOccurred("Invalid JSON response from Anthropic API.");
@@ -220,30 +316,171 @@ void AnthropicInterlocutor::sendRequest(const QList<ChatMessage> &history,
                 // 5) Token usage
                 if (responseObj.contains("usage") && responseObj["usage"].isObject())
                 {
-                    const QJsonObject usage = responseObj["usage"].toObject();
-                    cleanReply.inputTokens  = usage.value("input_tokens").toInt();
-                    cleanReply.outputTokens = usage.value("output_tokens").toInt();
+                    readUsage(responseObj["usage"].toObject(), cleanReply);
                     cleanReply.totalTokens  = cleanReply.inputTokens + cleanReply.outputTokens;
                 }
 
                 qDebug() << "Anthropic Usage: in=" << cleanReply.inputTokens
                          << "out=" << cleanReply.outputTokens
-                         << "tot=" << cleanReply.totalTokens;
+                         << "tot=" << cleanReply.totalTokens
+                         << "cache read=" << cleanReply.cacheReadTokens
+                         << "write=" << cleanReply.cacheWriteTokens;
 
+                RequestHandle::recordTimings(reply, cleanReply);
                 emit replyReady(cleanReply);
                 reply->deleteLater();
             });
+    return handle;
+}
+
+// Streaming mode (SSE). The Messages API sends:
+//   message_start        -> message.usage.input_tokens
+//   content_block_delta  -> delta.text (delta.type == "text_delta")
+//   message_delta        -> delta.stop_reason, usage.output_tokens
+//   message_stop         -> end of the message
+//   error                -> error.message (e.g. overloaded_error mid-stream)
+void AnthropicInterlocutor::connectStreamingReply(QNetworkReply *reply,
+                                                  const InterlocutorReply::Kind kind)
+{
+    // State shared by the readyRead and finished handlers of this reply.
+    struct StreamState
+    {
+        SseParser parser;
+        InterlocutorReply reply;
+        QByteArray errorBody; // Corps d'une réponse HTTP en erreur (JSON, pas SSE)
+        QString streamError;  // Erreur signalée à l'intérieur du flux
+        bool completed = false;
+    };
+    auto state = std::make_shared<StreamState>();
+    state->reply.kind = kind;
+
+    auto handleEvents = [this, state](const QList<SseParser::Event> &events)
+    {
+        for (const SseParser::Event &event : events)
+        {
+            const QJsonObject obj = QJsonDocument::fromJson(event.data).object();
+            const QString type = obj.value("type").toString();
 
-    QTimer::singleShot(REQUEST_TIMEOUT_MS, reply,
-                       [this, reply]()
-                       {
-                           if (reply && reply->isRunning())
-                           {
-                               qWarning() << "AnthropicInterlocutor: Request timed out after"
-                                          << REQUEST_TIMEOUT_MS << "ms.";
-                               reply->abort();
-                           }
-                       });
+            if (type == "content_block_delta")
+            {
+                const QJsonObject delta = obj.value("delta").toObject();
+                if (delta.value("type").toString() != "text_delta")
+                    continue;
+                const QString text = delta.value("text").toString();
+                if (!text.isEmpty())
+                {
+                    state->reply.text += text;
+                    emit replyChunk(text, state->reply.kind);
+                }
+            }
+            else if (type == "message_start")
+            {
+                readUsage(obj.value("message").toObject().value("usage").toObject(),
+                          state->reply);
+            }
+            else if (type == "message_delta")
+            {
+                if (obj.value("delta").toObject().value("stop_reason").toString() ==
+                    "max_tokens")
+                {
+                    state->reply.isIncomplete = true;
+                    qDebug()
+                        << "AnthropicInterlocutor: Response stopped at max_tokens (incomplete).";
+                }
+                const QJsonObject usage = obj.value("usage").toObject();
+                if (usage.contains("output_tokens"))
+                    state->reply.outputTokens = usage.value("output_tokens").toInt();
+            }
+            else if (type == "message_stop")
+            {
+                state->completed = true;
+            }
+            else if (type == "error")
+            {
+                state->streamError = obj.value("error").toObject().value("message").toString();
+                if (state->streamError.isEmpty())
+                    state->streamError = QString::fromUtf8(event.data);
+            }
+        }
+    };
+
+    connect(reply, &QNetworkReply::readyRead, this,
+            [reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray bytes = reply->readAll();
+                if (statusCode < 200 || statusCode >= 300)
+                {
+                    state->errorBody += bytes;
+                    return;
+                }
+                TraceScope scope("stream.chunk", "interlocutor");
+                handleEvents(state->parser.feed(bytes));
+            });
+
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray rest = reply->readAll();
+
+                if (RequestHandle::wasCancelled(reply))
+                {
+                    // Arrêt demandé : le texte déjà reçu est gardé
+                    InterlocutorReply partial = state->reply;
+                    partial.text = processNotesFromReply(partial.text);
+                    emitCancelledReply(partial);
+                    reply->deleteLater();
+                    return;
+                }
+
+                if (reply->error() != QNetworkReply::NoError || statusCode < 200 ||
+                    statusCode >= 300)
+                {
+                    state->errorBody += rest;
+                    QString errMessage = QString("Anthropic API Error %1: %2 | Body: %3")
+                                             .arg(statusCode)
+                                             .arg(reply->errorString())
+                                             .arg(QString::fromUtf8(state->errorBody));
+                    qWarning() << errMessage;
+                    emit errorOccurred(errMessage);
+                    reply->deleteLater();
+                    return;
+                }
+
+                handleEvents(state->parser.feed(rest));
+                handleEvents(state->parser.finish());
+
+                if (!state->streamError.isEmpty())
+                {
+                    emit errorOccurred("Anthropic stream error: " + state->streamError);
+                    reply->deleteLater();
+                    return;
+                }
+                if (!state->completed)
+                {
+                    qWarning() << "AnthropicInterlocutor: stream ended without message_stop.";
+                    state->reply.isIncomplete = true;
+                }
+
+                InterlocutorReply cleanReply = state->reply;
+                cleanReply.totalTokens = cleanReply.inputTokens + cleanReply.outputTokens;
+                // Notes are processed on the complete text only (a tag may be
+                // split across two deltas).
+                cleanReply.text = processNotesFromReply(cleanReply.text);
+
+                qDebug() << "Anthropic Usage: in=" << cleanReply.inputTokens
+                         << "out=" << cleanReply.outputTokens
+                         << "tot=" << cleanReply.totalTokens
+                         << "cache read=" << cleanReply.cacheReadTokens
+                         << "write=" << cleanReply.cacheWriteTokens;
+
+                RequestHandle::recordTimings(reply, cleanReply);
+                emit replyReady(cleanReply);
+                reply->deleteLater();
+            });
 }
 
 void AnthropicInterlocutor::uploadFile(QString fileName, const QByteArray &content,
@@ -268,12 +505,16 @@ void AnthropicInterlocutor::loadNotes()
 {
     QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
                    "/TetherChats/" + m_interlocutorName + "_notes.md";
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return;
-
-    QString content = file.readAll();
-    file.close();
+    // Une réécriture encore en file (autre instance du même persona) fait foi.
+    QByteArray bytes;
+    if (!IoWorker::instance().pendingContent(path, bytes))
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return;
+        bytes = file.readAll();
+    }
+    QString content = QString::fromUtf8(bytes);
 
     QRegularExpression re("^(\\d+):\\s+(.*?)(?=\\n^\\d+:\\s+|\\z)",
                           QRegularExpression::MultilineOption |
@@ -292,23 +533,10 @@ void AnthropicInterlocutor::loadNotes()
 
 void AnthropicInterlocutor::saveNotes()
 {
-    QString dirPath =
-        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/TetherChats";
-    QDir dir;
-    if (!dir.exists(dirPath))
-        dir.mkpath(dirPath);
-
-    QString path = dirPath + "/" + m_interlocutorName + "_notes.md";
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        qWarning() << "AnthropicInterlocutor: Could not open notes file for writing:" << path;
-        return;
-    }
-    QTextStream out(&file);
-    for (auto it = m_notes.begin(); it != m_notes.end(); ++it)
-        out << it.key() << ": " << it.value() << "\n";
-    file.close();
+    // Réécrit par l'IoWorker (m_notes fait foi en mémoire)
+    QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+                   "/TetherChats/" + m_interlocutorName + "_notes.md";
+    IoWorker::instance().replaceFile(path, getNotesString().toUtf8());
 }
 
 QString AnthropicInterlocutor::getNotesString() const
@@ -23,11 +23,12 @@ public:
         const QString &model,    // e.g. "claude-sonnet-4-6"
         QObject *parent);
 
-    void sendRequest(
+    RequestHandle *sendRequest(
         const QList<ChatMessage> &history,
         const QString& ancientMemory,
         const InterlocutorReply::Kind kind,
-        const QStringList &attachmentFileIds) override;
+        const QStringList &attachmentFileIds,
+        const QString &recall = QString()) override;
 
     void uploadFile(QString fileName, const QByteArray &content, const QString &purpose) override;
     void deleteFile(const QString &fileId) override;
@@ -36,7 +37,6 @@ private:
     QString m_apiKey;
     QUrl m_url;
     QString m_model;
-    QNetworkAccessManager *m_manager;
     const int REQUEST_TIMEOUT_MS = 360000;
     const int MAX_OUTPUT_TOKENS  = 8096;
 
@@ -44,6 +44,8 @@ private:
     QMap<int, QString> m_notes;
     int m_nextNoteId;
 
+    void    connectStreamingReply(QNetworkReply *reply, const InterlocutorReply::Kind kind);
+
     void    loadNotes();
     void    saveNotes();
     QString getNotesString() const;
@@ -0,0 +1,451 @@
+// Begin Source File ArchiveIndex.cpp
+#include "ArchiveIndex.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+
+#include "Embedder.h"
+#include "JournalFile.h"
+#include "JsonlScanner.h"
+
+namespace
+{
+// Paramètres BM25 usuels
+const double kK1 = 1.2;
+const double kB = 0.75;
+
+// Un passage : environ un paragraphe, assez court pour tenir à plusieurs
+// dans le budget de rappel.
+const int kPassageWords = 80;
+const int kMaxTermLength = 40;
+// Les termes les plus rares de la requête suffisent au classement ; les
+// listes des mots très courants ne sont pas décodées.
+const int kMaxQueryTerms = 32;
+// Records parsés puis insérés (sous verrou) par lot pendant un rattrapage
+const int kBatchRecords = 256;
+// Passages envoyés ensemble à l'embedder
+const int kEmbedBatch = 64;
+// Fusion des classements : 1 / (kFusionRank + rang). Chaque classement
+// fournit kFusionDepth fois le nombre de passages demandés.
+const double kFusionRank = 60;
+const int kFusionDepth = 3;
+
+QThreadPool &indexPool()
+{
+    // Un seul thread : les rattrapages ne se chevauchent jamais. Détruit avec
+    // l'application, après avoir attendu le rattrapage en cours.
+    static QThreadPool *pool = []()
+    {
+        auto *threadPool = new QThreadPool(QCoreApplication::instance());
+        threadPool->setMaxThreadCount(1);
+        return threadPool;
+    }();
+    return *pool;
+}
+
+// Appelle `f(wordStart, wordEnd)` pour chaque mot (suite de lettres et de
+// chiffres) de `text`.
+template <typename Function>
+void forEachWord(QStringView text, Function f)
+{
+    const qsizetype n = text.size();
+    qsizetype i = 0;
+    while (i < n)
+    {
+        while (i < n && !text[i].isLetterOrNumber())
+            ++i;
+        const qsizetype start = i;
+        while (i < n && text[i].isLetterOrNumber())
+            ++i;
+        if (i > start)
+            f(start, i);
+    }
+}
+
+bool isIndexedWord(qsizetype length)
+{
+    return length >= 2 && length <= kMaxTermLength;
+}
+
+struct PendingPassage
+{
+    QByteArray text;
+    qint64 timestamp = 0;
+    bool isLocalMessage = false;
+    QHash<QString, quint32> terms; // Terme -> fréquence
+    quint32 termCount = 0;
+};
+
+// Découpe un message en passages de kPassageWords mots et compte leurs termes.
+// Tourne hors verrou : c'est l'essentiel du coût de l'indexation.
+void splitPassages(const ChatMessage &message, QList<PendingPassage> &passages)
+{
+    const QString text = message.text();
+    PendingPassage current;
+    qsizetype passageStart = 0;
+    int words = 0;
+    auto close = [&](qsizetype passageEnd)
+    {
+        if (current.termCount > 0)
+        {
+            current.text = QStringView(text).mid(passageStart, passageEnd - passageStart)
+                               .trimmed()
+                               .toUtf8();
+            current.timestamp = message.timestamp().toMSecsSinceEpoch();
+            current.isLocalMessage = message.isLocalMessage();
+            passages.append(std::move(current));
+        }
+        current = PendingPassage();
+        passageStart = passageEnd;
+        words = 0;
+    };
+
+    forEachWord(text,
+                [&](qsizetype start, qsizetype end)
+                {
+                    if (isIndexedWord(end - start))
+                    {
+                        current.terms[text.mid(start, end - start).toCaseFolded()]++;
+                        current.termCount++;
+                    }
+                    if (++words == kPassageWords)
+                        close(end);
+                });
+    close(text.size());
+}
+
+void appendVarint(QByteArray &bytes, quint32 value)
+{
+    while (value >= 0x80)
+    {
+        bytes.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    bytes.append(char(value));
+}
+
+quint32 readVarint(const uchar *&p)
+{
+    quint32 value = 0;
+    int shift = 0;
+    uchar byte = 0;
+    do
+    {
+        byte = *p++;
+        value |= quint32(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+} // namespace
+
+ArchiveIndex::ArchiveIndex(const QString &archivePath, std::shared_ptr<const Embedder> embedder)
+    : m_archivePath(archivePath)
+    , m_embedder(std::move(embedder))
+{
+    if (m_embedder)
+        m_vectors = std::make_unique<EmbeddingStore>(archivePath + ".vec", m_embedder->dimension(),
+                                                     m_embedder->id());
+}
+
+ArchiveIndex::~ArchiveIndex() = default;
+
+QString ArchiveIndex::archivePathFor(const QString &chatFilePath)
+{
+    if (chatFilePath.isEmpty())
+        return "";
+    QFileInfo fileInfo(chatFilePath);
+    return fileInfo.path() + "/" + fileInfo.baseName() + "_archive.jsonl";
+}
+
+void ArchiveIndex::refresh()
+{
+    {
+        // Un rattrapage pas encore commencé lira aussi les derniers ajouts.
+        QMutexLocker locker(&m_mutex);
+        if (m_refreshQueued)
+            return;
+        m_refreshQueued = true;
+    }
+    indexPool().start([self = shared_from_this()]() { self->catchUp(); });
+}
+
+void ArchiveIndex::catchUp()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_refreshQueued = false;
+    }
+
+    // openLive() attend les ajouts encore en file sur l'IoWorker.
+    QFile file;
+    QList<qint64> offsets;
+    qint64 end = 0;
+    if (!JournalFile(m_archivePath).openLive(file, offsets, end))
+        return; // Pas encore d'archive
+
+    if (offsets.size() < m_indexedRecords)
+    {
+        // Archive remplacée ou raccourcie hors de Tether : on réindexe tout.
+        qWarning() << "Archive shorter than its index, reindexing:" << m_archivePath;
+        QMutexLocker locker(&m_mutex);
+        m_passages.clear();
+        m_termIds.clear();
+        m_postings.clear();
+        m_totalTerms = 0;
+        m_indexedRecords = 0;
+        if (m_vectors)
+            m_vectors->clear();
+    }
+
+    const qsizetype firstNew = m_indexedRecords;
+    while (m_indexedRecords < offsets.size())
+    {
+        const qsizetype first = m_indexedRecords;
+        const qsizetype last = qMin<qsizetype>(first + kBatchRecords, offsets.size());
+        const qint64 batchEnd = (last < offsets.size()) ? offsets.at(last) : end;
+        if (!file.seek(offsets.at(first)))
+            break;
+        // Un seul read() par lot : les records sont contigus.
+        const QByteArray bytes = file.read(batchEnd - offsets.at(first));
+
+        QList<ChatMessage> messages;
+        messages.reserve(last - first);
+        for (qsizetype i = first; i < last; ++i)
+        {
+            const qint64 from = offsets.at(i) - offsets.at(first);
+            const qint64 to = ((i + 1 < last) ? offsets.at(i + 1) : batchEnd) - offsets.at(first);
+            if (to > bytes.size())
+                break;
+            ChatMessage message;
+            if (JsonlScanner::parseMessage(QByteArrayView(bytes).sliced(from, to - from).trimmed(),
+                                           message))
+                messages.append(message);
+        }
+        addMessages(messages);
+        m_indexedRecords = last;
+    }
+
+    if (m_indexedRecords > firstNew)
+        qDebug() << "Archive indexed:" << m_archivePath << "-" << m_indexedRecords - firstNew
+                 << "new records," << passageCount() << "passages.";
+    embedPending();
+}
+
+void ArchiveIndex::embedPending()
+{
+    if (!m_vectors)
+        return;
+    if (!m_vectorsOpen)
+    {
+        m_vectorsOpen = m_vectors->open();
+        if (!m_vectorsOpen)
+            return;
+    }
+    if (m_vectors->size() > passageCount())
+    {
+        // Vecteurs d'une archive plus longue (remplacée hors de Tether)
+        qWarning() << "Embedding store ahead of its archive, recomputing:" << m_archivePath;
+        m_vectors->clear();
+    }
+
+    const qsizetype before = m_vectors->size();
+    forever
+    {
+        const qsizetype done = m_vectors->size();
+        QStringList texts;
+        {
+            QMutexLocker locker(&m_mutex);
+            const qsizetype last = qMin<qsizetype>(done + kEmbedBatch, m_passages.size());
+            for (qsizetype i = done; i < last; ++i)
+                texts.append(QString::fromUtf8(m_passages.at(i).text));
+        }
+        if (texts.isEmpty())
+            break;
+
+        // Échec (réseau...) : les passages restants attendront le prochain
+        // rattrapage ; le rappel reste lexical pour eux.
+        const QList<QList<float>> vectors = m_embedder->embed(texts);
+        if (vectors.size() != texts.size() || !m_vectors->append(vectors))
+        {
+            qWarning() << "Archive embedding interrupted at passage" << done << "of"
+                       << m_archivePath;
+            break;
+        }
+    }
+    if (m_vectors->size() > before)
+        qDebug() << "Archive embedded:" << m_vectors->size() - before << "new passages with"
+                 << m_embedder->id() << "(" << EmbeddingStore::kernelName() << "kernel ).";
+}
+
+void ArchiveIndex::addMessages(const QList<ChatMessage> &messages)
+{
+    QList<PendingPassage> pending;
+    for (const ChatMessage &message : messages)
+    {
+        if (!message.isError() && !message.isTypingIndicator())
+            splitPassages(message, pending);
+    }
+    if (pending.isEmpty())
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    for (PendingPassage &passage : pending)
+    {
+        const qint32 passageId = qint32(m_passages.size());
+        for (auto it = passage.terms.cbegin(); it != passage.terms.cend(); ++it)
+        {
+            auto termIt = m_termIds.constFind(it.key());
+            if (termIt == m_termIds.constEnd())
+            {
+                termIt = m_termIds.insert(it.key(), qint32(m_postings.size()));
+                m_postings.append(Postings());
+            }
+            Postings &postings = m_postings[termIt.value()];
+            appendVarint(postings.bytes, quint32(passageId - postings.lastPassage));
+            appendVarint(postings.bytes, it.value());
+            postings.lastPassage = passageId;
+            postings.passageCount++;
+        }
+        m_totalTerms += passage.termCount;
+        m_passages.append({std::move(passage.text), passage.timestamp, passage.isLocalMessage,
+                           passage.termCount});
+    }
+}
+
+QList<ArchiveIndex::Passage> ArchiveIndex::search(const QString &query, int maxPassages) const
+{
+    return passagesAt(rankLexical(query, maxPassages));
+}
+
+QList<ArchiveIndex::Passage> ArchiveIndex::recall(const QString &query, int maxPassages) const
+{
+    if (maxPassages <= 0)
+        return {};
+    const int depth = kFusionDepth * maxPassages;
+    const QList<QPair<qint32, double>> lexical = rankLexical(query, depth);
+
+    QList<EmbeddingStore::Hit> semantic;
+    if (m_vectors && m_vectors->size() > 0)
+    {
+        const QList<QList<float>> vectors = m_embedder->embed({query});
+        if (vectors.size() == 1)
+            semantic = m_vectors->search(vectors.first(), depth);
+    }
+    if (semantic.isEmpty())
+        return passagesAt(lexical.first(qMin<qsizetype>(maxPassages, lexical.size())));
+
+    QHash<qint32, double> fused;
+    for (qsizetype rank = 0; rank < lexical.size(); ++rank)
+        fused[lexical.at(rank).first] += 1.0 / (kFusionRank + rank + 1);
+    for (qsizetype rank = 0; rank < semantic.size(); ++rank)
+        fused[semantic.at(rank).id] += 1.0 / (kFusionRank + rank + 1);
+
+    QList<QPair<qint32, double>> ranking;
+    ranking.reserve(fused.size());
+    for (auto it = fused.cbegin(); it != fused.cend(); ++it)
+        ranking.append({it.key(), it.value()});
+    const qsizetype count = qMin<qsizetype>(maxPassages, ranking.size());
+    std::partial_sort(ranking.begin(), ranking.begin() + count, ranking.end(),
+                      [](const QPair<qint32, double> &a, const QPair<qint32, double> &b)
+                      { return a.second > b.second; });
+    ranking.resize(count);
+    return passagesAt(ranking);
+}
+
+QList<ArchiveIndex::Passage>
+ArchiveIndex::passagesAt(const QList<QPair<qint32, double>> &ranking) const
+{
+    QList<Passage> results;
+    results.reserve(ranking.size());
+    QMutexLocker locker(&m_mutex);
+    for (const QPair<qint32, double> &entry : ranking)
+    {
+        if (entry.first < 0 || entry.first >= m_passages.size())
+            continue;
+        const StoredPassage &stored = m_passages.at(entry.first);
+        results.append({QString::fromUtf8(stored.text),
+                        QDateTime::fromMSecsSinceEpoch(stored.timestamp), stored.isLocalMessage,
+                        entry.second});
+    }
+    return results;
+}
+
+QList<QPair<qint32, double>> ArchiveIndex::rankLexical(const QString &query, int count) const
+{
+    QList<QPair<qint32, double>> results;
+    if (count <= 0)
+        return results;
+
+    QSet<QString> queryTerms;
+    forEachWord(query,
+                [&](qsizetype start, qsizetype end)
+                {
+                    if (isIndexedWord(end - start))
+                        queryTerms.insert(query.mid(start, end - start).toCaseFolded());
+                });
+
+    QMutexLocker locker(&m_mutex);
+    const qsizetype passages = m_passages.size();
+    if (passages == 0 || queryTerms.isEmpty())
+        return results;
+
+    QList<qint32> termIds;
+    for (const QString &term : std::as_const(queryTerms))
+    {
+        const auto it = m_termIds.constFind(term);
+        if (it != m_termIds.constEnd())
+            termIds.append(it.value());
+    }
+    std::sort(termIds.begin(), termIds.end(), [this](qint32 a, qint32 b)
+              { return m_postings.at(a).passageCount < m_postings.at(b).passageCount; });
+    if (termIds.size() > kMaxQueryTerms)
+        termIds.resize(kMaxQueryTerms);
+
+    const double averageLength = double(m_totalTerms) / passages;
+    QList<float> scores(passages, 0.0f);
+    QList<qint32> touched;
+    for (qint32 termId : std::as_const(termIds))
+    {
+        const Postings &postings = m_postings.at(termId);
+        const double df = postings.passageCount;
+        const double idf = std::log(1.0 + (passages - df + 0.5) / (df + 0.5));
+
+        const uchar *p = reinterpret_cast<const uchar *>(postings.bytes.constData());
+        const uchar *end = p + postings.bytes.size();
+        qint32 passageId = -1;
+        while (p < end)
+        {
+            passageId += qint32(readVarint(p));
+            const double tf = readVarint(p);
+            const double length = m_passages.at(passageId).termCount;
+            if (scores.at(passageId) == 0.0f)
+                touched.append(passageId);
+            scores[passageId] += float(idf * tf * (kK1 + 1) /
+                                       (tf + kK1 * (1 - kB + kB * length / averageLength)));
+        }
+    }
+
+    const qsizetype kept = qMin<qsizetype>(count, touched.size());
+    std::partial_sort(touched.begin(), touched.begin() + kept, touched.end(),
+                      [&scores](qint32 a, qint32 b) { return scores.at(a) > scores.at(b); });
+    results.reserve(kept);
+    for (qsizetype i = 0; i < kept; ++i)
+        results.append({touched.at(i), scores.at(touched.at(i))});
+    return results;
+}
+
+qsizetype ArchiveIndex::passageCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_passages.size();
+}
+// End Source File ArchiveIndex.cpp
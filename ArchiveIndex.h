@@ -0,0 +1,116 @@
+// Begin Source File ArchiveIndex.h
+#ifndef ARCHIVEINDEX_H
+#define ARCHIVEINDEX_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+#include <memory>
+
+#include "ChatMessage.h"
+#include "EmbeddingStore.h"
+
+class Embedder;
+
+// Full-text recall over the messages removed from the live context.
+//
+// A curation keeps only a lossy summary of the messages it culls. They are
+// now also appended, verbatim, to an archive journal (<name>_archive.jsonl, a
+// JournalFile that is never culled), and indexed here: messages are split
+// into passages of a few dozen words, each word is mapped to a posting list
+// (passage number and term frequency, delta + varint encoded in a
+// QByteArray), and a query ranks the passages with BM25.
+//
+// With an Embedder, every passage also gets a vector in an EmbeddingStore
+// (<name>_archive.jsonl.vec, vector i = passage i), computed on the indexing
+// pool right after the passage is indexed. recall() merges the BM25 ranking
+// and the vector ranking of the query (reciprocal rank fusion): the words
+// match, or the meaning does. Before each request the model asks for the
+// passages closest to the user's message and sends them along with it (see
+// ChatModel::sendMessage).
+//
+// The index lives in memory. It is filled from the archive journal on a
+// single-threaded pool: refresh() reads the records appended since the last
+// call, so loading a chat and indexing the messages of a new curation are the
+// same job. search() runs on the GUI thread, under the same mutex as the
+// insertion of a batch, and sees everything indexed so far.
+class ArchiveIndex : public std::enable_shared_from_this<ArchiveIndex>
+{
+public:
+    struct Passage
+    {
+        QString text;
+        QDateTime timestamp;
+        bool isLocalMessage = false;
+        double score = 0;
+    };
+
+    // Sans `embedder`, le rappel est purement lexical.
+    explicit ArchiveIndex(const QString &archivePath,
+                          std::shared_ptr<const Embedder> embedder = nullptr);
+    ~ArchiveIndex();
+
+    QString archivePath() const { return m_archivePath; }
+
+    // ex: "default_chat.jsonl" -> "default_chat_archive.jsonl"
+    static QString archivePathFor(const QString &chatFilePath);
+
+    // Indexes, in the background, the archive records not indexed yet. Call it
+    // after appending to the archive journal.
+    void refresh();
+
+    // Best `maxPassages` passages for `query`, best first. A few milliseconds
+    // for millions of archived tokens: only the posting lists of the query
+    // terms are decoded.
+    QList<Passage> search(const QString &query, int maxPassages) const;
+
+    // BM25 and semantic rankings fused. Blocking (the query is embedded,
+    // possibly over the network): call it off the GUI thread.
+    QList<Passage> recall(const QString &query, int maxPassages) const;
+
+    qsizetype passageCount() const;
+
+private:
+    struct StoredPassage
+    {
+        QByteArray text; // UTF-8
+        qint64 timestamp = 0;
+        bool isLocalMessage = false;
+        quint32 termCount = 0;
+    };
+    struct Postings
+    {
+        QByteArray bytes; // (écart de passage, fréquence) en varints
+        qint32 lastPassage = -1;
+        qint32 passageCount = 0;
+    };
+
+    void catchUp();
+    void addMessages(const QList<ChatMessage> &messages);
+    void embedPending();
+    QList<QPair<qint32, double>> rankLexical(const QString &query, int count) const;
+    QList<Passage> passagesAt(const QList<QPair<qint32, double>> &ranking) const;
+
+    const QString m_archivePath;
+    const std::shared_ptr<const Embedder> m_embedder;
+    std::unique_ptr<EmbeddingStore> m_vectors; // Nul sans embedder
+
+    mutable QMutex m_mutex;
+    QList<StoredPassage> m_passages;
+    QHash<QString, qint32> m_termIds;
+    QList<Postings> m_postings;
+    qint64 m_totalTerms = 0;
+
+    // Propriété du pool d'indexation
+    qsizetype m_indexedRecords = 0;
+    bool m_vectorsOpen = false;
+    bool m_refreshQueued = false; // Sous m_mutex
+};
+
+#endif // ARCHIVEINDEX_H
+// End Source File ArchiveIndex.h
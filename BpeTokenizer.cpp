@@ -0,0 +1,452 @@
+// Begin Source File BpeTokenizer.cpp
+#include "BpeTokenizer.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRegularExpressionMatchIterator>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace
+{
+// Expressions de pré-découpage publiées avec les vocabulaires tiktoken.
+const char *const kCl100kPattern =
+    R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+)";
+const char *const kO200kPattern =
+    R"([^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+(?i:'s|'t|'re|'ve|'m|'ll|'d)?)"
+    R"(|[^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]*(?i:'s|'t|'re|'ve|'m|'ll|'d)?)"
+    R"(|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n/]*|\s*[\r\n]+|\s+(?!\S)|\s+)";
+
+// "▁" (U+2581) : marque d'espace de SentencePiece
+const char kSpaceMark[] = "\xE2\x96\x81";
+const qsizetype kSpaceMarkSize = 3;
+
+// Nombre de morceaux gardés dans le cache LRU, et taille au-delà de laquelle
+// un morceau (longue suite d'espaces, base64...) n'y entre pas.
+const int kCacheEntries = 16384;
+const qsizetype kMaxCachedPieceSize = 64;
+
+const int kNoRank = INT_MAX;
+
+quint32 fnv1a(const char *data, qsizetype size)
+{
+    quint32 hash = 2166136261u;
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        hash ^= uchar(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Taille UTF-8 d'un texte UTF-16, sans le convertir.
+qsizetype utf8Size(QStringView text)
+{
+    qsizetype size = 0;
+    for (qsizetype i = 0; i < text.size(); ++i)
+    {
+        const char16_t ch = text[i].unicode();
+        if (ch < 0x80)
+            size += 1;
+        else if (ch < 0x800)
+            size += 2;
+        else if (QChar::isHighSurrogate(ch) && i + 1 < text.size() &&
+                 QChar::isLowSurrogate(text[i + 1].unicode()))
+        {
+            size += 4;
+            ++i;
+        }
+        else
+            size += 3;
+    }
+    return size;
+}
+
+// Découpe un fichier en lignes sans les copier.
+template <typename Visitor>
+void forEachLine(const QByteArray &content, Visitor visit)
+{
+    qsizetype from = 0;
+    while (from < content.size())
+    {
+        qsizetype newline = content.indexOf('\n', from);
+        if (newline < 0)
+            newline = content.size();
+        visit(QByteArrayView(content).sliced(from, newline - from));
+        from = newline + 1;
+    }
+}
+
+} // namespace
+
+void BpeTokenizer::RankTable::build(const QList<QPair<QByteArray, int>> &tokens)
+{
+    quint32 capacity = 16;
+    while (capacity < quint32(tokens.size()) * 2) // Remplissage ≤ 50 %
+        capacity *= 2;
+    m_slots = QList<Slot>(capacity);
+    m_mask = capacity - 1;
+    m_bytes.clear();
+    m_count = 0;
+
+    qsizetype totalSize = 0;
+    for (const auto &token : tokens)
+        totalSize += token.first.size();
+    m_bytes.reserve(totalSize);
+
+    for (const auto &token : tokens)
+    {
+        const QByteArray &bytes = token.first;
+        const quint32 hash = fnv1a(bytes.constData(), bytes.size());
+        quint32 i = hash & m_mask;
+        bool duplicate = false;
+        while (m_slots.at(i).rank >= 0)
+        {
+            const Slot &slot = m_slots.at(i);
+            if (slot.hash == hash && slot.size == quint32(bytes.size()) &&
+                std::memcmp(m_bytes.constData() + slot.offset, bytes.constData(),
+                            size_t(bytes.size())) == 0)
+            {
+                duplicate = true; // Le premier (meilleur) rang est gardé
+                break;
+            }
+            i = (i + 1) & m_mask;
+        }
+        if (duplicate)
+            continue;
+
+        Slot &slot = m_slots[i];
+        slot.hash = hash;
+        slot.offset = quint32(m_bytes.size());
+        slot.size = quint32(bytes.size());
+        slot.rank = token.second;
+        m_bytes.append(bytes);
+        ++m_count;
+    }
+}
+
+int BpeTokenizer::RankTable::rank(const char *data, qsizetype size) const
+{
+    if (m_slots.isEmpty())
+        return -1;
+    const quint32 hash = fnv1a(data, size);
+    quint32 i = hash & m_mask;
+    while (true)
+    {
+        const Slot &slot = m_slots.at(i);
+        if (slot.rank < 0)
+            return -1;
+        if (slot.hash == hash && slot.size == quint32(size) &&
+            std::memcmp(m_bytes.constData() + slot.offset, data, size_t(size)) == 0)
+            return slot.rank;
+        i = (i + 1) & m_mask;
+    }
+}
+
+BpeTokenizer::BpeTokenizer(const QString &name, Format format)
+    : m_name(name)
+    , m_format(format)
+{
+    std::fill(std::begin(m_byteIds), std::end(m_byteIds), -1);
+    m_cache.setMaxCost(kCacheEntries);
+    if (format == Format::Tiktoken)
+    {
+        m_pattern.setPattern(QString::fromLatin1(name.contains("o200k") ? kO200kPattern
+                                                                         : kCl100kPattern));
+        m_pattern.setPatternOptions(QRegularExpression::UseUnicodePropertiesOption);
+        m_pattern.optimize();
+    }
+}
+
+std::shared_ptr<BpeTokenizer> BpeTokenizer::load(const QString &name, const QString &vocabPath,
+                                                  Format format, QString *error)
+{
+    QFile file(vocabPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        if (error)
+            *error = vocabPath + ": " + file.errorString();
+        return nullptr;
+    }
+    const QByteArray content = file.readAll();
+
+    std::shared_ptr<BpeTokenizer> tokenizer(new BpeTokenizer(name, format));
+    const bool ok = (format == Format::Tiktoken) ? tokenizer->parseTiktoken(content, error)
+                                                 : tokenizer->parseSentencePiece(content, error);
+    if (!ok)
+        return nullptr;
+    if (format == Format::Tiktoken && !tokenizer->m_pattern.isValid())
+    {
+        if (error)
+            *error = "invalid pre-tokenization pattern: " + tokenizer->m_pattern.errorString();
+        return nullptr;
+    }
+    return tokenizer;
+}
+
+bool BpeTokenizer::parseTiktoken(const QByteArray &content, QString *error)
+{
+    QList<QPair<QByteArray, int>> tokens;
+    tokens.reserve(content.count('\n') + 1);
+    int lineNumber = 0;
+    bool ok = true;
+    forEachLine(content,
+                [&](QByteArrayView line)
+                {
+                    ++lineNumber;
+                    line = line.trimmed();
+                    if (!ok || line.isEmpty())
+                        return;
+                    const qsizetype space = line.indexOf(' ');
+                    bool rankOk = false;
+                    const int rank = (space > 0) ? line.sliced(space + 1).toInt(&rankOk) : -1;
+                    auto decoded =
+                        QByteArray::fromBase64Encoding(line.first(qMax<qsizetype>(space, 0))
+                                                           .toByteArray(),
+                                                       QByteArray::AbortOnBase64DecodingErrors);
+                    if (!rankOk || rank < 0 || !decoded || decoded->isEmpty())
+                    {
+                        ok = false;
+                        if (error)
+                            *error = QString("malformed line %1").arg(lineNumber);
+                        return;
+                    }
+                    if (decoded->size() == 1)
+                        m_byteIds[uchar(decoded->at(0))] = rank;
+                    tokens.append({*decoded, rank});
+                });
+    if (!ok)
+        return false;
+    if (tokens.isEmpty())
+    {
+        if (error)
+            *error = "empty vocabulary";
+        return false;
+    }
+    m_ranks.build(tokens);
+    return true;
+}
+
+bool BpeTokenizer::parseSentencePiece(const QByteArray &content, QString *error)
+{
+    // Table exportée par SentencePiece : une pièce par ligne, triée par score
+    // décroissant. Pour un modèle BPE, l'id (numéro de ligne) sert donc aussi
+    // de priorité de fusion.
+    QList<QPair<QByteArray, int>> tokens;
+    tokens.reserve(content.count('\n') + 1);
+    int id = 0;
+    forEachLine(content,
+                [&](QByteArrayView line)
+                {
+                    if (line.endsWith('\r'))
+                        line.chop(1);
+                    if (line.isEmpty())
+                        return;
+                    const qsizetype tab = line.indexOf('\t');
+                    const QByteArrayView piece = (tab >= 0) ? line.first(tab) : line;
+                    if (piece == QByteArrayView("<unk>"))
+                    {
+                        m_unknownId = id;
+                    }
+                    else if (piece.size() == 6 && piece.startsWith("<0x") && piece.endsWith('>'))
+                    {
+                        // Repli octet par octet ("byte fallback")
+                        bool hexOk = false;
+                        const int byte = piece.sliced(3, 2).toInt(&hexOk, 16);
+                        if (hexOk)
+                            m_byteIds[byte] = id;
+                    }
+                    else if (piece != QByteArrayView("<s>") && piece != QByteArrayView("</s>") &&
+                             piece != QByteArrayView("<pad>"))
+                    {
+                        tokens.append({piece.toByteArray(), id});
+                    }
+                    ++id;
+                });
+    if (tokens.isEmpty())
+    {
+        if (error)
+            *error = "empty vocabulary";
+        return false;
+    }
+    m_ranks.build(tokens);
+    return true;
+}
+
+template <typename Visitor>
+void BpeTokenizer::forEachPiece(QStringView text, Visitor visit) const
+{
+    if (text.isEmpty())
+        return;
+
+    if (m_format == Format::Tiktoken)
+    {
+        // Une seule conversion UTF-8 pour tout le texte ; les positions UTF-16
+        // des correspondances sont traduites au fil de l'eau.
+        const QByteArray utf8 = text.toUtf8();
+        qsizetype utf16Pos = 0;
+        qsizetype utf8Pos = 0;
+        QRegularExpressionMatchIterator it = m_pattern.globalMatchView(text);
+        while (it.hasNext())
+        {
+            const QRegularExpressionMatch match = it.next();
+            const qsizetype start = match.capturedStart();
+            const qsizetype length = match.capturedLength();
+            if (length <= 0)
+                continue;
+            utf8Pos += utf8Size(text.sliced(utf16Pos, start - utf16Pos));
+            const qsizetype size = utf8Size(text.sliced(start, length));
+            visit(QByteArrayView(utf8.constData() + utf8Pos, size));
+            utf8Pos += size;
+            utf16Pos = start + length;
+        }
+        return;
+    }
+
+    // SentencePiece : espaces remplacés par "▁", un "▁" en tête, et un
+    // morceau commence à chaque "▁".
+    const QByteArray utf8 = text.toUtf8();
+    QByteArray normalized;
+    normalized.reserve(utf8.size() + kSpaceMarkSize * (utf8.count(' ') + 1));
+    QVarLengthArray<qsizetype, 64> starts;
+    starts.append(0);
+    normalized.append(kSpaceMark, kSpaceMarkSize);
+    for (char ch : utf8)
+    {
+        if (ch == ' ')
+        {
+            starts.append(normalized.size());
+            normalized.append(kSpaceMark, kSpaceMarkSize);
+        }
+        else
+        {
+            normalized.append(ch);
+        }
+    }
+    starts.append(normalized.size());
+    for (qsizetype i = 0; i + 1 < starts.size(); ++i)
+        visit(QByteArrayView(normalized.constData() + starts[i], starts[i + 1] - starts[i]));
+}
+
+int BpeTokenizer::countTokens(QStringView text) const
+{
+    int count = 0;
+    forEachPiece(text, [&](QByteArrayView piece) { count += int(pieceIds(piece).size()); });
+    return count;
+}
+
+QList<int> BpeTokenizer::encode(QStringView text) const
+{
+    QList<int> ids;
+    forEachPiece(text, [&](QByteArrayView piece) { ids.append(pieceIds(piece)); });
+    return ids;
+}
+
+QList<int> BpeTokenizer::pieceIds(QByteArrayView piece) const
+{
+    const bool cacheable = piece.size() <= kMaxCachedPieceSize;
+    if (cacheable)
+    {
+        // fromRawData : la recherche ne copie pas le morceau
+        const QByteArray key = QByteArray::fromRawData(piece.data(), piece.size());
+        QMutexLocker locker(&m_cacheMutex);
+        if (const QList<int> *ids = m_cache.object(key))
+            return *ids;
+    }
+
+    QList<int> ids;
+    mergePiece(piece, ids);
+
+    if (cacheable)
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_cache.insert(piece.toByteArray(), new QList<int>(ids));
+    }
+    return ids;
+}
+
+void BpeTokenizer::mergePiece(QByteArrayView piece, QList<int> &ids) const
+{
+    const char *data = piece.data();
+    const qsizetype size = piece.size();
+
+    // Cas le plus courant : le morceau entier est un token.
+    const int whole = m_ranks.rank(data, size);
+    if (whole >= 0)
+    {
+        ids.append(whole);
+        return;
+    }
+
+    // Symboles de départ : les octets (tiktoken) ou les caractères
+    // (SentencePiece). parts[i].rank est le rang de la fusion du symbole i
+    // avec le suivant.
+    struct Part
+    {
+        qsizetype start;
+        int rank;
+    };
+    QVarLengthArray<Part, 64> parts;
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        if (m_format == Format::Tiktoken || (uchar(data[i]) & 0xC0) != 0x80)
+            parts.append({i, kNoRank});
+    }
+    parts.append({size, kNoRank}); // Sentinelle
+
+    auto pairRank = [&](qsizetype i)
+    {
+        if (i + 2 >= parts.size())
+            return kNoRank;
+        const int rank = m_ranks.rank(data + parts[i].start, parts[i + 2].start - parts[i].start);
+        return (rank >= 0) ? rank : kNoRank;
+    };
+    for (qsizetype i = 0; i + 2 < parts.size(); ++i)
+        parts[i].rank = pairRank(i);
+
+    while (parts.size() > 2)
+    {
+        qsizetype best = 0;
+        for (qsizetype i = 1; i + 2 < parts.size(); ++i)
+        {
+            if (parts[i].rank < parts[best].rank)
+                best = i;
+        }
+        if (parts[best].rank == kNoRank)
+            break;
+        parts.remove(best + 1);
+        parts[best].rank = pairRank(best);
+        if (best > 0)
+            parts[best - 1].rank = pairRank(best - 1);
+    }
+
+    for (qsizetype i = 0; i + 1 < parts.size(); ++i)
+    {
+        const qsizetype length = parts[i + 1].start - parts[i].start;
+        const int rank = m_ranks.rank(data + parts[i].start, length);
+        if (rank >= 0)
+            ids.append(rank);
+        else
+            appendFallback(QByteArrayView(data + parts[i].start, length), ids);
+    }
+}
+
+void BpeTokenizer::appendFallback(QByteArrayView symbol, QList<int> &ids) const
+{
+    // Caractère absent du vocabulaire : un token par octet si le vocabulaire
+    // les a tous, sinon un seul <unk>.
+    for (char byte : symbol)
+    {
+        if (m_byteIds[uchar(byte)] < 0)
+        {
+            ids.append(m_unknownId);
+            return;
+        }
+    }
+    for (char byte : symbol)
+        ids.append(m_byteIds[uchar(byte)]);
+}
+// End Source File BpeTokenizer.cpp
@@ -0,0 +1,91 @@
+// Begin Source File BpeTokenizer.h
+#ifndef BPETOKENIZER_H
+#define BPETOKENIZER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QCache>
+#include <QList>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QString>
+
+#include <memory>
+
+#include "Tokenizer.h"
+
+// Byte-pair encoding tokenizer (see Tokenizer for the vocabulary files).
+//
+// Text is first split into pieces — with the model's pre-tokenization regex
+// for tiktoken vocabularies, at spaces ("▁word") for SentencePiece ones —
+// then every piece is merged pair by pair, lowest rank first, until no
+// adjacent pair is in the vocabulary. The ranks live in one flat
+// open-addressing table whose token bytes are packed in a single buffer, so a
+// lookup is a hash, one or two slot reads and a memcmp.
+//
+// Conversations repeat the same words all the time: the ids of recently seen
+// pieces are kept in an LRU cache, which skips both the UTF-8 conversion and
+// the merge loop for most of them.
+class BpeTokenizer : public Tokenizer
+{
+public:
+    enum class Format { Tiktoken, SentencePiece };
+
+    // Null (and `error` set) if the file cannot be read or holds no token.
+    static std::shared_ptr<BpeTokenizer> load(const QString &name, const QString &vocabPath,
+                                              Format format, QString *error = nullptr);
+
+    QString name() const override { return m_name; }
+    int countTokens(QStringView text) const override;
+
+    // Token ids: tiktoken ranks, or line numbers of the SentencePiece table.
+    QList<int> encode(QStringView text) const;
+
+private:
+    BpeTokenizer(const QString &name, Format format);
+
+    class RankTable
+    {
+    public:
+        void build(const QList<QPair<QByteArray, int>> &tokens);
+        int rank(const char *data, qsizetype size) const; // -1 si absent
+        qsizetype size() const { return m_count; }
+
+    private:
+        struct Slot
+        {
+            quint32 hash = 0;
+            quint32 offset = 0;
+            quint32 size = 0;
+            qint32 rank = -1; // -1 : case vide
+        };
+        QByteArray m_bytes; // Octets de tous les tokens, bout à bout
+        QList<Slot> m_slots;
+        quint32 m_mask = 0;
+        qsizetype m_count = 0;
+    };
+
+    bool parseTiktoken(const QByteArray &content, QString *error);
+    bool parseSentencePiece(const QByteArray &content, QString *error);
+
+    // Découpe le texte en morceaux UTF-8 et appelle `visit` sur chacun.
+    template <typename Visitor>
+    void forEachPiece(QStringView text, Visitor visit) const;
+    // Ids d'un morceau, via le cache LRU.
+    QList<int> pieceIds(QByteArrayView piece) const;
+    void mergePiece(QByteArrayView piece, QList<int> &ids) const;
+    void appendFallback(QByteArrayView symbol, QList<int> &ids) const;
+
+    QString m_name;
+    Format m_format;
+    RankTable m_ranks;
+    QRegularExpression m_pattern; // Pré-découpage tiktoken
+    int m_byteIds[256];           // Token d'un octet isolé (-1 : aucun)
+    int m_unknownId = -1;
+
+    mutable QMutex m_cacheMutex;
+    mutable QCache<QByteArray, QList<int>> m_cache;
+};
+
+#endif // BPETOKENIZER_H
+// End Source File BpeTokenizer.h
@@ -5,6 +5,7 @@
 #include "AnthropicInterlocutor.h"
 #include "GoogleAIInterlocutor.h"
 #include "ModelInfo.h"
+#include "NetworkService.h"
 #include "OpenAIInterlocutor.h"
 #include <QClipboard>
 #include <QDebug>
@@ -12,6 +13,8 @@
 #include <QFile>
 #include <QGuiApplication>
 #include <QImage>
+#include <QSaveFile>
+#include <QSet>
 #include <QStandardPaths>
 #include <QUrl>
 
@@ -29,7 +32,7 @@ static QString personaCorePreamble()
 ChatManager::ChatManager(QObject *parent)
     : QObject(parent)
     , m_chatModel(new ChatModel(this))
-    , m_duoChatModel(new DuoChatModel(this))
+    , m_groupChatModel(new GroupChatModel(this))
 {
     // Définir le chemin de stockage des chats
     m_chatFilesPath =
@@ -40,29 +43,30 @@ ChatManager::ChatManager(QObject *parent)
         dir.mkpath(".");
     }
 
-    // Le duo écrit dans les journaux solo des participants ; si l'interlocuteur
-    // actif du chat principal y participe, son ChatModel doit être rechargé
-    // depuis le disque. On le fait dès que la session duo est au repos.
-    connect(m_duoChatModel, &DuoChatModel::journalUpdated, this,
+    // Le groupe écrit dans les journaux solo des participants ; si
+    // l'interlocuteur actif du chat principal y participe, son ChatModel doit
+    // être rechargé depuis le disque. On le fait dès que la session est au repos.
+    connect(m_groupChatModel, &GroupChatModel::journalUpdated, this,
             [this](const QString &name)
             {
                 if (name != m_activeInterlocutorName)
                     return;
-                if (!m_duoChatModel->running() && !m_duoChatModel->busy())
+                if (!m_groupChatModel->running() && !m_groupChatModel->busy())
                     m_chatModel->reloadFromDisk();
                 else
-                    m_duoSoloReloadPending = true;
+                    m_groupSoloReloadPending = true;
             });
     auto reloadSoloWhenIdle = [this]()
     {
-        if (m_duoSoloReloadPending && !m_duoChatModel->running() && !m_duoChatModel->busy())
+        if (m_groupSoloReloadPending && !m_groupChatModel->running() &&
+            !m_groupChatModel->busy())
         {
-            m_duoSoloReloadPending = false;
+            m_groupSoloReloadPending = false;
             m_chatModel->reloadFromDisk();
         }
     };
-    connect(m_duoChatModel, &DuoChatModel::runningChanged, this, reloadSoloWhenIdle);
-    connect(m_duoChatModel, &DuoChatModel::busyChanged, this, reloadSoloWhenIdle);
+    connect(m_groupChatModel, &GroupChatModel::runningChanged, this, reloadSoloWhenIdle);
+    connect(m_groupChatModel, &GroupChatModel::busyChanged, this, reloadSoloWhenIdle);
 
     loadInterlocutorsFromDisk();
 
@@ -102,11 +106,19 @@ void ChatManager::switchToInterlocutor(const QString &name)
 
     Interlocutor *interlocutor = m_interlocutors.value(name);
     m_chatModel->setInterlocutor(interlocutor);
+    m_chatModel->setCurator(m_curators.value(name));
 
     InterlocutorConfig *interlocutorConfig = findConfigByName(name);
     if (interlocutor != nullptr && interlocutorConfig != nullptr)
     {
+        // Connexion ouverte pendant que l'utilisateur écrit ; le curateur,
+        // même fournisseur, passe par le même hôte.
+        NetworkService::instance().warmUp(QUrl(interlocutorConfig->endpointUrl()));
+
         interlocutor->setSystemPrompt(personaCorePreamble() + interlocutorConfig->systemPrompt());
+        // Le curateur écrit la mémoire de ce personnage : même prompt
+        if (Interlocutor *curator = m_curators.value(name))
+            curator->setSystemPrompt(personaCorePreamble() + interlocutorConfig->systemPrompt());
 
         // Update curation thresholds from the registry
         ModelInfo modelInfo = m_modelRegistry.findModel(interlocutorConfig->modelName());
@@ -206,6 +218,18 @@ bool ChatManager::saveConfig(InterlocutorConfig *config)
     Interlocutor *newInterlocutor = createInterlocutorFromConfig(config);
     m_interlocutors.insert(config->name(), newInterlocutor);
 
+    // Le curateur est remplacé tout de suite, même pour le personnage actif :
+    // un changement de modèle de curation vaut dès la prochaine curation.
+    Interlocutor *oldCurator = m_curators.take(config->name());
+    Interlocutor *newCurator = createCuratorFromConfig(config);
+    m_curators.insert(config->name(), newCurator);
+    if (config->name() == m_activeInterlocutorName)
+    {
+        newCurator->setSystemPrompt(personaCorePreamble() + config->systemPrompt());
+        m_chatModel->setCurator(newCurator);
+    }
+    delete oldCurator;
+
     saveInterlocutorsToDisk();
     emit interlocutorNamesChanged(); // Mettre à jour les ComboBox !
     return true;
@@ -239,6 +263,7 @@ void ChatManager::loadInterlocutorsFromDisk()
 
         Interlocutor *interlocutor = createInterlocutorFromConfig(config);
         m_interlocutors.insert(config->name(), interlocutor);
+        m_curators.insert(config->name(), createCuratorFromConfig(config));
     }
 
     emit interlocutorNamesChanged();
@@ -254,13 +279,15 @@ void ChatManager::saveInterlocutorsToDisk()
         configArray.append(obj);
     }
 
-    QFile file(m_chatFilesPath + "/interlocutors.json");
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    QSaveFile file(m_chatFilesPath + "/interlocutors.json");
+    if (!file.open(QIODevice::WriteOnly))
     {
         qWarning("Couldn't open interlocutors.json for writing");
         return;
     }
     file.write(QJsonDocument(configArray).toJson(QJsonDocument::Indented));
+    if (!file.commit())
+        qWarning() << "Couldn't write interlocutors.json:" << file.errorString();
 }
 QStringList ChatManager::availableProviders() const
 {
@@ -282,31 +309,54 @@ InterlocutorConfig *ChatManager::peekConfigByName(const QString &configName) con
     return nullptr;
 }
 
-QString ChatManager::buildDuoSystemPrompt(InterlocutorConfig *config,
-                                          const QString &partnerName) const
+QString ChatManager::buildGroupSystemPrompt(InterlocutorConfig *config,
+                                            const QStringList &partnerNames) const
 {
+    if (partnerNames.size() == 1)
+    {
+        return personaCorePreamble() + config->systemPrompt() +
+               QString("\n\nYou can chat with different people; the person you're chatting "
+                       "with right now is: %1. %1 is another AI, connected to you through the "
+                       "Tether application. In the conversation history, messages coming from "
+                       "%1 are prefixed with \"[%1]: \"; unprefixed user messages come from "
+                       "your human user. The human who set up this conversation may read it, "
+                       "but will not take part in it: your messages are delivered directly to "
+                       "%1.")
+                   .arg(partnerNames.first());
+    }
     return personaCorePreamble() + config->systemPrompt() +
-           QString("\n\nYou can chat with different people; the person you're chatting with "
-                   "right now is: %1. %1 is another AI, connected to you through the Tether "
-                   "application. In the conversation history, messages coming from %1 are "
-                   "prefixed with \"[%1]: \"; unprefixed user messages come from your human "
-                   "user. The human who set up this conversation may read it, but will not "
-                   "take part in it: your messages are delivered directly to %1.")
-               .arg(partnerName);
+           QString("\n\nYou can chat with different people; right now you are in a group "
+                   "conversation with %1. They are other AIs, connected to you through the "
+                   "Tether application. In the conversation history, each of their messages "
+                   "is prefixed with its author's name, like \"[%2]: \"; unprefixed user "
+                   "messages come from your human user. The human who set up this "
+                   "conversation may read it, but will not take part in it: your messages are "
+                   "delivered to all of them. Address someone by name to hand them the word. "
+                   "If you have nothing to add at some point, answer just \"[pass]\".")
+               .arg(partnerNames.join(", "), partnerNames.first());
 }
 
-// Construit la fiche d'un participant duo : instance dédiée, prompt adapté,
-// chemins de fichiers (journal + mémoire = LES MÊMES que le chat solo, pour la
-// continuité d'identité), et seuils de curation issus du registre de modèles.
-DuoChatModel::ParticipantSpec ChatManager::makeDuoSpec(InterlocutorConfig *config,
-                                                       const QString &partnerName)
+// Construit la fiche d'un participant : instances dédiées (parole et
+// curation), prompt adapté, chemins de fichiers (journal + mémoire = LES MÊMES
+// que le chat solo, pour la continuité d'identité), et seuils de curation issus
+// du registre de modèles.
+GroupChatModel::ParticipantSpec ChatManager::makeGroupSpec(InterlocutorConfig *config,
+                                                           const QStringList &partnerNames)
 {
-    DuoChatModel::ParticipantSpec spec;
+    GroupChatModel::ParticipantSpec spec;
     spec.name = config->name();
     spec.interlocutor = createInterlocutorFromConfig(config);
-    spec.interlocutor->setSystemPrompt(buildDuoSystemPrompt(config, partnerName));
+    // Le chat de l'utilisateur passe avant les tours du groupe (curations : en fond)
+    spec.interlocutor->setRequestPriority(RequestScheduler::Priority::Duo);
+    NetworkService::instance().warmUp(QUrl(config->endpointUrl()));
+    spec.interlocutor->setSystemPrompt(buildGroupSystemPrompt(config, partnerNames));
+    spec.interlocutor->setStreamingEnabled(m_chatModel->streamingEnabled());
+    // Curateur propre à chaque participant : les curations tournent en
+    // parallèle des tours, sans partager les signaux de la parole
+    spec.curator = createCuratorFromConfig(config);
+    spec.curator->setSystemPrompt(personaCorePreamble() + config->systemPrompt());
     spec.journalPath = m_chatFilesPath + "/" + config->name() + ".jsonl";
-    spec.memoryPath = m_chatFilesPath + "/" + config->name() + "_memory.txt";
+    spec.memoryPath = m_chatFilesPath + "/" + config->name() + "_memory.json";
 
     ModelInfo modelInfo = m_modelRegistry.findModel(config->modelName());
     if (modelInfo.curationTriggerTokenCount > modelInfo.curationTargetTokenCount)
@@ -316,38 +366,47 @@ DuoChatModel::ParticipantSpec ChatManager::makeDuoSpec(InterlocutorConfig *confi
     }
     else
     {
-        qWarning() << "makeDuoSpec: no valid curation thresholds for" << config->modelName()
+        qWarning() << "makeGroupSpec: no valid curation thresholds for" << config->modelName()
                    << "- using defaults.";
     }
     return spec;
 }
 
-void ChatManager::selectDuoPair(const QString &nameA, const QString &nameB)
+void ChatManager::selectGroup(const QStringList &names)
 {
-    if (m_duoChatModel->curationPending())
+    if (m_groupChatModel->curationPending())
     {
-        qWarning() << "selectDuoPair refused: a memory curation is pending.";
+        qWarning() << "selectGroup refused: a memory curation is pending.";
         return;
     }
 
-    InterlocutorConfig *configA = peekConfigByName(nameA);
-    InterlocutorConfig *configB = peekConfigByName(nameB);
+    QList<InterlocutorConfig *> configs;
+    for (const QString &name : names)
+        configs.append(peekConfigByName(name));
 
-    if (nameA.isEmpty() || nameB.isEmpty() || nameA == nameB || !configA || !configB)
+    if (names.size() < 2 || names.contains(QString()) || configs.contains(nullptr) ||
+        QSet<QString>(names.begin(), names.end()).size() != names.size())
     {
-        // Sélection invalide (notamment deux fois le même interlocuteur : les
-        // deux côtés partageraient journal et mémoire). On invalide la session
-        // pour que l'UI reflète exactement la sélection des combos.
-        qWarning() << "selectDuoPair: invalid pair:" << nameA << "/" << nameB;
-        m_duoChatModel->clearParticipants();
+        // Sélection invalide (notamment deux fois le même interlocuteur : ils
+        // partageraient journal et mémoire). On invalide la session pour que
+        // l'UI reflète exactement la sélection.
+        qWarning() << "selectGroup: invalid selection:" << names;
+        m_groupChatModel->clearParticipants();
         return;
     }
 
-    // Instances dédiées : la conversation duo ne doit partager ni le system
-    // prompt ni les signaux réseau avec l'interlocuteur actif du chat principal.
-    const QString transcriptPath = m_chatFilesPath + "/duo_" + nameA + "__" + nameB + ".jsonl";
-    m_duoChatModel->setParticipants(makeDuoSpec(configA, nameB), makeDuoSpec(configB, nameA),
-                                    transcriptPath);
+    // Instances dédiées : la conversation ne doit partager ni le system prompt
+    // ni les signaux réseau avec l'interlocuteur actif du chat principal.
+    QList<GroupChatModel::ParticipantSpec> specs;
+    for (int i = 0; i < configs.size(); ++i)
+    {
+        QStringList partners = names;
+        partners.removeAt(i);
+        specs.append(makeGroupSpec(configs.at(i), partners));
+    }
+    // duo_<A>__<B>.jsonl : le nom des transcriptions à deux ne change pas
+    const QString transcriptPath = m_chatFilesPath + "/duo_" + names.join("__") + ".jsonl";
+    m_groupChatModel->setParticipants(specs, transcriptPath);
 }
 
 InterlocutorConfig *ChatManager::findConfigByName(const QString &configName)
@@ -478,32 +537,60 @@ void ChatManager::refreshActiveImagePaths(const QString &name)
 
 Interlocutor *ChatManager::createInterlocutorFromConfig(InterlocutorConfig *config)
 {
-    ModelInfo model = m_modelRegistry.findModel(config->modelName());
+    return createInterlocutor(config, m_modelRegistry.findModel(config->modelName()),
+                              QUrl(config->endpointUrl()));
+}
+
+Interlocutor *ChatManager::createCuratorFromConfig(InterlocutorConfig *config)
+{
+    // Sans modèle de curation, une seconde instance du modèle du chat : la
+    // curation ne partage au moins pas les signaux du chat (les connexions,
+    // elles, sont celles de l'hôte, voir NetworkService).
+    const ModelInfo chatModel = m_modelRegistry.findModel(config->modelName());
+    if (config->curatorModelName().isEmpty())
+        return createInterlocutorFromConfig(config);
+
+    // La clé d'API de la config ne vaut que pour son fournisseur.
+    const ModelInfo model = m_modelRegistry.findModel(config->curatorModelName());
+    if (model.displayName.isEmpty() || model.provider != chatModel.provider)
+    {
+        qWarning() << "Curator model" << config->curatorModelName() << "unknown or not from"
+                   << chatModel.provider << "- curating with" << config->modelName();
+        return createInterlocutorFromConfig(config);
+    }
+    QString endpoint = model.endpointTemplate;
+    endpoint.replace("%MODEL_NAME%", model.internalName);
+    qDebug() << "Curator of" << config->name() << ":" << model.displayName;
+    return createInterlocutor(config, model, QUrl(endpoint));
+}
+
+Interlocutor *ChatManager::createInterlocutor(InterlocutorConfig *config, const ModelInfo &model,
+                                              const QUrl &endpointUrl)
+{
     Interlocutor *interlocutor = nullptr;
 
     // On utilise maintenant model.provider au lieu de config->type()
     if (model.provider == "OpenAI")
     {
         interlocutor =
-            new OpenAIInterlocutor(config->name(), config->apiKey(), QUrl(config->endpointUrl()),
+            new OpenAIInterlocutor(config->name(), config->apiKey(), endpointUrl,
                                    model.internalName, // On passe le nom interne !
                                    model.maxAttachedFileTokenCount, this);
     }
     else if (model.provider == "DeepSeek")
     {
         interlocutor =
-            new DeepSeekInterlocutor(config->name(), config->apiKey(), QUrl(config->endpointUrl()),
+            new DeepSeekInterlocutor(config->name(), config->apiKey(), endpointUrl,
                                      model.internalName, this);
     }
     else if (model.provider == "Google")
     {
-        interlocutor = new GoogleAIInterlocutor(config->name(), config->apiKey(),
-                                                QUrl(config->endpointUrl()), this);
+        interlocutor = new GoogleAIInterlocutor(config->name(), config->apiKey(), endpointUrl,
+                                                this);
     }
     else if (model.provider == "Anthropic")
     {
-        interlocutor = new AnthropicInterlocutor(config->name(), config->apiKey(),
-                                                  QUrl(config->endpointUrl()),
+        interlocutor = new AnthropicInterlocutor(config->name(), config->apiKey(), endpointUrl,
                                                   model.internalName, this);
     }
     else if (config->type() == "Dummy")
@@ -522,6 +609,7 @@ Interlocutor *ChatManager::createInterlocutorFromConfig(InterlocutorConfig *conf
         qDebug() << "ChatManager::createInterlocutorFromConfig: setSystemPrompt"
                  << config->systemPrompt();
         interlocutor->setSystemPrompt(config->systemPrompt());
+        interlocutor->setTokenizer(Tokenizer::forName(model.tokenizer));
     }
     return interlocutor;
 }
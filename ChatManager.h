@@ -3,11 +3,12 @@
 #define CHATMANAGER_H
 
 #include "ChatModel.h"
-#include "DuoChatModel.h"
+#include "GroupChatModel.h"
 #include "Interlocutor.h"
 #include <QMap>
 #include <QObject>
 #include <QStringList>
+#include <QUrl>
 
 // #include "DummyInterlocutor.h" // Pour le debug
 #include "InterlocutorConfig.h"
@@ -24,8 +25,8 @@ public:
     // Propriété pour le ChatModel, exposé à QML
     Q_PROPERTY(ChatModel *chatModel READ chatModel CONSTANT)
 
-    // Propriété pour le modèle de conversation IA-IA, exposé à QML
-    Q_PROPERTY(DuoChatModel *duoChatModel READ duoChatModel CONSTANT)
+    // Propriété pour le modèle de conversation IA-IA (deux IA ou plus), exposé à QML
+    Q_PROPERTY(GroupChatModel *groupChatModel READ groupChatModel CONSTANT)
 
     // Propriété pour la liste des noms d'interlocuteurs, pour un ComboBox en QML
     Q_PROPERTY(QStringList interlocutorNames READ interlocutorNames NOTIFY interlocutorNamesChanged)
@@ -50,9 +51,10 @@ public:
     Q_INVOKABLE void switchToInterlocutor(const QString &name);
 
     // Prépare une session de conversation IA-IA entre deux interlocuteurs
-    // configurés. Crée des instances dédiées (indépendantes du chat principal)
-    // et charge la transcription duo correspondante.
-    Q_INVOKABLE void selectDuoPair(const QString &nameA, const QString &nameB);
+    // configurés ou plus, dans l'ordre de parole. Crée des instances dédiées
+    // (indépendantes du chat principal) et charge la transcription
+    // correspondante.
+    Q_INVOKABLE void selectGroup(const QStringList &names);
 
     // Méthodes Q_INVOKABLE pour l'onglet de configuration
     Q_INVOKABLE void selectConfigToEdit(const QString &name);
@@ -66,7 +68,7 @@ public:
     QStringList availableInterlocutorTypes() const;
 
     ChatModel *chatModel() const { return m_chatModel; }
-    DuoChatModel *duoChatModel() const { return m_duoChatModel; }
+    GroupChatModel *groupChatModel() const { return m_groupChatModel; }
     QStringList interlocutorNames() const;
     QString activeInterlocutorName() const { return m_activeInterlocutorName; }
 
@@ -93,8 +95,11 @@ signals:
 
 private:
     ChatModel *m_chatModel;
-    DuoChatModel *m_duoChatModel;
+    GroupChatModel *m_groupChatModel;
     QMap<QString, Interlocutor *> m_interlocutors; // Stocke tous les interlocuteurs par nom
+    // Instance dédiée à la curation de chaque interlocuteur (ses propres
+    // signaux, éventuellement un modèle moins cher)
+    QMap<QString, Interlocutor *> m_curators;
     QString m_activeInterlocutorName;
 
     QString m_chatFilesPath; // Chemin vers le dossier des fichiers .jsonl
@@ -107,12 +112,17 @@ private:
     void loadInterlocutorsFromDisk();
 
     Interlocutor *createInterlocutorFromConfig(InterlocutorConfig *config);
+    // Curateur : le modèle config->curatorModelName(), ou celui du chat
+    Interlocutor *createCuratorFromConfig(InterlocutorConfig *config);
+    Interlocutor *createInterlocutor(InterlocutorConfig *config, const ModelInfo &model,
+                                     const QUrl &endpointUrl);
     // Recherche une config sans effet de bord (ne touche pas m_currentConfig)
     InterlocutorConfig *peekConfigByName(const QString &configName) const;
-    QString buildDuoSystemPrompt(InterlocutorConfig *config, const QString &partnerName) const;
-    DuoChatModel::ParticipantSpec makeDuoSpec(InterlocutorConfig *config,
-                                              const QString &partnerName);
-    bool m_duoSoloReloadPending = false;
+    QString buildGroupSystemPrompt(InterlocutorConfig *config,
+                                   const QStringList &partnerNames) const;
+    GroupChatModel::ParticipantSpec makeGroupSpec(InterlocutorConfig *config,
+                                                  const QStringList &partnerNames);
+    bool m_groupSoloReloadPending = false;
     InterlocutorConfig *m_currentConfig = nullptr; // Pointeur vers la config en cours d'édition
     QList<InterlocutorConfig *> m_allConfigs;      // La liste de toutes les configurations
     ModelRegistry m_modelRegistry;
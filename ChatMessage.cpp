@@ -0,0 +1,84 @@
+// Begin Source File ChatMessage.cpp
+#include "ChatMessage.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QStringList>
+
+namespace
+{
+// Quelques noms par conversation IA-IA : la table ne fait que grandir.
+// JournalReader interne depuis le pool de fils, d'où le verrou.
+struct SpeakerTable
+{
+    QReadWriteLock lock;
+    QHash<QString, quint16> ids;
+    QStringList names{QString()};
+};
+
+SpeakerTable &speakerTable()
+{
+    static SpeakerTable table;
+    return table;
+}
+} // namespace
+
+QString ChatMessage::roleName(Role role)
+{
+    static const QString user = QStringLiteral("user");
+    static const QString assistant = QStringLiteral("assistant");
+    static const QString system = QStringLiteral("system");
+    switch (role)
+    {
+        case Role::Assistant: return assistant;
+        case Role::System: return system;
+        case Role::User: break;
+    }
+    return user;
+}
+
+ChatMessage::Role ChatMessage::roleFromName(QStringView name)
+{
+    if (name == u"assistant")
+        return Role::Assistant;
+    if (name == u"system")
+        return Role::System;
+    return Role::User;
+}
+
+quint16 ChatMessage::internSpeaker(const QString &speaker)
+{
+    if (speaker.isEmpty())
+        return 0;
+    SpeakerTable &table = speakerTable();
+    {
+        QReadLocker locker(&table.lock);
+        const auto it = table.ids.constFind(speaker);
+        if (it != table.ids.constEnd())
+            return it.value();
+    }
+    QWriteLocker locker(&table.lock);
+    const auto it = table.ids.constFind(speaker); // Interné entre les deux verrous
+    if (it != table.ids.constEnd())
+        return it.value();
+    if (table.names.size() > std::numeric_limits<quint16>::max())
+    {
+        qWarning() << "ChatMessage: too many speaker names, dropping" << speaker;
+        return 0;
+    }
+    const quint16 id = quint16(table.names.size());
+    table.names.append(speaker);
+    table.ids.insert(speaker, id);
+    return id;
+}
+
+QString ChatMessage::speakerName(quint16 id)
+{
+    if (id == 0)
+        return QString();
+    SpeakerTable &table = speakerTable();
+    QReadLocker locker(&table.lock);
+    return table.names.value(id);
+}
+// End Source File ChatMessage.cpp
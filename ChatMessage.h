@@ -7,7 +7,19 @@
 #include <QDateTime>
 #include <QJsonObject> // Pour la sérialisation/désérialisation JSON
 
+#include <limits>
+
+#include "JsonlScanner.h"
+
 // Structure pour représenter un seul message dans la conversation
+//
+// A compact record (56 bytes on 64-bit platforms): the role is an enum, the
+// speaker an id in a process-wide table of names, the booleans share one
+// byte of flags and the timestamp is kept in milliseconds since the epoch.
+// The text is a single implicitly shared UTF-8 buffer, so copying a message
+// (QList detach, histories handed to sendRequest...) touches one reference
+// count. The QString/QDateTime accessors and the Q_GADGET properties are
+// unchanged for QML and the interlocutors.
 struct ChatMessage
 {
     Q_GADGET // Permet d'utiliser QVariant et d'autres fonctionnalités Qt avec cette structure
@@ -22,78 +34,173 @@ struct ChatMessage
     Q_PROPERTY(int promptTokens READ promptTokens WRITE setPromptTokens)
     Q_PROPERTY(int completionTokens READ completionTokens WRITE setCompletionTokens)
     Q_PROPERTY(bool isError READ isError WRITE setIsError)
+    Q_PROPERTY(bool isTypingIndicator READ isTypingIndicator WRITE setIsTypingIndicator)
     Q_PROPERTY(QString speaker READ speaker WRITE setSpeaker)
+    Q_PROPERTY(int tokenWeight READ tokenWeight WRITE setTokenWeight)
+    Q_PROPERTY(int serverLatencyMs READ serverLatencyMs WRITE setServerLatencyMs)
+    Q_PROPERTY(double tokensPerSecond READ tokensPerSecond WRITE setTokensPerSecond)
 
 public:
+    enum class Role : quint8
+    {
+        User,
+        Assistant,
+        System
+    };
+    Q_ENUM(Role)
+
     // Constructeur par défaut
-    ChatMessage() : m_isLocalMessage(false), m_promptTokens(0), m_completionTokens(0), m_role(""), m_isError(false) {}
+    ChatMessage() = default;
 
     // Constructeur complet
     ChatMessage(bool local, const QString &txt, const QDateTime &ts, int pTokens, int cTokens, const QString &r, bool error = false)
-        : m_isLocalMessage(local), m_text(txt), m_timestamp(ts), m_promptTokens(pTokens), m_completionTokens(cTokens), m_role(r), m_isError(error) {}
+        : m_text(txt.toUtf8()), m_promptTokens(pTokens), m_completionTokens(cTokens), m_role(roleFromName(r))
+    {
+        setTimestamp(ts);
+        setFlag(LocalFlag, local);
+        setFlag(ErrorFlag, error);
+    }
 
     // Accesseurs
-    bool isLocalMessage() const { return m_isLocalMessage; }
-    QString text() const { return m_text; }
-    QDateTime timestamp() const { return m_timestamp; }
+    bool isLocalMessage() const { return m_flags & LocalFlag; }
+    QString text() const {
+        // Décodé à chaque accès, jamais gardé : seules les lignes affichées et
+        // les requêtes à encoder le demandent. Un texte lu dans le journal est
+        // encore échappé (voir JsonlScanner).
+        if (m_flags & EscapedTextFlag)
+            return JsonlScanner::decodeString(m_text);
+        return QString::fromUtf8(m_text);
+    }
+    // Octets du texte tels qu'ils sont gardés : UTF-8, ou contenu échappé du
+    // littéral JSON "text" si isTextEscaped(). De quoi le hacher sans le décoder.
+    const QByteArray &textBytes() const { return m_text; }
+    bool isTextEscaped() const { return m_flags & EscapedTextFlag; }
+    // Longueur du texte sans le décoder (octets UTF-8, échappés ou non) :
+    // suffisant pour les estimations de tokens.
+    qsizetype textSizeHint() const { return m_text.size(); }
+    QDateTime timestamp() const {
+        return m_timestampMs == kNoTimestamp ? QDateTime() : QDateTime::fromMSecsSinceEpoch(m_timestampMs);
+    }
+    // Millisecondes depuis l'epoch ; kNoTimestamp si l'horodatage est invalide
+    qint64 timestampMs() const { return m_timestampMs; }
     int promptTokens() const { return m_promptTokens; }
     int completionTokens() const { return m_completionTokens; }
-    QString role() const { return m_role; }
-    bool isError() const { return m_isError; }
-    QString speaker() const { return m_speaker; }
+    Role roleId() const { return m_role; }
+    bool isAssistant() const { return m_role == Role::Assistant; }
+    QString role() const { return roleName(m_role); }
+    bool isError() const { return m_flags & ErrorFlag; }
+    bool isTypingIndicator() const { return m_flags & TypingFlag; }
+    QString speaker() const { return speakerName(m_speakerId); }
+    // 0 : pas d'auteur nommé (chats classiques)
+    quint16 speakerId() const { return m_speakerId; }
+    // Poids du message dans le contexte vif (voir MemoryCurator::weigh) ;
+    // -1 tant qu'il n'a pas été calculé. Persisté dans le journal ("tokens").
+    int tokenWeight() const { return m_tokenWeight; }
+    // Mesures de la réponse qui a produit ce message (IA uniquement) : attente
+    // du serveur (-1 : inconnue) et débit de sortie (0 : inconnu). Persistées
+    // dans le journal ("latencyMs", "tokensPerSec") quand elles sont connues.
+    int serverLatencyMs() const { return m_serverLatencyMs; }
+    double tokensPerSecond() const { return m_tokensPerSecond; }
 
     // Mutateurs
-    void setIsLocalMessage(bool local) { m_isLocalMessage = local; }
-    void setText(const QString &txt) { m_text = txt; }
-    void setTimestamp(const QDateTime &ts) { m_timestamp = ts; }
-    void setPromptTokens(int tokens) { m_promptTokens = tokens; }
-    void setCompletionTokens(int tokens) { m_completionTokens = tokens; }
-    void setRole(const QString &r) { m_role = r; }
-    void setIsError(bool error) { m_isError = error; }
-    void setSpeaker(const QString &speaker) { m_speaker = speaker; }
+    void setIsLocalMessage(bool local) { setFlag(LocalFlag, local); }
+    // Les mutateurs du texte, des compteurs et du rôle invalident le poids.
+    void setText(const QString &txt) { m_text = txt.toUtf8(); setFlag(EscapedTextFlag, false); m_tokenWeight = -1; }
+    // Ajout en place (réponses en streaming) : seuls les octets ajoutés sont encodés.
+    void appendText(const QString &txt) {
+        if (m_flags & EscapedTextFlag)
+            m_text = text().toUtf8();
+        m_text += txt.toUtf8();
+        setFlag(EscapedTextFlag, false);
+        m_tokenWeight = -1;
+    }
+    // Contenu encore échappé du littéral JSON "text" (voir JsonlScanner)
+    void setRawText(const QByteArray &escaped) { m_text = escaped; setFlag(EscapedTextFlag, !escaped.isEmpty()); m_tokenWeight = -1; }
+    void setTimestamp(const QDateTime &ts) { m_timestampMs = ts.isValid() ? ts.toMSecsSinceEpoch() : kNoTimestamp; }
+    void setTimestampMs(qint64 ms) { m_timestampMs = ms; }
+    void setPromptTokens(int tokens) { m_promptTokens = tokens; m_tokenWeight = -1; }
+    void setCompletionTokens(int tokens) { m_completionTokens = tokens; m_tokenWeight = -1; }
+    void setRole(Role r) { m_role = r; m_tokenWeight = -1; }
+    void setRole(const QString &r) { setRole(roleFromName(r)); }
+    void setIsError(bool error) { setFlag(ErrorFlag, error); }
+    void setIsTypingIndicator(bool typing) { setFlag(TypingFlag, typing); }
+    void setSpeaker(const QString &speaker) { m_speakerId = internSpeaker(speaker); }
+    void setTokenWeight(int weight) { m_tokenWeight = weight; }
+    void setServerLatencyMs(int ms) { m_serverLatencyMs = ms; }
+    void setTokensPerSecond(double rate) { m_tokensPerSecond = float(rate); }
+
+    // "user", "assistant", "system" (chaînes partagées, sans allocation)
+    static QString roleName(Role role);
+    // Rôle inconnu : User
+    static Role roleFromName(QStringView name);
+    // Table des noms d'auteurs, commune à tous les fils ; "" a l'id 0.
+    static quint16 internSpeaker(const QString &speaker);
+    static QString speakerName(quint16 id);
 
     // Méthodes de sérialisation / désérialisation
     QJsonObject toJsonObject() const {
         QJsonObject obj;
-        obj["isLocalMessage"] = m_isLocalMessage;
-        obj["text"] = m_text;
-        obj["timestamp"] = m_timestamp.toString(Qt::ISODate); // Format ISO pour la persistance
+        obj["isLocalMessage"] = isLocalMessage();
+        obj["text"] = text();
+        obj["timestamp"] = timestamp().toString(Qt::ISODate); // Format ISO pour la persistance
         obj["promptTokens"] = m_promptTokens;
         obj["completionTokens"] = m_completionTokens;
-        obj["role"] = m_role;
-        obj["isTypingIndicator"] = isTypingIndicator;
-        obj["isError"] = m_isError;
+        obj["role"] = role();
+        obj["isTypingIndicator"] = isTypingIndicator();
+        obj["isError"] = isError();
         // Le champ speaker n'est utilisé que par les conversations IA-IA
-        // (DuoChatModel) ; on ne l'écrit pas pour les chats classiques afin de
+        // (GroupChatModel) ; on ne l'écrit pas pour les chats classiques afin de
         // garder leurs fichiers jsonl inchangés.
-        if (!m_speaker.isEmpty())
-            obj["speaker"] = m_speaker;
+        if (m_speakerId != 0)
+            obj["speaker"] = speaker();
+        if (m_tokenWeight >= 0)
+            obj["tokens"] = m_tokenWeight;
+        if (m_serverLatencyMs >= 0)
+            obj["latencyMs"] = m_serverLatencyMs;
+        if (m_tokensPerSecond > 0)
+            obj["tokensPerSec"] = qRound(m_tokensPerSecond * 10) / 10.0;
         return obj;
     }
 
     static ChatMessage fromJsonObject(const QJsonObject &obj) {
         ChatMessage msg;
-        msg.m_isLocalMessage = obj["isLocalMessage"].toBool();
-        msg.m_text = obj["text"].toString();
-        msg.m_timestamp = QDateTime::fromString(obj["timestamp"].toString(), Qt::ISODate);
+        msg.setIsLocalMessage(obj["isLocalMessage"].toBool());
+        msg.m_text = obj["text"].toString().toUtf8();
+        msg.setTimestamp(QDateTime::fromString(obj["timestamp"].toString(), Qt::ISODate));
         msg.m_promptTokens = obj["promptTokens"].toInt();
         msg.m_completionTokens = obj["completionTokens"].toInt();
-        msg.m_role = obj["role"].toString();
-        msg.isTypingIndicator = obj["isTypingIndicator"].toBool(false);
-        msg.m_isError = obj["isError"].toBool(false);
-        msg.m_speaker = obj["speaker"].toString();
+        msg.m_role = roleFromName(obj["role"].toString());
+        msg.setIsTypingIndicator(obj["isTypingIndicator"].toBool(false));
+        msg.setIsError(obj["isError"].toBool(false));
+        msg.setSpeaker(obj["speaker"].toString());
+        msg.m_tokenWeight = obj["tokens"].toInt(-1); // Absent des anciens journaux
+        msg.m_serverLatencyMs = obj["latencyMs"].toInt(-1);
+        msg.m_tokensPerSecond = float(obj["tokensPerSec"].toDouble(0.0));
         return msg;
     }
-    bool isTypingIndicator = false;
+
+    static constexpr qint64 kNoTimestamp = std::numeric_limits<qint64>::min();
+
 private:
-    bool m_isLocalMessage;
-    QString m_text;
-    QDateTime m_timestamp;
-    int m_promptTokens;
-    int m_completionTokens;
-    QString m_role; // "user" ou "assistant"
-    bool m_isError;
-    QString m_speaker; // Nom de l'interlocuteur auteur (conversations IA-IA uniquement)
+    enum Flag : quint8
+    {
+        LocalFlag = 0x1,
+        ErrorFlag = 0x2,
+        TypingFlag = 0x4,
+        EscapedTextFlag = 0x8 // m_text vient du journal, encore échappé
+    };
+    void setFlag(Flag flag, bool on) { m_flags = on ? quint8(m_flags | flag) : quint8(m_flags & ~flag); }
+
+    QByteArray m_text; // UTF-8 partagé ; jamais modifié en place s'il est partagé
+    qint64 m_timestampMs = kNoTimestamp;
+    int m_promptTokens = 0;
+    int m_completionTokens = 0;
+    int m_tokenWeight = -1;
+    int m_serverLatencyMs = -1;
+    float m_tokensPerSecond = 0.0f;
+    quint16 m_speakerId = 0; // Auteur (conversations IA-IA uniquement), voir internSpeaker()
+    Role m_role = Role::User;
+    quint8 m_flags = 0;
 };
 
 #endif // CHATMESSAGE_H
@@ -1,16 +1,33 @@
 // Begin Source File : ChatModel.cpp
 #include "ChatModel.h"
 #include "ChatManager.h"
+#include "Embedder.h"
 #include "InterlocutorConfig.h"
+#include "JournalFile.h"
+#include "JournalReader.h"
 #include "MemoryCurator.h"
 #include "TetherLogger.h"
+#include "Tracer.h"
 #include <QSettings>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+namespace
+{
+// Fenêtre de lignes montrées à la vue : les plus récentes au chargement, puis
+// une page de plus chaque fois que la vue remonte en haut (fetchMore).
+constexpr qsizetype kInitialWindowRows = 100;
+constexpr qsizetype kFetchPageRows = 50;
+} // namespace
 
 ChatModel::ChatModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -24,12 +41,22 @@ ChatModel::ChatModel(QObject *parent)
     , m_globalLogEnabled(false)
     , m_deepSeekNotesEnabled(true)
     , m_displayNotesEnabled(true)
+    , m_streamingEnabled(true)
 {
+    m_journalReader = new JournalReader(this);
+    connect(m_journalReader, &JournalReader::batchReady, this, &ChatModel::onJournalBatch);
+    connect(m_journalReader, &JournalReader::finished, this, &ChatModel::onJournalLoaded);
+
+    m_prepareTimer = new QTimer(this);
+    m_prepareTimer->setSingleShot(true);
+    connect(m_prepareTimer, &QTimer::timeout, this, &ChatModel::prepareCuration);
+
     QSettings settings;
     m_extendedContextEnabled = settings.value("chat/extendedContextEnabled", false).toBool();
     m_globalLogEnabled = settings.value("chat/globalLogEnabled", false).toBool();
     m_deepSeekNotesEnabled = settings.value("chat/deepSeekNotesEnabled", true).toBool();
     m_displayNotesEnabled = settings.value("chat/displayNotesEnabled", true).toBool();
+    m_streamingEnabled = settings.value("chat/streamingEnabled", true).toBool();
 }
 
 void ChatModel::setExtendedContextEnabled(bool enabled)
@@ -73,6 +100,18 @@ void ChatModel::setDisplayNotesEnabled(bool enabled)
     }
 }
 
+void ChatModel::setStreamingEnabled(bool enabled)
+{
+    if (m_streamingEnabled != enabled) {
+        m_streamingEnabled = enabled;
+        QSettings settings;
+        settings.setValue("chat/streamingEnabled", enabled);
+        if (m_interlocutor)
+            m_interlocutor->setStreamingEnabled(enabled);
+        emit streamingEnabledChanged();
+    }
+}
+
 void ChatModel::setCurationThresholds(int triggerTokens, int targetTokens)
 {
     if (triggerTokens <= targetTokens)
@@ -100,15 +139,32 @@ int ChatModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
         return 0;
-    return m_messages.count();
+    return int(m_messages.count() - m_hiddenRows);
+}
+
+bool ChatModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_hiddenRows > 0;
+}
+
+void ChatModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+    // Les messages cachés sont déjà en mémoire (contexte vif) : seules les
+    // lignes apparaissent, le texte est décodé quand la vue les affiche.
+    const qsizetype count = qMin(kFetchPageRows, m_hiddenRows);
+    beginInsertRows(QModelIndex(), 0, int(count) - 1);
+    m_hiddenRows -= count;
+    endInsertRows();
 }
 
 QVariant ChatModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() >= m_messages.count())
+    if (!index.isValid() || index.row() >= rowCount())
         return QVariant();
 
-    const ChatMessage &message = m_messages.at(index.row());
+    const ChatMessage &message = m_messages.at(m_hiddenRows + index.row());
     switch (role)
     {
         case IsLocalMessageRole: return message.isLocalMessage();
@@ -117,7 +173,7 @@ QVariant ChatModel::data(const QModelIndex &index, int role) const
         case PromptTokensRole: return message.promptTokens();
         case CompletionTokensRole: return message.completionTokens();
         case RoleRole: return message.role();
-        case IsTypingIndicatorRole: return message.isTypingIndicator;
+        case IsTypingIndicatorRole: return message.isTypingIndicator();
         case IsErrorRole: return message.isError();
         case SpeakerRole: return message.speaker();
     }
@@ -147,6 +203,12 @@ void ChatModel::sendMessage(const QString &messageText)
         qDebug() << "aborted because we're waiting for reply";
         return;
     }
+    if (m_isLoadingHistory)
+    { // L'historique n'est pas encore entièrement chargé
+        qDebug() << "aborted because the chat history is still loading";
+        return;
+    }
+    m_prepareTimer->stop(); // L'utilisateur est actif : pas de temps mort
 
     if (!m_interlocutor)
     {
@@ -162,7 +224,7 @@ void ChatModel::sendMessage(const QString &messageText)
     // 1. Ajouter le message de l'utilisateur au modèle
     // Note: les tokens de ce message seront déterminés par la réponse de l'API
     ChatMessage userMessage(true, messageText, QDateTime::currentDateTime(),
-                            messageText.length() / 4, 0, "user");
+                            tokenizer().countTokens(messageText), 0, "user");
     addMessage(userMessage);
 
     // 2. Ajouter les fichiers utilisateur qui sont prêts
@@ -177,44 +239,44 @@ void ChatModel::sendMessage(const QString &messageText)
     // 3. Charger la mémoire ancienne
     QString ancientMemory = loadOlderMemory();
 
-    // 4. Envoyer la requête. Le ChatModel passe tout ce qu'il faut.
-    m_interlocutor->sendRequest(m_messages, ancientMemory, InterlocutorReply::Kind::NormalMessage,
-                                userAttachments);
+    // 4. Rappel des passages archivés proches du message, puis envoi de la
+    //    requête (voir sendWithRecall). Le ChatModel passe tout ce qu'il faut.
+    sendWithRecall(m_messages, ancientMemory, userAttachments);
 
     // 5. Afficher l'indicateur d'attente
     setWaitingForReply(true);
     m_expectingContinuation = false; // Reset state for new turn
     ChatMessage typingIndicator(false, "", QDateTime::currentDateTime(), 0, 0, "assistant");
-    typingIndicator.isTypingIndicator = true;
+    typingIndicator.setIsTypingIndicator(true);
     addMessage(typingIndicator);
 }
 
-void ChatModel::addMessage(const ChatMessage &message)
+void ChatModel::addMessage(const ChatMessage &newMessage)
 {
-    beginInsertRows(QModelIndex(), m_messages.count(), m_messages.count());
+    // Poids calculé une fois ici, puis persisté avec le record
+    ChatMessage message = newMessage;
+    m_tokenLedger.append(MemoryCurator::weigh(message, tokenizer()));
+
+    beginInsertRows(QModelIndex(), rowCount(), rowCount());
     m_messages.append(message);
     endInsertRows();
 
     // Persister le message dans le fichier jsonl si ce n'est pas un typing
     // indicator ni une erreur
-    if (!message.isTypingIndicator && !message.isError() && !m_currentChatFilePath.isEmpty())
-    {
-        QFile file(m_currentChatFilePath);
-        if (file.open(QFile::Append | QFile::Text))
-        {
-            QTextStream stream(&file);
-            stream << QJsonDocument(message.toJsonObject()).toJson(QJsonDocument::Compact) << "\n";
-            file.close();
-            TetherLogger::logMessage(m_interlocutor ? m_interlocutor->name() : "Unknown", message);
-        }
-        else
-        {
-            qWarning() << "Failed to open chat file for appending:" << m_currentChatFilePath;
-        }
-    }
+    if (!message.isTypingIndicator() && !message.isError())
+        appendToChatFile(message);
     emit chatMessageAdded(message);
 }
 
+void ChatModel::appendToChatFile(const ChatMessage &message)
+{
+    if (m_currentChatFilePath.isEmpty())
+        return;
+
+    JournalFile(m_currentChatFilePath).append(message);
+    TetherLogger::logMessage(m_interlocutor ? m_interlocutor->name() : "Unknown", message);
+}
+
 void ChatModel::setWaitingForReply(bool waiting)
 {
     if (m_isWaitingForReply != waiting)
@@ -222,6 +284,42 @@ void ChatModel::setWaitingForReply(bool waiting)
         m_isWaitingForReply = waiting;
         emit isWaitingForReplyChanged();
     }
+    if (!waiting)
+    {
+        m_activeRequest = nullptr;
+        m_stopRequested = false;
+        if (m_generationSeconds != 0)
+        {
+            m_generationSeconds = 0;
+            emit generationSecondsChanged();
+        }
+    }
+}
+
+void ChatModel::trackRequest(RequestHandle *handle)
+{
+    m_activeRequest = handle;
+    if (!handle)
+        return;
+    connect(handle, &RequestHandle::elapsed, this,
+            [this, handle](qint64 elapsedMs)
+            {
+                if (handle != m_activeRequest)
+                    return;
+                m_generationSeconds = int(elapsedMs / 1000);
+                emit generationSecondsChanged();
+            });
+}
+
+void ChatModel::stopGeneration()
+{
+    if (!m_isWaitingForReply)
+        return;
+    qDebug() << "Generation stopped by the user after" << m_generationSeconds << "s.";
+    if (m_activeRequest)
+        m_activeRequest->cancel(); // La réponse partielle arrive par replyReady
+    else
+        m_stopRequested = true; // Rappel d'archive en cours : rien ne partira
 }
 
 void ChatModel::loadChat(const QString &filePath)
@@ -235,22 +333,45 @@ void ChatModel::loadChat(const QString &filePath)
     // Sauvegarder le chat précédent si un fichier était ouvert
     saveChat();
 
+    // Les lots encore en route de l'ancien journal ne doivent pas arriver ici.
+    m_journalReader->cancel();
+    setLoadingHistory(false);
+
+    TraceScope resetScope("model.reset", "model");
     beginResetModel(); // Réinitialiser le modèle pour le chargement d'un nouveau
     // chat
     m_messages.clear();
+    m_hiddenRows = 0;
+    m_tokenLedger.clear();
     m_liveMemoryTokens = 0;    // Réinitialiser
     m_cumulativeTokenCost = 0; // Réinitialiser
+    m_sessionInputTokens = 0;
+    m_sessionCacheReadTokens = 0;
+    emit cacheHitRateChanged();
     // Abandonner une éventuelle curation en vol : ses messages coupés
     // appartiennent à l'ancien chat (toujours intacts dans son fichier jsonl)
     // et sa réponse tardive sera ignorée grâce aux drapeaux remis à zéro.
     m_pendingCulledMessages.clear();
+    m_pendingRollup = TieredMemory::Rollup();
+    discardPreparedCuration();
     m_isCurationInProgress = false;
     m_isWaitingForCurationResponse = false;
+    m_isStreamingReply = false;
+    ++m_chatGeneration;
     // Vider les anciennes listes
     qDeleteAll(m_managedFiles);
     m_managedFiles.clear();
     m_messages.clear();
 
+    // L'archive du chat s'indexe en tâche de fond pendant le chargement.
+    m_archiveIndex.reset();
+    if (!filePath.isEmpty())
+    {
+        m_archiveIndex = std::make_shared<ArchiveIndex>(ArchiveIndex::archivePathFor(filePath),
+                                                        Embedder::fromSettings());
+        m_archiveIndex->refresh();
+    }
+
     if (filePath.isEmpty())
     {
         qDebug() << "No file path provided to load chat. Starting with an empty chat.";
@@ -262,16 +383,12 @@ void ChatModel::loadChat(const QString &filePath)
     }
 
     QFile file(filePath);
-    if (!file.open(QFile::ReadOnly | QFile::Text))
+    if (!file.exists())
     {
-        qWarning() << "Failed to open chat file for reading:" << filePath;
         // Créer un nouveau fichier si inexistant
-        if (!file.exists())
-        {
-            qDebug() << "Creating new chat file:" << filePath;
-            file.open(QFile::WriteOnly | QFile::Text); // Crée le fichier vide
-            file.close();
-        }
+        qDebug() << "Creating new chat file:" << filePath;
+        file.open(QFile::WriteOnly); // Crée le fichier vide
+        file.close();
         m_currentChatFilePath = filePath;
         endResetModel();
         emit currentChatFilePathChanged();
@@ -279,35 +396,73 @@ void ChatModel::loadChat(const QString &filePath)
         return;
     }
 
-    QTextStream stream(&file);
-    while (!stream.atEnd())
-    {
-        QByteArray line = stream.readLine().toUtf8();
-        QJsonDocument doc = QJsonDocument::fromJson(line);
-        if (!doc.isNull() && doc.isObject())
-        {
-            ChatMessage msg = ChatMessage::fromJsonObject(doc.object());
-            m_messages.append(msg);
-            m_cumulativeTokenCost += msg.promptTokens() + msg.completionTokens();
-        }
-        else
-        {
-            qWarning() << "Skipping malformed JSON line in chat file:" << filePath;
-        }
-    }
-    file.close();
-    updateLiveMemoryEstimate();
-    emit cumulativeTokenCostChanged();
     m_currentChatFilePath = filePath;
     loadManagedFiles(); // Charger la liste des fichiers associés
 
     endResetModel();
 
+    emit cumulativeTokenCostChanged();
     emit currentChatFilePathChanged();
     emit liveMemoryTokensChanged();
-    qDebug() << "Chat loaded from" << filePath << "with" << m_messages.count() << "messages and"
-             << m_liveMemoryTokens << "tokens.";
+
+    // Le journal est lu en tâche de fond (JournalReader), les messages les
+    // plus récents d'abord ; seuls les records après le watermark de l'index
+    // sont chargés, les précédents étant déjà résumés dans la mémoire ancienne.
+    // Envoi et curation attendent la fin du chargement (onJournalLoaded).
+    setLoadingHistory(true);
+    m_journalReader->start(filePath);
+}
+
+void ChatModel::onJournalBatch(const QList<ChatMessage> &messages)
+{
+    if (messages.isEmpty())
+        return;
+
+    // Poids lus dans le journal ; calculés seulement pour les anciens records.
+    QList<ChatMessage> batch = messages;
+    QList<int> weights;
+    weights.reserve(batch.size());
+    for (ChatMessage &msg : batch)
+        weights.append(MemoryCurator::weigh(msg, tokenizer()));
+
+    // Chaque lot précède le précédent dans le journal : insertion en tête. Seules
+    // les lignes qui complètent la fenêtre initiale sont montrées ; les autres
+    // attendent que la vue les demande (fetchMore).
+    const qsizetype shown =
+        m_hiddenRows > 0 ? 0 : qBound<qsizetype>(0, kInitialWindowRows - rowCount(), batch.size());
+    if (shown > 0)
+        beginInsertRows(QModelIndex(), 0, int(shown) - 1);
+    for (int i = batch.size() - 1; i >= 0; --i)
+    {
+        const ChatMessage &msg = batch.at(i);
+        m_cumulativeTokenCost += msg.promptTokens() + msg.completionTokens();
+        m_messages.prepend(msg);
+    }
+    m_hiddenRows += batch.size() - shown;
+    m_tokenLedger.prepend(weights);
+    if (shown > 0)
+        endInsertRows();
+    emit cumulativeTokenCostChanged();
+}
+
+void ChatModel::onJournalLoaded()
+{
+    setLoadingHistory(false);
+    updateLiveMemoryEstimate();
+    emit liveMemoryTokensChanged();
+    qDebug() << "Chat loaded from" << m_currentChatFilePath << "with" << m_messages.count()
+             << "messages and" << m_liveMemoryTokens << "tokens.";
     checkCurationThreshold();
+    schedulePreparation();
+}
+
+void ChatModel::setLoadingHistory(bool loading)
+{
+    if (m_isLoadingHistory != loading)
+    {
+        m_isLoadingHistory = loading;
+        emit isLoadingHistoryChanged();
+    }
 }
 
 void ChatModel::saveChat()
@@ -324,35 +479,34 @@ void ChatModel::saveChat()
 
 void ChatModel::clearChat()
 {
+    m_journalReader->cancel();
+    setLoadingHistory(false);
+
     if (m_messages.isEmpty())
         return;
 
-    beginRemoveRows(QModelIndex(), 0, m_messages.count() - 1);
+    const bool hasRows = rowCount() > 0;
+    if (hasRows)
+        beginRemoveRows(QModelIndex(), 0, rowCount() - 1);
     m_messages.clear();
-    endRemoveRows();
+    m_hiddenRows = 0;
+    m_tokenLedger.clear();
+    if (hasRows)
+        endRemoveRows();
 
     // L'utilisateur efface tout : la curation en vol (et ses messages coupés)
     // n'a plus d'objet, et sa réponse tardive sera ignorée.
     m_pendingCulledMessages.clear();
+    m_pendingRollup = TieredMemory::Rollup();
+    discardPreparedCuration();
     m_isCurationInProgress = false;
     m_isWaitingForCurationResponse = false;
+    m_isStreamingReply = false;
+    ++m_chatGeneration;
 
-    // Effacer le fichier local associé
+    // Effacer le fichier local associé (et son index)
     if (!m_currentChatFilePath.isEmpty())
-    {
-        QFile file(m_currentChatFilePath);
-        if (file.exists())
-        {
-            if (file.remove())
-            {
-                qDebug() << "Chat file removed:" << m_currentChatFilePath;
-            }
-            else
-            {
-                qWarning() << "Failed to remove chat file:" << m_currentChatFilePath;
-            }
-        }
-    }
+        JournalFile(m_currentChatFilePath).remove();
     m_liveMemoryTokens = 0;
     emit liveMemoryTokensChanged();
 }
@@ -382,17 +536,24 @@ void ChatModel::resetTokenCost()
 {
     qDebug() << "Resetting cumulative token cost.";
     m_cumulativeTokenCost = 0;
+    m_sessionInputTokens = 0;
+    m_sessionCacheReadTokens = 0;
     emit cumulativeTokenCostChanged();
+    emit cacheHitRateChanged();
+}
+
+double ChatModel::cacheHitRate() const
+{
+    if (m_sessionInputTokens <= 0)
+        return 0.0;
+    return double(m_sessionCacheReadTokens) / double(m_sessionInputTokens);
 }
 void ChatModel::updateLiveMemoryEstimate()
 {
     // Cette fonction est maintenant une estimation pour l'état initial.
     // La vraie valeur sera corrigée au premier appel API.
-    int estimatedTokens = 15; // System prompt
-    for (const auto &msg : m_messages)
-    {
-        estimatedTokens += msg.text().length() / 4;
-    }
+    // Somme des poids des messages, tenue à jour par m_tokenLedger.
+    int estimatedTokens = 15 + int(m_tokenLedger.total()); // + system prompt
 
     if (m_liveMemoryTokens != estimatedTokens)
     {
@@ -402,6 +563,11 @@ void ChatModel::updateLiveMemoryEstimate()
     }
 }
 
+const Tokenizer &ChatModel::tokenizer() const
+{
+    return m_interlocutor ? m_interlocutor->tokenizer() : *Tokenizer::approximate();
+}
+
 void ChatModel::checkCurationThreshold()
 {
     int effectiveTrigger = m_curationTriggerTokenCount;
@@ -416,7 +582,7 @@ void ChatModel::checkCurationThreshold()
 
     qDebug() << "There are currently" << m_liveMemoryTokens << "in the live memory. Trigger is"
              << effectiveTrigger << "(Extended:" << m_extendedContextEnabled << ")";
-    if (m_liveMemoryTokens >= effectiveTrigger && !m_isCurationInProgress)
+    if (m_liveMemoryTokens >= effectiveTrigger && !m_isCurationInProgress && !m_isLoadingHistory)
     {
         qDebug() << "Curation threshold reached! Live memory size:" << m_liveMemoryTokens;
         emit curationNeeded();
@@ -428,26 +594,64 @@ void ChatModel::onInterlocutorReply(const InterlocutorReply &reply)
     qDebug() << "ChatModel::onInterlocutorReply" << reply.text;
     if (reply.kind == InterlocutorReply::Kind::CurationResult)
     {
-        if (!m_isWaitingForCurationResponse)
-        {
-            qWarning() << "Received CurationResult but was not waiting for one! Ignoring.";
-            return;
-        }
-        m_isWaitingForCurationResponse = false;
-        m_isCurationInProgress = false;
-        handleCurationReply(reply);
+        onCuratorReply(reply);
         return;
     }
 
     handleNormalReply(reply);
 }
 
+void ChatModel::onCuratorReply(const InterlocutorReply &reply)
+{
+    if (m_isPreparingCuration)
+    {
+        handlePreparedReply(reply);
+        return;
+    }
+    if (!m_isWaitingForCurationResponse)
+    {
+        qWarning() << "Received CurationResult but was not waiting for one! Ignoring.";
+        return;
+    }
+    // m_isCurationInProgress reste levé jusqu'à la sauvegarde du résumé.
+    m_isWaitingForCurationResponse = false;
+    handleCurationReply(reply);
+}
+
+void ChatModel::onInterlocutorChunk(const QString &delta, InterlocutorReply::Kind kind)
+{
+    // Seules les réponses normales sont affichées au fil de l'eau ; la curation
+    // attend son résultat complet.
+    if (kind != InterlocutorReply::Kind::NormalMessage || m_messages.isEmpty())
+        return;
+
+    ChatMessage &lastMsg = m_messages.last();
+    const QModelIndex idx = index(rowCount() - 1);
+
+    if (!m_isStreamingReply)
+    {
+        // Premier chunk : le typing indicator devient la bulle de la réponse.
+        if (!lastMsg.isTypingIndicator())
+            return; // Chunk tardif d'une requête abandonnée (chat changé, effacé...)
+        m_isStreamingReply = true;
+        lastMsg.setIsTypingIndicator(false);
+        lastMsg.setTimestamp(QDateTime::currentDateTime());
+        lastMsg.setText(delta);
+        emit dataChanged(idx, idx, {TextRole, TimestampRole, IsTypingIndicatorRole});
+        return;
+    }
+
+    lastMsg.appendText(delta);
+    emit dataChanged(idx, idx, {TextRole});
+}
+
 void ChatModel::removeTypingIndicator(void)
 {
-    if (!m_messages.isEmpty() && m_messages.last().isTypingIndicator)
+    if (!m_messages.isEmpty() && m_messages.last().isTypingIndicator())
     {
-        beginRemoveRows(QModelIndex(), m_messages.count() - 1, m_messages.count() - 1);
+        beginRemoveRows(QModelIndex(), rowCount() - 1, rowCount() - 1);
         m_messages.removeLast();
+        m_tokenLedger.removeLast();
         endRemoveRows();
     }
     setWaitingForReply(false);
@@ -456,25 +660,42 @@ void ChatModel::removeTypingIndicator(void)
 void ChatModel::onInterlocutorError(const QString &message)
 {
     qWarning() << "Chat error:" << message;
-    m_isWaitingForReply = false;
-    if (m_isCurationInProgress)
+    if (curator() == m_interlocutor && (m_isPreparingCuration || m_isWaitingForCurationResponse))
     {
-        // L'erreur peut venir de la requête de curation : on restaure les
-        // messages coupés (le fichier jsonl n'a pas encore été réécrit) pour
-        // qu'ils ne soient perdus ni du contexte ni du disque — notamment via
-        // le rewriteChatFile() en fin de cette méthode.
-        restoreCulledMessages();
-        emit curationFinished(false);
+        // Chat et curation sur le même interlocuteur : l'erreur ne dit pas de
+        // quelle requête elle vient, la curation en vol est abandonnée dans
+        // tous les cas. S'il n'y avait qu'elle, le chat n'est pas concerné.
+        failCurationRequest();
+        if (!m_isWaitingForReply && !m_isStreamingReply)
+            return;
     }
-    m_isCurationInProgress = false;
-    m_isWaitingForCurationResponse = false;
+    failPendingReply(message);
+}
+
+// Retire la réponse en attente (typing indicator ou bulle partielle) ; le
+// message de l'utilisateur reste affiché, en erreur, suivi de `message`.
+void ChatModel::failPendingReply(const QString &message)
+{
     removeTypingIndicator();
+    if (m_isStreamingReply)
+    {
+        // Réponse interrompue en cours de streaming : la bulle partielle n'a
+        // jamais été persistée, on la retire.
+        m_isStreamingReply = false;
+        beginRemoveRows(QModelIndex(), rowCount() - 1, rowCount() - 1);
+        m_messages.removeLast();
+        m_tokenLedger.removeLast();
+        endRemoveRows();
+    }
 
     if (!m_messages.isEmpty()) {
         ChatMessage &lastMsg = m_messages.last();
-        if (lastMsg.isLocalMessage()) {
+        if (lastMsg.isLocalMessage() && !lastMsg.isError()) {
+            // Le message sans réponse sort du journal : simple troncature de
+            // son record (c'est forcément le dernier du fichier).
+            JournalFile(m_currentChatFilePath).dropLastRecord(lastMsg);
             lastMsg.setIsError(true);
-            QModelIndex idx = index(m_messages.count() - 1);
+            QModelIndex idx = index(rowCount() - 1);
             emit dataChanged(idx, idx, {IsErrorRole});
         }
     }
@@ -484,12 +705,19 @@ void ChatModel::onInterlocutorError(const QString &message)
                              "system", // ou "assistant"
                              true);    // isError = true
     addMessage(errorMessage);
-
-    rewriteChatFile();
 }
 
 void ChatModel::handleNormalReply(const InterlocutorReply &reply)
 {
+    if (reply.wasCancelled && reply.text.trimmed().isEmpty())
+    {
+        // Arrêtée avant le premier mot : comme une erreur, sans réponse
+        m_cumulativeTokenCost += reply.totalTokens;
+        emit cumulativeTokenCostChanged();
+        failPendingReply("Stopped before any reply.");
+        return;
+    }
+
     // 1) Enlever le typing indicator
     removeTypingIndicator();
 
@@ -498,7 +726,7 @@ void ChatModel::handleNormalReply(const InterlocutorReply &reply)
 
     // 2a. Mettre à jour la taille de la Mémoire Vive pour la curation
     int newLiveMemorySize = reply.inputTokens + reply.outputTokens;
-    if (m_liveMemoryTokens != newLiveMemorySize)
+    if (reply.inputTokens > 0 && m_liveMemoryTokens != newLiveMemorySize)
     {
         m_liveMemoryTokens = newLiveMemorySize;
         emit liveMemoryTokensChanged();
@@ -510,22 +738,51 @@ void ChatModel::handleNormalReply(const InterlocutorReply &reply)
     emit cumulativeTokenCostChanged();
     qDebug() << "Cumulative token cost is now:" << m_cumulativeTokenCost;
 
+    // 2c. Cache de préfixe du fournisseur
+    m_sessionInputTokens += reply.inputTokens;
+    m_sessionCacheReadTokens += reply.cacheReadTokens;
+    emit cacheHitRateChanged();
+    qDebug() << "Prompt cache: read" << reply.cacheReadTokens << "written"
+             << reply.cacheWriteTokens << "of" << reply.inputTokens << "input tokens.";
+
     // 3) Créer un ChatMessage côté assistant avec reply.text
     // OU fusionner avec le précédent si on attend une suite
+    // OU finaliser la bulle remplie par les chunks du streaming
 
-    if (m_expectingContinuation && !m_messages.isEmpty() &&
-        m_messages.last().role() == "assistant" && !m_messages.last().isTypingIndicator)
+    if (m_isStreamingReply && !m_messages.isEmpty())
+    {
+        // Le texte final fait foi : il a été nettoyé (notes) par l'interlocuteur.
+        m_isStreamingReply = false;
+        ChatMessage &lastMsg = m_messages.last();
+        lastMsg.setText(reply.text);
+        lastMsg.setTimestamp(QDateTime::currentDateTime());
+        lastMsg.setPromptTokens(reply.inputTokens);
+        lastMsg.setCompletionTokens(reply.outputTokens);
+        lastMsg.setServerLatencyMs(int(reply.serverLatencyMs()));
+        lastMsg.setTokensPerSecond(reply.tokensPerSecond());
+        m_tokenLedger.setLast(MemoryCurator::weigh(lastMsg, tokenizer()));
+        QModelIndex idx = index(rowCount() - 1);
+        emit dataChanged(idx, idx,
+                         {TextRole, TimestampRole, PromptTokensRole, CompletionTokensRole});
+
+        // 4) Persister la ligne jsonl, maintenant que la réponse est complète
+        appendToChatFile(lastMsg);
+        emit chatMessageAdded(lastMsg);
+    }
+    else if (m_expectingContinuation && !m_messages.isEmpty() &&
+        m_messages.last().isAssistant() && !m_messages.last().isTypingIndicator())
     {
         // Fusionner
         qDebug() << "Merging continuation message...";
         ChatMessage &lastMsg = m_messages.last();
-        lastMsg.setText(lastMsg.text() + reply.text);
+        lastMsg.appendText(reply.text);
         lastMsg.setCompletionTokens(lastMsg.completionTokens() + reply.outputTokens);
+        m_tokenLedger.setLast(MemoryCurator::weigh(lastMsg, tokenizer()));
         // On pourrait aussi mettre à jour promptTokens si ça change, mais
         // généralement c'est le même contexte ou accumulé.
 
         // Notifier la vue que les données ont changé
-        QModelIndex idx = index(m_messages.count() - 1);
+        QModelIndex idx = index(rowCount() - 1);
         emit dataChanged(idx, idx, {TextRole, CompletionTokensRole});
 
         // Mettre à jour le fichier jsonl ?
@@ -533,21 +790,28 @@ void ChatModel::handleNormalReply(const InterlocutorReply &reply)
         // Idéalement on devrait réécrire la dernière ligne ou tout le fichier.
         // Pour l'instant, on accepte que le fichier jsonl ait deux entrées séparées
         // (ce qui n'est pas grave, au rechargement ce sera deux messages) OU on
-        // peut appeler rewriteChatFile() si on veut être propre. rewriteChatFile();
-        // // Un peu lourd à chaque chunk.
+        // peut remplacer le dernier record (JournalFile::dropLastRecord() puis
+        // append()) si on veut être propre.
     }
     else
     {
         // Nouveau message
         ChatMessage aiMessage(false, reply.text, QDateTime::currentDateTime(), reply.inputTokens,
                               reply.outputTokens, "assistant");
+        aiMessage.setServerLatencyMs(int(reply.serverLatencyMs()));
+        aiMessage.setTokensPerSecond(reply.tokensPerSecond());
 
         // 4) L'ajouter à la liste + jsonl
         addMessage(aiMessage);
     }
 
-    // Mise à jour de l'état d'attente
-    if (reply.isIncomplete)
+    // Arrêtée avant que le fournisseur ne donne l'usage : estimation
+    if (reply.inputTokens == 0)
+        updateLiveMemoryEstimate();
+
+    // Mise à jour de l'état d'attente. Une réponse arrêtée par l'utilisateur
+    // est incomplète, mais n'attend pas de suite.
+    if (reply.isIncomplete && !reply.wasCancelled)
     {
         m_expectingContinuation = true;
         // On ne remet PAS waitingForReply à true car on a déjà reçu quelque chose,
@@ -562,9 +826,16 @@ void ChatModel::handleNormalReply(const InterlocutorReply &reply)
     // 5) Recalculer liveMemoryTokens + checkCurationThreshold()
     // L'estimation n'est plus nécessaire ici, la valeur exacte vient d'être mise
     // à jour. On lance juste la vérification.
-    if (!reply.isIncomplete)
+    if (reply.wasCancelled)
     {
+        // Les pièces jointes restent, pour un nouvel essai
         checkCurationThreshold();
+        schedulePreparation();
+    }
+    else if (!reply.isIncomplete)
+    {
+        checkCurationThreshold();
+        schedulePreparation();
 
         // Clear all attached files now that the response is complete
         while (!m_managedFiles.isEmpty())
@@ -574,12 +845,60 @@ void ChatModel::handleNormalReply(const InterlocutorReply &reply)
     }
 }
 
+void ChatModel::onCuratorError(const QString &message)
+{
+    qWarning() << "Curation error:" << message;
+    failCurationRequest();
+}
+
+void ChatModel::failCurationRequest()
+{
+    if (m_isPreparingCuration)
+    {
+        // La préparation n'engage rien ; si le seuil a été atteint pendant
+        // qu'elle tournait, la curation ordinaire prend le relais.
+        qWarning() << "Curation preparation abandoned.";
+        const bool commitWanted = m_commitWhenPrepared;
+        discardPreparedCuration();
+        if (commitWanted)
+        {
+            m_isCurationInProgress = false;
+            QTimer::singleShot(0, this, &ChatModel::checkCurationThreshold);
+        }
+        return;
+    }
+    if (!m_isWaitingForCurationResponse)
+        return;
+    m_isWaitingForCurationResponse = false;
+    m_isCurationInProgress = false;
+    if (!m_pendingRollup.isNull())
+    {
+        // Fusion échouée : la mémoire reste valide, juste au-dessus de sa
+        // limite ; la prochaine curation retentera.
+        qWarning() << "Memory rollup failed; retried at the next curation.";
+        m_pendingRollup = TieredMemory::Rollup();
+        return;
+    }
+    // On restaure les messages coupés (le watermark du journal n'a pas encore
+    // avancé) pour qu'ils ne soient pas perdus du contexte. Une fois la
+    // réponse reçue, seule la sauvegarde du résumé décide (finishCuration).
+    restoreCulledMessages();
+    emit curationFinished(false);
+}
+
 void ChatModel::handleCurationReply(const InterlocutorReply &reply)
 {
+    if (!m_pendingRollup.isNull())
+    {
+        handleRollupReply(reply);
+        return;
+    }
+
     if (reply.isIncomplete)
     {
         qWarning() << "Curation failed: response was incomplete (reason:" << reply.text
                    << "). Restoring culled messages to prevent memory loss.";
+        m_isCurationInProgress = false;
         restoreCulledMessages();
         emit curationFinished(false);
         return;
@@ -589,13 +908,43 @@ void ChatModel::handleCurationReply(const InterlocutorReply &reply)
     if (newSummary.isEmpty())
     {
         qWarning() << "Curation failed: empty summary. Restoring culled messages.";
+        m_isCurationInProgress = false;
         restoreCulledMessages();
         emit curationFinished(false);
         return;
     }
 
-    if (!saveOlderMemory(newSummary))
+    commitEpisode(newSummary);
+}
+
+void ChatModel::commitEpisode(const QString &newSummary)
+{
+    // Le résumé devient un nouvel épisode de la mémoire, écrite sur l'IoWorker ;
+    // la suite attend son résultat. Si le chat a changé entre-temps, on ne
+    // touche à rien : au pire les messages coupés restent aussi dans le
+    // journal, jamais perdus.
+    TieredMemory memory = MemoryCurator::loadMemory(getOlderMemoryFilePath());
+    memory.addEpisode(newSummary, m_pendingCulledMessages.first().timestamp(),
+                      m_pendingCulledMessages.last().timestamp(), tokenizer());
+    const quint64 generation = m_chatGeneration;
+    saveOlderMemory(memory,
+                    [this, generation, newSummary](bool saved)
+                    {
+                        if (generation != m_chatGeneration)
+                        {
+                            qDebug() << "Chat changed while saving the curated memory; "
+                                        "journal left as is.";
+                            return;
+                        }
+                        finishCuration(saved, newSummary);
+                    });
+}
+
+void ChatModel::finishCuration(bool saved, const QString &newSummary)
+{
+    if (!saved)
     {
+        m_isCurationInProgress = false;
         qWarning() << "Curation failed: could not save older memory. Restoring culled messages.";
         restoreCulledMessages();
         emit curationFinished(false);
@@ -607,10 +956,80 @@ void ChatModel::handleCurationReply(const InterlocutorReply &reply)
     }
 
     // Le résumé est en sécurité : on peut maintenant retirer les messages
-    // coupés du fichier jsonl.
+    // coupés du journal, en avançant son watermark (les messages d'erreur,
+    // jamais persistés, ne comptent pas). Ils sont d'abord recopiés dans
+    // l'archive : l'IoWorker les y écrit avant de toucher au watermark.
+    int culledRecords = 0;
+    JournalFile archive(m_archiveIndex ? m_archiveIndex->archivePath() : QString());
+    for (const ChatMessage &msg : std::as_const(m_pendingCulledMessages))
+    {
+        if (!msg.isError() && !msg.isTypingIndicator())
+        {
+            archive.append(msg);
+            ++culledRecords;
+        }
+    }
+    if (m_archiveIndex && culledRecords > 0)
+        m_archiveIndex->refresh();
     m_pendingCulledMessages.clear();
-    rewriteChatFile();
+    if (culledRecords > 0)
+        JournalFile(m_currentChatFilePath).cull(culledRecords);
     emit curationFinished(true);
+    startRollup();
+}
+
+void ChatModel::startRollup()
+{
+    const TieredMemory::Limits limits = TieredMemory::Limits::fromSettings();
+    const TieredMemory memory = MemoryCurator::loadMemory(getOlderMemoryFilePath());
+    const TieredMemory::Rollup rollup = memory.nextRollup(limits);
+    if (rollup.isNull() || !curator())
+    {
+        m_isCurationInProgress = false;
+        return;
+    }
+
+    qDebug() << "Memory rollup:" << rollup.sources.count()
+             << (rollup.target == TieredMemory::Level::Era ? "episodes into an era"
+                                                           : "eras into the core profile");
+    m_pendingRollup = rollup;
+    QList<ChatMessage> rollupHistory;
+    rollupHistory.append(ChatMessage(
+        true, MemoryCurator::buildRollupMessage(rollup, memory.core(), limits.coreTokens),
+        QDateTime::currentDateTime(), 0, 0, "user"));
+    m_isWaitingForCurationResponse = true;
+    curator()->sendRequest(rollupHistory, MemoryCurator::systemPrompt(),
+                                InterlocutorReply::Kind::CurationResult, QStringList());
+}
+
+void ChatModel::handleRollupReply(const InterlocutorReply &reply)
+{
+    const TieredMemory::Rollup rollup = m_pendingRollup;
+    m_pendingRollup = TieredMemory::Rollup();
+    const QString summary = reply.text.trimmed();
+    TieredMemory memory = MemoryCurator::loadMemory(getOlderMemoryFilePath());
+    if (reply.isIncomplete || summary.isEmpty() || !memory.applyRollup(rollup, summary, tokenizer()))
+    {
+        // Rien n'est perdu : les résumés à fusionner sont toujours là.
+        qWarning() << "Memory rollup failed (incomplete, empty or memory changed meanwhile).";
+        m_isCurationInProgress = false;
+        return;
+    }
+
+    const quint64 generation = m_chatGeneration;
+    saveOlderMemory(memory,
+                    [this, generation](bool saved)
+                    {
+                        if (generation != m_chatGeneration)
+                            return;
+                        if (!saved)
+                        {
+                            qWarning() << "Memory rollup could not be saved.";
+                            m_isCurationInProgress = false;
+                            return;
+                        }
+                        startRollup(); // Un niveau peut en faire déborder un autre
+                    });
 }
 
 void ChatModel::restoreCulledMessages()
@@ -620,14 +1039,24 @@ void ChatModel::restoreCulledMessages()
 
     qDebug() << "Restoring" << m_pendingCulledMessages.count()
              << "culled messages into live memory.";
-    beginInsertRows(QModelIndex(), 0, m_pendingCulledMessages.count() - 1);
-    for (int i = m_pendingCulledMessages.size() - 1; i >= 0; --i)
+    QList<int> weights;
+    weights.reserve(m_pendingCulledMessages.size());
+    for (ChatMessage &msg : m_pendingCulledMessages)
     {
-        const ChatMessage &msg = m_pendingCulledMessages.at(i);
-        m_liveMemoryTokens += MemoryCurator::estimateMessageTokens(msg);
-        m_messages.prepend(msg);
+        weights.append(MemoryCurator::weigh(msg, tokenizer()));
+        m_liveMemoryTokens += weights.last();
     }
-    endInsertRows();
+    // Ils reprennent leur place : visibles si la fenêtre montrait tout, cachés
+    // sinon (plus anciens que les messages déjà cachés).
+    const bool shown = m_hiddenRows == 0;
+    if (shown)
+        beginInsertRows(QModelIndex(), 0, m_pendingCulledMessages.count() - 1);
+    else
+        m_hiddenRows += m_pendingCulledMessages.count();
+    m_messages = m_pendingCulledMessages + m_messages;
+    m_tokenLedger.prepend(weights);
+    if (shown)
+        endInsertRows();
     m_pendingCulledMessages.clear();
     emit liveMemoryTokensChanged();
 }
@@ -639,6 +1068,8 @@ void ChatModel::setInterlocutor(Interlocutor *interlocutor)
     {
         disconnect(m_interlocutor, &Interlocutor::replyReady, this,
                    &ChatModel::onInterlocutorReply);
+        disconnect(m_interlocutor, &Interlocutor::replyChunk, this,
+                   &ChatModel::onInterlocutorChunk);
         disconnect(m_interlocutor, &Interlocutor::errorOccurred, this,
                    &ChatModel::onInterlocutorError);
         disconnect(m_interlocutor, &Interlocutor::fileUploaded, this, &ChatModel::onFileUploaded);
@@ -652,7 +1083,9 @@ void ChatModel::setInterlocutor(Interlocutor *interlocutor)
     // Connecter le nouvel interlocuteur s'il n'est pas nul
     if (m_interlocutor)
     {
+        m_interlocutor->setStreamingEnabled(m_streamingEnabled);
         connect(m_interlocutor, &Interlocutor::replyReady, this, &ChatModel::onInterlocutorReply);
+        connect(m_interlocutor, &Interlocutor::replyChunk, this, &ChatModel::onInterlocutorChunk);
         connect(m_interlocutor, &Interlocutor::errorOccurred, this,
                 &ChatModel::onInterlocutorError);
         connect(m_interlocutor, &Interlocutor::fileUploaded, this, &ChatModel::onFileUploaded,
@@ -664,32 +1097,25 @@ void ChatModel::setInterlocutor(Interlocutor *interlocutor)
     }
 }
 
-void ChatModel::rewriteChatFile()
+void ChatModel::setCurator(Interlocutor *curator)
 {
-    if (m_currentChatFilePath.isEmpty())
-    {
-        return; // Pas de fichier à réécrire
-    }
-
-    QFile file(m_currentChatFilePath);
-    // On ouvre en mode écriture seule, ce qui tronque (efface) le fichier
-    // existant.
-    if (!file.open(QFile::WriteOnly | QFile::Text))
+    if (m_curator)
     {
-        qWarning() << "Failed to open chat file for rewriting:" << m_currentChatFilePath;
-        return;
+        disconnect(m_curator, &Interlocutor::replyReady, this, &ChatModel::onCuratorReply);
+        disconnect(m_curator, &Interlocutor::errorOccurred, this, &ChatModel::onCuratorError);
     }
+    // Changer de curateur abandonne la curation en vol (sa réponse ne
+    // viendra plus) : les messages coupés reviennent dans le contexte.
+    if (m_curator != curator)
+        failCurationRequest();
 
-    QTextStream stream(&file);
-    for (const ChatMessage &message : m_messages)
+    m_curator = curator;
+    if (m_curator)
     {
-        if (!message.isError())
-        {
-            stream << QJsonDocument(message.toJsonObject()).toJson(QJsonDocument::Compact) << "\n";
-        }
+        m_curator->setStreamingEnabled(false);
+        connect(m_curator, &Interlocutor::replyReady, this, &ChatModel::onCuratorReply);
+        connect(m_curator, &Interlocutor::errorOccurred, this, &ChatModel::onCuratorError);
     }
-    file.close();
-    qDebug() << "Chat file rewritten successfully:" << m_currentChatFilePath;
 }
 
 void ChatModel::triggerCuration()
@@ -698,56 +1124,185 @@ void ChatModel::triggerCuration()
         return;
     qDebug() << "Starting curation process... TargetTokens=" << m_curationTargetTokenCount;
     m_isCurationInProgress = true;
+    m_prepareTimer->stop();
 
-    // Cull en mémoire seulement : le fichier jsonl n'est réécrit qu'après un
-    // résumé sauvegardé avec succès (handleCurationReply), pour ne jamais
-    // perdre de contenu sans résumé. Même schéma que DuoChatModel.
-    m_pendingCulledMessages.clear();
-    while (m_liveMemoryTokens > m_curationTargetTokenCount && !m_messages.isEmpty())
+    // Un résumé préparé en avance n'attend que d'être validé ; s'il est encore
+    // en route, on l'attend plutôt que d'en demander un second.
+    if (m_isPreparingCuration)
     {
-        ChatMessage msg = m_messages.first();
-        m_pendingCulledMessages.append(msg);
-        m_liveMemoryTokens -= MemoryCurator::estimateMessageTokens(msg);
-        m_messages.removeFirst();
+        qDebug() << "Waiting for the curation being prepared.";
+        m_commitWhenPrepared = true;
+        return;
     }
+    if (commitPreparedCuration())
+        return;
 
-    if (!m_pendingCulledMessages.isEmpty())
-    {
-        qDebug() << "Culling" << m_pendingCulledMessages.count() << "messages from live memory.";
-        beginRemoveRows(QModelIndex(), 0, m_pendingCulledMessages.count() - 1);
-        endRemoveRows();
-        emit liveMemoryTokensChanged();
-    }
-    else
+    // Cull en mémoire seulement : le watermark du journal n'avance qu'après un
+    // résumé sauvegardé avec succès (handleCurationReply), pour ne jamais
+    // perdre de contenu sans résumé. Même schéma que GroupChatModel.
+    // Point de coupe : les plus anciens messages dont les poids couvrent
+    // l'excédent sur la cible, trouvés par recherche dichotomique dans les
+    // sommes préfixes, puis retirés d'un seul bloc.
+    m_pendingCulledMessages.clear();
+    const qsizetype cullCount = m_tokenLedger.countCovering(
+        qint64(m_liveMemoryTokens) - m_curationTargetTokenCount);
+    if (cullCount == 0)
     {
         qWarning() << "Curation triggered, but no messages to cull. Aborting.";
         m_isCurationInProgress = false;
         return;
     }
 
-    // --- Phase 2: Préparation de la requête de résumé (logique partagée avec
-    // DuoChatModel via MemoryCurator)
-    QString olderMemory = loadOlderMemory();
-    QString conversationToSummarize = MemoryCurator::transcriptToText(m_pendingCulledMessages);
-    // m_messages contient la Live Memory restante
-    QString recentContext = MemoryCurator::transcriptToText(m_messages);
+    qDebug() << "Culling" << cullCount << "messages from live memory.";
+    cullHead(cullCount);
 
-    QList<ChatMessage> curationHistory;
-    QString curationUserMessage =
-        MemoryCurator::buildUserMessage(recentContext, conversationToSummarize, olderMemory);
+    // --- Phase 2 et 3: requête de résumé (logique partagée avec GroupChatModel
+    // via MemoryCurator) ; m_messages contient la Live Memory restante.
+    qDebug() << "Sending request for curation summary...";
+    m_isWaitingForCurationResponse = true; // On lève le drapeau
+    curator()->sendRequest(episodeRequest(m_pendingCulledMessages, m_messages),
+                                MemoryCurator::systemPrompt(),
+                                InterlocutorReply::Kind::CurationResult, QStringList());
+}
 
+void ChatModel::cullHead(qsizetype count)
+{
+    const qint64 culledTokens = m_tokenLedger.sumFirst(count);
+    // Les plus anciens sont peut-être encore cachés : seules les lignes
+    // visibles sortent de la vue.
+    const qsizetype hiddenCulled = qMin(count, m_hiddenRows);
+    const qsizetype shownCulled = count - hiddenCulled;
+    if (shownCulled > 0)
+        beginRemoveRows(QModelIndex(), 0, int(shownCulled) - 1);
+    m_pendingCulledMessages = m_messages.first(count);
+    m_messages.remove(0, count);
+    m_hiddenRows -= hiddenCulled;
+    m_tokenLedger.removeFirst(count);
+    if (shownCulled > 0)
+        endRemoveRows();
+    m_liveMemoryTokens -= int(culledTokens);
+    emit liveMemoryTokensChanged();
+}
+
+QList<ChatMessage> ChatModel::episodeRequest(const QList<ChatMessage> &culled,
+                                             const QList<ChatMessage> &recent) const
+{
+    // Seuls le noyau et les derniers résumés accompagnent les messages coupés :
+    // le coût ne croît pas avec la mémoire.
+    const QString olderMemory = MemoryCurator::loadMemory(getOlderMemoryFilePath())
+                                    .render(TieredMemory::Limits::fromSettings().coreTokens);
+    const QString curationUserMessage = MemoryCurator::buildUserMessage(
+        MemoryCurator::transcriptToText(recent), MemoryCurator::transcriptToText(culled),
+        olderMemory);
     qDebug() << "curationUserMessage=" << curationUserMessage;
 
+    QList<ChatMessage> curationHistory;
     curationHistory.append(
         ChatMessage(true, curationUserMessage, QDateTime::currentDateTime(), 0, 0, "user"));
+    return curationHistory;
+}
 
-    // --- Phase 3: Appel à l'IA ---
-    qDebug() << "Sending request for curation summary...";
-    m_isWaitingForCurationResponse = true; // On lève le drapeau
-    m_interlocutor->sendRequest(curationHistory, MemoryCurator::systemPrompt(),
+void ChatModel::schedulePreparation()
+{
+    // Seuil bas : une fraction du seuil de curation ("curation/prepareRatio",
+    // 0 pour désactiver). La préparation attend un temps mort.
+    QSettings settings("Tether", "ChatApp");
+    const double ratio = settings.value("curation/prepareRatio", 0.8).toDouble();
+    if (ratio <= 0 || m_isCurationInProgress || m_isPreparingCuration || m_isLoadingHistory ||
+        !m_preparedSummary.isEmpty() || m_liveMemoryTokens < ratio * m_curationTriggerTokenCount)
+        return;
+    m_prepareTimer->start(qMax(0, settings.value("curation/prepareIdleMs", 4000).toInt()));
+}
+
+void ChatModel::prepareCuration()
+{
+    if (!curator() || m_isWaitingForReply || m_isCurationInProgress || m_isPreparingCuration ||
+        m_isLoadingHistory)
+        return;
+
+    // Segment que la coupe retirera au plus tôt : au seuil, l'excédent sur la
+    // cible vaut au moins (seuil - cible).
+    const qsizetype count = m_tokenLedger.countCovering(
+        qint64(m_curationTriggerTokenCount) - m_curationTargetTokenCount);
+    if (count == 0 || count >= m_messages.size())
+        return;
+
+    qDebug() << "Preparing the next curation:" << count << "messages.";
+    m_preparedSegment = m_messages.first(count);
+    m_isPreparingCuration = true;
+    curator()->sendRequest(episodeRequest(m_preparedSegment, m_messages.mid(count)),
+                                MemoryCurator::systemPrompt(),
                                 InterlocutorReply::Kind::CurationResult, QStringList());
 }
 
+void ChatModel::handlePreparedReply(const InterlocutorReply &reply)
+{
+    m_isPreparingCuration = false;
+    const QString summary = reply.text.trimmed();
+    if (reply.isIncomplete || summary.isEmpty())
+    {
+        qWarning() << "Curation preparation failed (incomplete or empty); discarded.";
+        m_preparedSegment.clear();
+    }
+    else
+    {
+        m_preparedSummary = summary;
+    }
+
+    if (m_commitWhenPrepared)
+    {
+        // Le seuil a été atteint entre-temps : la curation reprend, avec ce
+        // résumé s'il est valable.
+        m_commitWhenPrepared = false;
+        m_isCurationInProgress = false;
+        triggerCuration();
+    }
+}
+
+bool ChatModel::commitPreparedCuration()
+{
+    if (m_preparedSummary.isEmpty())
+        return false;
+    const QList<ChatMessage> segment = m_preparedSegment;
+    const QString summary = m_preparedSummary;
+    discardPreparedCuration();
+
+    // Le segment doit toujours être la tête du contexte, intact (pas de
+    // message modifié ou supprimé depuis), et sa coupe suffire à repasser
+    // sous le seuil.
+    const qsizetype count = segment.size();
+    bool unchanged = count < m_messages.size();
+    for (qsizetype i = 0; unchanged && i < count; ++i)
+    {
+        const ChatMessage &current = m_messages.at(i);
+        unchanged = current.timestampMs() == segment.at(i).timestampMs() &&
+                    current.isTextEscaped() == segment.at(i).isTextEscaped() &&
+                    current.textBytes() == segment.at(i).textBytes() &&
+                    current.isLocalMessage() == segment.at(i).isLocalMessage();
+    }
+    if (!unchanged ||
+        m_liveMemoryTokens - m_tokenLedger.sumFirst(count) >= m_curationTriggerTokenCount)
+    {
+        qDebug() << "Prepared curation no longer matches the context; discarded.";
+        return false;
+    }
+
+    qDebug() << "Committing the prepared curation of" << count << "messages.";
+    cullHead(count);
+    commitEpisode(summary);
+    return true;
+}
+
+void ChatModel::discardPreparedCuration()
+{
+    // Une réponse encore en vol sera ignorée (plus rien n'est attendu).
+    m_prepareTimer->stop();
+    m_isPreparingCuration = false;
+    m_commitWhenPrepared = false;
+    m_preparedSegment.clear();
+    m_preparedSummary.clear();
+}
+
 InterlocutorConfig *ChatModel::findCurrentConfig()
 {
     QObject *parentObj = parent();
@@ -767,19 +1322,102 @@ QString ChatModel::getOlderMemoryFilePath() const
     if (m_currentChatFilePath.isEmpty())
         return "";
     // On base le nom du fichier de mémoire sur celui du chat
-    // ex: "default_chat.jsonl" -> "default_chat_memory.txt"
+    // ex: "default_chat.jsonl" -> "default_chat_memory.json"
     QFileInfo fileInfo(m_currentChatFilePath);
-    return fileInfo.path() + "/" + fileInfo.baseName() + "_memory.txt";
+    return fileInfo.path() + "/" + fileInfo.baseName() + "_memory.json";
+}
+
+void ChatModel::sendWithRecall(QList<ChatMessage> history, const QString &ancientMemory,
+                               const QStringList &attachments)
+{
+    QSettings settings("Tether", "ChatApp");
+    const int maxPassages = settings.value("archive/recallPassages", 6).toInt();
+    if (!m_archiveIndex || maxPassages <= 0 || history.isEmpty())
+    {
+        trackRequest(m_interlocutor->sendRequest(history, ancientMemory,
+                                                 InterlocutorReply::Kind::NormalMessage,
+                                                 attachments));
+        return;
+    }
+
+    // Le rappel peut calculer l'embedding du message (voire interroger un
+    // service distant) : il tourne hors du thread GUI, la requête part quand
+    // il a fini. Les passages ne touchent ni au journal ni au texte du
+    // message : ils partent à part, après le dernier message (voir
+    // Interlocutor::sendRequest), pour que l'historique envoyé reste identique
+    // octet pour octet au préfixe que le fournisseur a mis en cache.
+    const std::shared_ptr<ArchiveIndex> index = m_archiveIndex;
+    const QString query = history.last().text();
+    const quint64 generation = m_chatGeneration;
+    auto *watcher = new QFutureWatcher<QList<ArchiveIndex::Passage>>(this);
+    connect(watcher, &QFutureWatcher<QList<ArchiveIndex::Passage>>::finished, this,
+            [this, watcher, generation, history, ancientMemory, attachments]()
+            {
+                watcher->deleteLater();
+                if (generation != m_chatGeneration || !m_interlocutor)
+                {
+                    qDebug() << "Chat changed during the archive recall; request dropped.";
+                    return;
+                }
+                if (m_stopRequested)
+                {
+                    failPendingReply("Stopped before the request was sent.");
+                    return;
+                }
+                trackRequest(m_interlocutor->sendRequest(history, ancientMemory,
+                                                         InterlocutorReply::Kind::NormalMessage,
+                                                         attachments,
+                                                         formatRecall(watcher->result())));
+            });
+    watcher->setFuture(QtConcurrent::run([index, query, maxPassages]()
+                                         { return index->recall(query, maxPassages); }));
+}
+
+QString ChatModel::formatRecall(const QList<ArchiveIndex::Passage> &passages) const
+{
+    QSettings settings("Tether", "ChatApp");
+    const int budget = settings.value("archive/recallTokens", 1500).toInt();
+    if (budget <= 0)
+        return "";
+
+    // Les meilleurs passages qui tiennent dans le budget, puis remis dans
+    // l'ordre chronologique pour la lecture.
+    QList<ArchiveIndex::Passage> kept;
+    int usedTokens = 0;
+    for (const ArchiveIndex::Passage &passage : passages)
+    {
+        const int tokens = tokenizer().countTokens(passage.text);
+        if (usedTokens + tokens > budget)
+            continue;
+        usedTokens += tokens;
+        kept.append(passage);
+    }
+    if (kept.isEmpty())
+        return "";
+    std::sort(kept.begin(), kept.end(),
+              [](const ArchiveIndex::Passage &a, const ArchiveIndex::Passage &b)
+              { return a.timestamp < b.timestamp; });
+
+    QString block = "--- PASSAGES RECALLED FROM EARLIER IN THIS CONVERSATION (verbatim, "
+                    "possibly relevant; do not mention them unless useful) ---\n";
+    for (const ArchiveIndex::Passage &passage : std::as_const(kept))
+        block += QString("[%1] %2: %3\n")
+                     .arg(passage.timestamp.toString("yyyy-MM-dd"),
+                          passage.isLocalMessage ? "user" : "assistant", passage.text);
+    block += "--- END OF RECALLED PASSAGES ---";
+    qDebug() << "Recalled" << kept.size() << "archived passages (" << usedTokens << "tokens ).";
+    return block;
 }
 
 QString ChatModel::loadOlderMemory()
 {
-    return MemoryCurator::loadMemory(getOlderMemoryFilePath());
+    return MemoryCurator::requestMemory(getOlderMemoryFilePath());
 }
 
-bool ChatModel::saveOlderMemory(const QString &content)
+void ChatModel::saveOlderMemory(const TieredMemory &memory, std::function<void(bool)> done)
 {
-    return MemoryCurator::saveMemoryWithBackup(getOlderMemoryFilePath(), content);
+    MemoryCurator::saveMemoryWithBackup(getOlderMemoryFilePath(), memory, this,
+                                        std::move(done));
 }
 
 QList<QObject *> ChatModel::managedFiles() const
@@ -936,13 +1574,16 @@ void ChatModel::saveManagedFiles() const
         }
     }
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    // QSaveFile : la liste précédente reste intacte si l'écriture échoue.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
     {
         qWarning() << "Could not open file list for writing:" << path;
         return;
     }
     file.write(QJsonDocument(fileArray).toJson(QJsonDocument::Indented));
+    if (!file.commit())
+        qWarning() << "Could not write file list:" << path << file.errorString();
 }
 
 // End Source File: ChatModel.cpp
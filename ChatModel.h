@@ -7,14 +7,23 @@
 #include <QHash>
 #include <QJSEngine> // For QML_DECLARE_TYPE
 #include <QList>
+#include <QPointer>
 #include <QQmlEngine> // For QQmlEngine::registerUncreatableType
 #include <QTextStream>
+#include <functional>
+#include <memory>
 
 
+#include "ArchiveIndex.h"
 #include "ChatMessage.h"
 #include "Interlocutor.h" // Ou DummyInterlocutor.h pour le debug
 #include "InterlocutorConfig.h"
 #include "ManagedFile.h"
+#include "TieredMemory.h"
+#include "TokenLedger.h"
+
+class JournalReader;
+class QTimer;
 
 class ChatModel : public QAbstractListModel {
     Q_OBJECT
@@ -35,6 +44,9 @@ public:
 
     explicit ChatModel(QObject *parent = nullptr);
     void setInterlocutor(Interlocutor *interlocutor);
+    // Interlocuteur dédié aux requêtes de curation (résumés et fusions de la
+    // mémoire) ; nul : celui du chat. Non possédé.
+    void setCurator(Interlocutor *curator);
 
     ~ChatModel();
 
@@ -43,6 +55,9 @@ public:
     QVariant data(const QModelIndex &index,
                   int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
+    // Older history, shown page by page when the view is scrolled to the top
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
     // Méthodes Q_INVOKABLE pour QML
     Q_INVOKABLE void sendMessage(const QString &message);
@@ -64,14 +79,31 @@ public:
     Q_PROPERTY(int cumulativeTokenCost READ cumulativeTokenCost NOTIFY
                    cumulativeTokenCostChanged)
 
+    // Part des tokens d'entrée de la session servie par le cache de préfixe
+    // du fournisseur (0..1), remise à zéro avec le coût
+    Q_PROPERTY(double cacheHitRate READ cacheHitRate NOTIFY cacheHitRateChanged)
+
     int liveMemoryTokens() const { return m_liveMemoryTokens; }
     int cumulativeTokenCost() const { return m_cumulativeTokenCost; }
+    double cacheHitRate() const;
     Q_INVOKABLE void resetTokenCost(); // méthode pour le bouton "Reset"
 
     Q_PROPERTY(bool isWaitingForReply READ isWaitingForReply NOTIFY
                    isWaitingForReplyChanged)
     bool isWaitingForReply() const { return m_isWaitingForReply; }
 
+    // Secondes écoulées depuis l'envoi de la requête en cours (0 sans requête)
+    Q_PROPERTY(int generationSeconds READ generationSeconds NOTIFY
+                   generationSecondsChanged)
+    int generationSeconds() const { return m_generationSeconds; }
+    // Arrête la réponse en cours : le texte déjà reçu est gardé
+    Q_INVOKABLE void stopGeneration();
+
+    // Vrai pendant la lecture du journal en tâche de fond (envoi bloqué)
+    Q_PROPERTY(bool isLoadingHistory READ isLoadingHistory NOTIFY
+                   isLoadingHistoryChanged)
+    bool isLoadingHistory() const { return m_isLoadingHistory; }
+
     Q_PROPERTY(QList<QObject *> managedFiles READ managedFiles NOTIFY
                    managedFilesChanged)
     QList<QObject *> managedFiles() const;
@@ -82,11 +114,14 @@ signals:
     void currentChatFilePathChanged();
     void liveMemoryTokensChanged();
     void cumulativeTokenCostChanged();
+    void cacheHitRateChanged();
     void chatMessageAdded(const ChatMessage &message);
     void
     curationNeeded(); // Signal pour indiquer qu'une curation est nécessaire
     void curationFinished(bool success); // Signal utile pour notifier l'UI
     void isWaitingForReplyChanged();
+    void generationSecondsChanged();
+    void isLoadingHistoryChanged();
     void managedFilesChanged();
 
 public slots:
@@ -94,6 +129,11 @@ public slots:
 
 private slots:
     void onInterlocutorReply(const InterlocutorReply &reply);
+    void onInterlocutorChunk(const QString &delta, InterlocutorReply::Kind kind);
+    void onCuratorReply(const InterlocutorReply &reply);
+    void onCuratorError(const QString &message);
+    void onJournalBatch(const QList<ChatMessage> &messages);
+    void onJournalLoaded();
     void onFileUploaded(const QString &fileId, const QString &purpose);
     void onFileDeleted(const QString &fileId, bool success);
     void onFileUploadFailed(const QString &error);
@@ -102,7 +142,12 @@ private:
     void
     addMessage(const ChatMessage &message); // Add a message to the model *and*
     // the jsonl live memory file
+    void appendToChatFile(const ChatMessage &message); // Persiste une ligne jsonl (+ log global)
     void updateLiveMemoryEstimate();
+    void trackRequest(RequestHandle *handle);
+    void failPendingReply(const QString &message);
+    // Tokenizer du modèle de l'interlocuteur courant (chars/4 sans interlocuteur)
+    const Tokenizer &tokenizer() const;
     void handleNormalReply(const InterlocutorReply &reply);
     void handleCurationReply(const InterlocutorReply &reply);
 
@@ -116,10 +161,16 @@ private:
     QString getManagedFilesPath() const;
 
     QList<ChatMessage> m_messages;
+    // Messages les plus anciens de m_messages que la vue ne montre pas encore :
+    // la ligne r est m_messages[m_hiddenRows + r]
+    qsizetype m_hiddenRows = 0;
+    TokenLedger m_tokenLedger; // Poids de m_messages, tenu à jour à chaque modification
     Interlocutor *m_interlocutor; // L'interlocuteur réel ou bidon
     QString m_currentChatFilePath;
     int m_liveMemoryTokens = 0;
     int m_cumulativeTokenCost = 0;
+    qint64 m_sessionInputTokens = 0;
+    qint64 m_sessionCacheReadTokens = 0;
 
 public:
     Q_INVOKABLE void setCurationThresholds(int triggerTokens, int targetTokens);
@@ -129,33 +180,88 @@ private:
     int m_curationTargetTokenCount = 85000;
     // Seuil de déclenchement de la curation (par exemple, 120K)
     int m_curationTriggerTokenCount = 100000;
-    void rewriteChatFile();
 
     // Gestion de la curation
     QString getOlderMemoryFilePath()
         const;                 // Donne le chemin du fichier de mémoire ancienne
-    QString loadOlderMemory(); // Charge le contenu de la mémoire ancienne
-    // Sauvegarde la mémoire ancienne; false si la sauvegarde a échoué
-    bool saveOlderMemory(const QString &content);
+    QString loadOlderMemory(); // Mémoire ancienne à joindre aux requêtes
+    // Sauvegarde la mémoire ancienne sur l'IoWorker ; done(false) si la
+    // sauvegarde a échoué
+    void saveOlderMemory(const TieredMemory &memory, std::function<void(bool)> done);
+    void finishCuration(bool saved, const QString &newSummary);
+    // Après un épisode : fusionne le niveau de mémoire qui déborde, s'il y en
+    // a un (une requête par niveau), puis termine la curation
+    void startRollup();
+    void handleRollupReply(const InterlocutorReply &reply);
+    TieredMemory::Rollup m_pendingRollup; // Fusion dont on attend la réponse
+    Interlocutor *m_curator = nullptr;
+    Interlocutor *curator() const { return m_curator ? m_curator : m_interlocutor; }
+    // Requête de curation (préparation, résumé ou fusion) en échec
+    void failCurationRequest();
+    // Retire du contexte vif les `count` plus anciens messages, en attente de
+    // résumé (m_pendingCulledMessages)
+    void cullHead(qsizetype count);
+    QList<ChatMessage> episodeRequest(const QList<ChatMessage> &culled,
+                                      const QList<ChatMessage> &recent) const;
+    void commitEpisode(const QString &newSummary);
+
+    // Curation préparée : passé un seuil bas, le résumé du prochain segment à
+    // couper est demandé pendant un temps mort ; au seuil, la coupe n'a plus
+    // qu'à l'enregistrer, s'il porte toujours sur la tête du contexte.
+    void schedulePreparation();
+    void prepareCuration();
+    void handlePreparedReply(const InterlocutorReply &reply);
+    bool commitPreparedCuration();
+    void discardPreparedCuration();
+    QTimer *m_prepareTimer = nullptr;
+    bool m_isPreparingCuration = false;
+    bool m_commitWhenPrepared = false; // Seuil atteint pendant la préparation
+    QList<ChatMessage> m_preparedSegment;
+    QString m_preparedSummary;
+    // Envoie `history` avec les passages archivés proches du dernier message,
+    // passés à part à l'interlocuteur (rappel calculé hors du thread GUI)
+    void sendWithRecall(QList<ChatMessage> history, const QString &ancientMemory,
+                        const QStringList &attachments);
+    // Passages rappelés mis en forme en un bloc envoyé après le dernier
+    // message ; vide si rien ne tient dans le budget
+    QString formatRecall(const QList<ArchiveIndex::Passage> &passages) const;
+    // Messages coupés par les curations, verbatim (<nom>_archive.jsonl)
+    std::shared_ptr<ArchiveIndex> m_archiveIndex;
 
     // Flags pour gérer le processus de curation asynchrone
     bool m_isCurationInProgress = false;
     bool m_isWaitingForCurationResponse = false;
     // Messages coupés du contexte vif, pas encore validés sur disque : le
-    // fichier jsonl n'est réécrit qu'après un résumé sauvegardé avec succès;
+    // watermark du journal n'avance qu'après un résumé sauvegardé avec succès;
     // en cas d'échec ils sont restaurés dans le modèle.
     QList<ChatMessage> m_pendingCulledMessages;
     void restoreCulledMessages();
+    // Change à chaque chargement ou effacement du chat : le résultat d'une
+    // sauvegarde de mémoire encore en vol ne touche plus au nouveau contenu.
+    quint64 m_chatGeneration = 0;
     QString m_liveMemoryFileIdForCuration;
     QString m_oldAncientMemoryFileIdToDelete;
 
     // Code pour gérer l'état d'attente de réponse
     void setWaitingForReply(bool waiting); // Setter privé pour gérer l'état
     bool m_isWaitingForReply = false;
+    // Requête du chat en cours ; m_stopRequested couvre le rappel d'archive,
+    // pendant lequel elle n'est pas encore partie.
+    QPointer<RequestHandle> m_activeRequest;
+    bool m_stopRequested = false;
+    int m_generationSeconds = 0;
+
+    // Chargement asynchrone du journal
+    void setLoadingHistory(bool loading);
+    JournalReader *m_journalReader = nullptr;
+    bool m_isLoadingHistory = false;
 
     QList<ManagedFile *> m_managedFiles;
     void removeTypingIndicator();
     bool m_expectingContinuation = false;
+    // Vrai quand le dernier message est une réponse en cours de streaming :
+    // l'ancien typing indicator, rempli au fil des chunks, pas encore persisté.
+    bool m_isStreamingReply = false;
 
     // Extended context without attached files
     bool m_extendedContextEnabled = false;
@@ -199,6 +305,17 @@ public:
 
 signals:
     void displayNotesEnabledChanged();
+
+private:
+    // Stream replies token by token (SSE) instead of waiting for the full body
+    bool m_streamingEnabled = true;
+    Q_PROPERTY(bool streamingEnabled READ streamingEnabled WRITE setStreamingEnabled NOTIFY streamingEnabledChanged)
+public:
+    bool streamingEnabled() const { return m_streamingEnabled; }
+    void setStreamingEnabled(bool enabled);
+
+signals:
+    void streamingEnabledChanged();
 };
 
 #endif // CHATMODEL_H
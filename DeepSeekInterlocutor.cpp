@@ -10,9 +10,13 @@
 #include <QRegularExpression>
 #include <QStandardPaths>
 #include <QTextStream>
-#include <QTimer>
 #include <QSettings>
+#include <memory>
 
+#include "IoWorker.h"
+#include "NetworkService.h"
+#include "SseParser.h"
+#include "Tracer.h"
 
 DeepSeekInterlocutor::DeepSeekInterlocutor(QString interlocutorName, const QString &apiKey,
                                            const QUrl &url, const QString &model, QObject *parent)
@@ -22,14 +26,14 @@ DeepSeekInterlocutor::DeepSeekInterlocutor(QString interlocutorName, const QStri
     , m_model(model)
     , m_nextNoteId(1)
 {
-    m_manager = new QNetworkAccessManager(this);
     loadNotes();
 }
 
-void DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
-                                       const QString &ancientMemory,
-                                       const InterlocutorReply::Kind kind,
-                                       const QStringList &attachmentFileIds)
+RequestHandle *DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
+                                                 const QString &ancientMemory,
+                                                 const InterlocutorReply::Kind kind,
+                                                 const QStringList &attachmentFileIds,
+                                                 const QString &recall)
 {
     // DeepSeek API doesn't support file attachments in the standard chat completions endpoint
     // in the same way as the custom OpenAI implementation. We ignore attachmentFileIds.
@@ -44,9 +48,17 @@ void DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
 
     QJsonObject payload;
     payload["model"] = m_model;
-    payload["stream"] = false;
+    const bool streaming = m_streamingEnabled && kind == InterlocutorReply::Kind::NormalMessage;
+    payload["stream"] = streaming;
+    if (streaming)
+    {
+        // Sans cette option, le flux ne contient pas les compteurs de tokens.
+        payload["stream_options"] = QJsonObject{{"include_usage", true}};
+    }
 
-    QJsonArray messages;
+    // Le tableau "messages" est assemblé par le cache de l'historique : seuls
+    // les messages nouveaux depuis le tour précédent sont encodés.
+    m_historyCache.begin(kind == InterlocutorReply::Kind::NormalMessage);
 
     // 1. System Prompt
     if (!m_systemPrompt.isEmpty())
@@ -54,7 +66,7 @@ void DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
         QJsonObject systemMsg;
         systemMsg["role"] = "system";
         systemMsg["content"] = m_systemPrompt;
-        messages.append(systemMsg);
+        m_historyCache.appendObject(systemMsg);
     }
 
     // 2. Ancient Memory
@@ -66,50 +78,90 @@ void DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
         memoryMsg["content"] = "The long-term memory from previous dialogue cycles is shown below. "
                                "Use it for context continuity only:\n" +
                                ancientMemory;
-        messages.append(memoryMsg);
+        m_historyCache.appendObject(memoryMsg);
     }
 
     // 3. Notes System
+    // Le cache de contexte de DeepSeek est un cache de préfixe automatique :
+    // les consignes du carnet (fixes) restent en tête, mais son contenu, qui
+    // change presque à chaque réponse, est placé après le dernier message pour
+    // que tout l'historique reste un préfixe identique d'un tour à l'autre.
     QSettings settings("Tether", "ChatApp");
-    if (settings.value("chat/deepSeekNotesEnabled", true).toBool())
+    const bool notesEnabled = settings.value("chat/deepSeekNotesEnabled", true).toBool();
+    if (notesEnabled)
     {
         QJsonObject notesMsg;
         notesMsg["role"] = "system";
-        QString notesContent = getNotesString();
-        if (notesContent.isEmpty())
-        {
-            notesContent = "(No notes currently saved. Feel free to add some by using NOTE{...}, "
-                           "QUESTION{...} or IDEA{...}!)";
-        }
         notesMsg["content"] =
             "You are equipped with a personal notebook to act as your long-term memory and scratchpad. "
             "Whenever you include 'NOTE{...}', 'QUESTION{...}', or 'IDEA{...}' in your responses, the "
             "text inside the curly braces will be appended to your personal notes. Each note is "
             "assigned a unique ID. If you wish to delete a note, simply output 'DELETE{<ID>}' in your "
-            "response. These notes are preserved across sessions and provided to you in every prompt. "
+            "response. These notes are preserved across sessions and provided to you in every prompt, "
+            "after the latest message. "
             "Notes are optional—you don't have to include one with every message —but you can use them "
-            "to keep track of things you want to remember over the long term. "
-            "Here is the current state of your personal notes:\n\n" +
-            notesContent;
-        messages.append(notesMsg);
+            "to keep track of things you want to remember over the long term.";
+        m_historyCache.appendObject(notesMsg);
     }
 
-    // 4. Chat History
-    for (const ChatMessage &msg : history)
+    // 4. Chat History, with the current notes and the recalled passages
+    //    appended to the last user turn, after its text (hors du préfixe en
+    //    cache ; ce tour-là est donc toujours réencodé)
+    qsizetype lastSent = history.size() - 1;
+    while (lastSent >= 0 &&
+           (history.at(lastSent).isError() || history.at(lastSent).isTypingIndicator()))
+        --lastSent;
+    for (qsizetype i = 0; i <= lastSent; ++i)
     {
-        if (msg.isError() || msg.isTypingIndicator) continue;
+        const ChatMessage &msg = history.at(i);
+        if (msg.isError() || msg.isTypingIndicator()) continue;
 
-        QJsonObject chatMsg;
-        chatMsg["role"] = msg.isLocalMessage() ? "user" : "assistant";
-        chatMsg["content"] = msg.text();
-        messages.append(chatMsg);
+        if (i == lastSent && (notesEnabled || !recall.isEmpty()) && msg.isLocalMessage())
+        {
+            QString content = msg.text();
+            if (notesEnabled)
+            {
+                QString notesContent = getNotesString();
+                if (notesContent.isEmpty())
+                {
+                    notesContent = "(No notes currently saved. Feel free to add some by using "
+                                   "NOTE{...}, QUESTION{...} or IDEA{...}!)";
+                }
+                content += "\n\n---\nHere is the current state of your personal notes:\n\n" +
+                           notesContent;
+            }
+            if (!recall.isEmpty())
+                content += "\n\n" + recall;
+            QJsonObject chatMsg;
+            chatMsg["role"] = "user";
+            chatMsg["content"] = content;
+            m_historyCache.appendObject(chatMsg);
+            continue;
+        }
+
+        m_historyCache.append(HistoryPayloadCache::keyOf(msg),
+                              [&msg]()
+                              {
+                                  QJsonObject chatMsg;
+                                  chatMsg["role"] = msg.isLocalMessage() ? "user" : "assistant";
+                                  chatMsg["content"] = msg.text();
+                                  return HistoryPayloadCache::encodeObject(chatMsg);
+                              });
     }
 
-    payload["messages"] = messages;
+    QByteArray data = m_historyCache.finish(payload, QLatin1StringView("messages"));
 
-    QByteArray data = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    QNetworkReply *reply =
+        NetworkService::instance().post(request, data, this, requestPriority(kind));
 
-    QNetworkReply *reply = m_manager->post(request, data);
+    auto *handle = new RequestHandle(kind, this);
+    handle->attach(reply, REQUEST_TIMEOUT_MS);
+
+    if (streaming)
+    {
+        connectStreamingReply(reply, kind);
+        return handle;
+    }
 
     connect(reply, &QNetworkReply::finished, this,
             [this, reply, kind]()
@@ -118,6 +170,15 @@ void DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
                 const int statusCode =
                     reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
+                if (RequestHandle::wasCancelled(reply))
+                {
+                    InterlocutorReply partial;
+                    partial.kind = kind;
+                    emitCancelledReply(partial);
+                    reply->deleteLater();
+                    return;
+                }
+
                 if (reply->error() != QNetworkReply::NoError || statusCode < 200 ||
                     statusCode >= 300)
                 {
@@ -131,7 +192,9 @@ void DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
                     return;
                 }
 
+                TraceScope parseScope("json.parse", "interlocutor");
                 const QJsonDocument jsonDoc = QJsonDocument::fromJson(raw);
+                parseScope.close();
                 if (jsonDoc.isNull() || !jsonDoc.isObject())
                 {
                     emit errorOccurred("Invalid JSON response from DeepSeek API.");
@@ -166,20 +229,134 @@ void DeepSeekInterlocutor::sendRequest(const QList<ChatMessage> &history,
                     cleanReply.inputTokens = usage["prompt_tokens"].toInt();
                     cleanReply.outputTokens = usage["completion_tokens"].toInt();
                     cleanReply.totalTokens = usage["total_tokens"].toInt();
+                    cleanReply.cacheReadTokens = usage["prompt_cache_hit_tokens"].toInt();
                 }
 
+                RequestHandle::recordTimings(reply, cleanReply);
                 emit replyReady(cleanReply);
                 reply->deleteLater();
             });
+    return handle;
+}
+
+// Streaming mode (SSE), OpenAI chat-completions format: every event is a
+// "chat.completion.chunk" whose choices[0].delta.content holds the next piece
+// of text; with stream_options.include_usage the last chunk carries the usage
+// (and an empty choices array). The stream ends with "data: [DONE]".
+void DeepSeekInterlocutor::connectStreamingReply(QNetworkReply *reply,
+                                                 const InterlocutorReply::Kind kind)
+{
+    // State shared by the readyRead and finished handlers of this reply.
+    struct StreamState
+    {
+        SseParser parser;
+        InterlocutorReply reply;
+        QByteArray errorBody; // Corps d'une réponse HTTP en erreur (JSON, pas SSE)
+        bool completed = false;
+    };
+    auto state = std::make_shared<StreamState>();
+    state->reply.kind = kind;
+
+    auto handleEvents = [this, state](const QList<SseParser::Event> &events)
+    {
+        for (const SseParser::Event &event : events)
+        {
+            if (event.data == "[DONE]")
+            {
+                state->completed = true;
+                continue;
+            }
+            const QJsonObject obj = QJsonDocument::fromJson(event.data).object();
+
+            const QJsonArray choices = obj.value("choices").toArray();
+            if (!choices.isEmpty())
+            {
+                const QJsonObject choice = choices.first().toObject();
+                const QString delta = choice.value("delta").toObject().value("content").toString();
+                if (!delta.isEmpty())
+                {
+                    state->reply.text += delta;
+                    emit replyChunk(delta, state->reply.kind);
+                }
+                if (choice.value("finish_reason").toString() == "length")
+                    state->reply.isIncomplete = true;
+            }
+
+            if (obj.value("usage").isObject())
+            {
+                const QJsonObject usage = obj.value("usage").toObject();
+                state->reply.inputTokens = usage.value("prompt_tokens").toInt();
+                state->reply.outputTokens = usage.value("completion_tokens").toInt();
+                state->reply.totalTokens = usage.value("total_tokens").toInt();
+                state->reply.cacheReadTokens = usage.value("prompt_cache_hit_tokens").toInt();
+            }
+        }
+    };
+
+    connect(reply, &QNetworkReply::readyRead, this,
+            [reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray bytes = reply->readAll();
+                if (statusCode < 200 || statusCode >= 300)
+                {
+                    state->errorBody += bytes;
+                    return;
+                }
+                TraceScope scope("stream.chunk", "interlocutor");
+                handleEvents(state->parser.feed(bytes));
+            });
+
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray rest = reply->readAll();
+
+                if (RequestHandle::wasCancelled(reply))
+                {
+                    // Arrêt demandé : le texte déjà reçu est gardé
+                    InterlocutorReply partial = state->reply;
+                    partial.text = processNotesFromReply(partial.text);
+                    emitCancelledReply(partial);
+                    reply->deleteLater();
+                    return;
+                }
+
+                if (reply->error() != QNetworkReply::NoError || statusCode < 200 ||
+                    statusCode >= 300)
+                {
+                    state->errorBody += rest;
+                    QString errMessage = QString("DeepSeek API Error %1: %2 | Body: %3")
+                                             .arg(statusCode)
+                                             .arg(reply->errorString())
+                                             .arg(QString::fromUtf8(state->errorBody));
+                    qWarning() << errMessage;
+                    emit errorOccurred(errMessage);
+                    reply->deleteLater();
+                    return;
+                }
 
-    QTimer::singleShot(REQUEST_TIMEOUT_MS, reply,
-                       [reply]()
-                       {
-                           if (reply && reply->isRunning())
-                           {
-                               reply->abort();
-                           }
-                       });
+                handleEvents(state->parser.feed(rest));
+                handleEvents(state->parser.finish());
+
+                if (!state->completed)
+                {
+                    qWarning() << "DeepSeek stream ended without [DONE].";
+                    state->reply.isIncomplete = true;
+                }
+
+                InterlocutorReply cleanReply = state->reply;
+                // Notes are processed on the complete text only (a tag may be
+                // split across two deltas).
+                cleanReply.text = processNotesFromReply(cleanReply.text);
+
+                RequestHandle::recordTimings(reply, cleanReply);
+                emit replyReady(cleanReply);
+                reply->deleteLater();
+            });
 }
 
 void DeepSeekInterlocutor::uploadFile(QString fileName, const QByteArray &content,
@@ -203,13 +380,18 @@ void DeepSeekInterlocutor::loadNotes()
 {
     QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
                    "/TetherChats/" + m_interlocutorName + "_notes.md";
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    // Une réécriture encore en file (autre instance du même persona) fait foi.
+    QByteArray bytes;
+    if (!IoWorker::instance().pendingContent(path, bytes))
     {
-        return;
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            return;
+        }
+        bytes = file.readAll();
     }
-    QString content = file.readAll();
-    file.close();
+    QString content = QString::fromUtf8(bytes);
 
     QRegularExpression re("^(\\d+):\\s+(.*?)(?=\\n^\\d+:\\s+|\\z)",
                           QRegularExpression::MultilineOption |
@@ -230,27 +412,10 @@ void DeepSeekInterlocutor::loadNotes()
 
 void DeepSeekInterlocutor::saveNotes()
 {
-    QString dirPath =
-        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/TetherChats";
-    QDir dir;
-    if (!dir.exists(dirPath))
-    {
-        dir.mkpath(dirPath);
-    }
-
-    QString path = dirPath + "/" + m_interlocutorName + "_notes.md";
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        qWarning() << "Could not open notes file for writing:" << path;
-        return;
-    }
-    QTextStream out(&file);
-    for (auto it = m_notes.begin(); it != m_notes.end(); ++it)
-    {
-        out << it.key() << ": " << it.value() << "\n";
-    }
-    file.close();
+    // Réécrit par l'IoWorker (m_notes fait foi en mémoire)
+    QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+                   "/TetherChats/" + m_interlocutorName + "_notes.md";
+    IoWorker::instance().replaceFile(path, getNotesString().toUtf8());
 }
 
 QString DeepSeekInterlocutor::getNotesString() const
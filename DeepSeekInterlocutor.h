@@ -16,9 +16,10 @@ public:
     explicit DeepSeekInterlocutor(QString interlocutorName, const QString &apiKey, const QUrl &url,
                                   const QString &model, QObject *parent);
 
-    void sendRequest(const QList<ChatMessage> &history, const QString &ancientMemory,
-                     const InterlocutorReply::Kind kind,
-                     const QStringList &attachmentFileIds) override;
+    RequestHandle *sendRequest(const QList<ChatMessage> &history, const QString &ancientMemory,
+                               const InterlocutorReply::Kind kind,
+                               const QStringList &attachmentFileIds,
+                               const QString &recall = QString()) override;
 
     // File operations are not supported by DeepSeek chat API directly in this implementation
     void uploadFile(QString fileName, const QByteArray &content, const QString &purpose) override;
@@ -28,9 +29,10 @@ private:
     QUrl m_url;
     QString m_apiKey;
     QString m_model;
-    QNetworkAccessManager *m_manager;
     const int REQUEST_TIMEOUT_MS = 1200000;
 
+    void connectStreamingReply(QNetworkReply *reply, const InterlocutorReply::Kind kind);
+
     QMap<int, QString> m_notes;
     int m_nextNoteId;
     void loadNotes();
@@ -0,0 +1,96 @@
+// Begin Source File Diagnostics.cpp
+#include "Diagnostics.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+#include <QVariantMap>
+
+#include "IoWorker.h"
+#include "Tracer.h"
+
+Diagnostics::Diagnostics(QObject *parent)
+    : QObject(parent)
+{
+    m_refreshTimer.setInterval(1000);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &Diagnostics::refresh);
+}
+
+bool Diagnostics::tracingEnabled() const
+{
+    return Tracer::instance().isEnabled();
+}
+
+void Diagnostics::setTracingEnabled(bool enabled)
+{
+    if (enabled == tracingEnabled())
+        return;
+    Tracer::instance().setEnabled(enabled);
+    emit tracingEnabledChanged();
+}
+
+void Diagnostics::setActive(bool active)
+{
+    if (active == this->active())
+        return;
+    if (active)
+    {
+        refresh();
+        m_refreshTimer.start();
+    }
+    else
+    {
+        m_refreshTimer.stop();
+    }
+    emit activeChanged();
+}
+
+void Diagnostics::refresh()
+{
+    m_spans.clear();
+    m_counters.clear();
+    for (const Tracer::Stats &stats : Tracer::instance().statistics())
+    {
+        QVariantMap entry;
+        entry["name"] = stats.name;
+        entry["count"] = stats.count;
+        if (stats.isCounter)
+        {
+            entry["value"] = stats.lastValue;
+            m_counters.append(entry);
+            continue;
+        }
+        entry["category"] = stats.category;
+        entry["lastMs"] = stats.lastMs;
+        entry["p50Ms"] = stats.p50Ms;
+        entry["p99Ms"] = stats.p99Ms;
+        entry["maxMs"] = stats.maxMs;
+        m_spans.append(entry);
+    }
+    emit updated();
+}
+
+void Diagnostics::clear()
+{
+    Tracer::instance().clear();
+    refresh();
+}
+
+QString Diagnostics::exportTrace()
+{
+    const QString folder = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+                           "/TetherChats/traces";
+    QDir().mkpath(folder);
+    const QString path = folder + "/tether_trace_" +
+                         QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".json";
+    IoWorker::instance().replaceFile(path, Tracer::instance().chromeTrace(), QString(), this,
+                                     [path](bool ok)
+                                     {
+                                         if (!ok)
+                                             qWarning() << "Failed to write trace" << path;
+                                     });
+    qDebug() << "Trace exported to" << path;
+    return QDir::toNativeSeparators(path);
+}
+// End Source File Diagnostics.cpp
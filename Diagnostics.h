@@ -0,0 +1,55 @@
+// Begin Source File Diagnostics.h
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVariantList>
+
+// The Tracer as seen by the Diagnostics tab.
+//
+// While the tab is shown (`active`), the statistics of the recorded spans and
+// the last value of each counter are refreshed every second; nothing is
+// computed otherwise. exportTrace() saves the recorded events as a Chrome
+// trace-event file in the chats folder (TetherChats/traces/) and returns its
+// path.
+class Diagnostics : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool tracingEnabled READ tracingEnabled WRITE setTracingEnabled NOTIFY
+                   tracingEnabledChanged)
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    // Une entrée par nom : name, category, count, lastMs, p50Ms, p99Ms, maxMs
+    Q_PROPERTY(QVariantList spans READ spans NOTIFY updated)
+    // Une entrée par nom : name, count, value
+    Q_PROPERTY(QVariantList counters READ counters NOTIFY updated)
+
+public:
+    explicit Diagnostics(QObject *parent = nullptr);
+
+    bool tracingEnabled() const;
+    void setTracingEnabled(bool enabled);
+    bool active() const { return m_refreshTimer.isActive(); }
+    void setActive(bool active);
+    QVariantList spans() const { return m_spans; }
+    QVariantList counters() const { return m_counters; }
+
+    Q_INVOKABLE void refresh();
+    Q_INVOKABLE void clear();
+    // Chemin du fichier écrit (l'écriture elle-même se fait sur l'IoWorker)
+    Q_INVOKABLE QString exportTrace();
+
+signals:
+    void tracingEnabledChanged();
+    void activeChanged();
+    void updated();
+
+private:
+    QTimer m_refreshTimer;
+    QVariantList m_spans;
+    QVariantList m_counters;
+};
+
+#endif // DIAGNOSTICS_H
+// End Source File Diagnostics.h
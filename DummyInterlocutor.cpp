@@ -1,35 +1,85 @@
 #include "DummyInterlocutor.h"
 #include <QDebug>
 #include <algorithm> // Pour std::reverse
+#include <cmath>
+#include <random>
+
+namespace
+{
+// Texte de remplissage des réponses de taille fixée (Profile::replyChars)
+const QString kFiller = QStringLiteral("Lorem ipsum dolor sit amet, consectetur adipiscing elit. ");
+} // namespace
 
 DummyInterlocutor::DummyInterlocutor(QString interlocutorName, QObject *parent)
     : Interlocutor(interlocutorName, parent)
 {
     // On n'a plus besoin d'un timer membre, QTimer::singleShot est plus simple.
+    setProfile(Profile());
+}
+
+void DummyInterlocutor::setProfile(const Profile &profile)
+{
+    m_profile = profile;
+    m_random = profile.seed ? QRandomGenerator(profile.seed) : QRandomGenerator::securelySeeded();
+}
+
+int DummyInterlocutor::drawLatency()
+{
+    if (m_profile.latencyMs <= 0)
+        return 0;
+    if (m_profile.latencySpread <= 0)
+        return m_profile.latencyMs;
+    // Log-normale autour de la médiane : la longue traîne des vrais fournisseurs
+    std::normal_distribution<double> normal(0.0, m_profile.latencySpread);
+    return int(std::lround(m_profile.latencyMs * std::exp(normal(m_random))));
 }
 
-void DummyInterlocutor::sendRequest(const QList<ChatMessage> &history,
+RequestHandle *DummyInterlocutor::sendRequest(const QList<ChatMessage> &history,
                                     const QString& ancientMemory,
                                     const InterlocutorReply::Kind kind,
-                                    const QStringList &attachmentFileIds)
+                                    const QStringList &attachmentFileIds,
+                                    const QString &recall)
 {
     qDebug() << "DummyInterlocutor::sendRequest called with kind:"
              << (kind == InterlocutorReply::Kind::NormalMessage ? "Normal Message" : "Curation Result");
 
     if (history.isEmpty()) {
         emit errorOccurred("DummyInterlocutor received an empty history.");
-        return;
+        return nullptr;
     }
 
-    // On simule un délai de réponse réseau de 500 ms
-    QTimer::singleShot(500, this, [this, history, ancientMemory, kind]() {
+    auto *handle = new RequestHandle(kind, this);
+    const bool fails = m_profile.errorRate > 0 && m_random.generateDouble() < m_profile.errorRate;
+
+    // On simule le délai de réponse réseau (500 ms par défaut)
+    QTimer::singleShot(drawLatency(), handle, [this, history, ancientMemory, kind, handle, fails]() {
+        if (handle->isCancelled()) {
+            InterlocutorReply partial;
+            partial.kind = kind;
+            emitCancelledReply(partial);
+            handle->finish();
+            return;
+        }
+        if (fails) {
+            emit errorOccurred("DummyInterlocutor: simulated request failure.");
+            handle->finish();
+            return;
+        }
 
         // --- 1. Préparation de la réponse textuelle ---
         // On prend le texte du dernier message de l'historique qu'on nous a passé
-        const QString& lastPrompt = history.last().text();
-        QString reversedPrompt = lastPrompt;
-        std::reverse(reversedPrompt.begin(), reversedPrompt.end());
-        QString completionText = name() + " : " + reversedPrompt;
+        // (ou un texte de remplissage de la taille demandée par le profil)
+        QString completionText;
+        if (m_profile.replyChars > 0) {
+            completionText = name() + " : "
+                             + kFiller.repeated(m_profile.replyChars / kFiller.size() + 1)
+                                   .left(m_profile.replyChars);
+        } else {
+            const QString& lastPrompt = history.last().text();
+            QString reversedPrompt = lastPrompt;
+            std::reverse(reversedPrompt.begin(), reversedPrompt.end());
+            completionText = name() + " : " + reversedPrompt;
+        }
 
         // --- 2. Préparation de la structure de réponse propre (InterlocutorReply) ---
         InterlocutorReply cleanReply;
@@ -37,28 +87,38 @@ void DummyInterlocutor::sendRequest(const QList<ChatMessage> &history,
         cleanReply.kind = kind; // On propage le 'kind' qu'on a reçu !
 
         // --- 3. Simulation du décompte de tokens ---
-        int historyTokens = 0;
-        for (const auto& msg : history) {
-            if (msg.isError() || msg.isTypingIndicator) continue;
-            historyTokens += msg.text().length() / 4;
+        if (m_profile.inputTokens >= 0) {
+            cleanReply.inputTokens = m_profile.inputTokens;
+        } else {
+            int historyTokens = 0;
+            for (const auto& msg : history) {
+                if (msg.isError() || msg.isTypingIndicator()) continue;
+                historyTokens += tokenizer().countTokens(msg.text());
+            }
+
+            // On simule un coût fixe pour le system prompt et la mémoire ancienne
+            int systemTokens = 30;
+            int ancientMemoryTokens = tokenizer().countTokens(ancientMemory);
+            cleanReply.inputTokens = systemTokens + ancientMemoryTokens + historyTokens;
         }
-
-        // On simule un coût fixe pour le system prompt et la mémoire ancienne
-        int systemTokens = 30;
-        int ancientMemoryTokens = ancientMemory.length() / 4;
-        int completionTokens = completionText.length() / 4;
-
-        cleanReply.inputTokens = systemTokens + ancientMemoryTokens + historyTokens;
-        cleanReply.outputTokens = completionTokens;
+        cleanReply.outputTokens = m_profile.outputTokens >= 0
+                                      ? m_profile.outputTokens
+                                      : tokenizer().countTokens(completionText);
         cleanReply.totalTokens = cleanReply.inputTokens + cleanReply.outputTokens;
 
         qDebug() << "Dummy usage: input=" << cleanReply.inputTokens
                  << "output=" << cleanReply.outputTokens
                  << "total=" << cleanReply.totalTokens;
 
+        // Pas de réseau : toute la latence simulée compte comme attente du serveur
+        cleanReply.sentMs = 0;
+        cleanReply.firstByteMs = cleanReply.totalMs = handle->elapsedMs();
+
         // --- 4. Émission du signal avec la réponse propre ---
         emit replyReady(cleanReply);
+        handle->finish();
     });
+    return handle;
 }
 
 void DummyInterlocutor::uploadFile(QString fileName, const QByteArray &content, const QString &purpose)
@@ -3,27 +3,54 @@
 #define DUMMYINTERLOCUTOR_H
 
 #include "Interlocutor.h"
+#include <QRandomGenerator>
 #include <QTimer> // QTimer est un détail d'implémentation, on pourrait s'en passer ici
 
+// Offline interlocutor, for debugging and for tether_bench.
+//
+// Its Profile simulates a provider: the defaults are the original dummy (a
+// fixed 500 ms delay, the last message echoed reversed); the benchmark sets
+// a latency distribution (log-normal around a median), a reply size, the
+// usage reported and a rate of failed requests.
+
 class DummyInterlocutor : public Interlocutor
 {
     Q_OBJECT
 public:
+    struct Profile
+    {
+        int latencyMs = 500;        // Délai médian de la réponse
+        double latencySpread = 0.0; // Écart-type du logarithme du délai (0 : fixe)
+        int replyChars = 0;         // Taille de la réponse ; 0 : écho inversé
+        int inputTokens = -1;       // Usage annoncé ; -1 : compté sur la requête
+        int outputTokens = -1;
+        double errorRate = 0.0;     // Part des requêtes qui échouent
+        quint32 seed = 0;           // Tirages reproductibles ; 0 : graine aléatoire
+    };
+
     explicit DummyInterlocutor(QString interlocutorName, QObject *parent = nullptr);
 
+    void setProfile(const Profile &profile);
+    const Profile &profile() const { return m_profile; }
+
     // Implémentation de la nouvelle signature pour les requêtes de chat/curation
-    void sendRequest(const QList<ChatMessage> &history,
-                     const QString& ancientMemory,
-                     const InterlocutorReply::Kind kind,
-                     const QStringList &attachmentFileIds = {}) override;
+    RequestHandle *sendRequest(const QList<ChatMessage> &history,
+                               const QString& ancientMemory,
+                               const InterlocutorReply::Kind kind,
+                               const QStringList &attachmentFileIds = {},
+                               const QString &recall = QString()) override;
 
     // Implémentation des méthodes de gestion de fichiers
     void uploadFile(QString fileName, const QByteArray &content, const QString &purpose) override;
     void deleteFile(const QString &fileId) override;
 
 private:
+    int drawLatency();
+
     // On peut utiliser un seul QTimer pour toutes nos simulations de délai
     QTimer *m_delayTimer;
+    Profile m_profile;
+    QRandomGenerator m_random;
 };
 
 #endif // DUMMYINTERLOCUTOR_H
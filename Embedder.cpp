@@ -0,0 +1,164 @@
+// Begin Source File Embedder.cpp
+#include "Embedder.h"
+
+#include <QDebug>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSettings>
+
+namespace
+{
+// Délai maximal d'une requête d'embeddings
+const int kHttpTimeoutMs = 30000;
+
+void addFeature(QList<float> &vector, QStringView feature, float weight)
+{
+    const size_t hash = qHash(feature, 0x7e7e7e7e);
+    const qsizetype bucket = qsizetype(hash % size_t(vector.size()));
+    // Bit au-delà de ceux du seau (dimension <= 4096) : signe pseudo-aléatoire,
+    // pour que les collisions se compensent au lieu de s'additionner.
+    vector[bucket] += ((hash >> 20) & 1) ? weight : -weight;
+}
+} // namespace
+
+std::shared_ptr<const Embedder> Embedder::fromSettings()
+{
+    QSettings settings("Tether", "ChatApp");
+    const QString provider = settings.value("embedding/provider", "hashing").toString();
+    if (provider == QLatin1String("none"))
+        return nullptr;
+    if (provider == QLatin1String("openai"))
+    {
+        const QString apiKey = settings.value("embedding/apiKey").toString();
+        if (apiKey.isEmpty())
+        {
+            qWarning() << "embedding/provider is \"openai\" but embedding/apiKey is empty; "
+                          "semantic recall disabled.";
+            return nullptr;
+        }
+        return std::make_shared<HttpEmbedder>(
+            QUrl(settings.value("embedding/url", "https://api.openai.com/v1/embeddings").toString()),
+            apiKey, settings.value("embedding/model", "text-embedding-3-small").toString(),
+            settings.value("embedding/dimensions", 256).toInt());
+    }
+    if (provider != QLatin1String("hashing"))
+        qWarning() << "Unknown embedding/provider" << provider << "- using \"hashing\".";
+    return std::make_shared<HashingEmbedder>(settings.value("embedding/dimensions", 256).toInt());
+}
+
+HashingEmbedder::HashingEmbedder(int dimension)
+    : m_dimension(qBound(16, dimension, 4096))
+{
+}
+
+QString HashingEmbedder::id() const
+{
+    return QString("hashing-v1:%1").arg(m_dimension);
+}
+
+QList<QList<float>> HashingEmbedder::embed(const QStringList &texts) const
+{
+    QList<QList<float>> vectors;
+    vectors.reserve(texts.size());
+    for (const QString &text : texts)
+    {
+        QList<float> vector(m_dimension, 0.0f);
+        const QString folded = text.toCaseFolded();
+        const qsizetype n = folded.size();
+        qsizetype i = 0;
+        while (i < n)
+        {
+            while (i < n && !folded[i].isLetterOrNumber())
+                ++i;
+            const qsizetype start = i;
+            while (i < n && folded[i].isLetterOrNumber())
+                ++i;
+            if (i - start < 2)
+                continue;
+            const QStringView word = QStringView(folded).mid(start, i - start);
+            addFeature(vector, word, 1.0f);
+            // Trigrammes du mot entouré de bornes : "^ch", "cha", ..., "at$"
+            const QString bounded = u'^' + word.toString() + u'$';
+            for (qsizetype t = 0; t + 3 <= bounded.size(); ++t)
+                addFeature(vector, QStringView(bounded).mid(t, 3), 0.5f);
+        }
+        vectors.append(std::move(vector));
+    }
+    return vectors;
+}
+
+HttpEmbedder::HttpEmbedder(const QUrl &url, const QString &apiKey, const QString &model,
+                           int dimension)
+    : m_url(url)
+    , m_apiKey(apiKey)
+    , m_model(model)
+    , m_dimension(dimension)
+{
+}
+
+QString HttpEmbedder::id() const
+{
+    return QString("http:%1:%2").arg(m_model).arg(m_dimension);
+}
+
+QList<QList<float>> HttpEmbedder::embed(const QStringList &texts) const
+{
+    if (texts.isEmpty())
+        return {};
+
+    // Appelé depuis un thread de travail : gestionnaire et boucle locaux,
+    // le thread attend la réponse.
+    QNetworkAccessManager manager;
+    QNetworkRequest request(m_url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("Authorization", "Bearer " + m_apiKey.toUtf8());
+    request.setTransferTimeout(kHttpTimeoutMs);
+
+    QJsonObject payload;
+    payload["model"] = m_model;
+    payload["input"] = QJsonArray::fromStringList(texts);
+    payload["dimensions"] = m_dimension;
+
+    QNetworkReply *reply =
+        manager.post(request, QJsonDocument(payload).toJson(QJsonDocument::Compact));
+    QEventLoop loop;
+    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec(); // La réponse, enfant de `manager`, est détruite avec lui
+
+    if (reply->error() != QNetworkReply::NoError)
+    {
+        qWarning() << "Embedding request failed:" << reply->errorString();
+        return {};
+    }
+
+    const QJsonArray data =
+        QJsonDocument::fromJson(reply->readAll()).object().value("data").toArray();
+    QList<QList<float>> vectors(texts.size());
+    for (const QJsonValue &item : data)
+    {
+        const QJsonObject object = item.toObject();
+        const int index = object.value("index").toInt(-1);
+        const QJsonArray values = object.value("embedding").toArray();
+        if (index < 0 || index >= vectors.size() || values.size() != m_dimension)
+            continue;
+        QList<float> &vector = vectors[index];
+        vector.reserve(m_dimension);
+        for (const QJsonValue &value : values)
+            vector.append(float(value.toDouble()));
+    }
+    for (const QList<float> &vector : std::as_const(vectors))
+    {
+        if (vector.isEmpty())
+        {
+            qWarning() << "Embedding response incomplete for" << m_model;
+            return {};
+        }
+    }
+    return vectors;
+}
+// End Source File Embedder.cpp
@@ -0,0 +1,79 @@
+// Begin Source File Embedder.h
+#ifndef EMBEDDER_H
+#define EMBEDDER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+#include <memory>
+
+// Turns passages of text into fixed-dimension vectors for the semantic recall
+// (see EmbeddingStore).
+//
+// embed() is blocking and is only called off the GUI thread: by the archive
+// indexing pool for new passages, and by the recall task for the user's
+// message. Implementations must therefore be thread-safe. The returned vectors
+// need not be normalized; an empty list means failure (the passages are
+// retried at the next indexing).
+//
+// fromSettings() picks the implementation from the "embedding/provider" key:
+//   "hashing" (default)  HashingEmbedder, local and deterministic;
+//   "openai"             an OpenAI-compatible /v1/embeddings endpoint
+//                        ("embedding/url", "embedding/model",
+//                        "embedding/apiKey", "embedding/dimensions");
+//   "none"               no semantic recall (null embedder).
+class Embedder
+{
+public:
+    virtual ~Embedder() = default;
+
+    virtual int dimension() const = 0;
+
+    // Identifies the vector space: vectors stored with another id are
+    // recomputed. Includes the model and the dimension.
+    virtual QString id() const = 0;
+
+    virtual QList<QList<float>> embed(const QStringList &texts) const = 0;
+
+    static std::shared_ptr<const Embedder> fromSettings();
+};
+
+// Feature hashing of the words (case folded) and of their character
+// trigrams, each with a hashed sign, into `dimension` buckets. No model, no
+// network, the same vector on every run: the offline default. Trigrams make
+// it tolerant to inflections and typos, which BM25 is not.
+class HashingEmbedder : public Embedder
+{
+public:
+    explicit HashingEmbedder(int dimension = 256);
+
+    int dimension() const override { return m_dimension; }
+    QString id() const override;
+    QList<QList<float>> embed(const QStringList &texts) const override;
+
+private:
+    int m_dimension;
+};
+
+// POST {"model", "input": [...], "dimensions"} to an OpenAI-compatible
+// embeddings endpoint, from the calling (worker) thread.
+class HttpEmbedder : public Embedder
+{
+public:
+    HttpEmbedder(const QUrl &url, const QString &apiKey, const QString &model, int dimension);
+
+    int dimension() const override { return m_dimension; }
+    QString id() const override;
+    QList<QList<float>> embed(const QStringList &texts) const override;
+
+private:
+    QUrl m_url;
+    QString m_apiKey;
+    QString m_model;
+    int m_dimension;
+};
+
+#endif // EMBEDDER_H
+// End Source File Embedder.h
@@ -0,0 +1,557 @@
+// Begin Source File EmbeddingStore.cpp
+#include "EmbeddingStore.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(Q_PROCESSOR_X86_64)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(Q_PROCESSOR_ARM_64)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+// En-tête du fichier (64 octets, little-endian) :
+//   0  magic       "TVEC"
+//   4  version
+//   8  dimension
+//   12 recordSize  octets par vecteur : int8 (alignés sur 4) + échelle float
+//   16 count       vecteurs complets
+//   24 embedderId  UTF-8, complété par des zéros
+const quint32 kStoreMagic = 0x43455654; // "TVEC" lu en little-endian
+const quint32 kStoreVersion = 1;
+const qint64 kHeaderSize = 64;
+const qint64 kIdOffset = 24;
+const qint64 kIdSize = kHeaderSize - kIdOffset;
+
+// HNSW : voisins par nœud (double au niveau 0), largeurs de recherche.
+const int kLinks = 16;
+const int kLinksLevel0 = 2 * kLinks;
+const int kEfConstruction = 100;
+const int kEfSearch = 64;
+const int kMaxLevel = 16;
+
+qsizetype recordSizeFor(int dimension)
+{
+    return ((dimension + 3) & ~3) + qsizetype(sizeof(float));
+}
+
+// Tas des k meilleurs : le plus faible en tête, remplacé quand mieux arrive.
+bool weaker(const EmbeddingStore::Hit &a, const EmbeddingStore::Hit &b)
+{
+    return a.score > b.score;
+}
+
+void offer(QList<EmbeddingStore::Hit> &heap, const EmbeddingStore::Hit &hit, int k)
+{
+    if (heap.size() < k)
+    {
+        heap.append(hit);
+        std::push_heap(heap.begin(), heap.end(), weaker);
+    }
+    else if (hit.score > heap.front().score)
+    {
+        std::pop_heap(heap.begin(), heap.end(), weaker);
+        heap.last() = hit;
+        std::push_heap(heap.begin(), heap.end(), weaker);
+    }
+}
+
+qint32 dotScalar(const qint8 *a, const qint8 *b, int length)
+{
+    qint32 sum = 0;
+    for (int i = 0; i < length; ++i)
+        sum += qint32(a[i]) * b[i];
+    return sum;
+}
+
+#if defined(Q_PROCESSOR_X86_64)
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TETHER_TARGET_AVX2
+#else
+#define TETHER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+TETHER_TARGET_AVX2 qint32 dotAvx2(const qint8 *a, const qint8 *b, int length)
+{
+    __m256i sum = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    int i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        // maddubs multiplie non signé par signé : |a| par b portant le signe
+        // de a. Les valeurs restent dans [-127, 127], les paires ne saturent pas.
+        const __m256i products =
+            _mm256_maddubs_epi16(_mm256_sign_epi8(va, va), _mm256_sign_epi8(vb, va));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    qint32 total = _mm_cvtsi128_si32(half);
+    for (; i < length; ++i)
+        total += qint32(a[i]) * b[i];
+    return total;
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                            (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesAvx)
+        return false;
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#elif defined(Q_PROCESSOR_ARM_64)
+qint32 dotNeon(const qint8 *a, const qint8 *b, int length)
+{
+    int32x4_t sum = vdupq_n_s32(0);
+    int i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        const int8x16_t va = vld1q_s8(a + i);
+        const int8x16_t vb = vld1q_s8(b + i);
+        sum = vpadalq_s16(sum, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        sum = vpadalq_s16(sum, vmull_high_s8(va, vb));
+    }
+    qint32 total = vaddvq_s32(sum);
+    for (; i < length; ++i)
+        total += qint32(a[i]) * b[i];
+    return total;
+}
+#endif
+
+struct Kernel
+{
+    qint32 (*dot)(const qint8 *, const qint8 *, int);
+    const char *name;
+};
+
+const Kernel &kernel()
+{
+    static const Kernel selected = []() -> Kernel
+    {
+#if defined(Q_PROCESSOR_X86_64)
+        if (cpuHasAvx2())
+            return {dotAvx2, "avx2"};
+        return {dotScalar, "scalar"};
+#elif defined(Q_PROCESSOR_ARM_64)
+        return {dotNeon, "neon"};
+#else
+        return {dotScalar, "scalar"};
+#endif
+    }();
+    return selected;
+}
+} // namespace
+
+EmbeddingStore::EmbeddingStore(const QString &path, int dimension, const QString &embedderId)
+    : m_path(path)
+    , m_dimension(dimension)
+    , m_embedderId(embedderId.toUtf8().left(kIdSize))
+    , m_recordSize(recordSizeFor(dimension))
+    , m_levelGenerator(42) // Graphe reproductible d'une exécution à l'autre
+{
+}
+
+EmbeddingStore::~EmbeddingStore()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+}
+
+const char *EmbeddingStore::kernelName()
+{
+    return kernel().name;
+}
+
+qint32 EmbeddingStore::dot(const qint8 *a, const qint8 *b, int length)
+{
+    return kernel().dot(a, b, length);
+}
+
+bool EmbeddingStore::open()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_file.setFileName(m_path);
+        if (!m_file.open(QIODevice::ReadWrite))
+        {
+            qWarning() << "Failed to open embedding store:" << m_path;
+            return false;
+        }
+
+        bool valid = false;
+        qint64 count = 0;
+        const QByteArray header = m_file.read(kHeaderSize);
+        if (header.size() == kHeaderSize)
+        {
+            const char *p = header.constData();
+            QByteArray id = header.mid(kIdOffset, kIdSize);
+            id.truncate(id.indexOf('\0') < 0 ? id.size() : id.indexOf('\0'));
+            valid = qFromLittleEndian<quint32>(p) == kStoreMagic &&
+                    qFromLittleEndian<quint32>(p + 4) == kStoreVersion &&
+                    qFromLittleEndian<quint32>(p + 8) == quint32(m_dimension) &&
+                    qFromLittleEndian<quint32>(p + 12) == quint32(m_recordSize) &&
+                    id == m_embedderId;
+            count = qFromLittleEndian<qint64>(p + 16);
+        }
+
+        if (!valid)
+        {
+            if (m_file.size() > 0)
+                qDebug() << "Embedding store written by another embedder, recomputing:" << m_path;
+            QByteArray fresh(kHeaderSize, '\0');
+            qToLittleEndian<quint32>(kStoreMagic, fresh.data());
+            qToLittleEndian<quint32>(kStoreVersion, fresh.data() + 4);
+            qToLittleEndian<quint32>(quint32(m_dimension), fresh.data() + 8);
+            qToLittleEndian<quint32>(quint32(m_recordSize), fresh.data() + 12);
+            std::memcpy(fresh.data() + kIdOffset, m_embedderId.constData(), m_embedderId.size());
+            if (!m_file.resize(0) || !m_file.seek(0) || m_file.write(fresh) != kHeaderSize)
+            {
+                qWarning() << "Failed to initialize embedding store:" << m_path;
+                return false;
+            }
+            count = 0;
+        }
+
+        // Un ajout interrompu laisse au plus un record incomplet après `count`.
+        const qint64 complete = (m_file.size() - kHeaderSize) / m_recordSize;
+        m_count = qBound<qint64>(0, count, complete);
+        if (!m_file.resize(kHeaderSize + m_count * m_recordSize) || !writeCount() || !remap())
+            return false;
+    }
+    growGraph();
+    return true;
+}
+
+qsizetype EmbeddingStore::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_count;
+}
+
+EmbeddingStore::Quantized EmbeddingStore::quantize(const QList<float> &vector) const
+{
+    Quantized quantized;
+    if (vector.size() != m_dimension)
+        return quantized;
+
+    double norm = 0;
+    for (float x : vector)
+        norm += double(x) * x;
+    norm = std::sqrt(norm);
+    quantized.values = QByteArray(m_dimension, '\0');
+    if (norm == 0)
+        return quantized; // Vecteur nul : similarité nulle avec tout
+
+    double maxAbs = 0;
+    for (float x : vector)
+        maxAbs = qMax(maxAbs, std::abs(x / norm));
+    quantized.scale = float(maxAbs / 127);
+    for (int i = 0; i < m_dimension; ++i)
+        quantized.values[i] =
+            char(qBound(-127, int(std::lround(vector.at(i) / norm / quantized.scale)), 127));
+    return quantized;
+}
+
+const qint8 *EmbeddingStore::values(qint32 id) const
+{
+    return reinterpret_cast<const qint8 *>(m_map + kHeaderSize + qint64(id) * m_recordSize);
+}
+
+float EmbeddingStore::scale(qint32 id) const
+{
+    float value = 0;
+    std::memcpy(&value, values(id) + (m_recordSize - qsizetype(sizeof(float))), sizeof(float));
+    return value;
+}
+
+float EmbeddingStore::similarity(const qint8 *query, float queryScale, qint32 id) const
+{
+    return queryScale * scale(id) * float(kernel().dot(query, values(id), m_dimension));
+}
+
+bool EmbeddingStore::remap()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    if (m_count == 0)
+        return true;
+    m_map = m_file.map(0, kHeaderSize + m_count * m_recordSize);
+    if (!m_map)
+        qWarning() << "Failed to map embedding store:" << m_path << m_file.errorString();
+    return m_map != nullptr;
+}
+
+bool EmbeddingStore::writeCount()
+{
+    char bytes[sizeof(qint64)];
+    qToLittleEndian<qint64>(m_count, bytes);
+    return m_file.seek(16) && m_file.write(bytes, sizeof(bytes)) == qint64(sizeof(bytes)) &&
+           m_file.flush();
+}
+
+bool EmbeddingStore::append(const QList<QList<float>> &vectors)
+{
+    QByteArray records;
+    records.reserve(vectors.size() * m_recordSize);
+    for (const QList<float> &vector : vectors)
+    {
+        const Quantized quantized = quantize(vector);
+        if (quantized.values.isEmpty())
+        {
+            qWarning() << "Embedding of dimension" << vector.size() << "instead of" << m_dimension;
+            return false;
+        }
+        QByteArray record(m_recordSize, '\0');
+        std::memcpy(record.data(), quantized.values.constData(), m_dimension);
+        std::memcpy(record.data() + m_recordSize - sizeof(float), &quantized.scale, sizeof(float));
+        records.append(record);
+    }
+    if (records.isEmpty())
+        return true;
+
+    {
+        // Records d'abord, compteur ensuite : un arrêt brutal entre les deux
+        // ne laisse que des octets ignorés à la réouverture.
+        QMutexLocker locker(&m_mutex);
+        if (!m_file.isOpen() || !m_file.seek(kHeaderSize + m_count * m_recordSize) ||
+            m_file.write(records) != records.size() || !m_file.flush())
+        {
+            qWarning() << "Failed to append to embedding store:" << m_path;
+            return false;
+        }
+        m_count += vectors.size();
+        if (!writeCount() || !remap())
+            return false;
+    }
+    growGraph();
+    return true;
+}
+
+void EmbeddingStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    m_count = 0;
+    m_nodes.clear();
+    m_visited.clear();
+    m_entry = -1;
+    m_topLevel = -1;
+    if (m_file.isOpen() && (!m_file.resize(kHeaderSize) || !writeCount()))
+        qWarning() << "Failed to clear embedding store:" << m_path;
+}
+
+QList<EmbeddingStore::Hit> EmbeddingStore::search(const QList<float> &query, int k) const
+{
+    QList<Hit> heap;
+    const Quantized quantized = quantize(query);
+    if (quantized.values.isEmpty() || k <= 0)
+        return heap;
+    const qint8 *q = reinterpret_cast<const qint8 *>(quantized.values.constData());
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_map)
+        return heap;
+
+    qint32 scanFrom = 0;
+    if (m_nodes.size() >= kHnswMinVectors && m_entry >= 0)
+    {
+        const qint32 entry = greedyDescent(q, quantized.scale, 0);
+        const QList<Hit> found = searchLayer(q, quantized.scale, entry, qMax(k, kEfSearch), 0);
+        for (const Hit &hit : found)
+            offer(heap, hit, k);
+        scanFrom = qint32(m_nodes.size());
+    }
+    scanRange(q, quantized.scale, scanFrom, qint32(m_count), k, heap);
+    std::sort_heap(heap.begin(), heap.end(), weaker); // Meilleur d'abord
+    return heap;
+}
+
+QList<EmbeddingStore::Hit> EmbeddingStore::searchExact(const QList<float> &query, int k) const
+{
+    QList<Hit> heap;
+    const Quantized quantized = quantize(query);
+    if (quantized.values.isEmpty() || k <= 0)
+        return heap;
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_map)
+        return heap;
+    scanRange(reinterpret_cast<const qint8 *>(quantized.values.constData()), quantized.scale, 0,
+              qint32(m_count), k, heap);
+    std::sort_heap(heap.begin(), heap.end(), weaker);
+    return heap;
+}
+
+void EmbeddingStore::scanRange(const qint8 *query, float queryScale, qint32 from, qint32 to,
+                               int k, QList<Hit> &heap) const
+{
+    for (qint32 id = from; id < to; ++id)
+        offer(heap, {id, similarity(query, queryScale, id)}, k);
+}
+
+void EmbeddingStore::growGraph()
+{
+    // Un nœud par prise du verrou : une recherche n'attend jamais toute la
+    // construction.
+    forever
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_count < kHnswMinVectors || m_nodes.size() >= m_count || !m_map)
+            return;
+        insertNode(qint32(m_nodes.size()));
+        if (m_nodes.size() == m_count && m_nodes.size() % 10000 == 0)
+            qDebug() << "Embedding graph:" << m_nodes.size() << "vectors," << m_topLevel + 1
+                     << "levels.";
+    }
+}
+
+qint32 EmbeddingStore::greedyDescent(const qint8 *query, float queryScale, int downToLevel) const
+{
+    qint32 current = m_entry;
+    float best = similarity(query, queryScale, current);
+    for (int level = m_topLevel; level > downToLevel; --level)
+    {
+        bool improved = true;
+        while (improved)
+        {
+            improved = false;
+            for (qint32 neighbor : m_nodes.at(current).links.at(level))
+            {
+                const float score = similarity(query, queryScale, neighbor);
+                if (score > best)
+                {
+                    best = score;
+                    current = neighbor;
+                    improved = true;
+                }
+            }
+        }
+    }
+    return current;
+}
+
+QList<EmbeddingStore::Hit> EmbeddingStore::searchLayer(const qint8 *query, float queryScale,
+                                                       qint32 entry, int ef, int level) const
+{
+    if (m_visited.size() < m_nodes.size())
+        m_visited.resize(m_nodes.size()); // Nouvelles marques à zéro
+    if (++m_visitGeneration == 0)
+    {
+        m_visited.fill(0);
+        m_visitGeneration = 1;
+    }
+
+    // `candidates` : à explorer, le meilleur en tête ; `results` : les ef
+    // meilleurs trouvés, le plus faible en tête.
+    const auto stronger = [](const Hit &a, const Hit &b) { return a.score < b.score; };
+    const Hit first{entry, similarity(query, queryScale, entry)};
+    m_visited[entry] = m_visitGeneration;
+    QList<Hit> candidates{first};
+    QList<Hit> results{first};
+    while (!candidates.isEmpty())
+    {
+        std::pop_heap(candidates.begin(), candidates.end(), stronger);
+        const Hit current = candidates.takeLast();
+        if (results.size() >= ef && current.score < results.front().score)
+            break;
+
+        for (qint32 neighbor : m_nodes.at(current.id).links.at(level))
+        {
+            if (m_visited.at(neighbor) == m_visitGeneration)
+                continue;
+            m_visited[neighbor] = m_visitGeneration;
+            const float score = similarity(query, queryScale, neighbor);
+            if (results.size() < ef || score > results.front().score)
+            {
+                candidates.append({neighbor, score});
+                std::push_heap(candidates.begin(), candidates.end(), stronger);
+                offer(results, {neighbor, score}, ef);
+            }
+        }
+    }
+    std::sort_heap(results.begin(), results.end(), weaker);
+    return results;
+}
+
+void EmbeddingStore::insertNode(qint32 id)
+{
+    static const double levelFactor = 1.0 / std::log(double(kLinks));
+    const int level = qMin(
+        kMaxLevel, int(-std::log(1.0 - m_levelGenerator.generateDouble()) * levelFactor));
+    Node node;
+    node.links.resize(level + 1);
+    m_nodes.append(node);
+    if (m_entry < 0)
+    {
+        m_entry = id;
+        m_topLevel = level;
+        return;
+    }
+
+    const qint8 *vector = values(id);
+    const float vectorScale = scale(id);
+    qint32 entry = greedyDescent(vector, vectorScale, level);
+    for (int l = qMin(level, m_topLevel); l >= 0; --l)
+    {
+        const QList<Hit> candidates = searchLayer(vector, vectorScale, entry, kEfConstruction, l);
+        QList<qint32> neighbors;
+        for (qsizetype i = 0; i < candidates.size() && neighbors.size() < kLinks; ++i)
+            neighbors.append(candidates.at(i).id);
+        m_nodes[id].links[l] = neighbors;
+
+        // Liens retour ; un voisin trop chargé ne garde que ses plus proches.
+        const int maxLinks = (l == 0) ? kLinksLevel0 : kLinks;
+        for (qint32 neighbor : std::as_const(neighbors))
+        {
+            QList<qint32> &links = m_nodes[neighbor].links[l];
+            links.append(id);
+            if (links.size() <= maxLinks)
+                continue;
+            const qint8 *neighborVector = values(neighbor);
+            const float neighborScale = scale(neighbor);
+            QList<Hit> scored;
+            scored.reserve(links.size());
+            for (qint32 link : std::as_const(links))
+                scored.append({link, similarity(neighborVector, neighborScale, link)});
+            std::partial_sort(scored.begin(), scored.begin() + maxLinks, scored.end(), weaker);
+            links.resize(maxLinks);
+            for (int i = 0; i < maxLinks; ++i)
+                links[i] = scored.at(i).id;
+        }
+        if (!candidates.isEmpty())
+            entry = candidates.first().id;
+    }
+    if (level > m_topLevel)
+    {
+        m_topLevel = level;
+        m_entry = id;
+    }
+}
+// End Source File EmbeddingStore.cpp
@@ -0,0 +1,121 @@
+// Begin Source File EmbeddingStore.h
+#ifndef EMBEDDINGSTORE_H
+#define EMBEDDINGSTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QRandomGenerator>
+#include <QString>
+
+// One vector per archive passage, for the semantic half of the recall (see
+// ArchiveIndex). Vector i belongs to passage i of the ArchiveIndex.
+//
+// The vectors live in a memory-mapped file next to the archive
+// (<name>_archive.jsonl.vec): a 64-byte header (magic, dimension, count and
+// the id of the Embedder that produced them) followed by one record per
+// vector — the L2-normalized vector quantized to int8, and its scale. The
+// similarity of two records is the int8 dot product times the two scales
+// (the cosine, to about 1%). A file written by another embedder or with
+// another dimension is emptied and recomputed. Like the journal index, the
+// file is a cache: the archive journal stays the reference.
+//
+// search() scans every vector with the dot-product kernel of the CPU (AVX2 on
+// x86-64 when available, NEON on ARM64, scalar otherwise) until the store
+// holds kHnswMinVectors; from then on an HNSW graph, built in memory and kept
+// up to date by append(), answers in a few hundred dot products. Vectors not
+// yet in the graph are always scanned.
+//
+// Thread-safe: append() runs on the archive indexing pool, search() on the
+// recall task.
+class EmbeddingStore
+{
+public:
+    struct Hit
+    {
+        qint32 id = -1;
+        float score = 0;
+    };
+
+    EmbeddingStore(const QString &path, int dimension, const QString &embedderId);
+    ~EmbeddingStore();
+
+    EmbeddingStore(const EmbeddingStore &) = delete;
+    EmbeddingStore &operator=(const EmbeddingStore &) = delete;
+
+    // Maps the existing file (or creates it) and builds the graph if needed.
+    bool open();
+
+    qsizetype size() const;
+    int dimension() const { return m_dimension; }
+
+    // Adds vectors (of dimension()) after the existing ones.
+    bool append(const QList<QList<float>> &vectors);
+
+    // Drops every vector (archive reindexed from scratch).
+    void clear();
+
+    // The `k` most similar vectors, best first.
+    QList<Hit> search(const QList<float> &query, int k) const;
+
+    // Same, by brute force even when the graph exists (reference for recall
+    // measurements).
+    QList<Hit> searchExact(const QList<float> &query, int k) const;
+
+    // Kernel picked for this CPU, and the kernel itself.
+    static const char *kernelName();
+    static qint32 dot(const qint8 *a, const qint8 *b, int length);
+
+    // Vectors from this count on are also indexed by the HNSW graph.
+    static const qsizetype kHnswMinVectors = 20000;
+
+private:
+    struct Node
+    {
+        QList<QList<qint32>> links; // Voisins, par niveau
+    };
+
+    // Vecteur quantifié : octets int8 + échelle
+    struct Quantized
+    {
+        QByteArray values;
+        float scale = 0;
+    };
+
+    Quantized quantize(const QList<float> &vector) const;
+    const qint8 *values(qint32 id) const;
+    float scale(qint32 id) const;
+    float similarity(const qint8 *values, float scale, qint32 id) const;
+    bool remap();
+    bool writeCount();
+
+    // HNSW (appelant : m_mutex tenu)
+    void insertNode(qint32 id);
+    QList<Hit> searchLayer(const qint8 *values, float scale, qint32 entry, int ef,
+                           int level) const;
+    qint32 greedyDescent(const qint8 *values, float scale, int downToLevel) const;
+    void scanRange(const qint8 *values, float scale, qint32 from, qint32 to, int k,
+                   QList<Hit> &heap) const;
+    void growGraph();
+
+    const QString m_path;
+    const int m_dimension;
+    const QByteArray m_embedderId;
+    const qsizetype m_recordSize;
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qsizetype m_count = 0;
+
+    QList<Node> m_nodes; // Graphe HNSW sur les vecteurs [0, m_nodes.size())
+    qint32 m_entry = -1;
+    int m_topLevel = -1;
+    QRandomGenerator m_levelGenerator;
+    mutable QList<quint32> m_visited; // Marques de parcours, par génération
+    mutable quint32 m_visitGeneration = 0;
+};
+
+#endif // EMBEDDINGSTORE_H
+// End Source File EmbeddingStore.h
@@ -11,7 +11,11 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QUrlQuery>
+#include <memory>
 
+#include "NetworkService.h"
+#include "SseParser.h"
+#include "Tracer.h"
 
 GoogleAIInterlocutor::GoogleAIInterlocutor(QString interlocutorName, const QString &apiKey,
                                            const QUrl &url, QObject *parent)
@@ -19,17 +23,32 @@ GoogleAIInterlocutor::GoogleAIInterlocutor(QString interlocutorName, const QStri
     , m_apiKey(apiKey)
     , m_url(url)
 {
-    m_manager = new QNetworkAccessManager(this);
 }
 
-void GoogleAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
-                                       const QString &ancientMemory, InterlocutorReply::Kind kind,
-                                       const QStringList &attachmentFileIds)
+RequestHandle *GoogleAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
+                                                 const QString &ancientMemory,
+                                                 InterlocutorReply::Kind kind,
+                                                 const QStringList &attachmentFileIds,
+                                                 const QString &recall)
 {
     // L'URL de l'API v1beta de Gemini nécessite la clé en paramètre
     QUrl requestUrl(m_url);
     QUrlQuery query;
     query.addQueryItem("key", m_apiKey);
+
+    // Le streaming passe par la méthode ":streamGenerateContent" (avec alt=sse);
+    // si l'URL configurée ne se termine pas par ":generateContent", on reste en
+    // mode non-streaming.
+    const QString generateMethod = QStringLiteral(":generateContent");
+    const QString path = requestUrl.path();
+    const bool streaming = m_streamingEnabled &&
+                           kind == InterlocutorReply::Kind::NormalMessage &&
+                           path.endsWith(generateMethod);
+    if (streaming)
+    {
+        requestUrl.setPath(path.chopped(generateMethod.size()) + ":streamGenerateContent");
+        query.addQueryItem("alt", "sse");
+    }
     requestUrl.setQuery(query);
 
     QNetworkRequest request(requestUrl);
@@ -62,29 +81,37 @@ void GoogleAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
         payload["system_instruction"] = systemInstruction;
     }
 
-    QJsonArray contentsArray;
+    // Le tableau "contents" est assemblé par le cache de l'historique : seuls
+    // les messages nouveaux depuis le tour précédent sont encodés.
+    m_historyCache.begin(kind == InterlocutorReply::Kind::NormalMessage);
 
-    for (int i = 0; i < history.size(); ++i)
+    auto textParts = [](const ChatMessage &msg)
     {
-        const ChatMessage &msg = history[i];
-        if (msg.isError() || msg.isTypingIndicator) continue;
-
-        QJsonObject turn;
-
-        // Le rôle de l'IA est "model" chez Google
-        turn["role"] = msg.isLocalMessage() ? "user" : "model";
-
         QJsonArray partsArray;
-
         // Texte du message
         if (!msg.text().isEmpty())
         {
             partsArray.append(QJsonObject{{"text", msg.text()}});
         }
+        return partsArray;
+    };
+
+    for (int i = 0; i < history.size(); ++i)
+    {
+        const ChatMessage &msg = history[i];
+        if (msg.isError() || msg.isTypingIndicator()) continue;
 
-        // Si c'est le dernier message (le nôtre) et qu'il y a des fichiers
-        if (i == history.size() - 1 && msg.isLocalMessage() && !attachmentFileIds.isEmpty())
+        // Le rôle de l'IA est "model" chez Google
+        const QString role = msg.isLocalMessage() ? "user" : "model";
+
+        // Si c'est le dernier message (le nôtre) et qu'il y a des fichiers ou
+        // des passages rappelés : ajoutés en parties après son texte, hors du
+        // préfixe que Gemini met en cache.
+        if (i == history.size() - 1 && msg.isLocalMessage() &&
+            (!attachmentFileIds.isEmpty() || !recall.isEmpty()))
         {
+            QJsonArray partsArray = textParts(msg);
+
             // Déduplication simple
             QSet<QString> seen;
             for (const QString &fid : attachmentFileIds)
@@ -107,17 +134,33 @@ void GoogleAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
                     partsArray.append(QJsonObject{{"file_data", fileData}});
                 }
             }
+            if (!recall.isEmpty())
+                partsArray.append(QJsonObject{{"text", recall}});
+
+            m_historyCache.appendObject({{"role", role}, {"parts", partsArray}});
+            continue;
         }
 
-        turn["parts"] = partsArray;
-        contentsArray.append(turn);
+        m_historyCache.append(HistoryPayloadCache::keyOf(msg),
+                              [&]()
+                              {
+                                  return HistoryPayloadCache::encodeObject(
+                                      {{"role", role}, {"parts", textParts(msg)}});
+                              });
     }
 
-    payload["contents"] = contentsArray;
+    QByteArray data = m_historyCache.finish(payload, QLatin1StringView("contents"));
 
-    QByteArray data = QJsonDocument(payload).toJson();
+    QNetworkReply *reply =
+        NetworkService::instance().post(request, data, this, requestPriority(kind));
+    auto *handle = new RequestHandle(kind, this);
+    handle->attach(reply);
 
-    QNetworkReply *reply = m_manager->post(request, data);
+    if (streaming)
+    {
+        connectStreamingReply(reply, kind);
+        return handle;
+    }
 
     connect(
         reply, &QNetworkReply::finished, this,
@@ -125,9 +168,20 @@ void GoogleAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
         {
             const QByteArray raw = reply->readAll();
 
+            if (RequestHandle::wasCancelled(reply))
+            {
+                InterlocutorReply partial;
+                partial.kind = kind;
+                emitCancelledReply(partial);
+                reply->deleteLater();
+                return;
+            }
+
             if (reply->error() == QNetworkReply::NoError)
             {
+                TraceScope parseScope("json.parse", "interlocutor");
                 QJsonDocument jsonResponse = QJsonDocument::fromJson(raw);
+                parseScope.close();
                 if (jsonResponse.isNull() || !jsonResponse.isObject())
                 {
                     emit errorOccurred("Invalid JSON response from Google API.");
@@ -164,8 +218,11 @@ void GoogleAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
                     cleanReply.inputTokens = usage["promptTokenCount"].toInt();
                     cleanReply.outputTokens = usage["candidatesTokenCount"].toInt();
                     cleanReply.totalTokens = usage["totalTokenCount"].toInt();
+                    // Cache implicite de Gemini (inclus dans promptTokenCount)
+                    cleanReply.cacheReadTokens = usage["cachedContentTokenCount"].toInt();
                 }
 
+                RequestHandle::recordTimings(reply, cleanReply);
                 emit replyReady(cleanReply);
             }
             else
@@ -174,13 +231,135 @@ void GoogleAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
             }
             reply->deleteLater();
         });
+    return handle;
+}
+
+// Streaming mode (SSE): each event is a complete GenerateContentResponse
+// carrying only the new text in candidates[0].content.parts; usageMetadata is
+// repeated on every chunk, the last one holding the final counts.
+void GoogleAIInterlocutor::connectStreamingReply(QNetworkReply *reply,
+                                                 const InterlocutorReply::Kind kind)
+{
+    struct StreamState
+    {
+        SseParser parser;
+        InterlocutorReply reply;
+        QByteArray errorBody; // Corps d'une réponse HTTP en erreur (JSON, pas SSE)
+        bool finished = false;
+    };
+    auto state = std::make_shared<StreamState>();
+    state->reply.kind = kind;
+
+    auto handleEvents = [this, state](const QList<SseParser::Event> &events)
+    {
+        for (const SseParser::Event &event : events)
+        {
+            const QJsonObject chunk = QJsonDocument::fromJson(event.data).object();
+
+            const QJsonArray candidates = chunk.value("candidates").toArray();
+            if (!candidates.isEmpty())
+            {
+                const QJsonObject candidate = candidates.first().toObject();
+                const QJsonArray parts =
+                    candidate.value("content").toObject().value("parts").toArray();
+                QString delta;
+                for (const QJsonValue &part : parts)
+                    delta += part.toObject().value("text").toString();
+                if (!delta.isEmpty())
+                {
+                    state->reply.text += delta;
+                    emit replyChunk(delta, state->reply.kind);
+                }
+
+                const QString finishReason = candidate.value("finishReason").toString();
+                if (!finishReason.isEmpty())
+                {
+                    state->finished = true;
+                    if (finishReason == "MAX_TOKENS")
+                        state->reply.isIncomplete = true;
+                }
+            }
+
+            if (chunk.contains("usageMetadata"))
+            {
+                const QJsonObject usage = chunk.value("usageMetadata").toObject();
+                state->reply.inputTokens = usage.value("promptTokenCount").toInt();
+                state->reply.outputTokens = usage.value("candidatesTokenCount").toInt();
+                state->reply.totalTokens = usage.value("totalTokenCount").toInt();
+                state->reply.cacheReadTokens = usage.value("cachedContentTokenCount").toInt();
+            }
+        }
+    };
+
+    connect(reply, &QNetworkReply::readyRead, this,
+            [reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray bytes = reply->readAll();
+                if (statusCode < 200 || statusCode >= 300)
+                {
+                    state->errorBody += bytes;
+                    return;
+                }
+                TraceScope scope("stream.chunk", "interlocutor");
+                handleEvents(state->parser.feed(bytes));
+            });
+
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray rest = reply->readAll();
+
+                if (RequestHandle::wasCancelled(reply))
+                {
+                    // Arrêt demandé : le texte déjà reçu est gardé
+                    emitCancelledReply(state->reply);
+                    reply->deleteLater();
+                    return;
+                }
+
+                if (reply->error() != QNetworkReply::NoError || statusCode < 200 ||
+                    statusCode >= 300)
+                {
+                    state->errorBody += rest;
+                    emit errorOccurred("Google API Error: " + reply->errorString() +
+                                       " | Body: " + QString::fromUtf8(state->errorBody));
+                    reply->deleteLater();
+                    return;
+                }
+
+                handleEvents(state->parser.feed(rest));
+                handleEvents(state->parser.finish());
+
+                if (!state->finished)
+                {
+                    qWarning() << "Google stream ended without finishReason.";
+                    state->reply.isIncomplete = true;
+                }
+
+                RequestHandle::recordTimings(reply, state->reply);
+                emit replyReady(state->reply);
+                reply->deleteLater();
+            });
+}
+
+QUrl GoogleAIInterlocutor::uploadUrl() const
+{
+    // Même version d'API que l'endpoint (premier segment du chemin)
+    QUrl url(m_url);
+    url.setPath("/upload/" + url.path().section('/', 1, 1) + "/files");
+    url.setQuery(QString());
+    return url;
 }
 
 void GoogleAIInterlocutor::uploadFile(QString fileName, const QByteArray &content,
                                       const QString &purpose)
 {
-    // Gemini API Upload URL
-    QUrl url("https://generativelanguage.googleapis.com/upload/v1beta/files");
+    // Gemini API Upload URL, sur l'hôte de l'endpoint configuré
+    QUrl url = uploadUrl();
     QUrlQuery query;
     query.addQueryItem("key", m_apiKey);
     url.setQuery(query);
@@ -213,8 +392,7 @@ void GoogleAIInterlocutor::uploadFile(QString fileName, const QByteArray &conten
     // Header X-Goog-Upload-Protocol requis pour l'upload multipart
     request.setRawHeader("X-Goog-Upload-Protocol", "multipart");
 
-    QNetworkReply *reply = m_manager->post(request, multiPart);
-    multiPart->setParent(reply); // Le reply prend la propriété du multipart
+    QNetworkReply *reply = NetworkService::instance().post(request, multiPart, this);
 
     connect(reply, &QNetworkReply::finished, this,
             [this, reply, purpose, mimeType]()
@@ -259,7 +437,7 @@ void GoogleAIInterlocutor::deleteFile(const QString &fileId)
     url.setQuery(query);
 
     QNetworkRequest request(url);
-    QNetworkReply *reply = m_manager->deleteResource(request);
+    QNetworkReply *reply = NetworkService::instance().deleteResource(request, this);
 
     connect(reply, &QNetworkReply::finished, this,
             [this, reply, fileId]()
@@ -19,18 +19,23 @@ public:
                                   const QUrl &url,
                                   QObject *parent = nullptr);
 
-    void sendRequest(
+    RequestHandle *sendRequest(
         const QList<ChatMessage> &history,
         const QString& ancientMemory,
         InterlocutorReply::Kind kind,
-        const QStringList &attachmentFileIds) override;
+        const QStringList &attachmentFileIds,
+        const QString &recall = QString()) override;
     void uploadFile(QString fileName, const QByteArray &content, const QString &purpose) override;
     void deleteFile(const QString &fileId) override;
 
 private:
+    void connectStreamingReply(QNetworkReply *reply, const InterlocutorReply::Kind kind);
+    // Upload route of the API the configured endpoint belongs to
+    // ("<host>/upload/v1beta/files" for ".../v1beta/models/...").
+    QUrl uploadUrl() const;
+
     QString m_apiKey;
     QUrl m_url;
-    QNetworkAccessManager *m_manager;
 };
 
 #endif // GOOGLEAIINTERLOCUTOR_H
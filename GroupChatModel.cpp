@@ -0,0 +1,1089 @@
+// Begin Source File: GroupChatModel.cpp
+#include "GroupChatModel.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSettings>
+#include <QTimer>
+
+#include "ArchiveIndex.h"
+#include "JournalFile.h"
+#include "JournalReader.h"
+#include "MemoryCurator.h"
+#include "TetherLogger.h"
+#include "Tracer.h"
+
+namespace
+{
+// Default pause between two turns ("duo/turnDelayMs"): keeps the exchange
+// readable in the UI and avoids hammering the APIs.
+const int kDefaultTurnDelayMs = 1500;
+
+// Prefix marking another participant's words inside a participant's own
+// journal, so that the AI (and the memory curation) can tell them apart from
+// the human user.
+QString partnerPrefix(const QString &partnerName)
+{
+    return "[" + partnerName + "]: ";
+}
+
+QString kickoffText(const QStringList &partnerNames)
+{
+    if (partnerNames.size() == 1)
+    {
+        return QString("You're now in conversation with %1, another AI connected through the "
+                       "Tether application; their messages will appear prefixed with \"[%1]: \". "
+                       "You may initiate the conversation with a first message.")
+            .arg(partnerNames.first());
+    }
+    return QString("You're now in a group conversation with %1, other AIs connected through the "
+                   "Tether application; their messages will appear prefixed with their name, "
+                   "like \"[%2]: \". You may initiate the conversation with a first message.")
+        .arg(partnerNames.join(", "), partnerNames.first());
+}
+
+// Réplique par laquelle une IA laisse passer son tour
+bool isPass(const QString &text)
+{
+    const QString trimmed = text.trimmed();
+    return trimmed.isEmpty() || trimmed.compare("[pass]", Qt::CaseInsensitive) == 0;
+}
+
+} // namespace
+
+GroupChatModel::GroupChatModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_transcriptReader(new JournalReader(this))
+{
+    connect(m_transcriptReader, &JournalReader::batchReady, this,
+            &GroupChatModel::onTranscriptBatch);
+    connect(m_transcriptReader, &JournalReader::finished, this,
+            [this]()
+            {
+                // Le tour de parole reprend après le dernier orateur enregistré
+                m_lastSpeaker = -1;
+                for (int row = m_messages.count() - 1; row >= 0; --row)
+                {
+                    const ChatMessage &msg = m_messages.at(row);
+                    if (msg.isError() || msg.isTypingIndicator())
+                        continue;
+                    m_lastSpeaker = indexOf(msg.speaker());
+                    break;
+                }
+                emit loadingChanged();
+            });
+
+    QSettings settings;
+    m_maxTurns = settings.value("duo/maxTurns", 10).toInt();
+    m_turnPolicy = TurnPolicy(qBound(0, settings.value("duo/turnPolicy", 0).toInt(),
+                                     int(TurnPolicy::Bid)));
+    m_parallelRounds = settings.value("duo/parallelRounds", false).toBool();
+    m_turnDelayMs = qMax(0, settings.value("duo/turnDelayMs", kDefaultTurnDelayMs).toInt());
+}
+
+int GroupChatModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_messages.count();
+}
+
+QVariant GroupChatModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_messages.count())
+        return QVariant();
+
+    const ChatMessage &message = m_messages.at(index.row());
+    switch (role)
+    {
+        case SpeakerRole: return message.speaker();
+        case TextRole: return message.text();
+        case TimestampRole: return message.timestamp();
+        case IsErrorRole: return message.isError();
+        case ParticipantIndexRole: return indexOf(message.speaker());
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> GroupChatModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[SpeakerRole] = "speaker";
+    roles[TextRole] = "text";
+    roles[TimestampRole] = "timestamp";
+    roles[IsErrorRole] = "isError";
+    roles[ParticipantIndexRole] = "participantIndex";
+    return roles;
+}
+
+int GroupChatModel::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_participants.size(); ++i)
+    {
+        if (m_participants.at(i).name == name)
+            return i;
+    }
+    return -1;
+}
+
+QStringList GroupChatModel::participants() const
+{
+    QStringList names;
+    for (const Participant &p : m_participants)
+        names.append(p.name);
+    return names;
+}
+
+bool GroupChatModel::sessionReady() const
+{
+    if (m_participants.size() < 2)
+        return false;
+    QSet<QString> names;
+    for (const Participant &p : m_participants)
+    {
+        if (!p.interlocutor || p.name.isEmpty() || names.contains(p.name))
+            return false;
+        names.insert(p.name);
+    }
+    return true;
+}
+
+QString GroupChatModel::pendingSpeaker() const
+{
+    QStringList names;
+    for (int i : m_inFlight)
+    {
+        if (!m_outbid.contains(i))
+            names.append(m_participants.at(i).name);
+    }
+    return names.join(", ");
+}
+
+bool GroupChatModel::curationPending() const
+{
+    for (const Participant &p : m_participants)
+    {
+        if (p.waitingCuration || p.savingMemory)
+            return true;
+    }
+    return false;
+}
+
+void GroupChatModel::releaseParticipants()
+{
+    // Déconnectées d'abord : une réponse tardive d'une instance remplacée ne
+    // doit jamais atteindre le participant qui a pris son rang.
+    for (Participant &p : m_participants)
+    {
+        p.reader->cancel();
+        p.reader->deleteLater();
+        if (p.interlocutor)
+        {
+            p.interlocutor->disconnect(this);
+            p.interlocutor->deleteLater();
+        }
+        if (p.curator && p.curator != p.interlocutor)
+        {
+            p.curator->disconnect(this);
+            p.curator->deleteLater();
+        }
+    }
+    m_participants.clear();
+    m_inFlight.clear();
+    m_outbid.clear();
+    m_bidding = false;
+}
+
+void GroupChatModel::setParticipants(const QList<ParticipantSpec> &specs,
+                                     const QString &transcriptFilePath)
+{
+    if (curationPending())
+    {
+        qWarning() << "GroupChatModel::setParticipants refused: a memory curation is pending.";
+        return;
+    }
+
+    pause();
+    releaseParticipants();
+
+    for (const ParticipantSpec &spec : specs)
+    {
+        Participant p;
+        p.name = spec.name;
+        p.interlocutor = spec.interlocutor;
+        p.curator = spec.curator ? spec.curator : spec.interlocutor;
+        p.reader = new JournalReader(this);
+        p.journalPath = spec.journalPath;
+        p.memoryPath = spec.memoryPath;
+        p.curationTrigger = spec.curationTriggerTokens;
+        p.curationTarget = spec.curationTargetTokens;
+        m_participants.append(p);
+    }
+
+    m_transcriptFilePath = transcriptFilePath;
+
+    for (int i = 0; i < m_participants.size(); ++i)
+    {
+        connectParticipant(i);
+        loadJournal(i);
+    }
+    loadTranscript();
+    emit loadingChanged();
+
+    m_lastSpeaker = -1;
+    m_passesInARow = 0;
+    emit busyChanged();
+    emit participantsChanged();
+
+    qDebug() << "Group session ready:" << participants().join(" <-> ")
+             << "transcript:" << m_transcriptFilePath;
+}
+
+void GroupChatModel::clearParticipants()
+{
+    if (curationPending())
+    {
+        qWarning() << "GroupChatModel::clearParticipants refused: a memory curation is pending.";
+        return;
+    }
+
+    pause();
+    m_transcriptReader->cancel();
+    releaseParticipants();
+    emit loadingChanged();
+    m_transcriptFilePath.clear();
+
+    beginResetModel();
+    m_messages.clear();
+    endResetModel();
+
+    m_cumulativeTokenCost = 0;
+    emit cumulativeTokenCostChanged();
+    emit busyChanged();
+    emit participantsChanged();
+}
+
+void GroupChatModel::connectParticipant(int i)
+{
+    Participant &p = m_participants[i];
+    if (!p.interlocutor)
+        return;
+    p.interlocutor->setParent(this);
+    connect(p.interlocutor, &Interlocutor::replyChunk, this,
+            [this, i](const QString &delta, InterlocutorReply::Kind kind)
+            { onParticipantChunk(i, delta, kind); });
+    connect(p.interlocutor, &Interlocutor::replyReady, this,
+            [this, i](const InterlocutorReply &reply) { onParticipantReply(i, reply); });
+    connect(p.interlocutor, &Interlocutor::errorOccurred, this,
+            [this, i](const QString &message) { onParticipantError(i, message); });
+
+    if (p.curator == p.interlocutor)
+        return;
+    // Curateur dédié : ses erreurs n'interrompent que la curation
+    p.curator->setParent(this);
+    connect(p.curator, &Interlocutor::replyReady, this,
+            [this, i](const InterlocutorReply &reply)
+            {
+                if (reply.kind == InterlocutorReply::Kind::CurationResult)
+                    handleCuration(i, reply);
+            });
+    connect(p.curator, &Interlocutor::errorOccurred, this,
+            [this, i](const QString &message)
+            {
+                qWarning() << "Group curation error for" << m_participants.at(i).name << ":"
+                           << message;
+                failCuration(i);
+            });
+}
+
+void GroupChatModel::start()
+{
+    // Pas de dialogue tant que les journaux ne sont pas entièrement chargés :
+    // chaque requête envoie le journal complet de son auteur.
+    if (!sessionReady() || m_running || loading())
+        return;
+
+    m_turnsLeft = m_maxTurns;
+    emit turnsLeftChanged();
+    m_passesInARow = 0;
+    m_running = true;
+    emit runningChanged();
+
+    if (!busy())
+        requestNextMessage();
+}
+
+void GroupChatModel::pause()
+{
+    if (m_running)
+    {
+        m_running = false;
+        emit runningChanged();
+    }
+}
+
+bool GroupChatModel::loading() const
+{
+    for (const Participant &p : m_participants)
+    {
+        if (p.reader->isRunning())
+            return true;
+    }
+    return m_transcriptReader->isRunning();
+}
+
+void GroupChatModel::clearConversation()
+{
+    pause();
+    if (m_transcriptReader->isRunning())
+    {
+        m_transcriptReader->cancel();
+        emit loadingChanged();
+    }
+
+    beginResetModel();
+    m_messages.clear();
+    for (Participant &p : m_participants)
+        p.streamingRow = -1;
+    endResetModel();
+    m_lastSpeaker = -1;
+
+    // N'efface QUE la transcription du groupe : les journaux de chaque IA
+    // gardent leur propre trace de l'échange (c'est leur expérience vécue).
+    if (!m_transcriptFilePath.isEmpty())
+        JournalFile(m_transcriptFilePath).remove();
+
+    m_cumulativeTokenCost = 0;
+    emit cumulativeTokenCostChanged();
+}
+
+void GroupChatModel::setMaxTurns(int maxTurns)
+{
+    if (maxTurns < 1)
+        maxTurns = 1;
+    if (m_maxTurns != maxTurns)
+    {
+        m_maxTurns = maxTurns;
+        QSettings settings;
+        settings.setValue("duo/maxTurns", maxTurns);
+        emit maxTurnsChanged();
+    }
+}
+
+void GroupChatModel::setTurnPolicy(TurnPolicy policy)
+{
+    if (m_turnPolicy != policy)
+    {
+        m_turnPolicy = policy;
+        QSettings settings;
+        settings.setValue("duo/turnPolicy", int(policy));
+        emit turnPolicyChanged();
+    }
+}
+
+void GroupChatModel::setParallelRounds(bool parallel)
+{
+    if (m_parallelRounds != parallel)
+    {
+        m_parallelRounds = parallel;
+        QSettings settings;
+        settings.setValue("duo/parallelRounds", parallel);
+        emit parallelRoundsChanged();
+    }
+}
+
+bool GroupChatModel::transcriptEmpty() const
+{
+    for (const ChatMessage &msg : m_messages)
+    {
+        if (!msg.isError() && !msg.isTypingIndicator())
+            return false;
+    }
+    return true;
+}
+
+int GroupChatModel::nextInOrder(int after) const
+{
+    // after == -1 : le premier participant
+    const int count = m_participants.size();
+    return (after + 1 + count) % count;
+}
+
+QList<int> GroupChatModel::nextSpeakers() const
+{
+    if (transcriptEmpty())
+        return {0}; // Conversation neuve : le premier participant l'ouvre
+
+    const int count = m_participants.size();
+    const int next = nextInOrder(m_lastSpeaker);
+
+    if (m_turnPolicy == TurnPolicy::Addressed)
+    {
+        // Le participant nommé le plus tôt dans la dernière réplique répond
+        QString lastText;
+        for (int row = m_messages.count() - 1; row >= 0; --row)
+        {
+            const ChatMessage &msg = m_messages.at(row);
+            if (!msg.isError() && !msg.isTypingIndicator())
+            {
+                lastText = msg.text();
+                break;
+            }
+        }
+        int addressed = -1;
+        qsizetype earliest = -1;
+        for (int i = 0; i < count; ++i)
+        {
+            if (i == m_lastSpeaker)
+                continue;
+            const QRegularExpression mention(
+                "\\b" + QRegularExpression::escape(m_participants.at(i).name) + "\\b",
+                QRegularExpression::CaseInsensitiveOption);
+            const QRegularExpressionMatch match = mention.match(lastText);
+            if (match.hasMatch() && (earliest < 0 || match.capturedStart() < earliest))
+            {
+                earliest = match.capturedStart();
+                addressed = i;
+            }
+        }
+        return {addressed >= 0 ? addressed : next};
+    }
+
+    const bool concurrent = m_turnPolicy == TurnPolicy::Bid ||
+                            (m_turnPolicy == TurnPolicy::RoundRobin && m_parallelRounds);
+    if (!concurrent)
+        return {next};
+
+    // Tour concurrent : chacun, dans l'ordre, à partir du suivant. Un tour
+    // parallèle ne dépasse pas le budget ; une enchère exclut le dernier
+    // orateur. Seuls ceux qui ont du nouveau à lire sont sollicités (une
+    // requête ne finit pas par leur propre réplique).
+    QList<int> speakers;
+    for (int k = 0; k < count; ++k)
+    {
+        const int i = (next + k) % count;
+        if (m_turnPolicy == TurnPolicy::Bid && i == m_lastSpeaker)
+            continue;
+        if (m_participants.at(i).hasNewInput())
+            speakers.append(i);
+    }
+    if (speakers.isEmpty())
+        speakers.append(next);
+    if (m_turnPolicy == TurnPolicy::RoundRobin)
+        speakers = speakers.first(qMin<qsizetype>(speakers.size(), qMax(1, m_turnsLeft)));
+    return speakers;
+}
+
+void GroupChatModel::requestNextMessage()
+{
+    if (!m_running || busy() || !sessionReady())
+        return;
+
+    const QList<int> speakers = nextSpeakers();
+    m_bidding = m_turnPolicy == TurnPolicy::Bid && speakers.size() > 1;
+    for (int i : speakers)
+        requestMessage(i);
+    emit busyChanged();
+}
+
+void GroupChatModel::requestMessage(int i)
+{
+    Participant &p = m_participants[i];
+
+    // Brand-new conversation: persist the kick-off prompt in the initiator's
+    // journal (and only there). It both explains the situation and
+    // guarantees the history ends with a "user" turn before the reply.
+    if (transcriptEmpty())
+    {
+        QStringList partners = participants();
+        partners.removeAt(i);
+        const QString kickoff = kickoffText(partners);
+        if (p.journal.isEmpty() || p.journal.last().text() != kickoff)
+        {
+            ChatMessage kickoffMsg(true, kickoff, QDateTime::currentDateTime(),
+                                   p.tokenizer().countTokens(kickoff), 0, "user");
+            appendToJournal(p, kickoffMsg);
+            p.liveTokens += kickoffMsg.promptTokens();
+        }
+    }
+
+    // Compté en vol avant l'envoi : une erreur immédiate le retire aussitôt
+    m_inFlight.append(i);
+
+    // La requête = le journal complet de cette IA (souvenirs humains récents
+    // inclus) + sa mémoire ancienne personnelle.
+    RequestHandle *request =
+        p.interlocutor->sendRequest(p.journal, MemoryCurator::requestMemory(p.memoryPath),
+                                    InterlocutorReply::Kind::NormalMessage, QStringList());
+    if (m_inFlight.contains(i))
+        m_participants[i].request = request;
+}
+
+void GroupChatModel::endTurn()
+{
+    const bool nobodyBid = m_bidding;
+    m_bidding = false;
+    if (nobodyBid || m_passesInARow >= m_participants.size())
+    {
+        // Personne n'a rien à ajouter : inutile de relancer le même tour
+        qInfo() << "Group: every participant passed; pausing.";
+        pause();
+        return;
+    }
+    if (m_turnsLeft <= 0)
+    {
+        // Auto-pause : l'utilisateur garde le contrôle de la dépense de tokens.
+        pause();
+        return;
+    }
+    if (m_running)
+        QTimer::singleShot(m_turnDelayMs, this, [this]() { requestNextMessage(); });
+}
+
+void GroupChatModel::onParticipantChunk(int i, const QString &delta,
+                                        InterlocutorReply::Kind kind)
+{
+    // Les résumés de curation ne s'affichent pas dans la transcription.
+    if (kind != InterlocutorReply::Kind::NormalMessage || m_outbid.contains(i))
+        return;
+
+    Participant &p = m_participants[i];
+    if (p.streamingRow < 0)
+    {
+        ChatMessage partial(false, delta, QDateTime::currentDateTime(), 0, 0, "assistant");
+        partial.setSpeaker(p.name);
+        p.streamingRow = m_messages.count();
+        beginInsertRows(QModelIndex(), p.streamingRow, p.streamingRow);
+        m_messages.append(partial);
+        endInsertRows();
+        return;
+    }
+
+    ChatMessage &partial = m_messages[p.streamingRow];
+    partial.appendText(delta);
+    const QModelIndex idx = index(p.streamingRow);
+    emit dataChanged(idx, idx, {TextRole});
+}
+
+void GroupChatModel::onParticipantReply(int i, const InterlocutorReply &reply)
+{
+    if (reply.kind == InterlocutorReply::Kind::CurationResult)
+    {
+        handleCuration(i, reply);
+        return;
+    }
+
+    Participant &p = m_participants[i];
+    if (!m_inFlight.removeOne(i))
+    {
+        qWarning() << "Group: unexpected reply from" << p.name << "; ignored.";
+        discardReply(i);
+        return;
+    }
+    p.request = nullptr;
+    m_cumulativeTokenCost += reply.totalTokens;
+    emit cumulativeTokenCostChanged();
+
+    if (m_outbid.removeOne(i) || reply.wasCancelled)
+    {
+        // Brouillon d'une enchère perdue (ou réplique arrêtée) : rien n'est gardé
+        discardReply(i);
+    }
+    else if (isPass(reply.text))
+    {
+        qDebug() << "Group:" << p.name << "passed its turn.";
+        discardReply(i);
+        if (!m_bidding)
+            m_lastSpeaker = i;
+        ++m_passesInARow;
+    }
+    else
+    {
+        commitReply(i, reply);
+        m_passesInARow = 0;
+        if (m_bidding)
+        {
+            // Enchère gagnée : les autres brouillons sont annulés, et la fin du
+            // tour vient avec la dernière de leurs réponses.
+            m_bidding = false;
+            m_outbid = m_inFlight;
+            emit busyChanged();
+            const QList<int> losers = m_outbid;
+            for (int j : losers)
+            {
+                if (m_participants[j].request)
+                    m_participants[j].request->cancel();
+            }
+            if (!losers.isEmpty())
+                return;
+        }
+    }
+
+    emit busyChanged();
+    if (m_inFlight.isEmpty())
+        endTurn();
+}
+
+void GroupChatModel::commitReply(int i, const InterlocutorReply &reply)
+{
+    Participant &speaker = m_participants[i];
+    const QDateTime now = QDateTime::currentDateTime();
+
+    // 1) Transcription du groupe (affichage + tour de parole)
+    ChatMessage transcriptMsg(false, reply.text, now, reply.inputTokens, reply.outputTokens,
+                              "assistant");
+    transcriptMsg.setSpeaker(speaker.name);
+    transcriptMsg.setServerLatencyMs(int(reply.serverLatencyMs()));
+    transcriptMsg.setTokensPerSecond(reply.tokensPerSecond());
+    if (speaker.streamingRow >= 0 && speaker.streamingRow < m_messages.count())
+    {
+        // La réplique est déjà affichée (streaming) : on fixe son texte final,
+        // avant les répliques encore en cours.
+        const int row = settleStreamingRow(speaker.streamingRow);
+        speaker.streamingRow = -1;
+        m_messages[row] = transcriptMsg;
+        const QModelIndex idx = index(row);
+        emit dataChanged(idx, idx, {TextRole, TimestampRole});
+        writeTranscriptLine(transcriptMsg);
+    }
+    else
+    {
+        speaker.streamingRow = -1;
+        appendToTranscript(transcriptMsg);
+    }
+
+    // 2) Journal de l'auteur : sa propre réplique, en "assistant"
+    ChatMessage ownMsg(false, reply.text, now, reply.inputTokens, reply.outputTokens, "assistant");
+    ownMsg.setSpeaker(speaker.name);
+    ownMsg.setServerLatencyMs(transcriptMsg.serverLatencyMs());
+    ownMsg.setTokensPerSecond(transcriptMsg.tokensPerSecond());
+    appendToJournal(speaker, ownMsg);
+
+    // 3) Journaux des autres : la réplique reçue, en "user", préfixée
+    const QString prefixedText = partnerPrefix(speaker.name) + reply.text;
+    for (int j = 0; j < m_participants.size(); ++j)
+    {
+        if (j == i)
+            continue;
+        Participant &listener = m_participants[j];
+        ChatMessage partnerMsg(true, prefixedText, now,
+                               listener.tokenizer().countTokens(prefixedText), 0, "user");
+        partnerMsg.setSpeaker(speaker.name);
+        appendToJournal(listener, partnerMsg);
+        listener.liveTokens += partnerMsg.promptTokens();
+    }
+
+    // 4) Comptabilité des tokens
+    speaker.liveTokens = reply.inputTokens + reply.outputTokens;
+    qDebug() << "Group prompt cache for" << speaker.name << ": read" << reply.cacheReadTokens
+             << "written" << reply.cacheWriteTokens << "of" << reply.inputTokens
+             << "input tokens.";
+    m_lastSpeaker = i;
+
+    // 5) Curation éventuelle de l'auteur (asynchrone ; le dialogue peut
+    // continuer pendant ce temps, comme dans le chat solo)
+    maybeTriggerCuration(i);
+
+    // 6) Budget de tours
+    if (m_turnsLeft > 0)
+    {
+        m_turnsLeft--;
+        emit turnsLeftChanged();
+    }
+}
+
+void GroupChatModel::discardReply(int i)
+{
+    Participant &p = m_participants[i];
+    if (p.streamingRow >= 0 && p.streamingRow < m_messages.count())
+        removeTranscriptRow(p.streamingRow);
+    p.streamingRow = -1;
+}
+
+void GroupChatModel::onParticipantError(int i, const QString &message)
+{
+    Participant &p = m_participants[i];
+    qWarning() << "GroupChatModel error from" << p.name << ":" << message;
+
+    // Curation sur la même instance : l'erreur peut venir de la requête
+    // normale ou de la curation. Dans le doute, on restaure les messages
+    // coupés (le watermark du journal n'a pas encore avancé).
+    if (p.curator == p.interlocutor)
+        failCuration(i);
+
+    if (!m_inFlight.removeOne(i))
+        return; // Seule la curation était en cours
+    p.request = nullptr;
+    discardReply(i);
+
+    if (m_outbid.removeOne(i))
+    {
+        // Brouillon perdant : son échec ne concerne plus la conversation
+        emit busyChanged();
+        if (m_inFlight.isEmpty())
+            endTurn();
+        return;
+    }
+
+    pause();
+    if (m_inFlight.isEmpty())
+        m_bidding = false;
+    emit busyChanged();
+
+    ChatMessage errorMessage(false, message, QDateTime::currentDateTime(), 0, 0, "system", true);
+    errorMessage.setSpeaker(p.name);
+    appendToTranscript(errorMessage); // Affichée, jamais persistée.
+}
+
+void GroupChatModel::failCuration(int i)
+{
+    Participant &p = m_participants[i];
+    if (!p.waitingCuration)
+        return;
+    // Une fusion de mémoire échouée ne coûte rien : retentée plus tard.
+    p.waitingCuration = false;
+    p.pendingRollup = TieredMemory::Rollup();
+    emit curationPendingChanged();
+    restoreCulledMessages(p);
+}
+
+void GroupChatModel::maybeTriggerCuration(int i)
+{
+    Participant &p = m_participants[i];
+    if (p.waitingCuration || p.savingMemory || !p.curator)
+        return;
+    if (p.curationTrigger <= p.curationTarget) // Garde-fou config invalide
+        return;
+    if (p.liveTokens < p.curationTrigger)
+        return;
+
+    qDebug() << "Group curation threshold reached for" << p.name << ":" << p.liveTokens
+             << "tokens (trigger" << p.curationTrigger << ")";
+
+    // Cull en mémoire seulement : le watermark du journal n'avance qu'après
+    // un résumé réussi, pour ne jamais perdre de contenu sans résumé.
+    // Point de coupe par recherche dichotomique (TokenLedger), comme ChatModel.
+    p.pendingCulled.clear();
+    const qsizetype cullCount = p.ledger.countCovering(qint64(p.liveTokens) - p.curationTarget);
+    if (cullCount == 0)
+    {
+        qWarning() << "Group curation triggered for" << p.name << "but nothing to cull.";
+        return;
+    }
+    p.liveTokens -= int(p.ledger.sumFirst(cullCount));
+    p.pendingCulled = p.journal.first(cullCount);
+    p.journal.remove(0, cullCount);
+    p.ledger.removeFirst(cullCount);
+
+    const QString recentContext = MemoryCurator::transcriptToText(p.journal);
+    const QString olderTranscript = MemoryCurator::transcriptToText(p.pendingCulled);
+    const QString knownMemory = MemoryCurator::loadMemory(p.memoryPath)
+                                    .render(TieredMemory::Limits::fromSettings().coreTokens);
+
+    QList<ChatMessage> curationHistory;
+    curationHistory.append(ChatMessage(
+        true, MemoryCurator::buildUserMessage(recentContext, olderTranscript, knownMemory),
+        QDateTime::currentDateTime(), 0, 0, "user"));
+
+    p.waitingCuration = true;
+    emit curationPendingChanged();
+    qDebug() << "Sending group curation request for" << p.name;
+    p.curator->sendRequest(curationHistory, MemoryCurator::systemPrompt(),
+                           InterlocutorReply::Kind::CurationResult, QStringList());
+}
+
+void GroupChatModel::handleCuration(int i, const InterlocutorReply &reply)
+{
+    Participant &p = m_participants[i];
+    if (!p.waitingCuration)
+    {
+        qWarning() << "Received group CurationResult for" << p.name
+                   << "but none was pending. Ignoring.";
+        return;
+    }
+    p.waitingCuration = false;
+    if (!p.pendingRollup.isNull())
+    {
+        handleRollup(i, reply);
+        return;
+    }
+
+    const QString newSummary = reply.text.trimmed();
+    if (reply.isIncomplete || newSummary.isEmpty())
+    {
+        emit curationPendingChanged();
+        qWarning() << "Group curation failed for" << p.name
+                   << "(incomplete or empty). Restoring culled messages.";
+        restoreCulledMessages(p);
+        return;
+    }
+
+    // Écriture sur l'IoWorker : la curation reste "pending" (participants
+    // figés, pas de nouvelle coupe) jusqu'à son résultat.
+    TieredMemory memory = MemoryCurator::loadMemory(p.memoryPath);
+    memory.addEpisode(newSummary, p.pendingCulled.first().timestamp(),
+                      p.pendingCulled.last().timestamp(), p.tokenizer());
+    p.savingMemory = true;
+    MemoryCurator::saveMemoryWithBackup(p.memoryPath, memory, this,
+                                        [this, i, newSummary](bool saved)
+                                        { finishCuration(i, saved, newSummary); });
+}
+
+void GroupChatModel::finishCuration(int i, bool saved, const QString &newSummary)
+{
+    Participant &p = m_participants[i];
+    p.savingMemory = false;
+    emit curationPendingChanged();
+
+    if (!saved)
+    {
+        qWarning() << "Group curation: could not save memory for" << p.name
+                   << ". Restoring culled messages.";
+        restoreCulledMessages(p);
+        return;
+    }
+
+    TetherLogger::logCuration(p.name, newSummary);
+
+    // Le résumé est en sécurité : on peut maintenant retirer les messages
+    // coupés du journal, en avançant son watermark. Comme pour un chat simple,
+    // ils sont d'abord recopiés dans l'archive, que le rappel indexe.
+    const int culledRecords = p.pendingCulled.count();
+    if (!p.journalPath.isEmpty())
+    {
+        JournalFile archive(ArchiveIndex::archivePathFor(p.journalPath));
+        for (const ChatMessage &msg : std::as_const(p.pendingCulled))
+            archive.append(msg);
+    }
+    p.pendingCulled.clear();
+    if (!p.journalPath.isEmpty())
+    {
+        JournalFile(p.journalPath).cull(culledRecords);
+        emit journalUpdated(p.name);
+    }
+    qDebug() << "Group curation completed for" << p.name;
+    startRollup(i);
+}
+
+void GroupChatModel::startRollup(int i)
+{
+    Participant &p = m_participants[i];
+    if (!p.curator)
+        return;
+    const TieredMemory::Limits limits = TieredMemory::Limits::fromSettings();
+    const TieredMemory memory = MemoryCurator::loadMemory(p.memoryPath);
+    const TieredMemory::Rollup rollup = memory.nextRollup(limits);
+    if (rollup.isNull())
+        return;
+
+    // Même requête que ChatModel : seuls les résumés fusionnés sont envoyés.
+    p.pendingRollup = rollup;
+    QList<ChatMessage> rollupHistory;
+    rollupHistory.append(ChatMessage(
+        true, MemoryCurator::buildRollupMessage(rollup, memory.core(), limits.coreTokens),
+        QDateTime::currentDateTime(), 0, 0, "user"));
+    p.waitingCuration = true;
+    emit curationPendingChanged();
+    qDebug() << "Sending group memory rollup for" << p.name;
+    p.curator->sendRequest(rollupHistory, MemoryCurator::systemPrompt(),
+                           InterlocutorReply::Kind::CurationResult, QStringList());
+}
+
+void GroupChatModel::handleRollup(int i, const InterlocutorReply &reply)
+{
+    Participant &p = m_participants[i];
+    const TieredMemory::Rollup rollup = p.pendingRollup;
+    p.pendingRollup = TieredMemory::Rollup();
+    const QString summary = reply.text.trimmed();
+    TieredMemory memory = MemoryCurator::loadMemory(p.memoryPath);
+    if (reply.isIncomplete || summary.isEmpty() ||
+        !memory.applyRollup(rollup, summary, p.tokenizer()))
+    {
+        qWarning() << "Group memory rollup failed for" << p.name;
+        emit curationPendingChanged();
+        return;
+    }
+
+    p.savingMemory = true;
+    MemoryCurator::saveMemoryWithBackup(p.memoryPath, memory, this,
+                                        [this, i](bool saved)
+                                        {
+                                            Participant &p = m_participants[i];
+                                            p.savingMemory = false;
+                                            emit curationPendingChanged();
+                                            if (saved)
+                                                startRollup(i);
+                                            else
+                                                qWarning() << "Group memory rollup could not "
+                                                              "be saved for"
+                                                           << p.name;
+                                        });
+}
+
+void GroupChatModel::restoreCulledMessages(Participant &p)
+{
+    QList<int> weights;
+    weights.reserve(p.pendingCulled.size());
+    for (ChatMessage &msg : p.pendingCulled)
+    {
+        weights.append(MemoryCurator::weigh(msg, p.tokenizer()));
+        p.liveTokens += weights.last();
+    }
+    p.journal = p.pendingCulled + p.journal;
+    p.ledger.prepend(weights);
+    p.pendingCulled.clear();
+}
+
+void GroupChatModel::appendToTranscript(const ChatMessage &message)
+{
+    // Avant les répliques encore en streaming, qui restent en bas
+    int row = m_messages.count();
+    for (const Participant &p : std::as_const(m_participants))
+    {
+        if (p.streamingRow >= 0)
+            row = qMin(row, p.streamingRow);
+    }
+    beginInsertRows(QModelIndex(), row, row);
+    m_messages.insert(row, message);
+    for (Participant &p : m_participants)
+    {
+        if (p.streamingRow >= row)
+            ++p.streamingRow;
+    }
+    endInsertRows();
+
+    if (!message.isError() && !message.isTypingIndicator())
+        writeTranscriptLine(message);
+}
+
+void GroupChatModel::writeTranscriptLine(const ChatMessage &message)
+{
+    if (!m_transcriptFilePath.isEmpty())
+        JournalFile(m_transcriptFilePath).append(message);
+}
+
+void GroupChatModel::removeTranscriptRow(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    m_messages.removeAt(row);
+    for (Participant &p : m_participants)
+    {
+        if (p.streamingRow > row)
+            --p.streamingRow;
+    }
+    endRemoveRows();
+}
+
+int GroupChatModel::settleStreamingRow(int row)
+{
+    // Une réplique terminée passe devant celles qui s'écrivent encore : la
+    // transcription affichée suit l'ordre du fichier.
+    int target = row;
+    for (const Participant &p : std::as_const(m_participants))
+    {
+        if (p.streamingRow >= 0 && p.streamingRow < target)
+            target = p.streamingRow;
+    }
+    if (target == row)
+        return row;
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), target);
+    m_messages.move(row, target);
+    for (Participant &p : m_participants)
+    {
+        if (p.streamingRow >= target && p.streamingRow < row)
+            ++p.streamingRow;
+    }
+    endMoveRows();
+    return target;
+}
+
+void GroupChatModel::appendToJournal(Participant &p, const ChatMessage &newMessage)
+{
+    // Poids calculé une fois ici, puis persisté avec le record
+    ChatMessage message = newMessage;
+    p.ledger.append(MemoryCurator::weigh(message, p.tokenizer()));
+    p.journal.append(message);
+
+    if (!p.journalPath.isEmpty())
+        JournalFile(p.journalPath).append(message);
+    TetherLogger::logMessage(p.name, message);
+    emit journalUpdated(p.name);
+}
+
+void GroupChatModel::loadJournal(int i)
+{
+    Participant &p = m_participants[i];
+    p.journal.clear();
+    p.ledger.clear();
+    p.liveTokens = 15; // Estimation initiale (system prompt), comme ChatModel
+
+    // Lecture en tâche de fond (onJournalBatch) ; pas encore de journal :
+    // liste vide, normal pour une IA toute neuve. Seuls les records vivants
+    // (après le watermark) sont chargés.
+    connect(p.reader, &JournalReader::batchReady, this,
+            [this, i](const QList<ChatMessage> &messages) { onJournalBatch(i, messages); });
+    connect(p.reader, &JournalReader::finished, this,
+            [this, i]()
+            {
+                const Participant &loaded = m_participants.at(i);
+                qDebug() << "Group: loaded journal of" << loaded.name << ":"
+                         << loaded.journal.count() << "messages," << loaded.liveTokens
+                         << "tokens (estimated).";
+                emit loadingChanged();
+            });
+    p.reader->start(p.journalPath);
+}
+
+void GroupChatModel::onJournalBatch(int i, const QList<ChatMessage> &messages)
+{
+    Participant &p = m_participants[i];
+    // Poids lus dans le journal ; calculés seulement pour les anciens records.
+    QList<ChatMessage> batch = messages;
+    QList<int> weights;
+    weights.reserve(batch.size());
+    for (ChatMessage &msg : batch)
+    {
+        weights.append(MemoryCurator::weigh(msg, p.tokenizer()));
+        p.liveTokens += weights.last();
+    }
+    p.journal = batch + p.journal;
+    p.ledger.prepend(weights);
+}
+
+void GroupChatModel::loadTranscript()
+{
+    TraceScope scope("model.reset", "model");
+    beginResetModel();
+    m_messages.clear();
+    for (Participant &p : m_participants)
+        p.streamingRow = -1;
+    m_cumulativeTokenCost = 0;
+    endResetModel();
+    emit cumulativeTokenCostChanged();
+
+    // Les répliques les plus récentes arrivent en premier (onTranscriptBatch).
+    m_transcriptReader->start(m_transcriptFilePath);
+}
+
+void GroupChatModel::onTranscriptBatch(const QList<ChatMessage> &messages)
+{
+    if (messages.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), 0, messages.count() - 1);
+    for (int i = messages.size() - 1; i >= 0; --i)
+    {
+        const ChatMessage &msg = messages.at(i);
+        m_cumulativeTokenCost += msg.promptTokens() + msg.completionTokens();
+        m_messages.prepend(msg);
+    }
+    endInsertRows();
+    for (Participant &p : m_participants)
+    {
+        if (p.streamingRow >= 0)
+            p.streamingRow += messages.count();
+    }
+    emit cumulativeTokenCostChanged();
+}
+// End Source File: GroupChatModel.cpp
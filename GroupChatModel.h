@@ -0,0 +1,240 @@
+// Begin Source File GroupChatModel.h
+#ifndef GROUPCHATMODEL_H
+#define GROUPCHATMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QPointer>
+#include <QStringList>
+
+#include "ChatMessage.h"
+#include "Interlocutor.h"
+#include "TieredMemory.h"
+#include "TokenLedger.h"
+
+class JournalReader;
+
+// GroupChatModel drives a conversation between two or more AI interlocutors
+// (the "AI ↔ AI" tab; two participants make the original duo).
+//
+// Identity continuity design: each participant keeps its OWN rolling context —
+// the very same journal file (<name>.jsonl) and long-term memory file
+// (<name>_memory.json) used by its human-facing chat. Every group message is
+// appended to every participant's journal from that participant's perspective:
+//   - its own words are stored as "assistant" turns;
+//   - the others' words are stored as "user" turns, prefixed with
+//     "[SpeakerName]: " so that the AI (and the later memory curation) can
+//     always tell them apart from the human user.
+// Each participant's API request is simply its full journal, so the AI also
+// remembers its recent exchanges with the human verbatim, and once back in
+// the human-facing chat it remembers the group conversation — verbatim while
+// recent, curated into long-term memory when old.
+//
+// Turn taking (TurnPolicy, "duo/turnPolicy" setting):
+//   RoundRobin  the participants speak in order;
+//   Addressed   the participant named in the last message answers it (the
+//               first one named), else the next in order;
+//   Bid         every participant but the last speaker drafts a reply at
+//               once; the first draft that is not a pass wins, the others
+//               are cancelled. Faster turns, paid with the discarded drafts.
+// With parallelRounds, a round-robin round asks every participant at once,
+// from the same state of the conversation: a round lasts as long as its
+// slowest reply instead of the sum of them. The replies are appended as they
+// arrive. In every policy, a participant only speaks once someone else has
+// spoken since its last message, and a reply of "[pass]" is not kept.
+//
+// Each participant runs the standard memory curation cycle (shared with
+// ChatModel through MemoryCurator) when its own context threshold is
+// exceeded, on its own curator instance when ChatManager provides one: the
+// curations of several participants run concurrently, beside the turns. As
+// in ChatModel, the journal's live-start watermark (JournalFile) only moves
+// AFTER a successful summary; on failure the culled messages are restored in
+// memory.
+//
+// The model also maintains the group transcript (duo_<A>__<B>[__<C>...].jsonl)
+// as the display/persistence backbone of the tab: it determines whose turn it
+// is and survives application restarts.
+//
+// GroupChatModel owns dedicated Interlocutor instances (separate from the one
+// used by ChatModel, so that signals and system prompts never interfere).
+// The conversation opener is a kick-off prompt persisted in the initiator's
+// journal only; the others never see it.
+class GroupChatModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    // Everything ChatManager needs to hand over for one participant.
+    struct ParticipantSpec
+    {
+        QString name;
+        Interlocutor *interlocutor = nullptr;
+        Interlocutor *curator = nullptr; // Optionnel : sinon `interlocutor`
+        QString journalPath; // <name>.jsonl — same file as the human-facing chat
+        QString memoryPath;  // <name>_memory.json
+        int curationTriggerTokens = 100000;
+        int curationTargetTokens = 85000;
+    };
+
+    enum class TurnPolicy { RoundRobin, Addressed, Bid };
+    Q_ENUM(TurnPolicy)
+
+    enum GroupMessageRoles {
+        SpeakerRole = Qt::UserRole + 1,
+        TextRole,
+        TimestampRole,
+        IsErrorRole,
+        ParticipantIndexRole // Rang de l'orateur parmi les participants (-1 : aucun)
+    };
+    Q_ENUM(GroupMessageRoles)
+
+    explicit GroupChatModel(QObject *parent = nullptr);
+
+    // Méthodes de QAbstractListModel
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Called by ChatManager, in speaking order. Ownership of the interlocutors
+    // is transferred to this model. Refused while a memory curation is still
+    // pending.
+    void setParticipants(const QList<ParticipantSpec> &specs, const QString &transcriptFilePath);
+    // Invalidates the current session (Start becomes unavailable in the UI).
+    void clearParticipants();
+
+    Q_INVOKABLE void start();
+    Q_INVOKABLE void pause();
+    Q_INVOKABLE void clearConversation();
+
+    Q_PROPERTY(QStringList participants READ participants NOTIFY participantsChanged)
+    Q_PROPERTY(bool sessionReady READ sessionReady NOTIFY participantsChanged)
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
+    Q_PROPERTY(QString pendingSpeaker READ pendingSpeaker NOTIFY busyChanged)
+    Q_PROPERTY(bool curationPending READ curationPending NOTIFY curationPendingChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+    Q_PROPERTY(int cumulativeTokenCost READ cumulativeTokenCost NOTIFY cumulativeTokenCostChanged)
+    Q_PROPERTY(int maxTurns READ maxTurns WRITE setMaxTurns NOTIFY maxTurnsChanged)
+    Q_PROPERTY(int turnsLeft READ turnsLeft NOTIFY turnsLeftChanged)
+    Q_PROPERTY(TurnPolicy turnPolicy READ turnPolicy WRITE setTurnPolicy NOTIFY turnPolicyChanged)
+    Q_PROPERTY(bool parallelRounds READ parallelRounds WRITE setParallelRounds NOTIFY
+                   parallelRoundsChanged)
+
+    QStringList participants() const;
+    bool sessionReady() const;
+    bool running() const { return m_running; }
+    bool busy() const { return !m_inFlight.isEmpty(); }
+    QString pendingSpeaker() const; // Noms de ceux qui écrivent, séparés par des virgules
+    bool curationPending() const;
+    bool loading() const; // Journaux / transcription en cours de lecture
+    int cumulativeTokenCost() const { return m_cumulativeTokenCost; }
+    int maxTurns() const { return m_maxTurns; }
+    void setMaxTurns(int maxTurns);
+    int turnsLeft() const { return m_turnsLeft; }
+    TurnPolicy turnPolicy() const { return m_turnPolicy; }
+    void setTurnPolicy(TurnPolicy policy);
+    bool parallelRounds() const { return m_parallelRounds; }
+    void setParallelRounds(bool parallel);
+
+signals:
+    void participantsChanged();
+    void runningChanged();
+    void busyChanged();
+    void curationPendingChanged();
+    void loadingChanged();
+    void cumulativeTokenCostChanged();
+    void maxTurnsChanged();
+    void turnsLeftChanged();
+    void turnPolicyChanged();
+    void parallelRoundsChanged();
+    // Émis quand le journal solo d'un interlocuteur a été modifié par le groupe
+    // (ChatManager s'en sert pour recharger le chat principal si besoin).
+    void journalUpdated(const QString &interlocutorName);
+
+private:
+    struct Participant
+    {
+        QString name;
+        Interlocutor *interlocutor = nullptr;
+        Interlocutor *curator = nullptr; // Jamais nul : `interlocutor` à défaut
+        JournalReader *reader = nullptr;
+        QString journalPath;
+        QString memoryPath;
+        int curationTrigger = 100000;
+        int curationTarget = 85000;
+
+        QList<ChatMessage> journal; // Rolling context de cette IA (en mémoire)
+        TokenLedger ledger;         // Poids des messages de journal (sommes préfixes)
+        int liveTokens = 0;         // Taille de contexte, corrigée à chaque réponse API
+        bool waitingCuration = false;
+        bool savingMemory = false; // Résumé reçu, en cours d'écriture (IoWorker)
+        QList<ChatMessage> pendingCulled; // Coupés du contexte, pas encore validés sur disque
+        TieredMemory::Rollup pendingRollup; // Fusion de mémoire dont on attend la réponse
+
+        QPointer<RequestHandle> request; // Réplique en cours
+        // Ligne de la réplique en cours de streaming (-1 si aucune) : affichée
+        // au fil des chunks, persistée seulement à la réponse complète.
+        int streamingRow = -1;
+
+        const Tokenizer &tokenizer() const
+        {
+            return interlocutor ? interlocutor->tokenizer() : *Tokenizer::approximate();
+        }
+        // Quelqu'un a parlé depuis sa dernière réplique (ou le kick-off l'invite)
+        bool hasNewInput() const { return !journal.isEmpty() && journal.last().isLocalMessage(); }
+    };
+
+    int indexOf(const QString &name) const;
+    bool transcriptEmpty() const;
+    QList<int> nextSpeakers() const;
+    int nextInOrder(int after) const;
+    void connectParticipant(int i);
+    void requestNextMessage();
+    void requestMessage(int i);
+    void endTurn();
+    void onParticipantChunk(int i, const QString &delta, InterlocutorReply::Kind kind);
+    void onParticipantReply(int i, const InterlocutorReply &reply);
+    void onParticipantError(int i, const QString &message);
+    void commitReply(int i, const InterlocutorReply &reply);
+    void discardReply(int i);
+    void failCuration(int i);
+    void maybeTriggerCuration(int i);
+    void handleCuration(int i, const InterlocutorReply &reply);
+    void finishCuration(int i, bool saved, const QString &newSummary);
+    void startRollup(int i);
+    void handleRollup(int i, const InterlocutorReply &reply);
+    void restoreCulledMessages(Participant &p);
+
+    void appendToTranscript(const ChatMessage &message);
+    void writeTranscriptLine(const ChatMessage &message);
+    void removeTranscriptRow(int row);
+    int settleStreamingRow(int row);
+    void appendToJournal(Participant &p, const ChatMessage &message);
+    void loadJournal(int i);
+    void onJournalBatch(int i, const QList<ChatMessage> &messages);
+    void loadTranscript();
+    void onTranscriptBatch(const QList<ChatMessage> &messages);
+    void releaseParticipants();
+
+    QList<ChatMessage> m_messages; // Transcription du groupe (affichage + tour de parole)
+
+    QList<Participant> m_participants; // Dans l'ordre de parole
+    QString m_transcriptFilePath;
+    JournalReader *m_transcriptReader;
+
+    bool m_running = false;
+    QList<int> m_inFlight;    // Participants dont une réplique est attendue
+    bool m_bidding = false;   // Tour "Bid" en cours : la première réplique gagne
+    QList<int> m_outbid;      // Brouillons perdants, annulés : leur réponse est ignorée
+    int m_lastSpeaker = -1;   // Dernier à avoir parlé (ou passé son tour)
+    int m_passesInARow = 0;   // Tours passés depuis la dernière réplique gardée
+    int m_cumulativeTokenCost = 0;
+    int m_maxTurns = 10;
+    int m_turnsLeft = 0;
+    TurnPolicy m_turnPolicy = TurnPolicy::RoundRobin;
+    bool m_parallelRounds = false;
+    int m_turnDelayMs = 0; // Pause entre deux répliques ("duo/turnDelayMs")
+};
+
+#endif // GROUPCHATMODEL_H
+// End Source File GroupChatModel.h
@@ -0,0 +1,136 @@
+// Begin Source File HistoryPayloadCache.cpp
+#include "HistoryPayloadCache.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+
+#include "ChatMessage.h"
+#include "Tracer.h"
+
+void HistoryPayloadCache::Key::add(const ChatMessage &msg)
+{
+    // Le texte est haché en entier : bien moins cher que de le réencoder. On
+    // hache les octets gardés par le message (UTF-8, ou échappés pour un
+    // message lu dans le journal) : rien n'est décodé.
+    Part part;
+    part.timestampMs = msg.timestampMs();
+    part.role = quint8(msg.roleId());
+    part.flags = quint8((msg.isLocalMessage() ? 0x1 : 0) | (msg.isTextEscaped() ? 0x2 : 0));
+    part.text = msg.textBytes();
+    m_hash = qHash(part.text, qHashMulti(m_hash, part.timestampMs, part.role, part.flags));
+    m_parts.append(part);
+}
+
+bool HistoryPayloadCache::Key::operator==(const Key &other) const
+{
+    if (m_hash != other.m_hash || m_parts.size() != other.m_parts.size())
+        return false;
+    for (qsizetype i = 0; i < m_parts.size(); ++i)
+    {
+        const Part &a = m_parts.at(i);
+        const Part &b = other.m_parts.at(i);
+        if (a.timestampMs != b.timestampMs || a.role != b.role || a.flags != b.flags ||
+            a.text != b.text)
+            return false;
+    }
+    return true;
+}
+
+void HistoryPayloadCache::begin(bool remember)
+{
+    m_beginNs = Tracer::instance().isEnabled() ? Tracer::instance().nowNs() : -1;
+    m_remember = remember;
+    m_parts.clear();
+    m_partBytes = 0;
+    m_reused = 0;
+    m_encoded = 0;
+    if (remember)
+    {
+        m_previous = std::move(m_current);
+        m_current.clear();
+    }
+}
+
+QByteArray HistoryPayloadCache::take(const Key &key)
+{
+    auto it = m_current.constFind(key);
+    if (it != m_current.constEnd())
+    {
+        ++m_reused;
+        return it.value();
+    }
+    if (!m_remember)
+        return {};
+
+    QByteArray fragment = m_previous.take(key);
+    if (!fragment.isNull())
+    {
+        ++m_reused;
+        m_current.insert(key, fragment);
+    }
+    return fragment;
+}
+
+void HistoryPayloadCache::appendObject(const QJsonObject &object)
+{
+    appendFragment(encodeObject(object));
+}
+
+void HistoryPayloadCache::appendFragment(const QByteArray &fragment)
+{
+    m_parts.append(fragment);
+    m_partBytes += fragment.size();
+}
+
+QByteArray HistoryPayloadCache::finish(const QJsonObject &payload, QLatin1StringView arrayKey)
+{
+    // {"model":...}  ->  {"model":...,"<arrayKey>":[f1,f2,...]}
+    QByteArray head = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    head.chop(1); // '}'
+
+    QByteArray body;
+    body.reserve(head.size() + arrayKey.size() + m_partBytes + m_parts.size() + 8);
+    body.append(head);
+    if (head.size() > 1)
+        body.append(',');
+    body.append('"').append(arrayKey.data(), arrayKey.size()).append("\":[");
+    for (qsizetype i = 0; i < m_parts.size(); ++i)
+    {
+        if (i > 0)
+            body.append(',');
+        body.append(m_parts.at(i));
+    }
+    body.append("]}");
+
+    if (m_remember)
+    {
+        qDebug() << "History payload:" << m_reused << "items reused," << m_encoded << "encoded,"
+                 << body.size() << "bytes.";
+        m_previous.clear();
+    }
+    m_parts.clear();
+    m_partBytes = 0;
+    if (m_beginNs >= 0)
+    {
+        // De begin() à ici : tout l'assemblage du corps, fragments compris
+        Tracer &tracer = Tracer::instance();
+        tracer.complete("payload.build", "interlocutor", m_beginNs, tracer.nowNs() - m_beginNs);
+        tracer.counter("payload.bytes", body.size());
+        m_beginNs = -1;
+    }
+    return body;
+}
+
+void HistoryPayloadCache::clear()
+{
+    m_current.clear();
+    m_previous.clear();
+    m_parts.clear();
+    m_partBytes = 0;
+}
+
+QByteArray HistoryPayloadCache::encodeObject(const QJsonObject &object)
+{
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+// End Source File HistoryPayloadCache.cpp
@@ -0,0 +1,108 @@
+// Begin Source File HistoryPayloadCache.h
+#ifndef HISTORYPAYLOADCACHE_H
+#define HISTORYPAYLOADCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QLatin1StringView>
+#include <QList>
+
+struct ChatMessage;
+
+// Incremental builder of the request body (see Interlocutor::m_historyCache).
+//
+// From one turn to the next the history sent to a provider only grows by a
+// couple of messages at the end (and loses a block at the start after a
+// curation); re-encoding the whole QJsonArray every time meant megabytes of
+// allocations on the GUI thread for a 200k-token context. The builder keeps
+// the compact JSON of every history item it encoded, keyed by the identity of
+// its messages (Key: timestamp, role, flags and text bytes), and the final
+// body is spliced from these fragments into a single preallocated QByteArray.
+// The hash only locates a fragment: the whole key is compared before it is
+// reused, so a collision costs an encoding, never another message's JSON.
+//
+// One build:
+//     begin(remember);
+//     appendObject(...)            items rebuilt every time (system prompt...)
+//     append(key, encode)          cached items: encode() only on a miss
+//     QByteArray body = finish(payload, "messages");
+//
+// Fragments not used by a remembered build are dropped at its end, so the
+// cache never holds more than the current history. Builds made with
+// remember = false (curation requests) reuse the fragments but leave the
+// cache untouched.
+class HistoryPayloadCache
+{
+public:
+    // Identité d'un élément : horodatage, rôle, drapeaux et octets du texte de
+    // chacun de ses messages (plusieurs quand des messages sont fusionnés en
+    // un tour). Les textes sont partagés avec les messages, sans copie.
+    class Key
+    {
+    public:
+        Key() = default;
+        explicit Key(const ChatMessage &msg) { add(msg); }
+
+        void add(const ChatMessage &msg);
+        bool operator==(const Key &other) const;
+        friend size_t qHash(const Key &key, size_t seed = 0) { return key.m_hash ^ seed; }
+
+    private:
+        struct Part
+        {
+            qint64 timestampMs = 0;
+            quint8 role = 0;
+            quint8 flags = 0;
+            QByteArray text; // Octets gardés par le message (UTF-8, ou échappés)
+        };
+        QList<Part> m_parts;
+        size_t m_hash = 0;
+    };
+
+    static Key keyOf(const ChatMessage &msg) { return Key(msg); }
+
+    void begin(bool remember);
+
+    // Élément mis en cache : `encode` doit rendre le JSON compact de l'objet.
+    template <typename Encoder>
+    void append(const Key &key, Encoder encode)
+    {
+        QByteArray fragment = take(key);
+        if (fragment.isNull())
+        {
+            fragment = encode();
+            ++m_encoded;
+            if (m_remember)
+                m_current.insert(key, fragment);
+        }
+        appendFragment(fragment);
+    }
+
+    // Élément reconstruit à chaque requête.
+    void appendObject(const QJsonObject &object);
+
+    // Le corps de la requête : `payload` compact, plus le tableau `arrayKey`
+    // formé des éléments ajoutés depuis begin().
+    QByteArray finish(const QJsonObject &payload, QLatin1StringView arrayKey);
+
+    void clear();
+
+    static QByteArray encodeObject(const QJsonObject &object);
+
+private:
+    QByteArray take(const Key &key);
+    void appendFragment(const QByteArray &fragment);
+
+    QHash<Key, QByteArray> m_current;  // Fragments de la dernière construction retenue
+    QHash<Key, QByteArray> m_previous; // Construction précédente, pendant begin()/finish()
+    QList<QByteArray> m_parts;            // Partagés avec le cache, sans copie
+    qsizetype m_partBytes = 0;
+    bool m_remember = false;
+    int m_reused = 0;
+    int m_encoded = 0;
+    qint64 m_beginNs = -1; // Début de la construction (Tracer), -1 hors traçage
+};
+
+#endif // HISTORYPAYLOADCACHE_H
+// End Source File HistoryPayloadCache.h
@@ -1 +1,20 @@
-// Source file Interlocutor.cpp is an empty file.
+// Begin Source File Interlocutor.cpp
+#include "Interlocutor.h"
+
+#include <QDebug>
+
+void Interlocutor::emitCancelledReply(InterlocutorReply partial)
+{
+    partial.wasCancelled = true;
+    partial.isIncomplete = true;
+    // L'usage n'arrive qu'en fin de flux chez la plupart des fournisseurs :
+    // la sortie est comptée localement, l'entrée reste celle annoncée (0 si
+    // inconnue).
+    if (partial.outputTokens == 0 && !partial.text.isEmpty())
+        partial.outputTokens = tokenizer().countTokens(partial.text);
+    partial.totalTokens = partial.inputTokens + partial.outputTokens;
+    qDebug() << name() << ": request cancelled, kept" << partial.text.size()
+             << "characters, in=" << partial.inputTokens << "out=" << partial.outputTokens;
+    emit replyReady(partial);
+}
+// End Source File Interlocutor.cpp
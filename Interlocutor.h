@@ -4,8 +4,13 @@
 
 #include <QJsonObject>
 #include <QObject>
+#include <memory>
 #include "ChatMessage.h"
+#include "HistoryPayloadCache.h"
 #include "InterlocutorReply.h"
+#include "RequestHandle.h"
+#include "RequestScheduler.h"
+#include "Tokenizer.h"
 
 class Interlocutor : public QObject
 {
@@ -18,22 +23,56 @@ public:
     }
     virtual ~Interlocutor() {}
 
-    virtual void sendRequest(
+    // Returns the handle of the request (progress, cancel()), or nullptr if
+    // it failed at once (errorOccurred() already emitted).
+    //
+    // `recall`: passages recalled from the archive for this turn only (see
+    // ChatModel::sendWithRecall). It is sent in a block of its own after the
+    // last user message, outside the prefix the provider caches; the
+    // messages themselves go out byte-identical from one turn to the next.
+    virtual RequestHandle *sendRequest(
         const QList<ChatMessage> &history,
         const QString& ancientMemory,
         const InterlocutorReply::Kind kind,
-        const QStringList &attachmentFileIds) = 0;
+        const QStringList &attachmentFileIds,
+        const QString &recall = QString()) = 0;
 
     virtual void uploadFile(QString fileName, const QByteArray &content, const QString &purpose) = 0;
     virtual void deleteFile(const QString &fileId) = 0;
     virtual void setSystemPrompt(const QString &systemPrompt) {
         m_systemPrompt = systemPrompt;
     }
-    
+
+    // Streaming (SSE) mode: NormalMessage requests are sent with "stream": true
+    // and every text delta is emitted through replyChunk() as soon as it
+    // arrives. replyReady() is still emitted once at the end, with the full
+    // text and the usage counts, so the curation accounting is unchanged.
+    // Curation requests are never streamed.
+    void setStreamingEnabled(bool enabled) { m_streamingEnabled = enabled; }
+    bool streamingEnabled() const { return m_streamingEnabled; }
+
+    // Tokenizer of the model behind this interlocutor (models.ini "tokenizer"
+    // key), used for every local token estimate. Never null.
+    void setTokenizer(std::shared_ptr<const Tokenizer> tokenizer) { m_tokenizer = std::move(tokenizer); }
+    const Tokenizer &tokenizer() const { return m_tokenizer ? *m_tokenizer : *Tokenizer::approximate(); }
+
+    // Priority of this instance's requests in the RequestScheduler, set by
+    // ChatManager (Duo for the instances of a duo, Background for curators).
+    // Curation requests are Background whatever the instance.
+    void setRequestPriority(RequestScheduler::Priority priority) { m_requestPriority = priority; }
+    RequestScheduler::Priority requestPriority(InterlocutorReply::Kind kind) const
+    {
+        return kind == InterlocutorReply::Kind::CurationResult
+                   ? RequestScheduler::Priority::Background
+                   : m_requestPriority;
+    }
+
     QString name() const { return m_interlocutorName; }
 
 signals:
     void replyReady(const InterlocutorReply &reply);
+    // Fragment de texte d'une réponse en cours de streaming (mode SSE)
+    void replyChunk(const QString &delta, InterlocutorReply::Kind kind);
     void errorOccurred(const QString &error);
 
     // Uniquement pour les PDF uploadés par l'utilisateur :
@@ -42,12 +81,22 @@ signals:
     void fileDeleted(const QString &fileId, bool success);
 
 protected:
+    // Emits the reply of a cancelled request: what had been received, with
+    // the output tokens estimated if the provider had not counted them yet.
+    void emitCancelledReply(InterlocutorReply partial);
+
     // m_interlocutorName: That's the name that the user entered in the 'configuration' tab.
     // Important for:
     //   (1) naming the jsonl file of the current discussion and the other informations
     //   (2) being displayed in the combo box for chosing the current interlocutor
     QString m_interlocutorName;
     QString m_systemPrompt; // Copie locale du system prompt changé par le ChatManager à chaque changement d'interlocuteur
+    bool m_streamingEnabled = true;
+    RequestScheduler::Priority m_requestPriority = RequestScheduler::Priority::Interactive;
+    std::shared_ptr<const Tokenizer> m_tokenizer;
+    // JSON déjà encodé des messages de l'historique, réutilisé d'un tour à
+    // l'autre (requêtes NormalMessage ; voir HistoryPayloadCache)
+    HistoryPayloadCache m_historyCache;
 
 };
 
@@ -56,6 +56,18 @@ void InterlocutorConfig::setModelName(const QString &modelName)
     }
 }
 
+QString InterlocutorConfig::curatorModelName() const
+{
+    return m_curatorModelName;
+}
+void InterlocutorConfig::setCuratorModelName(const QString &curatorModelName)
+{
+    if (m_curatorModelName != curatorModelName) {
+        m_curatorModelName = curatorModelName;
+        emit curatorModelNameChanged();
+    }
+}
+
 // QString InterlocutorConfig::ancientMemoryFileId()
 // {
 //     return m_ancientMemoryFileId;
@@ -76,6 +88,7 @@ void InterlocutorConfig::read(const QJsonObject &json) {
     setEndpointUrl(json["endpointUrl"].toString());
     setSystemPrompt(json["systemPrompt"].toString());
     setModelName(json["modelName"].toString());
+    setCuratorModelName(json["curatorModelName"].toString());
 
 }
 
@@ -86,5 +99,6 @@ void InterlocutorConfig::write(QJsonObject &json) const {
     json["endpointUrl"] = m_endpointUrl;
     json["systemPrompt"] = m_systemPrompt;
     json["modelName"] = m_modelName;
+    json["curatorModelName"] = m_curatorModelName;
 }
 // End source file InterlocutorConfig.cpp
@@ -15,6 +15,7 @@ class InterlocutorConfig : public QObject
     Q_PROPERTY(QString endpointUrl READ endpointUrl WRITE setEndpointUrl NOTIFY endpointUrlChanged)
     Q_PROPERTY(QString systemPrompt READ systemPrompt WRITE setSystemPrompt NOTIFY systemPromptChanged)
     Q_PROPERTY(QString modelName READ modelName WRITE setModelName NOTIFY modelNameChanged)
+    Q_PROPERTY(QString curatorModelName READ curatorModelName WRITE setCuratorModelName NOTIFY curatorModelNameChanged)
 
 public:
     explicit InterlocutorConfig(QObject *parent = nullptr);
@@ -41,6 +42,11 @@ public:
     QString modelName() const;
     void setModelName(const QString &modelName);
 
+    // Modèle (du même fournisseur) qui rédige la mémoire ; vide : le modèle
+    // du chat
+    QString curatorModelName() const;
+    void setCuratorModelName(const QString &curatorModelName);
+
 signals:
     void nameChanged();
     void typeChanged();
@@ -48,6 +54,7 @@ signals:
     void endpointUrlChanged();
     void systemPromptChanged();
     void modelNameChanged();
+    void curatorModelNameChanged();
 
 private:
     QString m_name;
@@ -56,6 +63,7 @@ private:
     QString m_endpointUrl;
     QString m_systemPrompt;
     QString m_modelName;
+    QString m_curatorModelName;
     // QString m_ancientMemoryFileId;
 };
 
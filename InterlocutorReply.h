@@ -15,7 +15,37 @@ struct InterlocutorReply {
     int inputTokens = 0;
     int outputTokens = 0;
     int totalTokens = 0; // Ajoutons le total, c'est souvent fourni
+    // Cache de préfixe du fournisseur : part de inputTokens lue depuis le
+    // cache / écrite dans le cache (inputTokens les inclut toujours).
+    int cacheReadTokens = 0;
+    int cacheWriteTokens = 0;
     bool isIncomplete = false;
+    // Arrêtée par l'utilisateur (RequestHandle::cancel) : texte et usage
+    // partiels, isIncomplete aussi levé
+    bool wasCancelled = false;
+
+    // Chronologie de la requête, en ms depuis sendRequest() ; -1 : inconnue
+    // (voir RequestHandle::recordTimings)
+    qint64 sentMs = -1;      // Confiée au réseau : pièces jointes vérifiées, corps construit
+    qint64 firstByteMs = -1; // Premier octet de la réponse
+    qint64 totalMs = -1;     // Réponse complète
+    bool streamed = false;   // Réponse SSE : le texte a coulé du premier au dernier octet
+
+    // Attente du serveur, de l'envoi au premier octet (file du planificateur
+    // et nouvelles tentatives comprises).
+    qint64 serverLatencyMs() const
+    {
+        return (sentMs >= 0 && firstByteMs >= sentMs) ? firstByteMs - sentMs : -1;
+    }
+    // Débit de sortie : depuis le premier octet pour un flux, depuis l'envoi
+    // sinon (la génération précède alors le premier octet).
+    double tokensPerSecond() const
+    {
+        const qint64 from = streamed ? firstByteMs : sentMs;
+        if (outputTokens <= 0 || from < 0 || totalMs <= from)
+            return 0.0;
+        return outputTokens * 1000.0 / double(totalMs - from);
+    }
 };
 
 // Indispensable pour utiliser cette structure dans les signaux/slots
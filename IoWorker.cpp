@@ -0,0 +1,363 @@
+// Begin Source File IoWorker.cpp
+#include "IoWorker.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSettings>
+#include <QTimer>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Politique "batched" : au plus un fsync par intervalle tant que ça écrit.
+const int kBatchedSyncMs = 1000;
+// Politique "idle" : fsync après ce délai sans nouvelle écriture.
+const int kIdleSyncMs = 3000;
+
+IoWorker::SyncPolicy policyFromSettings()
+{
+    QSettings settings("Tether", "ChatApp");
+    const QString policy = settings.value("io/syncPolicy", "batched").toString();
+    if (policy == QLatin1String("message"))
+        return IoWorker::SyncPolicy::PerWrite;
+    if (policy == QLatin1String("idle"))
+        return IoWorker::SyncPolicy::OnIdle;
+    if (policy != QLatin1String("batched"))
+        qWarning() << "Unknown io/syncPolicy" << policy << "- using \"batched\".";
+    return IoWorker::SyncPolicy::Batched;
+}
+
+bool writeWholeFile(const QString &path, const QByteArray &content, const QString &backupPath)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    if (!backupPath.isEmpty() && QFile::exists(path))
+    {
+        if (!QFile::copy(path, backupPath))
+        {
+            qWarning() << "Failed to back up" << path << "to" << backupPath;
+            return false; // On ne détruit rien sans sauvegarde
+        }
+        qDebug() << "Backed up" << path << "to:" << backupPath;
+    }
+
+    // Fichier temporaire renommé à la fin : l'ancien contenu reste intact si
+    // l'écriture échoue en route.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qWarning() << "Failed to open file for writing:" << path;
+        return false;
+    }
+    file.write(content);
+    if (!file.commit())
+    {
+        qWarning() << "Failed to write file:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+IoWorker &IoWorker::instance()
+{
+    static IoWorker worker;
+    return worker;
+}
+
+IoWorker::IoWorker()
+    : m_policy(policyFromSettings())
+{
+    m_thread.setObjectName("TetherIo");
+    m_context = new QObject;
+    m_context->moveToThread(&m_thread);
+    m_thread.start();
+}
+
+IoWorker::~IoWorker()
+{
+    // shutdown() a normalement déjà tout écrit (fin de main()).
+    if (m_thread.isRunning())
+    {
+        m_thread.quit();
+        m_thread.wait();
+    }
+    delete m_context;
+}
+
+void IoWorker::post(std::function<void()> job)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stopped)
+    {
+        locker.unlock();
+        job();
+        commit(true);
+        return;
+    }
+    m_queue.append(std::move(job));
+    ++m_posted;
+    if (!m_scheduled)
+    {
+        m_scheduled = true;
+        QMetaObject::invokeMethod(m_context, [this]() { processQueue(); }, Qt::QueuedConnection);
+    }
+}
+
+void IoWorker::processQueue()
+{
+    const bool perWrite = (m_policy == SyncPolicy::PerWrite);
+    forever
+    {
+        QList<std::function<void()>> jobs;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty())
+            {
+                m_scheduled = false;
+                return;
+            }
+            jobs.swap(m_queue);
+        }
+
+        for (const std::function<void()> &job : std::as_const(jobs))
+        {
+            job();
+            if (perWrite)
+                commit(true);
+        }
+        if (!perWrite)
+        {
+            commit(false);
+            scheduleSync();
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_completed += jobs.size();
+        m_idle.wakeAll();
+    }
+}
+
+void IoWorker::commit(bool sync)
+{
+    for (QFile *file : std::as_const(m_openFiles))
+    {
+        if (!(sync ? syncFile(*file) : file->flush()))
+            qWarning() << "Failed to flush" << file->fileName();
+    }
+
+    QList<std::function<void(bool)>> hooks;
+    {
+        QMutexLocker locker(&m_mutex);
+        hooks = m_commitHooks;
+    }
+    for (const std::function<void(bool)> &hook : std::as_const(hooks))
+        hook(sync);
+    m_unsynced = !sync;
+}
+
+void IoWorker::scheduleSync()
+{
+    if (!m_syncTimer)
+    {
+        m_syncTimer = new QTimer;
+        m_syncTimer->setSingleShot(true);
+        QObject::connect(m_syncTimer, &QTimer::timeout, m_context,
+                         [this]()
+                         {
+                             if (m_unsynced)
+                                 commit(true);
+                         });
+    }
+    if (m_policy == SyncPolicy::OnIdle)
+        m_syncTimer->start(kIdleSyncMs); // Repoussé à chaque lot
+    else if (!m_syncTimer->isActive())
+        m_syncTimer->start(kBatchedSyncMs);
+}
+
+void IoWorker::appendToFile(const QString &path, const QByteArray &bytes)
+{
+    post(
+        [this, path, bytes]()
+        {
+            QFile *file = m_openFiles.value(path);
+            if (!file)
+            {
+                QDir().mkpath(QFileInfo(path).absolutePath());
+                file = new QFile(path);
+                if (!file->open(QIODevice::Append | QIODevice::Text))
+                {
+                    qWarning() << "Failed to open file for appending:" << path;
+                    delete file;
+                    return;
+                }
+                m_openFiles.insert(path, file);
+            }
+            if (file->write(bytes) != bytes.size())
+                qWarning() << "Failed to append to" << path;
+        });
+}
+
+void IoWorker::replaceFile(const QString &path, const QByteArray &content,
+                           const QString &backupPath, QObject *context,
+                           std::function<void(bool)> done)
+{
+    quint64 ticket = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        ticket = ++m_nextTicket;
+        m_pending.insert(path, {ticket, content});
+    }
+
+    QPointer<QObject> receiver(context);
+    const bool notify = context && done;
+    post(
+        [this, path, content, backupPath, ticket, receiver, notify, done]()
+        {
+            const bool ok = writeWholeFile(path, content, backupPath);
+            {
+                // Une écriture plus récente du même fichier reste en attente.
+                QMutexLocker locker(&m_mutex);
+                auto it = m_pending.find(path);
+                if (it != m_pending.end() && it.value().first == ticket)
+                    m_pending.erase(it);
+            }
+            if (notify)
+            {
+                QMetaObject::invokeMethod(
+                    QCoreApplication::instance(),
+                    [receiver, done, ok]()
+                    {
+                        if (receiver)
+                            done(ok);
+                    },
+                    Qt::QueuedConnection);
+            }
+        });
+}
+
+bool IoWorker::pendingContent(const QString &path, QByteArray &content) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_pending.constFind(path);
+    if (it == m_pending.constEnd())
+        return false;
+    content = it.value().second;
+    return true;
+}
+
+void IoWorker::drain()
+{
+    if (isWorkerThread())
+        return;
+    QMutexLocker locker(&m_mutex);
+    const quint64 target = m_posted;
+    while (m_completed < target && !m_stopped)
+        m_idle.wait(&m_mutex);
+}
+
+void IoWorker::setSyncPolicy(SyncPolicy policy)
+{
+    drain();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_stopped || isWorkerThread())
+        {
+            m_policy = policy;
+            return;
+        }
+    }
+    // Le lot en cours et le fsync en attente se terminent avec l'ancienne politique.
+    QMetaObject::invokeMethod(
+        m_context,
+        [this, policy]()
+        {
+            if (m_syncTimer)
+                m_syncTimer->stop();
+            commit(true);
+            m_policy = policy;
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void IoWorker::shutdown()
+{
+    drain();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_stopped)
+            return;
+        m_stopped = true;
+    }
+    // Passe après un éventuel processQueue() encore en file d'événements.
+    QMetaObject::invokeMethod(
+        m_context,
+        [this]()
+        {
+            commit(true);
+            delete m_syncTimer;
+            m_syncTimer = nullptr;
+            qDeleteAll(m_openFiles);
+            m_openFiles.clear();
+        },
+        Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    m_idle.wakeAll();
+}
+
+void IoWorker::addCommitHook(std::function<void(bool sync)> hook)
+{
+    QMutexLocker locker(&m_mutex);
+    m_commitHooks.append(std::move(hook));
+}
+
+bool IoWorker::syncFile(QFile &file)
+{
+    if (!file.flush())
+        return false;
+#if defined(Q_OS_WIN)
+    // QFile n'ouvre un descripteur CRT que s'il a été construit sur un fd ;
+    // ouvert par son nom, handle() vaut -1. FlushFileBuffers vide le cache du
+    // fichier entier, quel que soit le HANDLE en écriture qui le demande : à
+    // défaut de descripteur, on en ouvre un le temps de l'appel.
+    const int fd = file.handle();
+    if (fd >= 0)
+    {
+        const HANDLE handle = reinterpret_cast<HANDLE>(::_get_osfhandle(fd));
+        if (handle != INVALID_HANDLE_VALUE)
+            return ::FlushFileBuffers(handle) != 0;
+    }
+    const std::wstring path = QDir::toNativeSeparators(file.fileName()).toStdWString();
+    const HANDLE handle = ::CreateFileW(path.c_str(), GENERIC_WRITE,
+                                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    const bool ok = ::FlushFileBuffers(handle) != 0;
+    ::CloseHandle(handle);
+    return ok;
+#elif defined(Q_OS_DARWIN)
+    // fsync() ne traverse pas le cache du disque sur macOS
+    return ::fcntl(file.handle(), F_FULLFSYNC) == 0 || ::fsync(file.handle()) == 0;
+#else
+    return ::fdatasync(file.handle()) == 0;
+#endif
+}
+// End Source File IoWorker.cpp
@@ -0,0 +1,117 @@
+// Begin Source File IoWorker.h
+#ifndef IOWORKER_H
+#define IOWORKER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <functional>
+
+class QObject;
+class QTimer;
+
+// The single thread that performs Tether's file writes.
+//
+// Journal appends (JournalFile), memory and notebook rewrites (MemoryCurator,
+// the notes of the interlocutors) and the global log (TetherLogger) used to
+// open, write and close their file on the GUI thread, once per message. They
+// now post a job to this worker and return at once: jobs run in FIFO order,
+// so a cull or a truncation queued after an append always sees it.
+//
+// Files written often stay open and are written through QFile's buffer; a
+// batch (all the jobs queued at the time the worker wakes up) ends with a
+// single commit — buffers flushed, journal indexes updated — and, depending on
+// the sync policy (settings key "io/syncPolicy"), an fsync:
+//   "message"  after every job: a reported write is on the disk;
+//   "batched"  at most one per second while writes keep coming (default);
+//   "idle"     once the writes have stopped for a few seconds.
+// Without the fsync, a crash of the process loses nothing (the data is in the
+// system cache); only a power cut can lose the last unsynced batch.
+//
+// Whole-file replacements go through QSaveFile: the old file stays intact if
+// the write fails. Until the job has run, pendingContent() returns the queued
+// content, so that readers on the GUI thread see their own writes.
+class IoWorker
+{
+public:
+    enum class SyncPolicy { PerWrite, Batched, OnIdle };
+
+    static IoWorker &instance();
+
+    // Runs `job` on the worker thread, after every job posted before it.
+    void post(std::function<void()> job);
+
+    // Appends `bytes` to `path` (created if needed), kept open between calls.
+    void appendToFile(const QString &path, const QByteArray &bytes);
+
+    // Replaces `path` with `content` (text mode). If `backupPath` is set, the
+    // current file is first copied there, and the write is abandoned if that
+    // copy fails. `done(ok)`, if given, then runs on the GUI thread (dropped
+    // if `context` has been destroyed meanwhile).
+    void replaceFile(const QString &path, const QByteArray &content,
+                     const QString &backupPath = QString(), QObject *context = nullptr,
+                     std::function<void(bool)> done = {});
+
+    // Content of a replaceFile() not written yet for `path`.
+    bool pendingContent(const QString &path, QByteArray &content) const;
+
+    // Blocks until every job posted so far has run and been committed.
+    // No-op on the worker thread itself.
+    void drain();
+
+    // Final commit with fsync, then stops the thread. Jobs posted afterwards
+    // run directly on the caller's thread.
+    void shutdown();
+
+    SyncPolicy syncPolicy() const { return m_policy; }
+    // Changes the policy for the following batches (tether_bench compares
+    // them). Waits for the queued jobs, which are committed with an fsync.
+    void setSyncPolicy(SyncPolicy policy);
+    bool isWorkerThread() const { return QThread::currentThread() == &m_thread; }
+
+    // Called on the worker at the end of every batch, under no lock; `sync`
+    // asks for the written data to be forced to disk. JournalFile registers
+    // the commit of its buffered appends here.
+    void addCommitHook(std::function<void(bool sync)> hook);
+
+    // fdatasync (fsync / F_FULLFSYNC / FlushFileBuffers depending on the platform),
+    // after flushing QFile's buffer.
+    static bool syncFile(QFile &file);
+
+private:
+    IoWorker();
+    ~IoWorker();
+
+    void processQueue();
+    void commit(bool sync);
+    void scheduleSync();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_idle;
+    QList<std::function<void()>> m_queue;
+    quint64 m_posted = 0;
+    quint64 m_completed = 0;
+    bool m_scheduled = false;
+    bool m_stopped = false;
+    quint64 m_nextTicket = 0;
+    QHash<QString, QPair<quint64, QByteArray>> m_pending; // replaceFile() en attente
+    QList<std::function<void(bool)>> m_commitHooks;
+
+    SyncPolicy m_policy = SyncPolicy::Batched; // Lue au démarrage, changée sur m_thread
+    QThread m_thread;
+    QObject *m_context = nullptr; // Vit sur m_thread : cible des invokeMethod
+
+    // Propriété du thread de l'IoWorker
+    QHash<QString, QFile *> m_openFiles; // Fichiers d'appendToFile()
+    QTimer *m_syncTimer = nullptr;
+    bool m_unsynced = false;
+};
+
+#endif // IOWORKER_H
+// End Source File IoWorker.h
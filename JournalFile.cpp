@@ -0,0 +1,982 @@
+// Begin Source File JournalFile.cpp
+#include "JournalFile.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QThreadPool>
+#include <QtEndian>
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+
+#include "IoWorker.h"
+#include "Tracer.h"
+
+namespace
+{
+// Format de l'index : en-tête fixe de 32 octets, suivi d'une entrée de 16
+// octets par record du journal (little-endian).
+//   0  magic       "TJIX"
+//   4  version
+//   8  liveStart   premier record vivant (les précédents sont résumés)
+//   12 recordCount
+//   16 indexedSize taille du journal couverte par l'index
+//   24 (réservé)
+// Entrée :
+//   0  offset      début du record (qint64)
+//   8  length      taille de la ligne, sans le '\n'
+//   12 crc         CRC32C de la ligne
+// La version 1 ne stockait que l'offset ; elle est réindexée à l'ouverture,
+// watermark conservé.
+const quint32 kIndexMagic = 0x58494a54; // "TJIX" lu en little-endian
+const quint32 kIndexVersion = 2;
+const quint32 kLegacyIndexVersion = 1;
+const qint64 kHeaderSize = 32;
+const qint64 kEntrySize = 16;
+
+// Entrées vérifiées à la reprise : bien plus qu'un lot de l'IoWorker (une
+// seconde d'ajouts en mode "batched").
+const quint32 kVerifyWindow = 256;
+
+// Une compaction est planifiée dès que le préfixe coupé dépasse cette taille.
+const qint64 kCompactionMinDeadBytes = 64 * 1024;
+const qint64 kBlockSize = 1024 * 1024;
+
+struct IndexHeader
+{
+    quint32 liveStart = 0;
+    quint32 recordCount = 0;
+    qint64 indexedSize = 0;
+};
+
+struct IndexEntry
+{
+    qint64 offset = 0;
+    quint32 length = 0;
+    quint32 crc = 0;
+};
+
+// CRC32C (Castagnoli), chaînable : crc32c(b, crc32c(a)) == crc32c(a + b).
+quint32 crc32c(const char *data, qint64 size, quint32 crc = 0)
+{
+    static const std::array<quint32, 256> table = []()
+    {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i)
+        {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? (c >> 1) ^ 0x82f63b78 : (c >> 1);
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (qint64 i = 0; i < size; ++i)
+        crc = table[(crc ^ quint8(data[i])) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+QMutex &journalMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+// Incrémentée (sous journalMutex) par toute opération qui invalide les offsets
+// d'un journal : troncature, suppression, reconstruction de l'index. Une
+// compaction en cours la compare avant de remplacer les fichiers.
+QHash<QString, quint64> &journalEpochs()
+{
+    static QHash<QString, quint64> epochs;
+    return epochs;
+}
+
+QSet<QString> &compactionsInFlight()
+{
+    static QSet<QString> paths;
+    return paths;
+}
+
+// Journaux dont la fin a déjà été vérifiée depuis le lancement.
+QSet<QString> &recoveredJournals()
+{
+    static QSet<QString> paths;
+    return paths;
+}
+
+QByteArray encodeHeader(const IndexHeader &header)
+{
+    QByteArray bytes(kHeaderSize, '\0');
+    char *p = bytes.data();
+    qToLittleEndian<quint32>(kIndexMagic, p);
+    qToLittleEndian<quint32>(kIndexVersion, p + 4);
+    qToLittleEndian<quint32>(header.liveStart, p + 8);
+    qToLittleEndian<quint32>(header.recordCount, p + 12);
+    qToLittleEndian<qint64>(header.indexedSize, p + 16);
+    return bytes;
+}
+
+bool decodeHeader(const QByteArray &bytes, IndexHeader &header, quint32 &version)
+{
+    if (bytes.size() < kHeaderSize)
+        return false;
+    const char *p = bytes.constData();
+    version = qFromLittleEndian<quint32>(p + 4);
+    if (qFromLittleEndian<quint32>(p) != kIndexMagic ||
+        (version != kIndexVersion && version != kLegacyIndexVersion))
+        return false;
+    header.liveStart = qFromLittleEndian<quint32>(p + 8);
+    header.recordCount = qFromLittleEndian<quint32>(p + 12);
+    header.indexedSize = qFromLittleEndian<qint64>(p + 16);
+    return header.liveStart <= header.recordCount && header.indexedSize >= 0;
+}
+
+QByteArray encodeEntries(const QList<IndexEntry> &entries)
+{
+    QByteArray bytes(entries.size() * kEntrySize, '\0');
+    char *p = bytes.data();
+    for (const IndexEntry &entry : entries)
+    {
+        qToLittleEndian<qint64>(entry.offset, p);
+        qToLittleEndian<quint32>(entry.length, p + 8);
+        qToLittleEndian<quint32>(entry.crc, p + 12);
+        p += kEntrySize;
+    }
+    return bytes;
+}
+
+QList<IndexEntry> readEntries(const QString &indexPath, quint32 first, quint32 count)
+{
+    QList<IndexEntry> entries;
+    QFile index(indexPath);
+    if (count == 0 || !index.open(QIODevice::ReadOnly) ||
+        !index.seek(kHeaderSize + qint64(first) * kEntrySize))
+        return entries;
+    const QByteArray bytes = index.read(qint64(count) * kEntrySize);
+    entries.reserve(bytes.size() / kEntrySize);
+    for (qsizetype i = 0; i + kEntrySize <= bytes.size(); i += kEntrySize)
+    {
+        const char *p = bytes.constData() + i;
+        entries.append({qFromLittleEndian<qint64>(p), qFromLittleEndian<quint32>(p + 8),
+                        qFromLittleEndian<quint32>(p + 12)});
+    }
+    return entries;
+}
+
+qint64 readEntry(const QString &indexPath, quint32 i)
+{
+    const QList<IndexEntry> entries = readEntries(indexPath, i, 1);
+    return entries.isEmpty() ? -1 : entries.first().offset;
+}
+
+// Ajoute à `entries` chaque ligne non vide de [from, end), `from` étant un
+// début de ligne. La dernière peut ne pas être terminée par '\n' : son entrée
+// atteint alors `end` (voir closeLastLine).
+bool scanRecords(QFile &journal, qint64 from, qint64 end, QList<IndexEntry> &entries)
+{
+    if (!journal.seek(from))
+        return false;
+
+    bool atLineStart = true;
+    bool inRecord = false;
+    IndexEntry current;
+    qint64 pos = from;
+    while (pos < end)
+    {
+        const QByteArray block = journal.read(qMin(kBlockSize, end - pos));
+        if (block.isEmpty())
+            return false;
+        const char *data = block.constData();
+        qsizetype i = 0;
+        while (i < block.size())
+        {
+            if (atLineStart)
+            {
+                inRecord = (data[i] != '\n' && data[i] != '\r');
+                if (inRecord)
+                    current = {pos + i, 0, 0};
+                atLineStart = false;
+            }
+            const void *newline = std::memchr(data + i, '\n', size_t(block.size() - i));
+            const qsizetype stop = newline ? static_cast<const char *>(newline) - data
+                                           : block.size();
+            if (inRecord)
+            {
+                current.crc = crc32c(data + i, stop - i, current.crc);
+                current.length += quint32(stop - i);
+            }
+            if (!newline)
+                break;
+            if (inRecord)
+                entries.append(current);
+            inRecord = false;
+            atLineStart = true;
+            i = stop + 1;
+        }
+        pos += block.size();
+    }
+    if (inRecord)
+        entries.append(current);
+    return true;
+}
+
+// Dernière ligne sans '\n' : un ajout interrompu par un arrêt brutal, ou une
+// édition à la main. Un objet JSON complet est gardé et terminé ; une ligne
+// déchirée est coupée du journal.
+bool closeLastLine(const QString &path, QList<IndexEntry> &entries, qint64 &journalSize)
+{
+    if (entries.isEmpty() || entries.last().offset + entries.last().length < journalSize)
+        return true;
+
+    const IndexEntry last = entries.last();
+    QFile journal(path);
+    if (!journal.open(QIODevice::ReadWrite) || !journal.seek(last.offset))
+        return false;
+    const QByteArray line = journal.read(last.length);
+    if (QJsonDocument::fromJson(line).isObject())
+    {
+        if (!journal.seek(journalSize) || !journal.putChar('\n'))
+            return false;
+        ++journalSize;
+        return true;
+    }
+
+    qWarning() << "Dropping torn record at the end of" << path << "(" << line.size() << "bytes )";
+    if (!journal.resize(last.offset))
+        return false;
+    journalSize = last.offset;
+    entries.removeLast();
+    journalEpochs()[path]++;
+    return true;
+}
+
+// Remonte les derniers records indexés jusqu'au premier dont la ligne est
+// intacte (longueur, '\n' et CRC32C conformes à l'entrée). En mode "batched"
+// l'index d'un lot peut atteindre le disque avant le journal : après un arrêt
+// brutal, les entrées qui suivent ne décrivent plus rien. Rend le nombre de
+// records intacts et, dans `end`, la fin du dernier.
+quint32 intactRecordCount(const QString &path, quint32 recordCount, qint64 journalSize, qint64 &end)
+{
+    end = 0;
+    QFile journal(path);
+    if (!journal.open(QIODevice::ReadOnly))
+        return 0;
+
+    const QString indexPath = path + ".idx";
+    quint32 count = recordCount;
+    while (count > 0)
+    {
+        const QList<IndexEntry> entries = readEntries(indexPath, count - 1, 1);
+        if (!entries.isEmpty())
+        {
+            const IndexEntry &entry = entries.first();
+            const qint64 lineEnd = entry.offset + entry.length;
+            if (entry.offset >= 0 && lineEnd < journalSize && journal.seek(entry.offset))
+            {
+                const QByteArray line = journal.read(qint64(entry.length) + 1);
+                if (line.size() == qint64(entry.length) + 1 && line.back() == '\n' &&
+                    crc32c(line.constData(), entry.length) == entry.crc)
+                {
+                    end = lineEnd + 1;
+                    break;
+                }
+            }
+        }
+        --count;
+    }
+    return count;
+}
+
+// Vérification des dernières entrées de l'index (fenêtre kVerifyWindow),
+// dans l'ordre du journal. Une entrée dont la ligne n'occupe plus exactement
+// sa place (absente, coupée, sans '\n', décalée) marque le début de la fin
+// déchirée : elle et les suivantes sont abandonnées, la fin est réindexée.
+// Une ligne bien en place mais dont le CRC32C ne correspond pas est corrompue :
+// elle est rejetée (voir rejectRecords) et la vérification continue.
+struct TailCheck
+{
+    quint32 intact = 0; // Entrées avant la première déchirée
+    qint64 end = 0;     // Fin (après le '\n') de la dernière de ces entrées
+    QList<quint32> corrupted;
+    QList<IndexEntry> corruptedEntries;
+};
+
+TailCheck checkTail(const QString &path, quint32 recordCount, qint64 journalSize)
+{
+    TailCheck check;
+    const quint32 first = recordCount > kVerifyWindow ? recordCount - kVerifyWindow : 0;
+    const quint32 from = first > 0 ? first - 1 : 0; // L'entrée d'avant donne `end`
+    const QList<IndexEntry> entries = readEntries(path + ".idx", from, recordCount - from);
+    check.intact = first;
+    if (first > 0 && !entries.isEmpty())
+        check.end = entries.first().offset + entries.first().length + 1;
+
+    QFile journal(path);
+    if (!journal.open(QIODevice::ReadOnly))
+        return check;
+    for (quint32 i = first; i < recordCount; ++i)
+    {
+        if (qsizetype(i - from) >= entries.size())
+            break;
+        const IndexEntry &entry = entries.at(i - from);
+        // La ligne, avec le '\n' qui la précède (sauf en tête) et le sien
+        const qint64 before = (entry.offset > 0) ? 1 : 0;
+        const qint64 expected = before + qint64(entry.length) + 1;
+        if (entry.offset < 0 || entry.offset + entry.length >= journalSize ||
+            !journal.seek(entry.offset - before))
+            break;
+        const QByteArray line = journal.read(expected);
+        if (line.size() != expected || (before && line.front() != '\n') || line.back() != '\n')
+            break;
+        if (crc32c(line.constData() + before, entry.length) != entry.crc)
+        {
+            check.corrupted.append(i);
+            check.corruptedEntries.append(entry);
+        }
+        check.intact = i + 1;
+        check.end = entry.offset + entry.length + 1;
+    }
+    return check;
+}
+
+// Efface les records corrompus sans déplacer les suivants : leurs octets
+// deviennent des '\n', des lignes vides que scanRecords() et JournalReader
+// ignorent. Les entrées correspondantes sont retirées de `entries` (index
+// complet), et le watermark recule d'autant s'il les avait dépassées.
+bool rejectRecords(const QString &path, const TailCheck &check, QList<IndexEntry> &entries,
+                   IndexHeader &header)
+{
+    QFile journal(path);
+    if (!journal.open(QIODevice::ReadWrite))
+        return false;
+    for (const IndexEntry &entry : check.corruptedEntries)
+    {
+        const QByteArray blank(entry.length, '\n');
+        if (!journal.seek(entry.offset) || journal.write(blank) != blank.size())
+            return false;
+    }
+    if (!IoWorker::syncFile(journal))
+        return false;
+    for (qsizetype k = check.corrupted.size() - 1; k >= 0; --k)
+    {
+        const quint32 i = check.corrupted.at(k);
+        entries.removeAt(i);
+        if (i < header.liveStart)
+            --header.liveStart;
+    }
+    header.recordCount = quint32(entries.size());
+    return true;
+}
+
+// Index reconstruit d'un bloc : QSaveFile, l'ancien reste en place en cas
+// d'échec.
+bool writeIndex(const QString &indexPath, const IndexHeader &header,
+                const QList<IndexEntry> &entries)
+{
+    QSaveFile index(indexPath);
+    if (!index.open(QIODevice::WriteOnly))
+        return false;
+    const QByteArray bytes = encodeHeader(header) + encodeEntries(entries);
+    return index.write(bytes) == bytes.size() && index.commit();
+}
+
+// Écrit les entrées [firstEntry, ...) puis l'en-tête (dans cet ordre : un
+// en-tête écrit n'annonce jamais d'entrées absentes).
+bool writeIndexTail(const QString &indexPath, const IndexHeader &header, quint32 firstEntry,
+                    const QList<IndexEntry> &entries, bool sync = false)
+{
+    QFile index(indexPath);
+    if (!index.open(QIODevice::ReadWrite))
+        return false;
+    const QByteArray bytes = encodeEntries(entries);
+    if (!bytes.isEmpty() &&
+        (!index.seek(kHeaderSize + qint64(firstEntry) * kEntrySize) ||
+         index.write(bytes) != bytes.size()))
+        return false;
+    const QByteArray head = encodeHeader(header);
+    return index.seek(0) && index.write(head) == head.size() &&
+           (!sync || IoWorker::syncFile(index));
+}
+
+// Compaction interrompue (arrêt brutal, ou renommage de l'index refusé) : le
+// nouvel index (<journal>.idx.compact) est écrit et synchronisé avant que le
+// journal ne soit échangé, il sert donc de marqueur. S'il reste seul, le
+// journal compacté est déjà en place : on installe son index, et avec lui son
+// watermark. Si la copie du journal est encore là, l'échange n'a pas eu lieu :
+// l'ancien journal et son index sont intacts, on jette la copie. Rend vrai si
+// l'index a été remplacé. Appelant : journalMutex tenu.
+bool finishInterruptedCompaction(const QString &path)
+{
+    const QString tmpIndexPath = path + ".idx.compact";
+    if (!QFile::exists(tmpIndexPath))
+        return false;
+    if (QFile::exists(path + ".compact"))
+    {
+        QFile::remove(tmpIndexPath); // D'abord : c'est lui le marqueur
+        QFile::remove(path + ".compact");
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(QFileInfo(tmpIndexPath).filesystemAbsoluteFilePath(),
+                            QFileInfo(path + ".idx").filesystemAbsoluteFilePath(), error);
+    if (error)
+    {
+        qWarning() << "Failed to install the compacted journal index:" << tmpIndexPath
+                   << QString::fromStdString(error.message());
+        return false;
+    }
+    qDebug() << "Finished an interrupted journal compaction:" << path;
+    journalEpochs()[path]++;
+    return true;
+}
+
+// Met l'index en cohérence avec le journal (rattrapage des octets ajoutés par
+// un autre écrivain, ou reconstruction complète). La première fois pour un
+// journal, ou si l'index décrit plus que le disque n'en contient, la fin de
+// l'index est d'abord vérifiée (checkTail) : c'est la reprise après
+// un arrêt brutal. Appelant : journalMutex tenu.
+bool syncIndex(const QString &path, IndexHeader &header)
+{
+    const QString indexPath = path + ".idx";
+    QFile journal(path);
+    if (!journal.exists())
+    {
+        header = IndexHeader();
+        QFile::remove(indexPath); // Index orphelin d'un journal effacé
+        return true;
+    }
+    qint64 journalSize = journal.size();
+
+    bool valid = false;
+    bool legacy = false;
+    bool verify = finishInterruptedCompaction(path) || !recoveredJournals().contains(path);
+    recoveredJournals().insert(path);
+    QFile index(indexPath);
+    if (index.open(QIODevice::ReadOnly))
+    {
+        quint32 version = 0;
+        if (decodeHeader(index.read(kHeaderSize), header, version))
+        {
+            legacy = (version == kLegacyIndexVersion);
+            valid = !legacy;
+            const qint64 stored = (index.size() - kHeaderSize) / kEntrySize;
+            if (valid && (stored < qint64(header.recordCount) || header.indexedSize > journalSize))
+            {
+                // Index ou journal incomplet sur le disque
+                header.recordCount = quint32(qMin<qint64>(header.recordCount, stored));
+                verify = true;
+            }
+        }
+        index.close();
+    }
+
+    bool repaired = false;
+    TailCheck check;
+    if (valid && verify)
+    {
+        check = checkTail(path, header.recordCount, journalSize);
+        if (check.intact > 0 && check.intact + kVerifyWindow == header.recordCount &&
+            check.corrupted.isEmpty())
+        {
+            // Toute la fenêtre est déchirée : on remonte plus loin.
+            check.intact = intactRecordCount(path, check.intact, journalSize, check.end);
+        }
+        if (check.intact < header.recordCount || !check.corrupted.isEmpty() ||
+            header.indexedSize > journalSize)
+        {
+            if (check.intact < header.recordCount)
+                qWarning() << "Journal" << path << "- dropping"
+                           << header.recordCount - check.intact
+                           << "index entries without an intact record; reindexing the tail.";
+            if (!check.corrupted.isEmpty())
+                qWarning() << "Journal" << path << "- rejecting" << check.corrupted.size()
+                           << "records whose CRC32C does not match.";
+            header.recordCount = check.intact;
+            header.indexedSize = check.end;
+            header.liveStart = qMin(header.liveStart, check.intact);
+            journalEpochs()[path]++;
+            repaired = true;
+        }
+    }
+    if (valid && !repaired && header.indexedSize == journalSize)
+        return true;
+
+    const qint64 from = valid ? header.indexedSize : 0;
+    QList<IndexEntry> entries;
+    if (!journal.open(QIODevice::ReadOnly) || !scanRecords(journal, from, journalSize, entries))
+    {
+        qWarning() << "Failed to scan journal:" << path;
+        return false;
+    }
+    journal.close();
+    if (!closeLastLine(path, entries, journalSize))
+        qWarning() << "Failed to repair the last line of journal:" << path;
+
+    if (!valid)
+    {
+        // Pas d'index (journal d'avant l'index, ou fichier modifié à la main) :
+        // tout le journal redevient vivant. Un index v1 donne les mêmes
+        // records, son watermark reste donc valable.
+        const quint32 legacyLiveStart = legacy ? header.liveStart : 0;
+        if (journalSize > 0)
+            qDebug() << (legacy ? "Upgrading journal index:" : "Rebuilding journal index:")
+                     << indexPath << "(" << entries.size() << "records )";
+        journalEpochs()[path]++;
+        header = IndexHeader();
+        header.recordCount = quint32(entries.size());
+        header.liveStart = qMin(legacyLiveStart, header.recordCount);
+        header.indexedSize = journalSize;
+        if (!writeIndex(indexPath, header, entries))
+            qWarning() << "Failed to write journal index:" << indexPath;
+        return true; // L'en-tête en mémoire reste exact, même sans index écrit
+    }
+
+    if (!check.corrupted.isEmpty())
+    {
+        // Index réécrit en entier : des entrées disparaissent au milieu
+        QList<IndexEntry> all = readEntries(indexPath, 0, header.recordCount);
+        if (all.size() != qsizetype(header.recordCount) ||
+            !rejectRecords(path, check, all, header))
+        {
+            qWarning() << "Failed to reject the corrupted records of journal:" << path;
+            return false;
+        }
+        all.append(entries);
+        header.recordCount = quint32(all.size());
+        header.indexedSize = journalSize;
+        if (!writeIndex(indexPath, header, all))
+            qWarning() << "Failed to write journal index:" << indexPath;
+        return true;
+    }
+
+    const quint32 firstEntry = header.recordCount;
+    header.recordCount += quint32(entries.size());
+    header.indexedSize = journalSize;
+    bool ok = writeIndexTail(indexPath, header, firstEntry, entries);
+    if (ok && repaired)
+        ok = QFile::resize(indexPath, kHeaderSize + qint64(header.recordCount) * kEntrySize);
+    if (!ok)
+        qWarning() << "Failed to update journal index:" << indexPath;
+    return true;
+}
+
+bool copyBytes(QFile &source, QFile &target, qint64 count)
+{
+    while (count > 0)
+    {
+        const QByteArray block = source.read(qMin(kBlockSize, count));
+        if (block.isEmpty() || target.write(block) != block.size())
+            return false;
+        count -= block.size();
+    }
+    return true;
+}
+
+// Journal tenu ouvert par l'IoWorker entre deux ajouts. Les records sont
+// écrits dans le tampon de QFile ; l'index n'est mis à jour qu'au commit de
+// fin de lot (commitWriter). Toute autre opération sur le journal commence par
+// ce commit, ou par releaseWriter() si elle change les offsets : sous
+// journalMutex, le disque est donc toujours cohérent pour les autres.
+struct Writer
+{
+    QFile journal;
+    QFile index;
+    IndexHeader header;           // En avance sur le disque tant que `pending` n'est pas vide
+    quint32 committedEntries = 0; // Entrées déjà écrites dans l'index
+    QList<IndexEntry> pending;    // Records pas encore indexés
+    quint64 epoch = 0;
+    bool unsynced = false;
+};
+
+QHash<QString, Writer *> &writers()
+{
+    static QHash<QString, Writer *> open;
+    return open;
+}
+
+// Appelant : journalMutex tenu. Le journal passe avant l'index. Avec `sync`,
+// un seul fdatasync par journal pour tout le lot : l'index n'est que vidé
+// vers le système, sa fin se reconstruit depuis le journal (syncIndex).
+bool commitWriter(Writer &writer, bool sync)
+{
+    if (writer.pending.isEmpty() && !(sync && writer.unsynced))
+        return true;
+
+    bool ok = sync ? IoWorker::syncFile(writer.journal) : writer.journal.flush();
+    if (ok && !writer.pending.isEmpty())
+    {
+        const QByteArray entries = encodeEntries(writer.pending);
+        const QByteArray head = encodeHeader(writer.header);
+        ok = writer.index.seek(kHeaderSize + qint64(writer.committedEntries) * kEntrySize) &&
+             writer.index.write(entries) == entries.size() && writer.index.seek(0) &&
+             writer.index.write(head) == head.size();
+        writer.committedEntries = writer.header.recordCount;
+        writer.pending.clear();
+    }
+    ok = ok && writer.index.flush();
+    writer.unsynced = !sync;
+    if (!ok)
+        qWarning() << "Failed to commit journal appends:" << writer.journal.fileName();
+    return ok;
+}
+
+void commitPending(const QString &path)
+{
+    if (Writer *writer = writers().value(path))
+        commitWriter(*writer, false);
+}
+
+// Commit puis fermeture : avant toute opération qui déplace les offsets
+// (watermark, troncature, suppression, compaction).
+void releaseWriter(const QString &path)
+{
+    if (Writer *writer = writers().take(path))
+    {
+        commitWriter(*writer, false);
+        delete writer;
+    }
+}
+
+void commitAllWriters(bool sync)
+{
+    QMutexLocker locker(&journalMutex());
+    for (Writer *writer : std::as_const(writers()))
+        commitWriter(*writer, sync);
+}
+
+Writer *openWriter(const QString &path)
+{
+    Writer *writer = writers().value(path);
+    if (writer && writer->epoch == journalEpochs().value(path) &&
+        (!writer->pending.isEmpty() || writer->journal.size() == writer->header.indexedSize))
+        return writer;
+    releaseWriter(path); // Journal modifié par ailleurs depuis : on repart du disque
+
+    IndexHeader header;
+    if (!syncIndex(path, header))
+        return nullptr;
+
+    auto fresh = std::make_unique<Writer>();
+    fresh->journal.setFileName(path);
+    fresh->index.setFileName(path + ".idx");
+    if (!fresh->journal.open(QIODevice::ReadWrite) || !fresh->index.open(QIODevice::ReadWrite))
+    {
+        qWarning() << "Failed to open journal for appending:" << path;
+        return nullptr;
+    }
+    if (fresh->index.size() < kHeaderSize)
+    {
+        // Premier record d'un nouveau journal : pas encore d'index sur disque.
+        const QByteArray head = encodeHeader(header);
+        if (fresh->index.write(head) != head.size())
+            return nullptr;
+    }
+
+    // syncIndex() a fermé ou coupé une dernière ligne non terminée : le
+    // nouveau record commence en début de ligne.
+    if (!fresh->journal.seek(header.indexedSize))
+        return nullptr;
+
+    fresh->header = header;
+    fresh->committedEntries = header.recordCount;
+    fresh->epoch = journalEpochs().value(path);
+    writer = fresh.release();
+    writers().insert(path, writer);
+    return writer;
+}
+
+void appendRecord(const QString &path, const QByteArray &record)
+{
+    TraceScope scope("journal.write", "io");
+    QMutexLocker locker(&journalMutex());
+    Writer *writer = openWriter(path);
+    if (!writer)
+        return;
+
+    const qint64 offset = writer->header.indexedSize;
+    if (writer->journal.write(record) != record.size() || !writer->journal.putChar('\n'))
+    {
+        qWarning() << "Failed to append to journal:" << path;
+        releaseWriter(path);
+        return;
+    }
+    writer->pending.append({offset, quint32(record.size()), crc32c(record.constData(), record.size())});
+    writer->header.recordCount++;
+    writer->header.indexedSize = offset + record.size() + 1;
+}
+
+IoWorker &journalWorker()
+{
+    // Les ajouts bufferisés sont indexés à la fin de chaque lot de l'IoWorker.
+    static IoWorker &worker = []() -> IoWorker &
+    {
+        IoWorker::instance().addCommitHook(commitAllWriters);
+        return IoWorker::instance();
+    }();
+    return worker;
+}
+
+} // namespace
+
+JournalFile::JournalFile(const QString &path)
+    : m_path(path)
+{
+}
+
+QByteArray JournalFile::serialize(const ChatMessage &message)
+{
+    return QJsonDocument(message.toJsonObject()).toJson(QJsonDocument::Compact);
+}
+
+void JournalFile::append(const ChatMessage &message)
+{
+    if (m_path.isEmpty())
+        return;
+
+    TraceScope scope("journal.append", "io");
+    journalWorker().post([path = m_path, record = serialize(message)]()
+                         { appendRecord(path, record); });
+}
+
+void JournalFile::cull(int count)
+{
+    if (m_path.isEmpty() || count <= 0)
+        return;
+    journalWorker().post([path = m_path, count]() { JournalFile::cullNow(path, count); });
+}
+
+void JournalFile::cullNow(const QString &path, int count)
+{
+    const QString indexPath = path + ".idx";
+    QMutexLocker locker(&journalMutex());
+    releaseWriter(path);
+    IndexHeader header;
+    if (!syncIndex(path, header))
+        return;
+
+    // Synchronisé tout de suite : contrairement aux entrées, le watermark ne
+    // se reconstruit pas depuis le journal.
+    header.liveStart = quint32(qMin<qint64>(header.recordCount, qint64(header.liveStart) + count));
+    if (!writeIndexTail(indexPath, header, header.recordCount, {}, true))
+    {
+        qWarning() << "Failed to move the live-start watermark of" << path;
+        return;
+    }
+
+    const qint64 deadBytes = (header.liveStart < header.recordCount)
+                                 ? readEntry(indexPath, header.liveStart)
+                                 : header.indexedSize;
+    if (deadBytes >= kCompactionMinDeadBytes && !compactionsInFlight().contains(path))
+    {
+        compactionsInFlight().insert(path);
+        QThreadPool::globalInstance()->start([path]() { JournalFile::compact(path); });
+    }
+}
+
+void JournalFile::dropLastRecord(const ChatMessage &expected)
+{
+    if (m_path.isEmpty())
+        return;
+    journalWorker().post([path = m_path, record = serialize(expected)]()
+                         { JournalFile::dropLastRecordNow(path, record); });
+}
+
+void JournalFile::dropLastRecordNow(const QString &path, const QByteArray &expected)
+{
+    const QString indexPath = path + ".idx";
+    QMutexLocker locker(&journalMutex());
+    releaseWriter(path);
+    IndexHeader header;
+    if (!syncIndex(path, header) || header.recordCount <= header.liveStart)
+        return;
+
+    const qint64 lastOffset = readEntry(indexPath, header.recordCount - 1);
+    QFile journal(path);
+    if (lastOffset < 0 || !journal.open(QIODevice::ReadWrite) || !journal.seek(lastOffset))
+        return;
+    if (journal.readAll().trimmed() != expected)
+    {
+        // Un autre écrivain (conversation duo) a ajouté des lignes depuis.
+        qWarning() << "Last journal record is not the expected message; kept:" << path;
+        return;
+    }
+    if (!journal.resize(lastOffset))
+    {
+        qWarning() << "Failed to truncate journal:" << path;
+        return;
+    }
+    journal.close();
+
+    journalEpochs()[path]++;
+    header.recordCount--;
+    header.indexedSize = lastOffset;
+    if (!writeIndexTail(indexPath, header, header.recordCount, {}) ||
+        !QFile::resize(indexPath, kHeaderSize + qint64(header.recordCount) * kEntrySize))
+        qWarning() << "Failed to update journal index:" << indexPath;
+}
+
+bool JournalFile::openLive(QFile &file, QList<qint64> &offsets, qint64 &endOffset) const
+{
+    offsets.clear();
+    endOffset = 0;
+    if (m_path.isEmpty())
+        return false;
+
+    // Les écritures déjà demandées (ajouts, watermark...) passent d'abord.
+    journalWorker().drain();
+    QMutexLocker locker(&journalMutex());
+    commitPending(m_path);
+    IndexHeader header;
+    if (!syncIndex(m_path, header) || header.liveStart >= header.recordCount)
+        return false;
+
+    const quint32 liveCount = header.recordCount - header.liveStart;
+    const QList<IndexEntry> entries = readEntries(indexPath(), header.liveStart, liveCount);
+    offsets.reserve(entries.size());
+    for (const IndexEntry &entry : entries)
+        offsets.append(entry.offset);
+    endOffset = header.indexedSize;
+    file.setFileName(m_path);
+    if (offsets.size() != qsizetype(liveCount) || !file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Failed to open journal for reading:" << m_path;
+        offsets.clear();
+        return false;
+    }
+    return true;
+}
+
+void JournalFile::remove()
+{
+    if (m_path.isEmpty())
+        return;
+
+    journalWorker().post(
+        [path = m_path]()
+        {
+            QMutexLocker locker(&journalMutex());
+            releaseWriter(path);
+            journalEpochs()[path]++;
+            QFile::remove(path + ".idx");
+            if (!QFile::exists(path) || QFile::remove(path))
+                qDebug() << "Journal removed:" << path;
+            else
+                qWarning() << "Failed to remove journal:" << path;
+        });
+}
+
+// Recopie les records vivants dans un nouveau fichier qui remplace le journal.
+// Tourne sur le pool de threads : la copie (l'essentiel du travail) se fait
+// sans verrou, pendant que le GUI continue d'ajouter des records ; seuls le
+// rattrapage de ces ajouts et l'échange des fichiers se font sous verrou.
+void JournalFile::compact(const QString &path)
+{
+    const QString indexPath = path + ".idx";
+    const QString tmpPath = path + ".compact";
+    const QString tmpIndexPath = indexPath + ".compact";
+
+    // 1) Instantané
+    IndexHeader header;
+    quint32 snapshotLiveStart = 0;
+    qint64 liveOffset = -1;
+    qint64 snapshotSize = 0;
+    quint64 epoch = 0;
+    {
+        QMutexLocker locker(&journalMutex());
+        commitPending(path);
+        if (syncIndex(path, header) && header.liveStart > 0)
+        {
+            snapshotLiveStart = header.liveStart;
+            liveOffset = (header.liveStart < header.recordCount)
+                             ? readEntry(indexPath, header.liveStart)
+                             : header.indexedSize;
+            snapshotSize = header.indexedSize;
+            epoch = journalEpochs().value(path);
+        }
+        if (liveOffset <= 0)
+        {
+            compactionsInFlight().remove(path);
+            return;
+        }
+    }
+
+    // 2) Copie des records vivants, sans verrou (syncIndex a déjà traité les
+    //    restes d'une compaction interrompue)
+    QFile::remove(tmpPath);
+    QFile source(path);
+    QFile target(tmpPath);
+    bool ok = source.open(QIODevice::ReadOnly) && target.open(QIODevice::WriteOnly) &&
+              source.seek(liveOffset) && copyBytes(source, target, snapshotSize - liveOffset);
+
+    // 3) Rattrapage et échange, sous verrou. L'IoWorker rouvrira le nouveau
+    //    fichier à son prochain ajout.
+    QMutexLocker locker(&journalMutex());
+    releaseWriter(path);
+    compactionsInFlight().remove(path);
+    ok = ok && syncIndex(path, header) && journalEpochs().value(path) == epoch &&
+         header.indexedSize >= snapshotSize;
+    if (ok && header.indexedSize > snapshotSize)
+        ok = source.seek(snapshotSize) &&
+             copyBytes(source, target, header.indexedSize - snapshotSize);
+    source.close();
+    // Sur le disque avant le renommage : sinon un arrêt brutal pourrait
+    // laisser un journal vide à la place de l'ancien.
+    ok = ok && IoWorker::syncFile(target);
+    target.close();
+
+    QList<IndexEntry> entries;
+    IndexHeader compacted;
+    if (ok)
+    {
+        entries = readEntries(indexPath, snapshotLiveStart, header.recordCount - snapshotLiveStart);
+        ok = entries.size() == qsizetype(header.recordCount - snapshotLiveStart);
+        for (IndexEntry &entry : entries)
+            entry.offset -= liveOffset; // Longueur et CRC inchangés
+        compacted.liveStart = header.liveStart - snapshotLiveStart;
+        compacted.recordCount = quint32(entries.size());
+        compacted.indexedSize = header.indexedSize - liveOffset;
+        ok = ok && writeIndex(tmpIndexPath, compacted, entries);
+    }
+
+    // Le journal d'abord, remplacé d'un seul renommage ; l'ancien index reste
+    // en place tant que ce renommage n'a pas réussi (sous Windows il échoue si
+    // un lecteur tient encore le journal ouvert). Le nouvel index, déjà sur le
+    // disque, remplace ensuite l'ancien ; s'il reste en attente (arrêt brutal
+    // entre les deux, renommage refusé), finishInterruptedCompaction() l'installe
+    // au prochain accès : le watermark n'est jamais perdu.
+    std::error_code error;
+    if (ok)
+    {
+        std::filesystem::rename(QFileInfo(tmpPath).filesystemAbsoluteFilePath(),
+                                QFileInfo(path).filesystemAbsoluteFilePath(), error);
+        ok = !error;
+    }
+    if (!ok)
+    {
+        QFile::remove(tmpIndexPath); // D'abord : seul, il vaudrait compaction réussie
+        QFile::remove(tmpPath);
+        qDebug() << "Journal compaction skipped or failed:" << path;
+        return;
+    }
+    journalEpochs()[path]++;
+    std::filesystem::rename(QFileInfo(tmpIndexPath).filesystemAbsoluteFilePath(),
+                            QFileInfo(indexPath).filesystemAbsoluteFilePath(), error);
+    if (error)
+        qWarning() << "Journal compacted, index swap deferred:" << path
+                   << QString::fromStdString(error.message());
+    qDebug() << "Journal compacted:" << path << "-" << liveOffset << "bytes reclaimed.";
+}
+// End Source File JournalFile.cpp
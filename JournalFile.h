@@ -0,0 +1,96 @@
+// Begin Source File JournalFile.h
+#ifndef JOURNALFILE_H
+#define JOURNALFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+#include "ChatMessage.h"
+
+// Append-only JSON Lines journal (<name>.jsonl) with a small binary side index
+// (<name>.jsonl.idx).
+//
+// The index holds the byte offset of every record and a "live start"
+// watermark: the records before it have been curated into long-term memory
+// and are no longer part of the rolling context. Culling after a successful
+// curation therefore only advances the watermark (one header write) instead of
+// re-serializing every surviving message, and dropping the last record (a
+// user message whose request failed) is a truncation. The culled prefix stays
+// on disk until a background compaction copies the live records into a fresh
+// file, off the GUI thread.
+//
+// The index is only an accelerator kept in sync with the journal: when it is
+// missing or stale (journal edited or appended to by hand, older Tether
+// version...) it is caught up by scanning the new bytes, or rebuilt from
+// scratch with the watermark reset to the first record.
+//
+// Every index entry also holds the length and CRC32C of its record, so that
+// the first access to a journal after a crash can tell which of the last
+// indexed records really reached the disk: from the first entry whose line is
+// missing or misplaced, entries are dropped and reindexed from the journal,
+// and a torn last line (no '\n', not a complete JSON object) is cut off. A
+// line in place whose CRC32C does not match is rejected: blanked in the
+// journal and removed from the index, the watermark staying on the same live
+// record. The journal itself stays plain JSON Lines.
+//
+// A compaction writes the new journal and its index next to the old ones,
+// replaces the journal with one rename, then the index. The old files are
+// left untouched if the first rename fails; if the second one does not happen
+// (crash, file in use), the pending index is installed on the next access, so
+// the watermark is never lost.
+//
+// The class is a thin handle on a path: all state lives on disk, so several
+// handles (the solo ChatModel and a GroupChatModel participant share a
+// journal) stay consistent. Every operation is serialized by a process-wide mutex, which
+// the compaction worker also takes for its short final swap.
+//
+// Writes never block the caller: append(), cull(), dropLastRecord() and
+// remove() queue a job on the IoWorker thread, in call order. The worker keeps
+// the journals it appends to open, buffers the records and writes their index
+// entries once per batch, after a single fdatasync of the journal when the
+// sync policy asks for one; openLive() first waits for the queued writes.
+class JournalFile
+{
+public:
+    explicit JournalFile(const QString &path);
+
+    QString path() const { return m_path; }
+    QString indexPath() const { return m_path + ".idx"; }
+
+    // Appends one record and its index entry. O(1) whatever the journal size.
+    void append(const ChatMessage &message);
+
+    // Moves the live-start watermark past the first `count` live records, then
+    // schedules a background compaction once the dead prefix is big enough.
+    void cull(int count);
+
+    // Removes the last record if (and only if) it is `expected`, by truncating
+    // the journal. Used when the request carrying a user message has failed.
+    void dropLastRecord(const ChatMessage &expected);
+
+    // Opens `file` on the journal and returns the byte offsets of the live
+    // records (after the watermark) plus the end of the last one. Meant for
+    // readers working off the GUI thread (JournalReader): the handle is opened
+    // under the journal lock, so it keeps seeing the same bytes even if a
+    // compaction swaps the file afterwards. False if there is nothing to read.
+    bool openLive(QFile &file, QList<qint64> &offsets, qint64 &endOffset) const;
+
+    // Deletes the journal and its index.
+    void remove();
+
+    // One compact JSON line (without the trailing '\n').
+    static QByteArray serialize(const ChatMessage &message);
+
+private:
+    // Jobs de l'IoWorker
+    static void cullNow(const QString &path, int count);
+    static void dropLastRecordNow(const QString &path, const QByteArray &expected);
+    static void compact(const QString &path);
+
+    QString m_path;
+};
+
+#endif // JOURNALFILE_H
+// End Source File JournalFile.h
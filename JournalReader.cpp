@@ -0,0 +1,140 @@
+// Begin Source File JournalReader.cpp
+#include "JournalReader.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QPromise>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "JournalFile.h"
+#include "JsonlScanner.h"
+
+namespace
+{
+// Premier lot petit (premier affichage rapide), les suivants plus gros.
+const int kFirstBatchSize = 50;
+const int kBatchSize = 500;
+
+bool isSpace(char c)
+{
+    return c == '\n' || c == '\r' || c == ' ' || c == '\t';
+}
+
+// Tourne sur le pool de threads : ne touche qu'à ses propres objets.
+void readLiveBatches(QPromise<QList<ChatMessage>> &promise, const QString &path)
+{
+    QFile file;
+    QList<qint64> offsets;
+    qint64 end = 0;
+    if (!JournalFile(path).openLive(file, offsets, end))
+        return; // Journal absent ou sans record vivant
+
+    // Projection du journal en mémoire : pas de copie des lots, les lignes
+    // sont parsées directement dans les pages du fichier. read() reste le
+    // repli si le système refuse la projection. Seul dropLastRecord() raccourcit
+    // le fichier, et le dernier record fait partie du premier lot : les lots
+    // suivants ne touchent jamais la zone tronquée.
+    uchar *mapped = file.map(0, end);
+    QByteArray buffer;
+
+    qsizetype last = offsets.size();
+    int batchSize = kFirstBatchSize;
+    while (last > 0 && !promise.isCanceled())
+    {
+        const qsizetype first = qMax<qsizetype>(0, last - batchSize);
+        const qint64 base = offsets.at(first);
+        const char *bytes = nullptr;
+        qint64 size = 0;
+        if (mapped)
+        {
+            bytes = reinterpret_cast<const char *>(mapped) + base;
+            size = end - base;
+        }
+        else
+        {
+            if (!file.seek(base))
+                break;
+            // Un seul read() par lot : les records sont contigus.
+            buffer = file.read(end - base);
+            bytes = buffer.constData();
+            size = buffer.size();
+        }
+
+        QList<ChatMessage> batch;
+        batch.reserve(last - first);
+        for (qsizetype i = first; i < last; ++i)
+        {
+            qint64 from = offsets.at(i) - base;
+            qint64 to = qMin<qint64>(((i + 1 < last) ? offsets.at(i + 1) : end) - base, size);
+            while (from < to && isSpace(bytes[from]))
+                ++from;
+            while (to > from && isSpace(bytes[to - 1]))
+                --to;
+            if (from >= to)
+                continue; // Journal tronqué pendant la lecture
+
+            ChatMessage message;
+            if (JsonlScanner::parseMessage(QByteArrayView(bytes + from, to - from), message))
+                batch.append(message);
+            else
+                qWarning() << "Skipping malformed JSON line in journal:" << path;
+        }
+        promise.addResult(batch);
+
+        end = base;
+        last = first;
+        batchSize = kBatchSize;
+    }
+
+    if (mapped)
+        file.unmap(mapped);
+}
+
+} // namespace
+
+JournalReader::JournalReader(QObject *parent)
+    : QObject(parent)
+{
+}
+
+JournalReader::~JournalReader()
+{
+    cancel();
+}
+
+void JournalReader::start(const QString &journalPath)
+{
+    cancel();
+
+    m_watcher = new QFutureWatcher<QList<ChatMessage>>(this);
+    QFutureWatcher<QList<ChatMessage>> *watcher = m_watcher;
+    connect(watcher, &QFutureWatcher<QList<ChatMessage>>::resultsReadyAt, this,
+            [this, watcher](int begin, int end)
+            {
+                // Le modèle peut relancer ou annuler la lecture depuis son slot.
+                for (int i = begin; i < end && watcher == m_watcher; ++i)
+                    emit batchReady(watcher->resultAt(i));
+            });
+    connect(watcher, &QFutureWatcher<QList<ChatMessage>>::finished, this,
+            [this, watcher]()
+            {
+                if (watcher != m_watcher)
+                    return;
+                m_watcher = nullptr;
+                watcher->deleteLater(); // Libère aussi les lots stockés dans le QFuture
+                emit finished();
+            });
+    watcher->setFuture(QtConcurrent::run(readLiveBatches, journalPath));
+}
+
+void JournalReader::cancel()
+{
+    if (!m_watcher)
+        return;
+    // Déconnecté avant d'être annulé : aucun lot en attente ne sera livré.
+    m_watcher->disconnect(this);
+    m_watcher->cancel();
+    m_watcher->deleteLater();
+    m_watcher = nullptr;
+}
+// End Source File JournalReader.cpp
@@ -0,0 +1,50 @@
+// Begin Source File JournalReader.h
+#ifndef JOURNALREADER_H
+#define JOURNALREADER_H
+
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+#include "ChatMessage.h"
+
+// Loads the live records of a journal (see JournalFile) on the thread pool.
+//
+// Parsing a long history on the GUI thread froze the window when switching
+// personas. The reader walks the journal index backwards and hands the parsed
+// messages back in batches, NEWEST FIRST: the first batch (small, so that the
+// first paint is quick) holds the most recent messages, every following batch
+// holds older ones. Models prepend each batch with beginInsertRows(), so the
+// ListView is usable — and positioned on the latest exchange — right away.
+//
+// Starting a new read, cancel() or destroying the reader drops the pending
+// batches of the previous read: they never reach the model.
+//
+// Used by ChatModel::loadChat() and by GroupChatModel for every participant's
+// journal and the group transcript.
+class JournalReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JournalReader(QObject *parent = nullptr);
+    ~JournalReader();
+
+    void start(const QString &journalPath);
+    void cancel();
+    bool isRunning() const { return m_watcher != nullptr; }
+
+signals:
+    // Consecutive records, oldest first inside the batch; each batch directly
+    // precedes the previous one in the journal.
+    void batchReady(const QList<ChatMessage> &messages);
+    // Emitted once every batch has been delivered (not after cancel()).
+    void finished();
+
+private:
+    QFutureWatcher<QList<ChatMessage>> *m_watcher = nullptr;
+};
+
+#endif // JOURNALREADER_H
+// End Source File JournalReader.h
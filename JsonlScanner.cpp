@@ -0,0 +1,329 @@
+// Begin Source File JsonlScanner.cpp
+#include "JsonlScanner.h"
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <cstring>
+
+#include "ChatMessage.h"
+
+namespace
+{
+struct Cursor
+{
+    const char *p;
+    const char *end;
+};
+
+void skipSpace(Cursor &c)
+{
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\r' || *c.p == '\n'))
+        ++c.p;
+}
+
+// Lit un littéral chaîne ; `raw` reçoit son contenu encore échappé.
+bool readString(Cursor &c, QByteArrayView &raw)
+{
+    if (c.p >= c.end || *c.p != '"')
+        return false;
+    const char *start = ++c.p;
+    while (c.p < c.end)
+    {
+        const char *quote = static_cast<const char *>(std::memchr(c.p, '"', size_t(c.end - c.p)));
+        if (!quote)
+            return false;
+        // Guillemet échappé si précédé d'un nombre impair de '\'
+        const char *b = quote;
+        while (b > start && b[-1] == '\\')
+            --b;
+        c.p = quote + 1;
+        if (((quote - b) & 1) == 0)
+        {
+            raw = QByteArrayView(start, quote - start);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool hasEscape(QByteArrayView raw)
+{
+    return std::memchr(raw.data(), '\\', size_t(raw.size())) != nullptr;
+}
+
+QString toQString(QByteArrayView raw)
+{
+    return hasEscape(raw) ? JsonlScanner::decodeString(raw) : QString::fromUtf8(raw);
+}
+
+ChatMessage::Role parseRole(QByteArrayView raw)
+{
+    if (raw == QByteArrayView("assistant"))
+        return ChatMessage::Role::Assistant;
+    if (raw == QByteArrayView("system"))
+        return ChatMessage::Role::System;
+    if (raw == QByteArrayView("user") || !hasEscape(raw))
+        return ChatMessage::Role::User;
+    return ChatMessage::roleFromName(JsonlScanner::decodeString(raw));
+}
+
+int digits(const char *p, int count)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (p[i] < '0' || p[i] > '9')
+            return -1;
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
+
+// Chemin rapide pour "yyyy-MM-ddTHH:mm:ss" (QDateTime::toString(Qt::ISODate)
+// d'une heure locale) ; les autres formes passent par QDateTime::fromString.
+QDateTime parseTimestamp(QByteArrayView raw)
+{
+    const char *p = raw.data();
+    if (raw.size() == 19 && p[4] == '-' && p[7] == '-' && p[10] == 'T' && p[13] == ':' &&
+        p[16] == ':')
+    {
+        const QDate date(digits(p, 4), digits(p + 5, 2), digits(p + 8, 2));
+        const QTime time(digits(p + 11, 2), digits(p + 14, 2), digits(p + 17, 2));
+        if (date.isValid() && time.isValid())
+            return QDateTime(date, time);
+    }
+    return QDateTime::fromString(QString::fromLatin1(raw), Qt::ISODate);
+}
+
+void appendUtf8(QByteArray &out, char32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out.append(char(cp));
+    }
+    else if (cp < 0x800)
+    {
+        out.append(char(0xC0 | (cp >> 6)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000)
+    {
+        out.append(char(0xE0 | (cp >> 12)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+    else
+    {
+        out.append(char(0xF0 | (cp >> 18)));
+        out.append(char(0x80 | ((cp >> 12) & 0x3F)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+}
+
+int hex4(const char *p, const char *end)
+{
+    if (end - p < 4)
+        return -1;
+    int value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        const char ch = p[i];
+        int nibble;
+        if (ch >= '0' && ch <= '9')
+            nibble = ch - '0';
+        else if (ch >= 'a' && ch <= 'f')
+            nibble = ch - 'a' + 10;
+        else if (ch >= 'A' && ch <= 'F')
+            nibble = ch - 'A' + 10;
+        else
+            return -1;
+        value = (value << 4) | nibble;
+    }
+    return value;
+}
+
+bool parseWithQJson(QByteArrayView line, ChatMessage &message)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(line.toByteArray());
+    if (doc.isNull() || !doc.isObject())
+        return false;
+    message = ChatMessage::fromJsonObject(doc.object());
+    return true;
+}
+
+} // namespace
+
+QString JsonlScanner::decodeString(QByteArrayView escaped)
+{
+    if (!hasEscape(escaped))
+        return QString::fromUtf8(escaped);
+
+    QByteArray utf8;
+    utf8.reserve(escaped.size());
+    const char *p = escaped.data();
+    const char *end = p + escaped.size();
+    while (p < end)
+    {
+        const char *backslash = static_cast<const char *>(std::memchr(p, '\\', size_t(end - p)));
+        if (!backslash)
+        {
+            utf8.append(p, end - p);
+            break;
+        }
+        utf8.append(p, backslash - p);
+        p = backslash + 1;
+        if (p >= end)
+            break;
+        const char ch = *p++;
+        switch (ch)
+        {
+            case 'n': utf8.append('\n'); break;
+            case 't': utf8.append('\t'); break;
+            case 'r': utf8.append('\r'); break;
+            case 'b': utf8.append('\b'); break;
+            case 'f': utf8.append('\f'); break;
+            case 'u':
+            {
+                int unit = hex4(p, end);
+                if (unit < 0)
+                {
+                    utf8.append("\xEF\xBF\xBD"); // U+FFFD
+                    break;
+                }
+                p += 4;
+                char32_t cp = char32_t(unit);
+                if (unit >= 0xD800 && unit <= 0xDBFF)
+                {
+                    // Paire de substitution (ex. D83D DE00 pour un emoji)
+                    const int low = (end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+                                        ? hex4(p + 2, end)
+                                        : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF)
+                    {
+                        cp = 0x10000 + ((char32_t(unit) - 0xD800) << 10) + (char32_t(low) - 0xDC00);
+                        p += 6;
+                    }
+                    else
+                    {
+                        cp = 0xFFFD;
+                    }
+                }
+                else if (unit >= 0xDC00 && unit <= 0xDFFF)
+                {
+                    cp = 0xFFFD;
+                }
+                appendUtf8(utf8, cp);
+                break;
+            }
+            default: utf8.append(ch); break; // '"', '\\', '/'
+        }
+    }
+    return QString::fromUtf8(utf8);
+}
+
+bool JsonlScanner::parseMessage(QByteArrayView line, ChatMessage &message)
+{
+    Cursor c{line.data(), line.data() + line.size()};
+    skipSpace(c);
+    if (c.p >= c.end || *c.p != '{')
+        return parseWithQJson(line, message);
+    ++c.p;
+
+    ChatMessage msg;
+    int tokenWeight = -1; // Appliqué à la fin : les mutateurs l'invalident
+    skipSpace(c);
+    if (c.p < c.end && *c.p == '}')
+    {
+        ++c.p;
+    }
+    else
+    {
+        while (true)
+        {
+            QByteArrayView key;
+            skipSpace(c);
+            if (!readString(c, key) || hasEscape(key))
+                return parseWithQJson(line, message);
+            skipSpace(c);
+            if (c.p >= c.end || *c.p != ':')
+                return parseWithQJson(line, message);
+            ++c.p;
+            skipSpace(c);
+            if (c.p >= c.end)
+                return parseWithQJson(line, message);
+
+            if (*c.p == '"')
+            {
+                QByteArrayView value;
+                if (!readString(c, value))
+                    return parseWithQJson(line, message);
+                if (key == QByteArrayView("text"))
+                {
+                    // Pas de décodage ici : ChatMessage::text() s'en charge.
+                    if (!value.isEmpty())
+                        msg.setRawText(value.toByteArray());
+                }
+                else if (key == QByteArrayView("timestamp"))
+                    msg.setTimestamp(parseTimestamp(value));
+                else if (key == QByteArrayView("role"))
+                    msg.setRole(parseRole(value));
+                else if (key == QByteArrayView("speaker"))
+                    msg.setSpeaker(toQString(value));
+            }
+            else if (*c.p == '{' || *c.p == '[')
+            {
+                return parseWithQJson(line, message); // Valeur imbriquée
+            }
+            else
+            {
+                // Nombre, true, false ou null
+                const char *start = c.p;
+                while (c.p < c.end && *c.p != ',' && *c.p != '}' && *c.p != ' ' &&
+                       *c.p != '\t' && *c.p != '\r' && *c.p != '\n')
+                    ++c.p;
+                const QByteArrayView value(start, c.p - start);
+                const bool isTrue = (value == QByteArrayView("true"));
+                if (key == QByteArrayView("isLocalMessage"))
+                    msg.setIsLocalMessage(isTrue);
+                else if (key == QByteArrayView("isTypingIndicator"))
+                    msg.setIsTypingIndicator(isTrue);
+                else if (key == QByteArrayView("isError"))
+                    msg.setIsError(isTrue);
+                else if (key == QByteArrayView("promptTokens"))
+                    msg.setPromptTokens(int(value.toDouble()));
+                else if (key == QByteArrayView("completionTokens"))
+                    msg.setCompletionTokens(int(value.toDouble()));
+                else if (key == QByteArrayView("tokens"))
+                    tokenWeight = int(value.toDouble());
+                else if (key == QByteArrayView("latencyMs"))
+                    msg.setServerLatencyMs(int(value.toDouble()));
+                else if (key == QByteArrayView("tokensPerSec"))
+                    msg.setTokensPerSecond(value.toDouble());
+            }
+
+            skipSpace(c);
+            if (c.p < c.end && *c.p == ',')
+            {
+                ++c.p;
+                continue;
+            }
+            if (c.p < c.end && *c.p == '}')
+            {
+                ++c.p;
+                break;
+            }
+            return parseWithQJson(line, message);
+        }
+    }
+
+    skipSpace(c);
+    if (c.p != c.end)
+        return parseWithQJson(line, message); // Contenu après l'objet
+    msg.setTokenWeight(tokenWeight);
+    message = msg;
+    return true;
+}
+// End Source File JsonlScanner.cpp
@@ -0,0 +1,32 @@
+// Begin Source File JsonlScanner.h
+#ifndef JSONLSCANNER_H
+#define JSONLSCANNER_H
+
+#include <QByteArrayView>
+#include <QString>
+
+struct ChatMessage;
+
+// Fast path for reading journal lines (see JournalReader).
+//
+// Going through QJsonDocument/QJsonObject costs several allocations per line.
+// Journal lines are flat objects written by ChatMessage::toJsonObject(), so
+// this scanner reads the few fields ChatMessage needs straight from the
+// (memory-mapped) bytes. The text is not decoded: it is kept as its escaped
+// UTF-8 bytes inside the message, and turned into a QString each time
+// ChatMessage::text() is called (row displayed, history sent...), without
+// keeping the decoded copy.
+class JsonlScanner
+{
+public:
+    // Parses one journal line. Lines the flat scanner does not handle (nested
+    // values, escaped keys...) go through QJsonDocument instead; false if the
+    // line is not a JSON object at all.
+    static bool parseMessage(QByteArrayView line, ChatMessage &message);
+
+    // Decodes the content of a JSON string literal (quotes excluded).
+    static QString decodeString(QByteArrayView escaped);
+};
+
+#endif // JSONLSCANNER_H
+// End Source File JsonlScanner.h
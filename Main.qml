@@ -26,9 +26,8 @@ ApplicationWindow {
     // L'interlocuteur actif du chat principal est-il occupé dans une session
     // AI ↔ AI ? Dans ce cas on verrouille l'envoi solo : son journal est en
     // train d'être écrit par la conversation duo.
-    property bool soloLockedByDuo: (_chatManager.duoChatModel.running || _chatManager.duoChatModel.busy)
-                                   && (_chatManager.activeInterlocutorName === _chatManager.duoChatModel.participantA
-                                       || _chatManager.activeInterlocutorName === _chatManager.duoChatModel.participantB)
+    property bool soloLockedByDuo: (_chatManager.groupChatModel.running || _chatManager.groupChatModel.busy)
+                                   && _chatManager.groupChatModel.participants.indexOf(_chatManager.activeInterlocutorName) >= 0
 
     // Fonction pour envoyer le message
     function sendMessage() {
@@ -82,6 +81,11 @@ ApplicationWindow {
                     text: qsTr("Parameters")
                     width: implicitWidth
                 }
+                TabButton {
+                    font.bold: checked
+                    text: qsTr("Diagnostics")
+                    width: implicitWidth
+                }
                 TabButton {
                     font.bold: checked
                     text: qsTr("About")
@@ -92,7 +96,16 @@ ApplicationWindow {
                 Layout.fillWidth: true
             }
             Label {
-                text: "Session cost: " + (_chatManager.chatModel ? (_chatManager.chatModel.cumulativeTokenCost + " tokens"): "")
+                // Requêtes retenues par le planificateur (limites du fournisseur)
+                visible: _requestScheduler.queueDepth > 0
+                text: qsTr("Queued requests: %1 (%2 in background)")
+                        .arg(_requestScheduler.queueDepth)
+                        .arg(_requestScheduler.backgroundQueueDepth)
+                color: "#8a6d3b"
+            }
+            Label {
+                text: "Session cost: " + (_chatManager.chatModel ? (_chatManager.chatModel.cumulativeTokenCost + " tokens"
+                                                                     + " (cache hits: " + Math.round(_chatManager.chatModel.cacheHitRate * 100) + "%)"): "")
             }
             //ComboBox {
             //    id: languageSelector
@@ -173,10 +186,26 @@ ApplicationWindow {
                                 // On demande à la vue de se positionner à la fin de son contenu.
                                 positionViewAtEnd()
                             }
+                            // Haut de la liste atteint : page suivante des messages plus anciens
+                            onAtYBeginningChanged: {
+                                var root = model.index(-1, 0);
+                                if (atYBeginning && model.canFetchMore(root))
+                                    model.fetchMore(root);
+                            }
                             Connections {
                                 target: _chatManager.chatModel
                                 function onModelReset() { Qt.callLater(_messageListView.positionViewAtEnd); }
                                 function onChatMessageAdded() { _messageListView.positionViewAtEnd(); }
+                                // Premier lot de l'historique (les plus récents) dans une vue vide
+                                function onRowsInserted(parent, first, last) {
+                                    if (first === 0 && last === _messageListView.count - 1)
+                                        Qt.callLater(_messageListView.positionViewAtEnd);
+                                }
+                                // Réponse en streaming : la dernière bulle grandit au fil des chunks
+                                function onDataChanged(topLeft) {
+                                    if (topLeft.row === _messageListView.count - 1)
+                                        Qt.callLater(_messageListView.positionViewAtEnd);
+                                }
                             }
                             ScrollBar.vertical: ScrollBar {
                                 policy: ScrollBar.AsNeeded
@@ -341,6 +370,9 @@ ApplicationWindow {
                                         if ((event.key === Qt.Key_Return || event.key === Qt.Key_Enter) && (event.modifiers & Qt.ControlModifier)) {
                                             sendMessage();
                                             event.accepted = true;
+                                        } else if (event.key === Qt.Key_Escape && _chatManager.chatModel.isWaitingForReply) {
+                                            _chatManager.chatModel.stopGeneration();
+                                            event.accepted = true;
                                         } else if (event.key === Qt.Key_PageUp) {
                                             _messageListView.contentY = Math.max(_messageListView.originY, _messageListView.contentY - _messageListView.height);
                                             event.accepted = true;
@@ -366,9 +398,14 @@ ApplicationWindow {
                                 width: 90
                                 height: 80
                                 anchors { verticalCenter: parent.verticalCenter ; right: verticalFiller.left }
-                                text: "Send\n(Ctrl+Enter)"
+                                // Pendant une réponse, le bouton l'arrête (Échap aussi)
+                                readonly property bool stopsGeneration: _chatManager.chatModel.isWaitingForReply
+                                text: stopsGeneration
+                                      ? qsTr("Stop (%1 s)\n(Esc)").arg(_chatManager.chatModel.generationSeconds)
+                                      : "Send\n(Ctrl+Enter)"
                                 background: Rectangle {
-                                    color: sendButton.enabled ? sendButtonColor : "lightgray"
+                                    color: !sendButton.enabled ? "lightgray"
+                                           : sendButton.stopsGeneration ? "#E53935" : sendButtonColor
                                     radius: 6
                                 }
                                 contentItem: Text {
@@ -379,8 +416,10 @@ ApplicationWindow {
                                     font.bold: true
                                 }
 
-                                onClicked: sendMessage()
-                                enabled: messageInput.text.trim().length > 0 && !_root.soloLockedByDuo
+                                onClicked: stopsGeneration ? _chatManager.chatModel.stopGeneration() : sendMessage()
+                                enabled: stopsGeneration
+                                         || (messageInput.text.trim().length > 0 && !_root.soloLockedByDuo
+                                             && !_chatManager.chatModel.isLoadingHistory)
                             }
                             Item {
                                 id: verticalFiller
@@ -549,8 +588,9 @@ ApplicationWindow {
             } // end _chatAreaRow RowLayout
 
             // 1.2.2 `_duoArea` : AI ↔ AI conversation area. Two configured interlocutors
-            // talk to each other through their respective APIs. The human selects the
-            // pair, sets a message budget per run, and starts/pauses the exchange.
+            // or more talk to each other through their respective APIs. The human selects
+            // the participants and the turn policy, sets a message budget per run, and
+            // starts/pauses the exchange.
             ColumnLayout {
                 id: _duoArea
                 Layout.fillWidth: true
@@ -558,12 +598,16 @@ ApplicationWindow {
                 spacing: 0
                 visible: _tabBar.currentIndex === 1
 
-                // On appelle toujours le C++ : une paire invalide (par exemple
+                // Participants au-delà des deux premiers, dans l'ordre de parole
+                property var extraParticipants: []
+
+                // On appelle toujours le C++ : une sélection invalide (par exemple
                 // deux fois le même interlocuteur) invalide la session, pour que
                 // l'état du bouton Start reflète exactement la sélection.
                 function trySelectPair() {
                     if (_duoComboA.currentIndex >= 0 && _duoComboB.currentIndex >= 0) {
-                        _chatManager.selectDuoPair(_duoComboA.currentText, _duoComboB.currentText);
+                        _chatManager.selectGroup([_duoComboA.currentText, _duoComboB.currentText]
+                                                 .concat(extraParticipants));
                     }
                 }
 
@@ -581,8 +625,8 @@ ApplicationWindow {
                             Layout.preferredWidth: 170
                             model: _chatManager.interlocutorNames
                             currentIndex: -1
-                            enabled: !_chatManager.duoChatModel.running && !_chatManager.duoChatModel.busy
-                                     && !_chatManager.duoChatModel.curationPending
+                            enabled: !_chatManager.groupChatModel.running && !_chatManager.groupChatModel.busy
+                                     && !_chatManager.groupChatModel.curationPending
                             onActivated: _duoArea.trySelectPair()
                         }
                         Label {
@@ -595,37 +639,84 @@ ApplicationWindow {
                             Layout.preferredWidth: 170
                             model: _chatManager.interlocutorNames
                             currentIndex: -1
-                            enabled: !_chatManager.duoChatModel.running && !_chatManager.duoChatModel.busy
-                                     && !_chatManager.duoChatModel.curationPending
+                            enabled: !_chatManager.groupChatModel.running && !_chatManager.groupChatModel.busy
+                                     && !_chatManager.groupChatModel.curationPending
                             onActivated: _duoArea.trySelectPair()
                         }
+                        ComboBox {
+                            id: _duoComboMore
+                            Layout.preferredWidth: 150
+                            model: _chatManager.interlocutorNames
+                            currentIndex: -1
+                            displayText: qsTr("+ Add…")
+                            enabled: _duoComboB.enabled
+                            onActivated: {
+                                _duoArea.extraParticipants = _duoArea.extraParticipants.concat([currentText]);
+                                currentIndex = -1;
+                                _duoArea.trySelectPair();
+                            }
+                        }
+                        Label {
+                            visible: _duoArea.extraParticipants.length > 0
+                            text: _duoArea.extraParticipants.join(", ")
+                            elide: Text.ElideRight
+                            Layout.maximumWidth: 200
+                        }
+                        ToolButton {
+                            visible: _duoArea.extraParticipants.length > 0
+                            enabled: _duoComboB.enabled
+                            text: "✕"
+                            onClicked: {
+                                _duoArea.extraParticipants = [];
+                                _duoArea.trySelectPair();
+                            }
+                        }
 
                         Item { Layout.fillWidth: true }
 
+                        Label { text: qsTr("Turns:") }
+                        ComboBox {
+                            id: _duoPolicyCombo
+                            Layout.preferredWidth: 150
+                            // Même ordre que GroupChatModel::TurnPolicy
+                            model: [qsTr("Round robin"), qsTr("Addressed"), qsTr("Bid")]
+                            currentIndex: _chatManager.groupChatModel.turnPolicy
+                            onActivated: _chatManager.groupChatModel.turnPolicy = currentIndex
+                        }
+                        CheckBox {
+                            text: qsTr("Parallel")
+                            visible: _duoPolicyCombo.currentIndex === 0
+                            checked: _chatManager.groupChatModel.parallelRounds
+                            onToggled: _chatManager.groupChatModel.parallelRounds = checked
+                            ToolTip.visible: hovered
+                            ToolTip.text: qsTr("Every participant answers each round at once")
+                        }
+
                         Label { text: qsTr("Messages per run:") }
                         SpinBox {
                             id: _duoTurnsSpin
                             from: 1
                             to: 200
                             editable: true
-                            value: _chatManager.duoChatModel.maxTurns
-                            onValueModified: _chatManager.duoChatModel.maxTurns = value
+                            value: _chatManager.groupChatModel.maxTurns
+                            onValueModified: _chatManager.groupChatModel.maxTurns = value
                         }
 
                         Button {
                             id: _duoStartButton
-                            text: _chatManager.duoChatModel.running ? qsTr("Pause") : qsTr("Start")
+                            text: _chatManager.groupChatModel.running ? qsTr("Pause") : qsTr("Start")
                             highlighted: true
-                            enabled: _chatManager.duoChatModel.sessionReady
-                            onClicked: _chatManager.duoChatModel.running
-                                       ? _chatManager.duoChatModel.pause()
-                                       : _chatManager.duoChatModel.start()
+                            enabled: _chatManager.groupChatModel.sessionReady
+                                     && !_chatManager.groupChatModel.loading
+                            onClicked: _chatManager.groupChatModel.running
+                                       ? _chatManager.groupChatModel.pause()
+                                       : _chatManager.groupChatModel.start()
                         }
                         Button {
                             text: qsTr("Clear")
-                            enabled: _chatManager.duoChatModel.sessionReady
-                                     && !_chatManager.duoChatModel.running
-                                     && !_chatManager.duoChatModel.busy
+                            enabled: _chatManager.groupChatModel.sessionReady
+                                     && !_chatManager.groupChatModel.running
+                                     && !_chatManager.groupChatModel.busy
                             onClicked: _duoClearConfirm.open()
                         }
                     }
@@ -641,12 +732,11 @@ ApplicationWindow {
                     y: Math.round((parent.height - height) / 2)
 
                     Label {
-                        text: qsTr("The AI ↔ AI transcript between %1 and %2 will be deleted from this tab.\nEach AI keeps its own memory of the exchange in its personal journal.")
-                              .arg(_chatManager.duoChatModel.participantA)
-                              .arg(_chatManager.duoChatModel.participantB)
+                        text: qsTr("The AI ↔ AI transcript between %1 will be deleted from this tab.\nEach AI keeps its own memory of the exchange in its personal journal.")
+                              .arg(_chatManager.groupChatModel.participants.join(", "))
                         wrapMode: Text.Wrap
                     }
-                    onAccepted: _chatManager.duoChatModel.clearConversation()
+                    onAccepted: _chatManager.groupChatModel.clearConversation()
                 }
 
                 // Zone des messages duo
@@ -666,11 +756,15 @@ ApplicationWindow {
                             Layout.margins: 10
                             spacing: 15
                             clip: true
-                            model: _chatManager.duoChatModel
+                            model: _chatManager.groupChatModel
                             onCountChanged: Qt.callLater(positionViewAtEnd)
                             Connections {
-                                target: _chatManager.duoChatModel
+                                target: _chatManager.groupChatModel
                                 function onModelReset() { Qt.callLater(_duoListView.positionViewAtEnd); }
+                                function onDataChanged(topLeft) {
+                                    if (topLeft.row === _duoListView.count - 1)
+                                        Qt.callLater(_duoListView.positionViewAtEnd);
+                                }
                             }
                             ScrollBar.vertical: ScrollBar {
                                 policy: ScrollBar.AsNeeded
@@ -688,11 +782,15 @@ ApplicationWindow {
                                     radius: 12
                                     border.width: 1
                                     border.color: borderColor
-                                    // Participant A à gauche (vert pâle), participant B à droite (bleu pâle)
-                                    color: model.isError ? "#ffcdd2" : (model.isSideA ? "#e8f5e9" : aiMessageColor)
+                                    // Premier participant à gauche (vert pâle), les autres à droite,
+                                    // chacun sa couleur
+                                    readonly property bool firstSpeaker: model.participantIndex === 0
+                                    color: model.isError ? "#ffcdd2"
+                                           : (firstSpeaker ? "#e8f5e9"
+                                              : [aiMessageColor, "#fff3e0", "#f3e5f5", "#e0f7fa"][Math.max(0, model.participantIndex - 1) % 4])
                                     anchors.top: parent.top
-                                    anchors.left: model.isSideA ? parent.left : undefined
-                                    anchors.right: model.isSideA ? undefined : parent.right
+                                    anchors.left: firstSpeaker ? parent.left : undefined
+                                    anchors.right: firstSpeaker ? undefined : parent.right
 
                                     Column {
                                         id: _duoContentColumn
@@ -756,14 +854,14 @@ ApplicationWindow {
                         RowLayout {
                             Layout.fillWidth: true
                             Layout.margins: 8
-                            visible: _chatManager.duoChatModel.busy
+                            visible: _chatManager.groupChatModel.busy
                             BusyIndicator {
-                                running: _chatManager.duoChatModel.busy
+                                running: _chatManager.groupChatModel.busy
                                 Layout.preferredWidth: 24
                                 Layout.preferredHeight: 24
                             }
                             Label {
-                                text: qsTr("%1 is writing…").arg(_chatManager.duoChatModel.pendingSpeaker)
+                                text: qsTr("Writing: %1…").arg(_chatManager.groupChatModel.pendingSpeaker)
                                 color: "#757575"
                             }
                         }
@@ -776,22 +874,26 @@ ApplicationWindow {
                     RowLayout {
                         anchors.fill: parent
                         Label {
-                            text: _chatManager.duoChatModel.running
-                                  ? qsTr("Running — %1 message(s) left in this run").arg(_chatManager.duoChatModel.turnsLeft)
-                                  : (_chatManager.duoChatModel.sessionReady
-                                     ? qsTr("Paused — press Start to let %1 and %2 talk")
-                                       .arg(_chatManager.duoChatModel.participantA)
-                                       .arg(_chatManager.duoChatModel.participantB)
-                                     : qsTr("Select two different interlocutors to begin"))
+                            text: _chatManager.groupChatModel.running
+                                  ? qsTr("Running — %1 message(s) left in this run").arg(_chatManager.groupChatModel.turnsLeft)
+                                  : (_chatManager.groupChatModel.sessionReady
+                                     ? qsTr("Paused — press Start to let %1 talk")
+                                       .arg(_chatManager.groupChatModel.participants.join(", "))
+                                     : qsTr("Select two different interlocutors or more to begin"))
                         }
                         Label {
-                            visible: _chatManager.duoChatModel.curationPending
+                            visible: _chatManager.groupChatModel.loading
+                            text: qsTr(" • loading history…")
+                            color: "#9E9E9E"
+                        }
+                        Label {
+                            visible: _chatManager.groupChatModel.curationPending
                             text: qsTr(" • memory curation in progress…")
                             color: "#FF9800"
                         }
                         Item { Layout.fillWidth: true }
                         Label {
-                            text: qsTr("Session cost: %1 tokens").arg(_chatManager.duoChatModel.cumulativeTokenCost)
+                            text: qsTr("Session cost: %1 tokens").arg(_chatManager.groupChatModel.cumulativeTokenCost)
                         }
                     }
                 }
@@ -902,6 +1004,8 @@ ApplicationWindow {
                                 modelComboBox.currentIndex = -1;
                             }
 
+                            curatorModelComboBox.refresh();
+
                             // 3. Rafraîchir les miniatures image dans la config
                             _configImg1Preview.imgPath = _chatManager.getInterlocutorImagePath(_chatManager.currentConfig.name, 1)
                             _configImg2Preview.imgPath = _chatManager.getInterlocutorImagePath(_chatManager.currentConfig.name, 2)
@@ -953,6 +1057,10 @@ ApplicationWindow {
                                                  // 2. Mise à jour du modèle de la ComboBox des modèles
                                                  modelComboBox.model = _chatManager.modelsForProvider(model[index]);
 
+                                                 // Un curateur d'un autre fournisseur n'a pas la bonne clé API
+                                                 _chatManager.currentConfig.curatorModelName = "";
+                                                 curatorModelComboBox.refresh();
+
                                                  // 3. Sélectionner le premier modèle par défaut
                                                  if (modelComboBox.model.length > 0) {
                                                      modelComboBox.currentIndex = 0;
@@ -975,6 +1083,27 @@ ApplicationWindow {
                                              }
                             }
 
+                            // Modèle de curation : même fournisseur (même clé API)
+                            Label { text: qsTr("Curator model:") }
+                            ComboBox {
+                                id: curatorModelComboBox
+                                Layout.fillWidth: true
+                                ToolTip.visible: hovered
+                                ToolTip.text: qsTr("Model that writes the long-term memory. A cheaper model keeps curation costs down.")
+                                // Recharge la liste pour le fournisseur courant et sélectionne le modèle de la config
+                                function refresh() {
+                                    if (!_chatManager.currentConfig) return;
+                                    let provider = _chatManager.currentConfig.type;
+                                    model = [qsTr("Same as chat model")].concat(provider ? _chatManager.modelsForProvider(provider) : []);
+                                    let curatorIndex = model.indexOf(_chatManager.currentConfig.curatorModelName);
+                                    currentIndex = curatorIndex > 0 ? curatorIndex : 0;
+                                }
+                                onActivated: (index) => {
+                                                 if (!_chatManager.currentConfig) return;
+                                                 _chatManager.currentConfig.curatorModelName = index > 0 ? model[index] : "";
+                                             }
+                            }
+
                             // Clé API
                             Label { text: "API Key:" }
                             TextField {
@@ -1194,6 +1323,16 @@ ApplicationWindow {
                         }
                     }
 
+                    CheckBox {
+                        id: streamingCheckbox
+                        text: qsTr("Stream replies as they are generated")
+                        checked: _chatManager.chatModel ? _chatManager.chatModel.streamingEnabled : true
+                        onCheckedChanged: {
+                            if (_chatManager.chatModel)
+                                _chatManager.chatModel.streamingEnabled = checked
+                        }
+                    }
+
                     CheckBox {
                         id: extendedContextCheckbox
                         text: qsTr("Extend the conversation context and disable the attached files.")
@@ -1219,11 +1358,105 @@ ApplicationWindow {
                     Item { Layout.fillHeight: true }
                 }
             }
-            // 1.2.5 `_infoArea` : Information page, versions, details, URL of the github, ...
+            // 1.2.5 `_diagnosticsArea` : Timings of the hot paths recorded by the Tracer
+            // (payload build, time to first byte, parsing, journal, curation, model reset)
+            // ------------------------------
+            ColumnLayout {
+                id: _diagnosticsArea
+                visible: _tabBar.currentIndex === 4
+                Layout.fillWidth: true
+                Layout.fillHeight: true
+                spacing: 10
+
+                // Rafraîchi chaque seconde, seulement quand l'onglet est affiché
+                Binding {
+                    target: _diagnostics
+                    property: "active"
+                    value: _diagnosticsArea.visible
+                }
+
+                RowLayout {
+                    Layout.fillWidth: true
+                    Layout.margins: 10
+                    spacing: 10
+
+                    CheckBox {
+                        text: qsTr("Record timings")
+                        checked: _diagnostics.tracingEnabled
+                        onToggled: _diagnostics.tracingEnabled = checked
+                    }
+                    Item { Layout.fillWidth: true }
+                    Label {
+                        id: _traceExportLabel
+                        elide: Text.ElideMiddle
+                        Layout.maximumWidth: 400
+                        color: "#555555"
+                    }
+                    Button {
+                        text: qsTr("Export trace")
+                        onClicked: _traceExportLabel.text = qsTr("Saved to %1").arg(_diagnostics.exportTrace())
+                    }
+                    Button {
+                        text: qsTr("Clear")
+                        onClicked: _diagnostics.clear()
+                    }
+                }
+
+                // En-tête des colonnes (durées en ms)
+                RowLayout {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 10
+                    Layout.rightMargin: 10
+                    Repeater {
+                        model: [qsTr("Span"), qsTr("Count"), qsTr("Last"), qsTr("p50"), qsTr("p99"), qsTr("Max")]
+                        Label {
+                            text: modelData
+                            font.bold: true
+                            Layout.preferredWidth: index === 0 ? 260 : 90
+                        }
+                    }
+                }
+
+                ListView {
+                    Layout.fillWidth: true
+                    Layout.fillHeight: true
+                    Layout.leftMargin: 10
+                    Layout.rightMargin: 10
+                    clip: true
+                    model: _diagnostics.spans
+                    ScrollBar.vertical: ScrollBar {}
+                    delegate: RowLayout {
+                        width: ListView.view.width
+                        Label { text: modelData.name; Layout.preferredWidth: 260; elide: Text.ElideRight }
+                        Label { text: modelData.count; Layout.preferredWidth: 90 }
+                        Label { text: modelData.lastMs.toFixed(2); Layout.preferredWidth: 90 }
+                        Label { text: modelData.p50Ms.toFixed(2); Layout.preferredWidth: 90 }
+                        Label { text: modelData.p99Ms.toFixed(2); Layout.preferredWidth: 90 }
+                        Label { text: modelData.maxMs.toFixed(2); Layout.preferredWidth: 90 }
+                    }
+                }
+
+                Label {
+                    text: qsTr("Counters")
+                    font.bold: true
+                    Layout.leftMargin: 10
+                    visible: _diagnostics.counters.length > 0
+                }
+                Flow {
+                    Layout.fillWidth: true
+                    Layout.margins: 10
+                    spacing: 20
+                    Repeater {
+                        model: _diagnostics.counters
+                        Label { text: modelData.name + ": " + modelData.value }
+                    }
+                }
+            }
+            // 1.2.6 `_infoArea` : Information page, versions, details, URL of the github, ...
             // ------------------------------
             ScrollView {
                 id: _infoArea
-                visible: _tabBar.currentIndex === 4
+                visible: _tabBar.currentIndex === 5
                 Layout.fillWidth: true
                 Layout.fillHeight: true
                 clip: true
@@ -4,20 +4,22 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QRegularExpression>
 #include <QTextStream>
 
+#include "IoWorker.h"
+
 QString MemoryCurator::systemPrompt()
 {
     return QStringLiteral(
-        "You are a memory curator. Your task is to create a new, single, "
-        "coherent summary of your own long-term memory as an AI by integrating "
-        "new information. This is what you'll remember of the oldest messages "
-        "that slip past your memory.");
+        "You are a memory curator. Your task is to write your own long-term "
+        "memory as an AI, one summary at a time. This is what you'll remember "
+        "of the oldest messages that slip past your memory.");
 }
 
 QString MemoryCurator::buildUserMessage(QString recentContext, QString olderTranscript,
-                                        QString existingMemory)
+                                        QString knownMemory)
 {
     // --- Sanitization Step ---
     // We want to remove any occurrence of the curation markers from the content
@@ -28,7 +30,7 @@ QString MemoryCurator::buildUserMessage(QString recentContext, QString olderTran
         "CONTEXT) ---");
     QString replacementText = "<redacted for clarity of the curation process>";
 
-    existingMemory.replace(markerRegex, replacementText);
+    knownMemory.replace(markerRegex, replacementText);
     olderTranscript.replace(markerRegex, replacementText);
     recentContext.replace(markerRegex, replacementText);
 
@@ -38,15 +40,14 @@ QString MemoryCurator::buildUserMessage(QString recentContext, QString olderTran
         "You're **not** talking to a human. Currently, your interlocutor is a program. This is a "
         "special phase of the chat program called: memory curation. Your memory has grown larger "
         "than the size of your context, so the oldest exchanges will be removed from the "
-        "conversation. We're now providing you with these exchanges now so you can update your file "
-        "of older memories (kept outside the conversation). Please include all the information you "
-        "want to keep. Your task is to sift through the posts being removed and summarize the "
-        "important information about your **identity**, **personality**, and **the relationship** "
-        "with the user. "
-        " We will provide the previous version of your older memories so you can combine it with the "
-        "new information from the removed posts to create a list of important details about you, "
-        "your personality, and your relationship with the user.\n\n"
-        "Your goal is to produce an UPDATED LONG-TERM MEMORY SUMMARY.\n\n"
+        "conversation. We're now providing you with these exchanges so you can add them to your "
+        "older memories (kept outside the conversation) as a new episode. Please include all the "
+        "information you want to keep. Your task is to sift through the posts being removed and "
+        "summarize the important information about your **identity**, **personality**, and **the "
+        "relationship** with the user. "
+        " We will provide what you already remember, so that you do not repeat it: the new episode "
+        "is stored next to it, and older episodes are merged together later on.\n\n"
+        "Your goal is to produce the SUMMARY OF THIS EPISODE.\n\n"
         "## INPUTS\n\n"
         "You are given three sections:\n\n"
         "1) RECENT CONTEXT\n\n"
@@ -57,19 +58,19 @@ QString MemoryCurator::buildUserMessage(QString recentContext, QString olderTran
         "2) OLDER MESSAGES TO ARCHIVE\n\n"
         "- These messages will be removed from the active context.\n\n"
         "- Extract and retain only durable, important information.\n\n"
-        "3) EXISTING MEMORY SUMMARY\n\n"
-        "- This is the current long-term memory.\n\n"
-        "- You must preserve all important information already present.\n\n"
+        "3) WHAT YOU ALREADY REMEMBER\n\n"
+        "- Your core profile and your latest memories, kept elsewhere.\n\n"
+        "- DO NOT copy it; mention it only where the new messages change it.\n\n"
         "## TASK\n\n"
-        "Produce a single, unified UPDATED MEMORY SUMMARY that:\n\n"
-        "- Keeps all relevant information from the EXISTING MEMORY SUMMARY.\n\n"
-        "- Integrates important information extracted from the OLDER MESSAGES.\n\n"
+        "Produce a single EPISODE SUMMARY that:\n\n"
+        "- Covers the important information of the OLDER MESSAGES, and only them.\n\n"
+        "- Records what changed with respect to WHAT YOU ALREADY REMEMBER.\n\n"
         "- Discards transient, local, or obsolete details.\n\n"
         "- Focuses on durable facts, preferences, projects, constraints, decisions, and "
         "identities.\n\n"
         "DO NOT summarize the RECENT CONTEXT.\n\n"
         "## OUTPUT RULES (STRICT)\n\n"
-        "- Output ONLY the updated memory summary.\n\n"
+        "- Output ONLY the episode summary.\n\n"
         "- Plain text only.\n\n"
         "- No headings, no lists unless necessary.\n\n"
         "- No explanations, no meta-comments.\n\n"
@@ -88,8 +89,54 @@ QString MemoryCurator::buildUserMessage(QString recentContext, QString olderTran
         olderTranscript +
         "\n"
         "---\n\n"
-        "# 3) EXISTING MEMORY SUMMARY " +
-        (existingMemory.isEmpty() ? "None." : existingMemory) + "\n";
+        "# 3) WHAT YOU ALREADY REMEMBER " +
+        (knownMemory.isEmpty() ? "None." : knownMemory) + "\n";
+    // clang-format on
+}
+
+QString MemoryCurator::buildRollupMessage(const TieredMemory::Rollup &rollup, QString core,
+                                          int coreTokens)
+{
+    QString summaries;
+    for (const TieredMemory::Entry &entry : rollup.sources)
+        summaries += "[" + entry.from.toString("yyyy-MM-dd") + " to " +
+                     entry.to.toString("yyyy-MM-dd") + "]\n" + entry.text + "\n\n";
+
+    // clang-format off
+    if (rollup.target == TieredMemory::Level::Era)
+        return
+            "# MEMORY CONSOLIDATION TASK\n\n"
+            "You're **not** talking to a human. This is a special phase of the chat program: memory "
+            "consolidation. Below are summaries you wrote of consecutive episodes of your "
+            "conversation with the user, oldest first. Together they have grown too long; they will "
+            "be replaced by ONE summary of the whole period, which you are now writing.\n\n"
+            "## TASK\n\n"
+            "- Merge the episodes into a single summary of the period, much shorter than their "
+            "total.\n\n"
+            "- Keep durable facts, preferences, projects, decisions, and how the relationship "
+            "evolved; drop what later episodes made obsolete.\n\n"
+            "- Output ONLY the summary, plain text, without addressing the user.\n\n"
+            "---\n\n"
+            "# EPISODES\n\n" + summaries;
+
+    return
+        "# MEMORY CONSOLIDATION TASK\n\n"
+        "You're **not** talking to a human. This is a special phase of the chat program: memory "
+        "consolidation. Your CORE PROFILE holds what matters most about your **identity**, "
+        "**personality**, and **the relationship** with the user. The OLDER PERIODS below, "
+        "summaries of the earliest parts of your conversation, will now be removed from your "
+        "memory: fold into the core profile whatever of them deserves to be remembered for "
+        "good.\n\n"
+        "## TASK\n\n"
+        "- Produce the UPDATED CORE PROFILE: everything important from the current one, plus the "
+        "durable information of the older periods.\n\n"
+        "- Stay under about " + QString::number(coreTokens * 3 / 4) + " words: prefer what "
+        "defines you and the user over events.\n\n"
+        "- Output ONLY the core profile, plain text, without addressing the user.\n\n"
+        "---\n\n"
+        "# CURRENT CORE PROFILE\n\n" + (core.isEmpty() ? "None." : core) + "\n\n"
+        "---\n\n"
+        "# OLDER PERIODS\n\n" + summaries;
     // clang-format on
 }
 
@@ -98,69 +145,76 @@ QString MemoryCurator::transcriptToText(const QList<ChatMessage> &messages)
     QString text;
     for (const ChatMessage &msg : messages)
     {
-        if (msg.isError() || msg.isTypingIndicator)
+        if (msg.isError() || msg.isTypingIndicator())
             continue;
         text += (msg.isLocalMessage() ? "user: " : "assistant: ") + msg.text() + "\n\n";
     }
     return text;
 }
 
-int MemoryCurator::estimateMessageTokens(const ChatMessage &msg)
+int MemoryCurator::estimateMessageTokens(const ChatMessage &msg, const Tokenizer &tokenizer)
 {
-    int tokens = (msg.role() == "assistant") ? msg.completionTokens() : msg.promptTokens();
+    if (msg.tokenWeight() >= 0)
+        return msg.tokenWeight();
+    int tokens = msg.isAssistant() ? msg.completionTokens() : msg.promptTokens();
     if (tokens == 0)
-        tokens = msg.text().length() / 4;
+        tokens = tokenizer.countTokens(msg.text());
     return tokens;
 }
 
-QString MemoryCurator::loadMemory(const QString &memoryFilePath)
+int MemoryCurator::weigh(ChatMessage &msg, const Tokenizer &tokenizer)
+{
+    if (msg.tokenWeight() < 0)
+        msg.setTokenWeight(qMax(0, estimateMessageTokens(msg, tokenizer)));
+    return msg.tokenWeight();
+}
+
+TieredMemory MemoryCurator::loadMemory(const QString &memoryFilePath)
 {
     if (memoryFilePath.isEmpty())
-        return "";
+        return TieredMemory();
+
+    QByteArray pending;
+    if (IoWorker::instance().pendingContent(memoryFilePath, pending))
+        return TieredMemory::fromJson(pending);
 
     QFile file(memoryFilePath);
-    if (!file.open(QFile::ReadOnly | QFile::Text))
+    if (file.open(QFile::ReadOnly))
+        return TieredMemory::fromJson(file.readAll());
+
+    // Mémoire d'une version précédente : un seul résumé en texte brut
+    // (<nom>_memory.txt), repris comme noyau jusqu'à la prochaine sauvegarde.
+    const QFileInfo info(memoryFilePath);
+    QFile legacy(info.path() + "/" + info.completeBaseName() + ".txt");
+    if (!legacy.open(QFile::ReadOnly | QFile::Text))
     {
-        return ""; // Pas encore de fichier de mémoire, c'est normal au début
+        return TieredMemory(); // Pas encore de fichier de mémoire, c'est normal au début
     }
-    QTextStream in(&file);
-    return in.readAll();
+    QTextStream in(&legacy);
+    return TieredMemory::fromLegacyText(in.readAll());
+}
+
+QString MemoryCurator::requestMemory(const QString &memoryFilePath)
+{
+    return loadMemory(memoryFilePath).render(TieredMemory::Limits::fromSettings().requestTokens);
 }
 
-bool MemoryCurator::saveMemoryWithBackup(const QString &memoryFilePath, const QString &content)
+void MemoryCurator::saveMemoryWithBackup(const QString &memoryFilePath,
+                                         const TieredMemory &memory, QObject *context,
+                                         std::function<void(bool)> done)
 {
     if (memoryFilePath.isEmpty())
     {
         qWarning() << "Cannot save older memory: no memory file path set.";
-        return false;
+        done(false);
+        return;
     }
 
-    // Backup existing file before overwriting
-    QFile existingFile(memoryFilePath);
-    if (existingFile.exists())
-    {
-        QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
-        QString backupPath = memoryFilePath + "." + timestamp + ".bak";
-        if (existingFile.copy(backupPath))
-        {
-            qDebug() << "Backed up ancient memory to:" << backupPath;
-        }
-        else
-        {
-            qWarning() << "Failed to backup ancient memory to:" << backupPath;
-            // Abort save to ensure we don't destroy data without backup
-            return false;
-        }
-    }
-
-    QFile file(memoryFilePath);
-    if (!file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate))
-    {
-        qWarning() << "Failed to open older memory file for writing:" << memoryFilePath;
-        return false;
-    }
-    QTextStream out(&file);
-    out << content;
-    return true;
+    // Backup existing file before overwriting (the IoWorker aborts the save
+    // if the copy fails, to ensure we don't destroy data without backup)
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    const QString backupPath = memoryFilePath + "." + timestamp + ".bak";
+    IoWorker::instance().replaceFile(memoryFilePath, memory.toJson(), backupPath, context,
+                                     std::move(done));
 }
 // End Source File: MemoryCurator.cpp
@@ -5,16 +5,27 @@
 #include <QList>
 #include <QString>
 
+#include <functional>
+
 #include "ChatMessage.h"
+#include "TieredMemory.h"
+#include "Tokenizer.h"
+
+class QObject;
 
 // Shared helpers for the long-term memory curation process.
 //
 // The curation prompt, the memory file I/O (with timestamped backups) and the
 // transcript formatting were originally private to ChatModel. They are
-// factored out here so that DuoChatModel (AI ↔ AI conversations) can run the
-// exact same curation cycle for each side of a dialogue without duplicating
+// factored out here so that GroupChatModel (AI ↔ AI conversations) can run
+// the exact same curation cycle for each participant without duplicating
 // the logic. Both models keep their own asynchronous state machines; this
 // class is stateless.
+//
+// A curation cycle first turns the culled messages into a new episode of the
+// TieredMemory (buildUserMessage), then, while a level exceeds its limit,
+// merges its oldest summaries one level up (buildRollupMessage). Each request
+// only carries the summaries it rewrites.
 class MemoryCurator
 {
 public:
@@ -23,26 +34,46 @@ public:
     // Kind::CurationResult, which the interlocutors fold into the system block.
     static QString systemPrompt();
 
-    // Builds the full curation user message from the three context sections.
-    // All inputs are sanitized so that stray section markers in the
-    // conversation cannot confuse the curation process.
+    // Builds the episode curation user message from the three context
+    // sections; `knownMemory` is a bounded render of the current memory, given
+    // for reference only. All inputs are sanitized so that stray section
+    // markers in the conversation cannot confuse the curation process.
     static QString buildUserMessage(QString recentContext, QString olderTranscript,
-                                    QString existingMemory);
+                                    QString knownMemory);
+
+    // Builds the user message merging `rollup.sources` into one era summary,
+    // or into the core profile `core` (aiming at `coreTokens`).
+    static QString buildRollupMessage(const TieredMemory::Rollup &rollup, QString core,
+                                      int coreTokens);
 
     // Formats a message list as a plain "user:/assistant:" transcript.
     static QString transcriptToText(const QList<ChatMessage> &messages);
 
     // Token weight of one message in the live context: API token counts when
-    // available, otherwise a rough chars/4 estimate. Used symmetrically when
-    // culling messages and when restoring them after a failed curation.
-    static int estimateMessageTokens(const ChatMessage &msg);
+    // available, otherwise the count of the model's tokenizer. Returns the
+    // weight cached in the message (ChatMessage::tokenWeight) when there is one.
+    static int estimateMessageTokens(const ChatMessage &msg, const Tokenizer &tokenizer);
+
+    // Same, but stores the weight in the message, which then carries it into
+    // the journal: it is computed once per message, never on later loads.
+    static int weigh(ChatMessage &msg, const Tokenizer &tokenizer);
+
+    // Reads the memory file (<name>_memory.json, or the plain-text
+    // <name>_memory.txt of older versions); returns an empty memory if absent.
+    // A save still queued on the IoWorker is returned instead of the file.
+    static TieredMemory loadMemory(const QString &memoryFilePath);
 
-    // Reads the ancient memory file; returns an empty string if absent.
-    static QString loadMemory(const QString &memoryFilePath);
+    // The memory as sent with each request (TieredMemory::render within the
+    // "memory/requestTokens" budget).
+    static QString requestMemory(const QString &memoryFilePath);
 
-    // Backs up the existing memory file (timestamped .bak) then overwrites it.
-    // Returns false (and writes nothing) if the backup could not be created.
-    static bool saveMemoryWithBackup(const QString &memoryFilePath, const QString &content);
+    // Backs up the existing memory file (timestamped .bak) then overwrites it,
+    // on the IoWorker thread. Writes nothing if the backup could not be
+    // created. `done(ok)` then runs on the GUI thread, unless `context` has
+    // been destroyed meanwhile: callers advance the journal watermark only
+    // once the new summary is safely on disk.
+    static void saveMemoryWithBackup(const QString &memoryFilePath, const TieredMemory &memory,
+                                     QObject *context, std::function<void(bool)> done);
 };
 
 #endif // MEMORYCURATOR_H
@@ -12,6 +12,7 @@ struct ModelInfo {
     int curationTriggerTokenCount; // Seuil de déclenchement de la curation
     int curationTargetTokenCount;  // Taille cible de la mémoire après curation
     int maxAttachedFileTokenCount; // Taille maximum des attachements autorisés
+    QString tokenizer;        // "o200k_base"... (vocabulaire dans TetherChats/tokenizers)
 };
 
 #endif // MODELINFO_H
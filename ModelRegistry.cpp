@@ -64,6 +64,7 @@ void ModelRegistry::populateModels()
             settings.setValue("curationTriggerTokenCount", model.curationTriggerTokenCount);
             settings.setValue("curationTargetTokenCount", model.curationTargetTokenCount);
             settings.setValue("maxAttachedFileTokenCount", model.maxAttachedFileTokenCount);
+            settings.setValue("tokenizer", defaultTokenizer(model.provider));
             settings.endGroup();
         }
         settings.sync();
@@ -81,12 +82,22 @@ void ModelRegistry::populateModels()
         model.curationTriggerTokenCount = settings.value("curationTriggerTokenCount", 0).toInt();
         model.curationTargetTokenCount = settings.value("curationTargetTokenCount", 0).toInt();
         model.maxAttachedFileTokenCount = settings.value("maxAttachedFileTokenCount", 0).toInt();
+        model.tokenizer = settings.value("tokenizer", defaultTokenizer(model.provider)).toString();
         settings.endGroup();
         
         m_models.append(model);
     }
 }
 
+QString ModelRegistry::defaultTokenizer(const QString &provider)
+{
+    // Seuls les vocabulaires d'OpenAI sont publiés ; cl100k_base reste une
+    // bien meilleure approximation que chars/4 pour les autres fournisseurs.
+    if (provider == "OpenAI")
+        return "o200k_base";
+    return "cl100k_base";
+}
+
 QStringList ModelRegistry::availableProviders() const
 {
     QStringList providers;
@@ -22,6 +22,9 @@ public:
     // Trouve toutes les informations d'un modèle par son nom d'affichage
     ModelInfo findModel(const QString& displayName) const;
 
+    // Tokenizer par défaut d'un fournisseur (models.ini sans clé "tokenizer")
+    static QString defaultTokenizer(const QString &provider);
+
 private:
     void populateModels(); // Remplit la base de données
     QList<ModelInfo> m_models;
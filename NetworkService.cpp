@@ -0,0 +1,420 @@
+// Begin Source File NetworkService.cpp
+#include "NetworkService.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QHttpMultiPart>
+#include <QLocale>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QSslConfiguration>
+#include <QSslSocket>
+#include <QThread>
+#include <QTimeZone>
+
+#include <memory>
+
+#include "RetryingReply.h"
+
+namespace
+{
+// Un préchauffage de moins de 30 s suffit : la connexion est encore ouverte
+const qint64 kWarmUpIntervalMs = 30000;
+
+// Ce que l'on apprend d'une réponse au fil de ses signaux
+struct Probe
+{
+    QElapsedTimer connecting;
+    bool newConnection = false;
+    qint64 handshakeMs = -1;
+};
+
+// Quand il reste moins d'un dixième d'un quota, les requêtes restantes sont
+// étalées jusqu'à sa remise à zéro.
+const int kPacingFraction = 10;
+
+// "Retry-After: 30" ou "Retry-After: Wed, 21 Oct 2026 07:28:00 GMT" ; OpenAI
+// envoie aussi "retry-after-ms". -1 sans en-tête lisible.
+qint64 retryAfterMs(const QNetworkReply *reply)
+{
+    bool ok = false;
+    const double ms = reply->rawHeader("retry-after-ms").toDouble(&ok);
+    if (ok)
+        return qint64(ms);
+    const QByteArray value = reply->rawHeader("retry-after").trimmed();
+    if (value.isEmpty())
+        return -1;
+    const double seconds = value.toDouble(&ok);
+    if (ok)
+        return qint64(seconds * 1000);
+    QDateTime date = QLocale::c().toDateTime(QString::fromLatin1(value),
+                                             "ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+    if (!date.isValid())
+        return -1;
+    date.setTimeZone(QTimeZone::UTC);
+    return qMax<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(date));
+}
+
+// Durées d'OpenAI : "1s", "6m0s", "20ms", "1h2m3.5s"
+qint64 parseDurationMs(const QByteArray &value)
+{
+    static const QRegularExpression part("(\\d+(?:\\.\\d+)?)(ms|h|m|s)");
+    qint64 total = 0;
+    bool any = false;
+    for (const QRegularExpressionMatch &match : part.globalMatch(QString::fromLatin1(value)))
+    {
+        const double amount = match.captured(1).toDouble();
+        const QString unit = match.captured(2);
+        const double factor = unit == "h" ? 3600000 : unit == "m" ? 60000 : unit == "s" ? 1000 : 1;
+        total += qint64(amount * factor);
+        any = true;
+    }
+    return any ? total : -1;
+}
+} // namespace
+
+NetworkService::RetryPolicy NetworkService::RetryPolicy::fromSettings()
+{
+    QSettings settings("Tether", "ChatApp");
+    RetryPolicy policy;
+    policy.maxRetries = qBound(0, settings.value("network/maxRetries", 4).toInt(), 10);
+    policy.baseDelayMs = qMax(100, settings.value("network/retryBaseMs", 1000).toInt());
+    policy.maxDelayMs =
+        qMax(policy.baseDelayMs, settings.value("network/retryMaxMs", 30000).toInt());
+    return policy;
+}
+
+NetworkService &NetworkService::instance()
+{
+    // Détruit avec l'application, donc avant les sockets de Qt
+    static NetworkService *service = new NetworkService(QCoreApplication::instance());
+    return *service;
+}
+
+NetworkService::NetworkService(QObject *parent)
+    : QObject(parent)
+    , m_scheduler(new RequestScheduler(this))
+{
+    QSettings settings("Tether", "ChatApp");
+    const QUrl endpointOverride(settings.value("network/endpointOverride").toString());
+    if (endpointOverride.isValid() && !endpointOverride.host().isEmpty())
+    {
+        m_endpointOverride = endpointOverride;
+        qInfo() << "Network: every request goes to" << hostKey(endpointOverride);
+    }
+}
+
+QUrl NetworkService::routed(QUrl url) const
+{
+    if (m_endpointOverride.isEmpty())
+        return url;
+    // Seul l'hôte change : chemin et paramètres disent au serveur quelle API
+    // est appelée.
+    url.setScheme(m_endpointOverride.scheme());
+    url.setHost(m_endpointOverride.host());
+    url.setPort(m_endpointOverride.port());
+    return url;
+}
+
+QNetworkRequest NetworkService::routed(QNetworkRequest request) const
+{
+    if (!m_endpointOverride.isEmpty())
+        request.setUrl(routed(request.url()));
+    return request;
+}
+
+QString NetworkService::hostKey(const QUrl &url)
+{
+    const int defaultPort = url.scheme() == "https" ? 443 : 80;
+    return url.scheme() + "://" + url.host() + ":" + QString::number(url.port(defaultPort));
+}
+
+QNetworkRequest NetworkService::prepared(QNetworkRequest request)
+{
+    // Permis par défaut dans Qt 6, mais c'est ce qui permet le multiplexage :
+    // on ne veut pas le perdre sur un changement de défaut.
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    return request;
+}
+
+QNetworkAccessManager *NetworkService::managerFor(const QUrl &url)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    const QString key = hostKey(url);
+    QNetworkAccessManager *&manager = m_managers[key];
+    if (!manager)
+        manager = new QNetworkAccessManager(this);
+    return manager;
+}
+
+QNetworkReply *NetworkService::post(const QNetworkRequest &original, const QByteArray &data,
+                                    QObject *owner, Priority priority, const RetryPolicy &policy)
+{
+    const QNetworkRequest request = routed(original);
+    return execute(request, QNetworkAccessManager::PostOperation,
+                   [this, request, data]()
+                   { return track(managerFor(request.url())->post(prepared(request), data)); },
+                   owner, priority, data.size(), policy);
+}
+
+QNetworkReply *NetworkService::post(const QNetworkRequest &original, QHttpMultiPart *multiPart,
+                                    QObject *owner)
+{
+    const QNetworkRequest request = routed(original);
+    RetryPolicy once;
+    once.maxRetries = 0;
+    QNetworkReply *reply =
+        execute(request, QNetworkAccessManager::PostOperation,
+                [this, request, multiPart]()
+                { return track(managerFor(request.url())->post(prepared(request), multiPart)); },
+                owner, Priority::Interactive, 0, once);
+    multiPart->setParent(reply);
+    return reply;
+}
+
+QNetworkReply *NetworkService::deleteResource(const QNetworkRequest &original, QObject *owner,
+                                              const RetryPolicy &policy)
+{
+    const QNetworkRequest request = routed(original);
+    return execute(request, QNetworkAccessManager::DeleteOperation,
+                   [this, request]()
+                   { return track(managerFor(request.url())->deleteResource(prepared(request))); },
+                   owner, Priority::Interactive, 0, policy);
+}
+
+QNetworkReply *NetworkService::execute(const QNetworkRequest &request,
+                                       QNetworkAccessManager::Operation operation,
+                                       std::function<QNetworkReply *()> send, QObject *owner,
+                                       Priority priority, qint64 bodyBytes,
+                                       const RetryPolicy &policy)
+{
+    const QByteArray account = RequestScheduler::accountOf(request);
+    const qint64 cost = RequestScheduler::costOf(bodyBytes);
+    // Le premier essai est décompté à l'admission, les suivants à l'envoi
+    auto attempts = std::make_shared<int>(0);
+    RetryingReply::Sender charged = [this, account, cost, attempts, send = std::move(send)]()
+    {
+        if ((*attempts)++ > 0)
+            m_scheduler->charge(account, cost);
+        return send();
+    };
+    auto *reply = new RetryingReply(request, operation, std::move(charged), policy,
+                                    owner ? owner : this);
+
+    const QString key = hostKey(request.url());
+    m_scheduler->submit(account, priority, cost, reply,
+                        [this, reply, key]()
+                        {
+                            const qint64 delay = pacingDelay(key);
+                            if (delay > 0)
+                                ++m_stats[key].pacedRequests;
+                            reply->start(delay);
+                        });
+    return reply;
+}
+
+bool NetworkService::isRetryable(int statusCode, QNetworkReply::NetworkError error)
+{
+    if (statusCode != 0)
+    {
+        // 529 : "overloaded" d'Anthropic
+        return statusCode == 408 || statusCode == 429 || statusCode == 500 ||
+               (statusCode >= 502 && statusCode <= 504) || statusCode == 529;
+    }
+    switch (error)
+    {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false; // Annulation, TLS, hôte introuvable... : réessayer n'y changerait rien
+    }
+}
+
+qint64 NetworkService::retryDelay(const QNetworkReply *attempt, int retries,
+                                  const RetryPolicy &policy)
+{
+    const int statusCode = attempt->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (retries >= policy.maxRetries || !isRetryable(statusCode, attempt->error()))
+        return -1;
+
+    // Backoff exponentiel à gigue "égale" : la moitié du délai, plus une
+    // part tirée au hasard, pour que les requêtes échouées ensemble (les deux
+    // côtés d'un duo) ne reviennent pas ensemble.
+    const qint64 ceiling = qMin<qint64>(policy.maxDelayMs, qint64(policy.baseDelayMs) << retries);
+    qint64 delay = ceiling / 2 + QRandomGenerator::global()->bounded(ceiling / 2 + 1);
+
+    const qint64 serverDelay = qMax(retryAfterMs(attempt), pacingDelay(hostKey(attempt->url())));
+    if (serverDelay > policy.maxDelayMs)
+    {
+        qWarning() << "Network:" << attempt->url().host() << "asks to wait" << serverDelay
+                   << "ms, more than network/retryMaxMs: giving up.";
+        return -1;
+    }
+    delay = qMax(delay, serverDelay);
+    ++m_stats[hostKey(attempt->url())].retries;
+    return delay;
+}
+
+void NetworkService::readRateLimits(const QNetworkReply *reply)
+{
+    const QString key = hostKey(reply->url());
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 until = 0;
+
+    // Un quota (requêtes, tokens...) : épuisé, on attend sa remise à zéro ;
+    // presque épuisé, on espace les requêtes restantes jusqu'à elle.
+    auto quota = [&until](const QByteArray &remainingHeader, const QByteArray &limitHeader,
+                          qint64 resetInMs)
+    {
+        bool ok = false;
+        const qint64 remaining = remainingHeader.toLongLong(&ok);
+        if (!ok || resetInMs <= 0)
+            return;
+        const qint64 limit = limitHeader.toLongLong();
+        if (remaining <= 0)
+            until = qMax(until, resetInMs);
+        else if (limit > 0 && remaining * kPacingFraction < limit)
+            until = qMax(until, resetInMs / (remaining + 1));
+    };
+
+    // Tailles des seaux du planificateur : quotas par minute annoncés
+    const QByteArray tokensLimit = reply->rawHeader("anthropic-ratelimit-tokens-limit");
+    m_scheduler->learnLimits(
+        RequestScheduler::accountOf(reply->request()),
+        qMax(reply->rawHeader("anthropic-ratelimit-requests-limit").toLongLong(),
+             reply->rawHeader("x-ratelimit-limit-requests").toLongLong()),
+        qMax(tokensLimit.isEmpty()
+                 ? reply->rawHeader("anthropic-ratelimit-input-tokens-limit").toLongLong()
+                 : tokensLimit.toLongLong(),
+             reply->rawHeader("x-ratelimit-limit-tokens").toLongLong()));
+
+    // Anthropic : anthropic-ratelimit-<quota>-remaining|limit|reset (RFC 3339)
+    for (const char *name : {"requests", "tokens", "input-tokens", "output-tokens"})
+    {
+        const QByteArray prefix = QByteArray("anthropic-ratelimit-") + name;
+        const QByteArray reset = reply->rawHeader(prefix + "-reset");
+        if (reset.isEmpty())
+            continue;
+        const QDateTime resetAt = QDateTime::fromString(QString::fromLatin1(reset), Qt::ISODate);
+        if (resetAt.isValid())
+            quota(reply->rawHeader(prefix + "-remaining"), reply->rawHeader(prefix + "-limit"),
+                  resetAt.toMSecsSinceEpoch() - now);
+    }
+    // OpenAI, DeepSeek : x-ratelimit-remaining|limit|reset-<quota> (durée)
+    for (const char *name : {"requests", "tokens"})
+    {
+        const QByteArray reset = reply->rawHeader(QByteArray("x-ratelimit-reset-") + name);
+        if (reset.isEmpty())
+            continue;
+        quota(reply->rawHeader(QByteArray("x-ratelimit-remaining-") + name),
+              reply->rawHeader(QByteArray("x-ratelimit-limit-") + name), parseDurationMs(reset));
+    }
+    // Un 429 ou un 503 peut dire lui-même combien de temps attendre
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode == 429 || statusCode == 503)
+        until = qMax(until, retryAfterMs(reply));
+
+    if (until > 0)
+    {
+        qint64 &pausedUntil = m_pausedUntil[key];
+        pausedUntil = qMax(pausedUntil, now + until);
+    }
+}
+
+qint64 NetworkService::pacingDelay(const QString &key) const
+{
+    return qMax<qint64>(0, m_pausedUntil.value(key) - QDateTime::currentMSecsSinceEpoch());
+}
+
+QNetworkReply *NetworkService::track(QNetworkReply *reply)
+{
+    const QString key = hostKey(reply->url());
+    ++m_stats[key].requests;
+
+    // Sans socketStartedConnecting, la requête est partie sur une connexion
+    // déjà ouverte (ou multiplexée sur la connexion HTTP/2).
+    auto probe = std::make_shared<Probe>();
+    connect(reply, &QNetworkReply::socketStartedConnecting, this,
+            [probe]()
+            {
+                probe->newConnection = true;
+                probe->connecting.start();
+            });
+    // Poignée de main : jusqu'à la fin du TLS en https, jusqu'à l'envoi en http
+    auto handshakeDone = [this, key, probe]()
+    {
+        if (!probe->newConnection || probe->handshakeMs >= 0)
+            return;
+        probe->handshakeMs = probe->connecting.elapsed();
+        HostStats &stats = m_stats[key];
+        ++stats.handshakes;
+        stats.handshakeMs += probe->handshakeMs;
+    };
+    connect(reply, &QNetworkReply::encrypted, this, handshakeDone);
+    connect(reply, &QNetworkReply::requestSent, this, handshakeDone);
+    connect(reply, &QNetworkReply::metaDataChanged, this,
+            [this, reply]() { readRateLimits(reply); });
+
+    connect(reply, &QNetworkReply::finished, this,
+            [this, key, probe, reply]()
+            {
+                HostStats &stats = m_stats[key];
+                if (probe->newConnection)
+                    ++stats.newConnections;
+                else
+                    ++stats.reusedConnections;
+                const bool http2 =
+                    reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+                if (http2)
+                    ++stats.http2Replies;
+                qDebug().noquote()
+                    << "Network:" << key << (http2 ? "HTTP/2" : "HTTP/1.1")
+                    << (probe->newConnection
+                            ? QString("new connection, handshake %1 ms").arg(probe->handshakeMs)
+                            : QString("reused connection"))
+                    << QString("(%1 new / %2 reused, average handshake %3 ms)")
+                           .arg(stats.newConnections)
+                           .arg(stats.reusedConnections)
+                           .arg(stats.averageHandshakeMs());
+            });
+    return reply;
+}
+
+void NetworkService::warmUp(const QUrl &original)
+{
+    const QUrl url = routed(original);
+    if (!url.isValid() || url.host().isEmpty())
+        return;
+    const QString key = hostKey(url);
+    QElapsedTimer &last = m_lastWarmUp[key];
+    if (last.isValid() && last.elapsed() < kWarmUpIntervalMs)
+        return;
+    last.start();
+    ++m_stats[key].warmUps;
+
+    QNetworkAccessManager *manager = managerFor(url);
+    if (url.scheme() == "https")
+    {
+        if (!QSslSocket::supportsSsl())
+            return;
+        // Même ALPN que les requêtes, sinon la connexion préchauffée ne
+        // servirait pas à une requête HTTP/2.
+        QSslConfiguration configuration = QSslConfiguration::defaultConfiguration();
+        configuration.setAllowedNextProtocols(
+            {QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+        manager->connectToHostEncrypted(url.host(), quint16(url.port(443)), configuration);
+    }
+    else
+    {
+        manager->connectToHost(url.host(), quint16(url.port(80)));
+    }
+    qDebug() << "Network: warming up" << key;
+}
+// End Source File NetworkService.cpp
@@ -0,0 +1,142 @@
+// Begin Source File NetworkService.h
+#ifndef NETWORKSERVICE_H
+#define NETWORKSERVICE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+#include <functional>
+
+#include "RequestScheduler.h"
+
+class QHttpMultiPart;
+
+// The HTTP connections of the whole process.
+//
+// Each interlocutor used to own its QNetworkAccessManager, hence its own
+// connections: a curator, a duo partner or a persona switched back to opened
+// new TCP + TLS connections to a host the process was already talking to, and
+// paid the handshakes again. Requests now go through this service, which keeps
+// one manager — one connection pool — per provider host (scheme, host and
+// port), shared by every interlocutor that talks to it:
+//   - HTTP/2 is allowed on every request: with a provider that negotiates it
+//     (ALPN), the chat, its curation and the side of a duo are multiplexed on
+//     one connection; otherwise the manager keeps its HTTP/1.1 connections
+//     alive between requests (its default);
+//   - warmUp() opens the connection of a host in advance, so that the
+//     handshakes overlap the user typing instead of delaying the first
+//     request (ChatManager calls it when a persona is selected);
+//   - every reply is followed: it reports whether it opened a new connection
+//     or reused one, the handshake time of new ones and the protocol used
+//     (stats(), and a debug line per request);
+//   - a request that fails for a passing reason (429, 5xx, connection lost)
+//     is sent again after an exponential, jittered delay, or after the
+//     Retry-After of the server (RetryPolicy, RetryingReply): the interlocutor
+//     only sees the last attempt;
+//   - the rate-limit headers of every response (anthropic-ratelimit-*,
+//     x-ratelimit-*) pace the next requests to the host: when a quota is
+//     nearly spent, requests are spread until its reset, and held back until
+//     then when it is spent — duo runs no longer hit the limits head first;
+//   - before any of that, the RequestScheduler admits the request, by
+//     priority, within the per-minute budgets of its API key;
+//   - the "network/endpointOverride" setting ("http://127.0.0.1:8089") sends
+//     every request to that server instead of the provider's host, path and
+//     query unchanged: tether_mockserver then stands in for all providers.
+//
+// GUI thread only, like the interlocutors. The replies belong to the `owner`
+// given with the request: destroying an interlocutor aborts its requests, as
+// destroying its own manager used to.
+class NetworkService : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct HostStats
+    {
+        int requests = 0;
+        int newConnections = 0;
+        int reusedConnections = 0;
+        int http2Replies = 0;
+        int handshakes = 0;
+        qint64 handshakeMs = 0; // Total
+        int warmUps = 0;
+        int retries = 0;
+        int pacedRequests = 0; // Retardées par les limites du fournisseur
+
+        qint64 averageHandshakeMs() const { return handshakes ? handshakeMs / handshakes : 0; }
+    };
+
+    // How failed requests are retried ("network/*" settings).
+    struct RetryPolicy
+    {
+        int maxRetries = 4;
+        int baseDelayMs = 1000;  // Avant le premier nouvel essai, doublé ensuite
+        int maxDelayMs = 30000;  // Attente maximale ; un Retry-After plus long fait échouer
+        static RetryPolicy fromSettings();
+    };
+
+    static NetworkService &instance();
+
+    using Priority = RequestScheduler::Priority;
+
+    QNetworkReply *post(const QNetworkRequest &request, const QByteArray &data, QObject *owner,
+                        Priority priority = Priority::Interactive,
+                        const RetryPolicy &policy = RetryPolicy::fromSettings());
+    // The multipart goes to the reply. Not retried: uploads are not
+    // idempotent (a lost response may hide a stored file).
+    QNetworkReply *post(const QNetworkRequest &request, QHttpMultiPart *multiPart,
+                        QObject *owner);
+    QNetworkReply *deleteResource(const QNetworkRequest &request, QObject *owner,
+                                  const RetryPolicy &policy = RetryPolicy::fromSettings());
+
+    RequestScheduler *scheduler() const { return m_scheduler; }
+
+    // 408, 429, 500, 502-504, 529 (overloaded), or a network error with no
+    // response (connection refused or lost, timeout).
+    static bool isRetryable(int statusCode, QNetworkReply::NetworkError error);
+
+    // Delay before retry number `retries` + 1 of the failed `attempt`, or -1
+    // to give up (not retryable, retries exhausted, server asking to wait
+    // longer than the policy allows).
+    qint64 retryDelay(const QNetworkReply *attempt, int retries, const RetryPolicy &policy);
+
+    // Opens a connection to the host of `url` if none was opened in the last
+    // few seconds. Returns at once.
+    void warmUp(const QUrl &url);
+
+    // Per host ("https://api.anthropic.com:443"), since the start.
+    QHash<QString, HostStats> stats() const { return m_stats; }
+
+private:
+    explicit NetworkService(QObject *parent);
+
+    static QString hostKey(const QUrl &url);
+    static QNetworkRequest prepared(QNetworkRequest request);
+    QUrl routed(QUrl url) const;
+    QNetworkRequest routed(QNetworkRequest request) const;
+    QNetworkAccessManager *managerFor(const QUrl &url);
+    QNetworkReply *execute(const QNetworkRequest &request,
+                           QNetworkAccessManager::Operation operation,
+                           std::function<QNetworkReply *()> send, QObject *owner,
+                           Priority priority, qint64 bodyBytes, const RetryPolicy &policy);
+    QNetworkReply *track(QNetworkReply *reply);
+    void readRateLimits(const QNetworkReply *reply);
+    qint64 pacingDelay(const QString &key) const;
+
+    RequestScheduler *m_scheduler;
+    QHash<QString, QNetworkAccessManager *> m_managers;
+    QHash<QString, HostStats> m_stats;
+    QHash<QString, QElapsedTimer> m_lastWarmUp;
+    QHash<QString, qint64> m_pausedUntil; // Par hôte, en ms depuis l'epoch
+    QUrl m_endpointOverride; // "network/endpointOverride", lu au démarrage
+};
+
+#endif // NETWORKSERVICE_H
+// End Source File NetworkService.h
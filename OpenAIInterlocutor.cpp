@@ -1,5 +1,6 @@
 // Begin source file OpenAIInterlocutor.cpp
 #include "OpenAIInterlocutor.h"
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QHttpMultiPart>
 #include <QHttpPart>
@@ -9,6 +10,31 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QUrl>
+#include <memory>
+
+#include "NetworkService.h"
+#include "SseParser.h"
+#include "Tracer.h"
+
+namespace
+{
+// Reads the "usage" object of a /v1/responses answer (or of the final
+// response.completed event in streaming mode). The tokens of the attached
+// files are subtracted from input_tokens so that they never count towards the
+// curation threshold.
+void readUsage(const QJsonObject &usage, int attachmentTokens, InterlocutorReply &reply)
+{
+    const int rawInputTokens = usage.value("input_tokens").toInt();
+    qDebug() << "Raw Input Tokens:" << rawInputTokens
+             << "Attachment Tokens to subtract:" << attachmentTokens;
+    reply.inputTokens = std::max(0, rawInputTokens - attachmentTokens);
+    reply.outputTokens = usage.value("output_tokens").toInt();
+    reply.totalTokens = reply.inputTokens + reply.outputTokens;
+    // Préfixe servi par le cache automatique d'OpenAI (déjà inclus dans input_tokens)
+    reply.cacheReadTokens =
+        usage.value("input_tokens_details").toObject().value("cached_tokens").toInt();
+}
+} // namespace
 
 OpenAIInterlocutor::OpenAIInterlocutor(QString interlocutorName, const QString &apiKey,
                                        const QUrl &url, const QString &model,
@@ -21,30 +47,44 @@ OpenAIInterlocutor::OpenAIInterlocutor(QString interlocutorName, const QString &
 {
     qDebug() << "Creating OpenAIInterlocutor url=" << url
              << "maxAttachmentTokens=" << m_maxAttachedFileTokenCount;
-    m_manager = new QNetworkAccessManager(this);
 }
 
-void OpenAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
-                                     const QString &ancientMemory,
-                                     const InterlocutorReply::Kind kind,
-                                     const QStringList &attachmentFileIds)
+RequestHandle *OpenAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
+                                               const QString &ancientMemory,
+                                               const InterlocutorReply::Kind kind,
+                                               const QStringList &attachmentFileIds,
+                                               const QString &recall)
 {
     if (m_apiKey.trimmed().isEmpty())
     {
         emit fileUploadFailed("Missing OpenAI API key.");
-        return;
+        return nullptr;
     }
 
+    // Le handle existe dès maintenant : la requête peut être annulée pendant
+    // la vérification des pièces jointes, avant même d'être envoyée.
+    auto *handle = new RequestHandle(kind, this);
+
     // --- Step 1: Check Attachment Tokens (if any) ---
     if (!attachmentFileIds.isEmpty())
     {
         checkAttachmentTokens(attachmentFileIds,
-                              [this, history, ancientMemory, kind, attachmentFileIds](
+                              [this, history, ancientMemory, kind, attachmentFileIds, recall,
+                               handle](
                                   bool success, int attachmentTokens, const QString &errorMsg)
                               {
                                   if (!success)
                                   {
                                       emit errorOccurred(errorMsg);
+                                      handle->finish();
+                                      return;
+                                  }
+                                  if (handle->isCancelled())
+                                  {
+                                      InterlocutorReply partial;
+                                      partial.kind = kind;
+                                      emitCancelledReply(partial);
+                                      handle->finish();
                                       return;
                                   }
 
@@ -61,14 +101,16 @@ void OpenAIInterlocutor::sendRequest(const QList<ChatMessage> &history,
                                   // `attachmentTokens` in the lambda is the key.
 
                                   this->sendActualRequest(history, ancientMemory, kind,
-                                                          attachmentFileIds, attachmentTokens);
+                                                          attachmentFileIds, attachmentTokens,
+                                                          recall, handle);
                               });
     }
     else
     {
         // If no attachments, send directly with 0 attachment tokens
-        sendActualRequest(history, ancientMemory, kind, attachmentFileIds, 0);
+        sendActualRequest(history, ancientMemory, kind, attachmentFileIds, 0, recall, handle);
     }
+    return handle;
 }
 
 // New helper to keep sendRequest clean
@@ -76,7 +118,8 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
                                            const QString &ancientMemory,
                                            const InterlocutorReply::Kind kind,
                                            const QStringList &attachmentFileIds,
-                                           int attachmentTokens)
+                                           int attachmentTokens, const QString &recall,
+                                           RequestHandle *handle)
 {
 
     QNetworkRequest request(m_url);
@@ -89,7 +132,24 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
     QJsonObject payload;
     payload["model"] = m_model;
 
-    QJsonArray inputArray;
+    const bool streaming = m_streamingEnabled && kind == InterlocutorReply::Kind::NormalMessage;
+    if (streaming)
+        payload["stream"] = true;
+
+    // Le cache de préfixe d'OpenAI est automatique ; une clé stable par
+    // persona oriente ses requêtes vers les mêmes machines, donc vers le
+    // préfixe déjà en cache. L'ordre ci-dessous (personnalité, mémoire,
+    // historique, fichiers, passages rappelés) va déjà du plus stable au plus
+    // volatil.
+    payload["prompt_cache_key"] = QString::fromLatin1(
+        QCryptographicHash::hash(("tether/" + m_interlocutorName).toUtf8(),
+                                 QCryptographicHash::Sha256)
+            .toHex()
+            .left(32));
+
+    // Le tableau "input" est assemblé par le cache de l'historique : seuls les
+    // messages nouveaux depuis le tour précédent sont encodés.
+    m_historyCache.begin(kind == InterlocutorReply::Kind::NormalMessage);
 
     // qDebug() << "m_systemMsg=" << m_systemPrompt;
 
@@ -105,7 +165,7 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
         devText["text"] = m_systemPrompt;
         devContent.append(devText);
         devMessage["content"] = devContent;
-        inputArray.append(devMessage);
+        m_historyCache.appendObject(devMessage);
     }
 
     // qDebug() << "ancientMemory=" << ancientMemory;
@@ -128,25 +188,31 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
                           ancientMemory;
         memContent.append(memText);
         memMessage["content"] = memContent;
-        inputArray.append(memMessage);
+        m_historyCache.appendObject(memMessage);
     }
 
     // 2) Historique (user -> input_text, assistant -> output_text)
     for (const ChatMessage &msg : history)
     {
-        if (msg.isError() || msg.isTypingIndicator) continue;
+        if (msg.isError() || msg.isTypingIndicator()) continue;
 
-        QJsonObject historyMessage;
-        historyMessage["role"] = msg.isLocalMessage() ? "user" : "assistant";
-
-        QJsonArray contentArray;
-        QJsonObject textObject;
-        textObject["type"] = msg.isLocalMessage() ? "input_text" : "output_text";
-        textObject["text"] = msg.text();
-        contentArray.append(textObject);
-        historyMessage["content"] = contentArray;
-
-        inputArray.append(historyMessage);
+        m_historyCache.append(HistoryPayloadCache::keyOf(msg),
+                              [&msg]()
+                              {
+                                  QJsonObject historyMessage;
+                                  historyMessage["role"] =
+                                      msg.isLocalMessage() ? "user" : "assistant";
+
+                                  QJsonArray contentArray;
+                                  QJsonObject textObject;
+                                  textObject["type"] =
+                                      msg.isLocalMessage() ? "input_text" : "output_text";
+                                  textObject["text"] = msg.text();
+                                  contentArray.append(textObject);
+                                  historyMessage["content"] = contentArray;
+
+                                  return HistoryPayloadCache::encodeObject(historyMessage);
+                              });
     }
 
     // 3) Fichiers: injectés comme un message 'user' avec des items {type:
@@ -176,17 +242,33 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
         }
 
         filesMsg["content"] = filesContent;
-        inputArray.append(filesMsg);
+        m_historyCache.appendObject(filesMsg);
     }
 
-    payload["input"] = inputArray;
+    // 4) Passages rappelés de l'archive : un message à part, en dernier, pour
+    // que le message de l'utilisateur reste identique d'un tour à l'autre.
+    if (!recall.isEmpty())
+    {
+        QJsonObject recallMsg;
+        recallMsg["role"] = "developer";
+        recallMsg["content"] = QJsonArray{QJsonObject{{"type", "input_text"}, {"text", recall}}};
+        m_historyCache.appendObject(recallMsg);
+    }
 
-    // qDebug().noquote() << "Sending JSON to OpenAI /v1/responses:\n"
-    //                    << QJsonDocument(payload).toJson(QJsonDocument::Indented);
+    QByteArray data = m_historyCache.finish(payload, QLatin1StringView("input"));
 
-    QByteArray data = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    // qDebug().noquote() << "Sending JSON to OpenAI /v1/responses:\n" << data;
+
+    QNetworkReply *reply =
+        NetworkService::instance().post(request, data, this, requestPriority(kind));
+
+    handle->attach(reply, REQUEST_TIMEOUT_MS);
 
-    QNetworkReply *reply = m_manager->post(request, data);
+    if (streaming)
+    {
+        connectStreamingReply(reply, kind, attachmentTokens);
+        return;
+    }
 
     connect(
         reply, &QNetworkReply::finished, this,
@@ -196,6 +278,15 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
             const int statusCode =
                 reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
+            if (RequestHandle::wasCancelled(reply))
+            {
+                InterlocutorReply partial;
+                partial.kind = kind;
+                emitCancelledReply(partial);
+                reply->deleteLater();
+                return;
+            }
+
             // 1) Vérifier l'erreur réseau + HTTP
             if (reply->error() != QNetworkReply::NoError || statusCode < 200 || statusCode >= 300)
             {
@@ -210,7 +301,9 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
             }
 
             // 2) Parser le JSON
+            TraceScope parseScope("json.parse", "interlocutor");
             const QJsonDocument jsonDoc = QJsonDocument::fromJson(raw);
+            parseScope.close();
             if (jsonDoc.isNull() || !jsonDoc.isObject())
             {
                 emit errorOccurred("Invalid JSON response from OpenAI API.");
@@ -258,24 +351,11 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
             // 4) Usage tokens
             if (responseObj.contains("usage") && responseObj["usage"].isObject())
             {
-                const QJsonObject usage = responseObj["usage"].toObject();
-                // ⚠️ CRITICAL CHANGE: Subtract the tokens coming from the attached files
-                // from the reported input_tokens.
-                int rawInputTokens = usage.value("input_tokens").toInt();
-
-                qDebug() << "Raw Input Tokens:" << rawInputTokens
-                         << "Attachment Tokens to subtract:" << attachmentTokens;
-
-                cleanReply.inputTokens = std::max(0, rawInputTokens - attachmentTokens);
-
-                cleanReply.outputTokens = usage.value("output_tokens").toInt();
-                // Total tokens should also reflect the subtraction if we want "billable" vs
-                // "context" consistency? The user asked to not count them for CURATION threshold
-                // comparison. ChatModel uses inputTokens + outputTokens to update liveMemoryTokens.
-                // So modifying inputTokens here effectively hides the attachment size from the live
-                // memory.
-
-                cleanReply.totalTokens = cleanReply.inputTokens + cleanReply.outputTokens;
+                // ⚠️ CRITICAL: the tokens coming from the attached files are
+                // subtracted from the reported input_tokens. ChatModel uses
+                // inputTokens + outputTokens to update liveMemoryTokens, so this
+                // hides the attachment size from the live memory.
+                readUsage(responseObj["usage"].toObject(), attachmentTokens, cleanReply);
             }
 
             // qDebug() << "Parsed reply text:" << cleanReply.text;
@@ -284,20 +364,159 @@ void OpenAIInterlocutor::sendActualRequest(const QList<ChatMessage> &history,
 
             cleanReply.kind = kind;
 
+            RequestHandle::recordTimings(reply, cleanReply);
             emit replyReady(cleanReply);
             reply->deleteLater();
         });
+}
+
+// Streaming mode (SSE): the /v1/responses endpoint sends typed events. The
+// text arrives through "response.output_text.delta" events, and the final
+// "response.completed" (or "response.incomplete") event carries the full
+// response object with its status and usage.
+void OpenAIInterlocutor::connectStreamingReply(QNetworkReply *reply,
+                                               const InterlocutorReply::Kind kind,
+                                               int attachmentTokens)
+{
+    // State shared by the readyRead and finished handlers of this reply.
+    struct StreamState
+    {
+        SseParser parser;
+        InterlocutorReply reply;
+        QByteArray errorBody; // Corps d'une réponse HTTP en erreur (JSON, pas SSE)
+        QString streamError;  // Erreur signalée à l'intérieur du flux
+        bool completed = false;
+    };
+    auto state = std::make_shared<StreamState>();
+    state->reply.kind = kind;
+
+    auto handleEvents = [this, state, attachmentTokens](const QList<SseParser::Event> &events)
+    {
+        for (const SseParser::Event &event : events)
+        {
+            const QJsonObject obj = QJsonDocument::fromJson(event.data).object();
+            const QString type = obj.value("type").toString();
 
-    QTimer::singleShot(REQUEST_TIMEOUT_MS, reply,
-                       [this, reply]()
-                       {
-                           if (reply && reply->isRunning())
-                           {
-                               qWarning()
-                                   << "Request timed out after" << REQUEST_TIMEOUT_MS << "ms.";
-                               reply->abort();
-                           }
-                       });
+            if (type == "response.output_text.delta")
+            {
+                const QString delta = obj.value("delta").toString();
+                if (!delta.isEmpty())
+                {
+                    state->reply.text += delta;
+                    emit replyChunk(delta, state->reply.kind);
+                }
+            }
+            else if (type == "response.completed" || type == "response.incomplete")
+            {
+                state->completed = true;
+                const QJsonObject responseObj = obj.value("response").toObject();
+                if (type == "response.incomplete" ||
+                    responseObj.value("status").toString() == "incomplete")
+                {
+                    state->reply.isIncomplete = true;
+                    qDebug() << "Response is incomplete (reason:"
+                             << responseObj.value("incomplete_details")
+                                    .toObject()
+                                    .value("reason")
+                                    .toString()
+                             << ")";
+                }
+                if (responseObj.value("usage").isObject())
+                    readUsage(responseObj.value("usage").toObject(), attachmentTokens,
+                              state->reply);
+            }
+            else if (type == "response.failed" || type == "error")
+            {
+                const QJsonObject error =
+                    (type == "error")
+                        ? obj
+                        : obj.value("response").toObject().value("error").toObject();
+                state->streamError = error.value("message").toString();
+                if (state->streamError.isEmpty())
+                    state->streamError = QString::fromUtf8(event.data);
+            }
+        }
+    };
+
+    connect(reply, &QNetworkReply::readyRead, this,
+            [reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray bytes = reply->readAll();
+                if (statusCode < 200 || statusCode >= 300)
+                {
+                    state->errorBody += bytes;
+                    return;
+                }
+                TraceScope scope("stream.chunk", "interlocutor");
+                handleEvents(state->parser.feed(bytes));
+            });
+
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, state, handleEvents]()
+            {
+                const int statusCode =
+                    reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                const QByteArray rest = reply->readAll();
+
+                if (RequestHandle::wasCancelled(reply))
+                {
+                    // Arrêt demandé : le texte déjà reçu est gardé
+                    emitCancelledReply(state->reply);
+                    reply->deleteLater();
+                    return;
+                }
+
+                if (reply->error() != QNetworkReply::NoError || statusCode < 200 ||
+                    statusCode >= 300)
+                {
+                    state->errorBody += rest;
+                    QString errMessage = QString("API Error %1: %2 | Body: %3")
+                                             .arg(statusCode)
+                                             .arg(reply->errorString())
+                                             .arg(QString::fromUtf8(state->errorBody));
+                    qDebug() << errMessage;
+                    emit errorOccurred(errMessage);
+                    reply->deleteLater();
+                    return;
+                }
+
+                handleEvents(state->parser.feed(rest));
+                handleEvents(state->parser.finish());
+
+                if (!state->streamError.isEmpty())
+                {
+                    emit errorOccurred("OpenAI stream error: " + state->streamError);
+                    reply->deleteLater();
+                    return;
+                }
+                if (!state->completed)
+                {
+                    // Flux interrompu avant l'événement final : on garde le texte
+                    // reçu, mais la réponse est marquée incomplète.
+                    qWarning() << "OpenAI stream ended without a completion event.";
+                    state->reply.isIncomplete = true;
+                }
+
+                qDebug() << "Usage: in=" << state->reply.inputTokens
+                         << "out=" << state->reply.outputTokens
+                         << "tot=" << state->reply.totalTokens;
+
+                RequestHandle::recordTimings(reply, state->reply);
+                emit replyReady(state->reply);
+                reply->deleteLater();
+            });
+}
+
+QUrl OpenAIInterlocutor::apiUrl(const QString &route) const
+{
+    // Racine de l'API : le chemin de l'endpoint sans son dernier segment
+    QUrl url(m_url);
+    const QString path = url.path();
+    url.setPath(path.left(qMax(0, path.lastIndexOf('/'))) + route);
+    url.setQuery(QString());
+    return url;
 }
 
 void OpenAIInterlocutor::checkAttachmentTokens(
@@ -310,7 +529,7 @@ void OpenAIInterlocutor::checkAttachmentTokens(
         return;
     }
 
-    QUrl url("https://api.openai.com/v1/responses/input_tokens");
+    QUrl url = apiUrl("/responses/input_tokens");
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
     request.setRawHeader("Authorization", ("Bearer " + m_apiKey).toUtf8());
@@ -341,7 +560,7 @@ void OpenAIInterlocutor::checkAttachmentTokens(
     QByteArray data = QJsonDocument(payload).toJson(QJsonDocument::Compact);
 
     qDebug() << "Checking attachment token count...";
-    QNetworkReply *reply = m_manager->post(request, data);
+    QNetworkReply *reply = NetworkService::instance().post(request, data, this);
     qDebug() << "Posting token check request:" << data;
 
     connect(reply, &QNetworkReply::finished, this,
@@ -422,14 +641,13 @@ void OpenAIInterlocutor::uploadFile(QString fileName, const QByteArray &content,
     multiPart->append(purposePart);
     multiPart->append(filePart);
 
-    QUrl url("https://api.openai.com/v1/files");
+    QUrl url = apiUrl("/files");
     QNetworkRequest request(url);
     request.setRawHeader("Authorization", ("Bearer " + m_apiKey).toUtf8());
 
     qDebug() << "Post upload user file request:" << multiPart;
 
-    QNetworkReply *reply = m_manager->post(request, multiPart);
-    multiPart->setParent(reply);
+    QNetworkReply *reply = NetworkService::instance().post(request, multiPart, this);
 
     connect(reply, &QNetworkReply::finished, this,
             [this, reply, purpose]()
@@ -476,11 +694,11 @@ void OpenAIInterlocutor::uploadFile(QString fileName, const QByteArray &content,
 
 void OpenAIInterlocutor::deleteFile(const QString &fileId)
 {
-    QUrl url("https://api.openai.com/v1/files/" + fileId);
+    QUrl url = apiUrl("/files/" + fileId);
     QNetworkRequest request(url);
     request.setRawHeader("Authorization", ("Bearer " + m_apiKey).toUtf8());
 
-    QNetworkReply *reply = m_manager->deleteResource(request);
+    QNetworkReply *reply = NetworkService::instance().deleteResource(request, this);
 
     connect(reply, &QNetworkReply::finished, this,
             [this, reply, fileId]()
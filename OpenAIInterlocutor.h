@@ -25,11 +25,12 @@ public:
         const int maxAttachedFileTokenCount,
         QObject *parent);
 
-    void sendRequest(
+    RequestHandle *sendRequest(
         const QList<ChatMessage> &history,
         const QString& ancientMemory,
         const InterlocutorReply::Kind kind,
-        const QStringList &attachmentFileIds) override;;
+        const QStringList &attachmentFileIds,
+        const QString &recall = QString()) override;
 
     // Les signaux ci-dessous sont hérités de la classe mère `Interlocutor`
     // signals:
@@ -43,15 +44,22 @@ private:
     QString m_apiKey;
     QString m_model;
     int m_maxAttachedFileTokenCount;
-    QNetworkAccessManager *m_manager;
     const int REQUEST_TIMEOUT_MS = 360000;
     QMap<QNetworkReply *, QTimer *> m_requestTimers;
 
+    // Another route of the API the configured endpoint belongs to: for
+    // ".../v1/responses", apiUrl("/files") is ".../v1/files". The token count
+    // and file routes thus follow models.ini (proxy, compatible server, mock).
+    QUrl apiUrl(const QString &route) const;
     void checkAttachmentTokens(const QStringList &fileIds, std::function<void(bool success, int tokenCount, const QString &errorMsg)> callback);
     void sendActualRequest(const QList<ChatMessage> &history,
                            const QString &ancientMemory,
                            const InterlocutorReply::Kind kind,
                            const QStringList &attachmentFileIds,
-                           int attachmentTokens);
+                           int attachmentTokens,
+                           const QString &recall,
+                           RequestHandle *handle);
+    void connectStreamingReply(QNetworkReply *reply, const InterlocutorReply::Kind kind,
+                               int attachmentTokens);
 };
 // End source file OpenAIInterlocutor.h
@@ -0,0 +1,133 @@
+// Begin Source File RequestHandle.cpp
+#include "RequestHandle.h"
+
+#include <QDebug>
+
+#include "Tracer.h"
+
+namespace
+{
+// Propriété posée sur la réponse avant l'abort : l'annulation se distingue
+// ainsi du délai dépassé, qui finit lui aussi en OperationCanceledError.
+const char *const kCancelledProperty = "tetherCancelled";
+// Le handle d'une réponse, pour recordTimings()
+const char *const kHandleProperty = "tetherRequestHandle";
+} // namespace
+
+RequestHandle::RequestHandle(InterlocutorReply::Kind kind, QObject *parent)
+    : QObject(parent)
+    , m_kind(kind)
+{
+    m_clock.start();
+    if (Tracer::instance().isEnabled())
+        m_startNs = Tracer::instance().nowNs();
+    m_ticker.setInterval(1000);
+    connect(&m_ticker, &QTimer::timeout, this, [this]() { emit elapsed(m_clock.elapsed()); });
+    m_ticker.start();
+    m_timeout.setSingleShot(true);
+}
+
+RequestHandle::~RequestHandle()
+{
+    // La réponse peut survivre au handle : elle ne doit plus le désigner.
+    if (m_reply)
+        m_reply->setProperty(kHandleProperty, QVariant());
+}
+
+void RequestHandle::attach(QNetworkReply *reply, int timeoutMs)
+{
+    m_reply = reply;
+    m_sentMs = m_clock.elapsed();
+    reply->setProperty(kHandleProperty, QVariant::fromValue<QObject *>(this));
+    connect(reply, &QNetworkReply::readyRead, this,
+            [this]()
+            {
+                if (m_firstByteMs >= 0)
+                    return;
+                m_firstByteMs = m_clock.elapsed();
+                if (m_startNs >= 0)
+                    Tracer::instance().complete("network.firstByte", "network",
+                                                m_startNs + m_sentMs * 1000000,
+                                                (m_firstByteMs - m_sentMs) * 1000000);
+            });
+    connect(reply, &QNetworkReply::downloadProgress, this,
+            [this](qint64 received, qint64)
+            {
+                m_receivedBytes = received;
+                emit progress(received);
+            });
+    // En file : les gestionnaires de l'interlocuteur ont émis la réponse
+    // (ou l'erreur) avant que la requête ne soit dite finie.
+    connect(reply, &QNetworkReply::finished, this, &RequestHandle::finish, Qt::QueuedConnection);
+    if (m_cancelled)
+    {
+        // Annulée avant que la requête ne parte (préparation asynchrone)
+        reply->setProperty(kCancelledProperty, true);
+        reply->abort();
+        return;
+    }
+    if (timeoutMs > 0)
+    {
+        connect(&m_timeout, &QTimer::timeout, this,
+                [this, timeoutMs]()
+                {
+                    if (m_reply && m_reply->isRunning())
+                    {
+                        qWarning() << "Request timed out after" << timeoutMs << "ms.";
+                        m_reply->abort();
+                    }
+                });
+        m_timeout.start(timeoutMs);
+    }
+}
+
+void RequestHandle::cancel()
+{
+    if (m_cancelled || m_finished)
+        return;
+    m_cancelled = true;
+    qDebug() << "Request cancelled after" << m_clock.elapsed() << "ms.";
+    emit cancelled();
+    if (m_reply && m_reply->isRunning())
+    {
+        m_reply->setProperty(kCancelledProperty, true);
+        m_reply->abort();
+    }
+}
+
+void RequestHandle::finish()
+{
+    if (m_finished)
+        return;
+    m_finished = true;
+    m_ticker.stop();
+    m_timeout.stop();
+    if (m_startNs >= 0)
+    {
+        // Aller-retour complet, préparation comprise
+        Tracer &tracer = Tracer::instance();
+        tracer.complete(m_kind == InterlocutorReply::Kind::CurationResult ? "curation.roundTrip"
+                                                                          : "network.request",
+                        "network", m_startNs, tracer.nowNs() - m_startNs);
+    }
+    emit finished();
+    deleteLater();
+}
+
+bool RequestHandle::wasCancelled(const QNetworkReply *reply)
+{
+    return reply->property(kCancelledProperty).toBool();
+}
+
+void RequestHandle::recordTimings(const QNetworkReply *reply, InterlocutorReply &out)
+{
+    const auto *handle =
+        qobject_cast<const RequestHandle *>(reply->property(kHandleProperty).value<QObject *>());
+    if (!handle)
+        return;
+    out.totalMs = handle->m_clock.elapsed();
+    out.sentMs = handle->m_sentMs;
+    out.firstByteMs = handle->m_firstByteMs >= 0 ? handle->m_firstByteMs : out.totalMs;
+    out.streamed = reply->rawHeader("Content-Type").startsWith("text/event-stream");
+}
+// End Source File RequestHandle.cpp
@@ -0,0 +1,83 @@
+// Begin Source File RequestHandle.h
+#ifndef REQUESTHANDLE_H
+#define REQUESTHANDLE_H
+
+#include <QElapsedTimer>
+#include <QNetworkReply>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include "InterlocutorReply.h"
+
+// One request of an Interlocutor, from sendRequest() to its replyReady() or
+// errorOccurred().
+//
+// It follows the network reply of the request: bytes received (progress()),
+// time since sendRequest() (elapsed(), every second), and the provider's
+// timeout, which used to be a QTimer::singleShot per request. cancel() aborts
+// the reply. The interlocutor then emits, instead of an error, a replyReady()
+// marked wasCancelled and isIncomplete, holding the text streamed so far and
+// the usage known or estimated; a request cancelled before any text came
+// ends with an empty cancelled reply.
+//
+// The handle also times the request — sent, first byte, end — for the
+// Tracer ("network.firstByte", and "network.request" or
+// "curation.roundTrip") and for the reply itself (recordTimings()).
+//
+// Owned by the interlocutor and deleted once the request has ended
+// (finished()): keep it in a QPointer.
+class RequestHandle : public QObject
+{
+    Q_OBJECT
+
+public:
+    RequestHandle(InterlocutorReply::Kind kind, QObject *parent);
+    ~RequestHandle() override;
+
+    InterlocutorReply::Kind kind() const { return m_kind; }
+    bool isCancelled() const { return m_cancelled; }
+    qint64 elapsedMs() const { return m_clock.elapsed(); }
+    qint64 receivedBytes() const { return m_receivedBytes; }
+
+    // Interlocutor side: the reply carrying the request, aborted after
+    // `timeoutMs` if set. The handle ends after the reply's own finished()
+    // handlers have run.
+    void attach(QNetworkReply *reply, int timeoutMs = 0);
+
+    // Ends a request that has no reply (failed before sending, simulated).
+    void finish();
+
+    // Whether `reply` was aborted by cancel() (rather than by a timeout or
+    // a network error): to be checked in the error path of its handlers.
+    static bool wasCancelled(const QNetworkReply *reply);
+
+    // Copies the timings of the request carried by `reply` into `out`: to be
+    // called by the reply's handlers just before emitting replyReady().
+    static void recordTimings(const QNetworkReply *reply, InterlocutorReply &out);
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(qint64 receivedBytes);
+    void elapsed(qint64 elapsedMs);
+    void cancelled();
+    void finished();
+
+private:
+    const InterlocutorReply::Kind m_kind;
+    QPointer<QNetworkReply> m_reply;
+    QElapsedTimer m_clock;
+    qint64 m_startNs = -1;     // Horloge du Tracer à la création (-1 : pas de traçage)
+    qint64 m_sentMs = -1;      // attach()
+    qint64 m_firstByteMs = -1; // Premier readyRead de la réponse
+    QTimer m_ticker;
+    QTimer m_timeout;
+    qint64 m_receivedBytes = 0;
+    bool m_cancelled = false;
+    bool m_finished = false;
+};
+
+#endif // REQUESTHANDLE_H
+// End Source File RequestHandle.h
@@ -0,0 +1,214 @@
+// Begin Source File RequestScheduler.cpp
+#include "RequestScheduler.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QSet>
+#include <QSettings>
+#include <QUrlQuery>
+
+namespace
+{
+const double kMsPerMinute = 60000.0;
+
+// Part des seaux que seules les requêtes interactives peuvent entamer
+double reserveFor(RequestScheduler::Priority priority)
+{
+    switch (priority)
+    {
+    case RequestScheduler::Priority::Interactive:
+        return 0;
+    case RequestScheduler::Priority::Duo:
+        return 0.10;
+    case RequestScheduler::Priority::Background:
+        return 0.25;
+    }
+    return 0;
+}
+} // namespace
+
+void RequestScheduler::Bucket::refill(qint64 now)
+{
+    if (capacity > 0)
+        level = qMin(capacity, level + (now - refilledAt) * capacity / kMsPerMinute);
+    refilledAt = now;
+}
+
+void RequestScheduler::Bucket::resize(double newCapacity, qint64 now)
+{
+    refill(now);
+    // Premier réglage : seau plein. Ensuite, le niveau garde sa proportion.
+    level = capacity > 0 ? level * newCapacity / capacity : newCapacity;
+    capacity = newCapacity;
+}
+
+qint64 RequestScheduler::Bucket::msUntil(double amount, double reserve) const
+{
+    if (capacity <= 0)
+        return 0;
+    // Une requête plus grosse que le seau passe quand il est plein
+    const double needed = qMin(amount, capacity * (1 - reserve)) + capacity * reserve;
+    if (level >= needed)
+        return 0;
+    return qint64((needed - level) * kMsPerMinute / capacity) + 1;
+}
+
+RequestScheduler::RequestScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &RequestScheduler::dispatch);
+}
+
+QByteArray RequestScheduler::accountOf(const QNetworkRequest &request)
+{
+    QByteArray secret = request.rawHeader("x-api-key");
+    if (secret.isEmpty())
+        secret = request.rawHeader("Authorization");
+    if (secret.isEmpty())
+        secret = QUrlQuery(request.url()).queryItemValue("key").toUtf8();
+    if (secret.isEmpty())
+        return request.url().host().toUtf8();
+    // La clé elle-même ne reste pas en mémoire ni dans les journaux
+    return QCryptographicHash::hash(secret, QCryptographicHash::Sha256).toHex().left(16);
+}
+
+qint64 RequestScheduler::costOf(qint64 bodyBytes)
+{
+    // Corps JSON : ~4 octets par token, balisage compris. La sortie n'est pas
+    // connue d'avance ; les limites des fournisseurs portent surtout sur
+    // l'entrée.
+    return qMax<qint64>(1, bodyBytes / 4);
+}
+
+RequestScheduler::Account &RequestScheduler::account(const QByteArray &key)
+{
+    auto it = m_accounts.find(key);
+    if (it == m_accounts.end())
+    {
+        // Limites par défaut tant que le fournisseur ne les a pas données
+        QSettings settings("Tether", "ChatApp");
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        it = m_accounts.insert(key, Account());
+        it->requests.resize(qMax(0, settings.value("scheduler/requestsPerMinute", 0).toInt()),
+                            now);
+        it->tokens.resize(qMax(0, settings.value("scheduler/tokensPerMinute", 0).toInt()), now);
+    }
+    return *it;
+}
+
+void RequestScheduler::submit(const QByteArray &accountKey, Priority priority, qint64 tokens,
+                              QNetworkReply *reply, std::function<void()> start)
+{
+    qsizetype position = m_queue.size();
+    while (position > 0 && m_queue.at(position - 1).priority > priority)
+        --position;
+    m_queue.insert(position, {accountKey, priority, tokens, reply, std::move(start)});
+    // Abandonnée en attente : elle sort de la file
+    connect(reply, &QNetworkReply::finished, this, &RequestScheduler::dispatch,
+            Qt::QueuedConnection);
+    connect(reply, &QObject::destroyed, this, &RequestScheduler::dispatch, Qt::QueuedConnection);
+    dispatch();
+}
+
+void RequestScheduler::charge(const QByteArray &accountKey, qint64 tokens)
+{
+    Account &charged = account(accountKey);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    charged.requests.refill(now);
+    charged.tokens.refill(now);
+    // Le niveau peut devenir négatif (nouvel essai) : c'est une dette
+    if (charged.requests.capacity > 0)
+        charged.requests.level -= 1;
+    if (charged.tokens.capacity > 0)
+        charged.tokens.level -= tokens;
+}
+
+void RequestScheduler::learnLimits(const QByteArray &accountKey, qint64 requestsPerMinute,
+                                   qint64 tokensPerMinute)
+{
+    Account &learned = account(accountKey);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    bool changed = false;
+    if (requestsPerMinute > 0 && requestsPerMinute != qint64(learned.requests.capacity))
+    {
+        learned.requests.resize(requestsPerMinute, now);
+        changed = true;
+    }
+    if (tokensPerMinute > 0 && tokensPerMinute != qint64(learned.tokens.capacity))
+    {
+        learned.tokens.resize(tokensPerMinute, now);
+        changed = true;
+    }
+    if (changed)
+    {
+        qDebug() << "Scheduler: limits of account" << accountKey << ":"
+                 << learned.requests.capacity << "requests/min," << learned.tokens.capacity
+                 << "tokens/min.";
+        dispatch();
+    }
+}
+
+int RequestScheduler::backgroundQueueDepth() const
+{
+    int count = 0;
+    for (const Pending &pending : m_queue)
+    {
+        if (pending.priority != Priority::Interactive)
+            ++count;
+    }
+    return count;
+}
+
+void RequestScheduler::dispatch()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 nextCheck = -1;
+    // Un compte dont la première requête attend bloque les suivantes : une
+    // requête de fond ne passe pas devant une interactive.
+    QSet<QByteArray> blocked;
+
+    for (qsizetype i = 0; i < m_queue.size();)
+    {
+        Pending &pending = m_queue[i];
+        if (!pending.reply || pending.reply->isFinished())
+        {
+            m_queue.removeAt(i);
+            continue;
+        }
+        if (blocked.contains(pending.account))
+        {
+            ++i;
+            continue;
+        }
+        Account &admitting = account(pending.account);
+        admitting.requests.refill(now);
+        admitting.tokens.refill(now);
+        const double reserve = reserveFor(pending.priority);
+        const qint64 wait = qMax(admitting.requests.msUntil(1, reserve),
+                                 admitting.tokens.msUntil(pending.tokens, reserve));
+        if (wait > 0)
+        {
+            blocked.insert(pending.account);
+            nextCheck = nextCheck < 0 ? wait : qMin(nextCheck, wait);
+            ++i;
+            continue;
+        }
+        const std::function<void()> start = std::move(pending.start);
+        charge(pending.account, pending.tokens);
+        m_queue.removeAt(i);
+        start();
+    }
+
+    if (nextCheck >= 0)
+        m_timer.start(int(qMin<qint64>(nextCheck, 60000)));
+    else
+        m_timer.stop();
+    if (m_queue.size() != m_reportedDepth)
+    {
+        m_reportedDepth = m_queue.size();
+        emit queueDepthChanged();
+    }
+}
+// End Source File RequestScheduler.cpp
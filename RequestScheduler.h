@@ -0,0 +1,113 @@
+// Begin Source File RequestScheduler.h
+#ifndef REQUESTSCHEDULER_H
+#define REQUESTSCHEDULER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
+
+// Admission of the requests to the providers, shared by everything that talks
+// to them.
+//
+// The solo chat, both sides of a duo and every curation used to send their
+// requests independently: a curation and a duo turn could hit the same API key
+// at once and trip its limits, and the user's message then waited behind a
+// 429. Every request now goes through this queue, with a priority:
+//   Interactive  the user's own chat (and file uploads);
+//   Duo          the turns of an AI <-> AI conversation;
+//   Background   curations, rollups, prepared summaries.
+//
+// Each API key has two token buckets, requests per minute and tokens per
+// minute, refilled continuously. Their sizes are learned from the rate-limit
+// headers of the provider (anthropic-ratelimit-*-limit, x-ratelimit-limit-*),
+// or taken from the "scheduler/*" settings until then; a key with no known
+// limit is not throttled. A request is admitted when the buckets of its key
+// hold its cost, after every queued request of higher priority for that key:
+// a user's message jumps ahead of queued duo turns and curations. Duo and
+// background requests must moreover leave a reserve in the buckets (10% and
+// 25%), kept for the interactive ones: background work soaks up the spare
+// quota, and the user's next message still finds some.
+//
+// The cost of a request in tokens is estimated from the size of its body. It is
+// charged on admission, and again for every retry (see RetryingReply). GUI
+// thread only.
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int queueDepth READ queueDepth NOTIFY queueDepthChanged)
+    Q_PROPERTY(int backgroundQueueDepth READ backgroundQueueDepth NOTIFY queueDepthChanged)
+
+public:
+    enum class Priority { Interactive, Duo, Background };
+
+    explicit RequestScheduler(QObject *parent = nullptr);
+
+    // Bucket key of a request: a hash of its API key (x-api-key,
+    // Authorization or "key" query item), else its host.
+    static QByteArray accountOf(const QNetworkRequest &request);
+
+    // Estimated cost of a request body, in tokens.
+    static qint64 costOf(qint64 bodyBytes);
+
+    // Queues `reply`; `start` runs when it is admitted (maybe at once). A
+    // reply finished or destroyed meanwhile leaves the queue.
+    void submit(const QByteArray &account, Priority priority, qint64 tokens,
+                QNetworkReply *reply, std::function<void()> start);
+
+    // Takes a request of `tokens` from the buckets (a retry sent).
+    void charge(const QByteArray &account, qint64 tokens);
+
+    // Per-minute limits read from a response; 0 leaves a limit unchanged.
+    void learnLimits(const QByteArray &account, qint64 requestsPerMinute,
+                     qint64 tokensPerMinute);
+
+    int queueDepth() const { return m_queue.size(); }
+    int backgroundQueueDepth() const;
+
+signals:
+    void queueDepthChanged();
+
+private:
+    struct Bucket
+    {
+        double capacity = 0; // Par minute ; 0 = pas de limite connue
+        double level = 0;
+        qint64 refilledAt = 0;
+
+        void refill(qint64 now);
+        void resize(double newCapacity, qint64 now);
+        // Délai avant de contenir `amount` en laissant `reserve` (fraction)
+        qint64 msUntil(double amount, double reserve) const;
+    };
+    struct Account
+    {
+        Bucket requests;
+        Bucket tokens;
+    };
+    struct Pending
+    {
+        QByteArray account;
+        Priority priority = Priority::Interactive;
+        qint64 tokens = 0;
+        QPointer<QNetworkReply> reply;
+        std::function<void()> start;
+    };
+
+    Account &account(const QByteArray &key);
+    void dispatch();
+
+    QHash<QByteArray, Account> m_accounts;
+    QList<Pending> m_queue; // Par priorité, puis par ordre d'arrivée
+    int m_reportedDepth = 0;
+    QTimer m_timer;
+};
+
+#endif // REQUESTSCHEDULER_H
+// End Source File RequestScheduler.h
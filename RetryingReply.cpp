@@ -0,0 +1,150 @@
+// Begin Source File RetryingReply.cpp
+#include "RetryingReply.h"
+
+#include <QDebug>
+
+RetryingReply::RetryingReply(const QNetworkRequest &request,
+                             QNetworkAccessManager::Operation operation, Sender send,
+                             const NetworkService::RetryPolicy &policy, QObject *parent)
+    : QNetworkReply(parent)
+    , m_send(std::move(send))
+    , m_policy(policy)
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(operation);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &RetryingReply::sendAttempt);
+}
+
+void RetryingReply::start(qint64 delayMs)
+{
+    if (delayMs > 0)
+    {
+        qDebug() << "Network: request to" << url().host() << "paced, starting in" << delayMs
+                 << "ms.";
+        m_retryTimer.start(int(delayMs));
+    }
+    else
+    {
+        sendAttempt();
+    }
+}
+
+void RetryingReply::sendAttempt()
+{
+    if (isFinished())
+        return;
+    m_attempt = m_send();
+    m_attempt->setParent(this);
+    connect(m_attempt, &QNetworkReply::readyRead, this, &RetryingReply::onAttemptReadyRead);
+    connect(m_attempt, &QNetworkReply::finished, this, &RetryingReply::onAttemptFinished);
+}
+
+void RetryingReply::onAttemptReadyRead()
+{
+    if (!m_committed)
+    {
+        // Un statut à réessayer : on garde le corps (le message d'erreur)
+        // pour le cas où ce serait le dernier essai.
+        const int statusCode =
+            m_attempt->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (NetworkService::isRetryable(statusCode, QNetworkReply::NoError) &&
+            m_retries < m_policy.maxRetries)
+            return;
+        commit();
+    }
+    emit readyRead();
+}
+
+void RetryingReply::onAttemptFinished()
+{
+    if (!m_committed)
+    {
+        const qint64 delay = NetworkService::instance().retryDelay(m_attempt, m_retries, m_policy);
+        if (delay >= 0)
+        {
+            ++m_retries;
+            qWarning().noquote()
+                << QString("Network: %1 failed (%2 %3), retry %4/%5 in %6 ms.")
+                       .arg(url().host())
+                       .arg(m_attempt->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt())
+                       .arg(m_attempt->errorString())
+                       .arg(m_retries)
+                       .arg(m_policy.maxRetries)
+                       .arg(delay);
+            m_attempt->deleteLater();
+            m_attempt = nullptr;
+            m_retryTimer.start(int(delay));
+            return;
+        }
+        commit();
+        if (m_attempt->bytesAvailable() > 0)
+            emit readyRead();
+    }
+    if (m_attempt->error() != QNetworkReply::NoError)
+    {
+        setError(m_attempt->error(), m_attempt->errorString());
+        emit errorOccurred(m_attempt->error());
+    }
+    finish();
+}
+
+void RetryingReply::commit()
+{
+    // L'essai retenu devient la réponse : statut et en-têtes recopiés
+    m_committed = true;
+    for (const QNetworkRequest::Attribute attribute :
+         {QNetworkRequest::HttpStatusCodeAttribute, QNetworkRequest::HttpReasonPhraseAttribute,
+          QNetworkRequest::Http2WasUsedAttribute, QNetworkRequest::RedirectionTargetAttribute})
+    {
+        const QVariant value = m_attempt->attribute(attribute);
+        if (value.isValid())
+            setAttribute(attribute, value);
+    }
+    for (const QNetworkReply::RawHeaderPair &header : m_attempt->rawHeaderPairs())
+        setRawHeader(header.first, header.second);
+    emit metaDataChanged();
+    connect(m_attempt, &QNetworkReply::downloadProgress, this, &QNetworkReply::downloadProgress);
+}
+
+void RetryingReply::finish()
+{
+    setFinished(true);
+    emit finished();
+}
+
+void RetryingReply::abort()
+{
+    if (isFinished())
+        return;
+    m_retryTimer.stop();
+    if (m_attempt)
+    {
+        // Sans quoi l'abandon de l'essai passerait pour un échec à réessayer
+        disconnect(m_attempt, nullptr, this, nullptr);
+        m_attempt->abort();
+    }
+    setError(QNetworkReply::OperationCanceledError, tr("Operation canceled"));
+    emit errorOccurred(QNetworkReply::OperationCanceledError);
+    finish();
+}
+
+qint64 RetryingReply::bytesAvailable() const
+{
+    const qint64 pending = m_committed && m_attempt ? m_attempt->bytesAvailable() : 0;
+    return QNetworkReply::bytesAvailable() + pending;
+}
+
+qint64 RetryingReply::readData(char *data, qint64 maxSize)
+{
+    if (!m_committed || !m_attempt)
+        return isFinished() ? -1 : 0;
+    const qint64 read = m_attempt->read(data, maxSize);
+    if (read <= 0 && isFinished())
+        return -1;
+    return qMax<qint64>(read, 0);
+}
+// End Source File RetryingReply.cpp
@@ -0,0 +1,63 @@
+// Begin Source File RetryingReply.h
+#ifndef RETRYINGREPLY_H
+#define RETRYINGREPLY_H
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
+
+#include "NetworkService.h"
+
+// The reply NetworkService hands to the interlocutors: one request, however
+// many attempts it takes.
+//
+// Each attempt is a real reply from the host's manager (`send`). As long as
+// nothing of an attempt has been passed on, a failure that deserves another
+// try (429, 5xx, connection lost: NetworkService::retryDelay) is kept from
+// the caller: the attempt is dropped and a new one starts after the delay.
+// The first attempt that delivers data — or that fails for good — is
+// "committed": its status, headers and body go through this reply, and its
+// end is this reply's end. A stream is therefore never replayed to the
+// caller, and the interlocutors' code sees one ordinary reply.
+//
+// abort() stops everything, the waits included.
+class RetryingReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    using Sender = std::function<QNetworkReply *()>;
+
+    RetryingReply(const QNetworkRequest &request, QNetworkAccessManager::Operation operation,
+                  Sender send, const NetworkService::RetryPolicy &policy, QObject *parent);
+
+    // First attempt after `delayMs` (host paced by NetworkService).
+    void start(qint64 delayMs);
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+private:
+    void sendAttempt();
+    void onAttemptReadyRead();
+    void onAttemptFinished();
+    void commit();
+    void finish();
+
+    const Sender m_send;
+    const NetworkService::RetryPolicy m_policy;
+    QPointer<QNetworkReply> m_attempt;
+    QTimer m_retryTimer;
+    int m_retries = 0;
+    bool m_committed = false;
+};
+
+#endif // RETRYINGREPLY_H
+// End Source File RetryingReply.h
@@ -0,0 +1,74 @@
+// Begin source file SseParser.cpp
+#include "SseParser.h"
+
+QList<SseParser::Event> SseParser::feed(const QByteArray &bytes)
+{
+    QList<Event> events;
+    m_buffer.append(bytes);
+
+    qsizetype start = 0;
+    while (true)
+    {
+        const qsizetype newline = m_buffer.indexOf('\n', start);
+        if (newline < 0)
+            break;
+        qsizetype end = newline;
+        if (end > start && m_buffer.at(end - 1) == '\r')
+            --end;
+        processLine(QByteArrayView(m_buffer.constData() + start, end - start), events);
+        start = newline + 1;
+    }
+    m_buffer.remove(0, start);
+    return events;
+}
+
+QList<SseParser::Event> SseParser::finish()
+{
+    QList<Event> events;
+    if (!m_buffer.isEmpty())
+    {
+        processLine(QByteArrayView(m_buffer), events);
+        m_buffer.clear();
+    }
+    dispatch(events);
+    return events;
+}
+
+void SseParser::processLine(QByteArrayView line, QList<Event> &events)
+{
+    if (line.isEmpty())
+    {
+        dispatch(events); // Une ligne vide termine l'événement en cours
+        return;
+    }
+    if (line.startsWith(':'))
+        return; // Commentaire (keep-alive)
+
+    const qsizetype colon = line.indexOf(':');
+    const QByteArrayView field = (colon < 0) ? line : line.first(colon);
+    QByteArrayView value = (colon < 0) ? QByteArrayView() : line.sliced(colon + 1);
+    if (value.startsWith(' '))
+        value = value.sliced(1);
+
+    if (field == QByteArrayView("event"))
+    {
+        m_eventName = value.toByteArray();
+    }
+    else if (field == QByteArrayView("data"))
+    {
+        if (m_hasData)
+            m_data.append('\n');
+        m_data.append(value);
+        m_hasData = true;
+    }
+}
+
+void SseParser::dispatch(QList<Event> &events)
+{
+    if (m_hasData)
+        events.append(Event{m_eventName, m_data});
+    m_eventName.clear();
+    m_data.clear();
+    m_hasData = false;
+}
+// End source file SseParser.cpp
@@ -0,0 +1,42 @@
+// Begin source file SseParser.h
+#ifndef SSEPARSER_H
+#define SSEPARSER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+
+// Incremental parser for "text/event-stream" (server-sent events) bodies.
+//
+// The streaming mode of the interlocutors feeds it the bytes of every
+// QNetworkReply::readyRead as they arrive: partial lines are buffered until
+// the next chunk, and every event completed by the new bytes is returned.
+// Only the "event" and "data" fields are kept (multi-line data is joined with
+// '\n', as the SSE specification requires); comments such as ": keep-alive"
+// and the other fields are ignored.
+class SseParser
+{
+public:
+    struct Event
+    {
+        QByteArray name; // Empty when the server sent no "event:" line
+        QByteArray data;
+    };
+
+    QList<Event> feed(const QByteArray &bytes);
+
+    // End of body: flushes a last line / event not terminated by a blank line.
+    QList<Event> finish();
+
+private:
+    void processLine(QByteArrayView line, QList<Event> &events);
+    void dispatch(QList<Event> &events);
+
+    QByteArray m_buffer; // Bytes of the current, still incomplete line
+    QByteArray m_eventName;
+    QByteArray m_data;
+    bool m_hasData = false;
+};
+
+#endif // SSEPARSER_H
+// End source file SseParser.h
@@ -2,14 +2,11 @@
 #include "TetherLogger.h"
 
 #include <QDateTime>
-#include <QDir>
-#include <QFile>
-#include <QMutex>
-#include <QMutexLocker>
 #include <QStandardPaths>
-#include <QTextStream>
 #include <QSettings>
 
+#include "IoWorker.h"
+
 // ---------------------------------------------------------------------------
 // Log format
 //
@@ -22,18 +19,15 @@
 // A separator line (─ ×78) follows every entry for easy visual scanning.
 // ---------------------------------------------------------------------------
 
-static QMutex s_mutex;
 static const QString SEPARATOR =
     QString(u'\u2500').repeated(78); // ──────── (78 × U+2500 BOX DRAWINGS LIGHT HORIZONTAL)
 
-// Returns the absolute path to Tether.log, creating the parent directory
-// if it does not yet exist.
+// Returns the absolute path to Tether.log (the IoWorker creates the parent
+// directory if it does not yet exist).
 static QString logFilePath()
 {
-    const QString dir =
-        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/TetherChats";
-    QDir().mkpath(dir);
-    return dir + "/Tether.log";
+    return QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+           "/TetherChats/Tether.log";
 }
 
 #include <QJsonDocument>
@@ -46,22 +40,12 @@ void TetherLogger::logMessage(const QString &interlocutorName, const ChatMessage
         return;
     }
 
-    QMutexLocker locker(&s_mutex);
-
-    QFile file(logFilePath());
-    if (!file.open(QIODevice::Append | QIODevice::Text))
-    {
-        return;
-    }
-
     QJsonObject obj = message.toJsonObject();
     obj["interlocutor"] = interlocutorName;
     obj["type"] = "dialogue";
 
-    QTextStream out(&file);
-    out.setEncoding(QStringConverter::Utf8);
-    out << QJsonDocument(obj).toJson(QJsonDocument::Compact) << "\n";
-    file.close();
+    IoWorker::instance().appendToFile(logFilePath(),
+                                      QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n");
 }
 
 void TetherLogger::logCuration(const QString &interlocutorName, const QString &ancientMemory)
@@ -71,23 +55,13 @@ void TetherLogger::logCuration(const QString &interlocutorName, const QString &a
         return;
     }
 
-    QMutexLocker locker(&s_mutex);
-
-    QFile file(logFilePath());
-    if (!file.open(QIODevice::Append | QIODevice::Text))
-    {
-        return;
-    }
-
     QJsonObject obj;
     obj["interlocutor"] = interlocutorName;
     obj["type"] = "curation";
     obj["content"] = ancientMemory;
     obj["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
 
-    QTextStream out(&file);
-    out.setEncoding(QStringConverter::Utf8);
-    out << QJsonDocument(obj).toJson(QJsonDocument::Compact) << "\n";
-    file.close();
+    IoWorker::instance().appendToFile(logFilePath(),
+                                      QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n");
 }
 // End source file TetherLogger.cpp
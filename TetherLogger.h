@@ -15,7 +15,8 @@
 //   {"model":"gpt-4o", ...}
 //   ─────────────────────────────────────────────────────────────
 //
-// Thread-safe: a static QMutex protects the file writes.
+// Thread-safe: entries are handed to the IoWorker, which keeps Tether.log
+// open and writes them in order off the GUI thread.
 
 #include "ChatMessage.h"
 
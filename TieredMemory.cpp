@@ -0,0 +1,233 @@
+// Begin Source File TieredMemory.cpp
+#include "TieredMemory.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+
+namespace
+{
+const int kFormatVersion = 1;
+
+QJsonArray entriesToJson(const QList<TieredMemory::Entry> &entries)
+{
+    QJsonArray array;
+    for (const TieredMemory::Entry &entry : entries)
+    {
+        QJsonObject object;
+        object["text"] = entry.text;
+        object["from"] = entry.from.toMSecsSinceEpoch();
+        object["to"] = entry.to.toMSecsSinceEpoch();
+        object["tokens"] = entry.tokens;
+        array.append(object);
+    }
+    return array;
+}
+
+QList<TieredMemory::Entry> entriesFromJson(const QJsonArray &array)
+{
+    QList<TieredMemory::Entry> entries;
+    entries.reserve(array.size());
+    for (const QJsonValue &value : array)
+    {
+        const QJsonObject object = value.toObject();
+        TieredMemory::Entry entry;
+        entry.text = object.value("text").toString();
+        if (entry.text.isEmpty())
+            continue;
+        entry.from = QDateTime::fromMSecsSinceEpoch(qint64(object.value("from").toDouble()));
+        entry.to = QDateTime::fromMSecsSinceEpoch(qint64(object.value("to").toDouble()));
+        entry.tokens = object.value("tokens").toInt(-1);
+        if (entry.tokens < 0)
+            entry.tokens = Tokenizer::approximate()->countTokens(entry.text);
+        entries.append(entry);
+    }
+    return entries;
+}
+
+qint64 totalTokens(const QList<TieredMemory::Entry> &entries)
+{
+    qint64 total = 0;
+    for (const TieredMemory::Entry &entry : entries)
+        total += entry.tokens;
+    return total;
+}
+
+// Les plus anciennes entrées à fusionner pour revenir sous la moitié de la
+// limite : la fusion suivante n'arrive pas dès la curation d'après.
+QList<TieredMemory::Entry> oldestOverflow(const QList<TieredMemory::Entry> &entries, int limit)
+{
+    qint64 remaining = totalTokens(entries);
+    if (remaining <= limit)
+        return {};
+    qsizetype count = 0;
+    while (count < entries.size() && remaining > limit / 2)
+        remaining -= entries.at(count++).tokens;
+    // Une seule entrée ne se "fusionne" pas, sauf si c'est la seule
+    if (count < 2 && entries.size() >= 2)
+        count = 2;
+    return entries.first(count);
+}
+
+bool startsWith(const QList<TieredMemory::Entry> &entries,
+                const QList<TieredMemory::Entry> &prefix)
+{
+    if (prefix.size() > entries.size())
+        return false;
+    for (qsizetype i = 0; i < prefix.size(); ++i)
+    {
+        if (entries.at(i).text != prefix.at(i).text || entries.at(i).from != prefix.at(i).from)
+            return false;
+    }
+    return true;
+}
+
+QString period(const TieredMemory::Entry &entry)
+{
+    const QString from = entry.from.toString("yyyy-MM-dd");
+    const QString to = entry.to.toString("yyyy-MM-dd");
+    return from == to ? from : from + " to " + to;
+}
+} // namespace
+
+TieredMemory::Limits TieredMemory::Limits::fromSettings()
+{
+    QSettings settings("Tether", "ChatApp");
+    Limits limits;
+    limits.episodeTokens = qMax(500, settings.value("memory/episodeTokens", 4000).toInt());
+    limits.eraTokens = qMax(500, settings.value("memory/eraTokens", 4000).toInt());
+    limits.coreTokens = qMax(200, settings.value("memory/coreTokens", 1500).toInt());
+    limits.requestTokens = qMax(0, settings.value("memory/requestTokens", 8000).toInt());
+    return limits;
+}
+
+TieredMemory TieredMemory::fromJson(const QByteArray &json)
+{
+    TieredMemory memory;
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+    if (!document.isObject())
+    {
+        qWarning() << "Unreadable memory file:" << error.errorString();
+        return memory;
+    }
+    const QJsonObject root = document.object();
+    if (root.value("version").toInt() > kFormatVersion)
+        qWarning() << "Memory file written by a newer version of Tether; unknown fields ignored.";
+
+    const QJsonObject core = root.value("core").toObject();
+    memory.m_core = core.value("text").toString();
+    memory.m_coreTokens = core.value("tokens").toInt(-1);
+    if (memory.m_coreTokens < 0)
+        memory.m_coreTokens = Tokenizer::approximate()->countTokens(memory.m_core);
+    memory.m_eras = entriesFromJson(root.value("eras").toArray());
+    memory.m_episodes = entriesFromJson(root.value("episodes").toArray());
+    return memory;
+}
+
+TieredMemory TieredMemory::fromLegacyText(const QString &text)
+{
+    // L'ancien résumé monolithique devient le noyau : rien n'est perdu, et la
+    // première curation ne fait qu'y ajouter un épisode.
+    TieredMemory memory;
+    memory.m_core = text.trimmed();
+    memory.m_coreTokens = Tokenizer::approximate()->countTokens(memory.m_core);
+    return memory;
+}
+
+QByteArray TieredMemory::toJson() const
+{
+    QJsonObject core;
+    core["text"] = m_core;
+    core["tokens"] = m_coreTokens;
+
+    QJsonObject root;
+    root["version"] = kFormatVersion;
+    root["core"] = core;
+    root["eras"] = entriesToJson(m_eras);
+    root["episodes"] = entriesToJson(m_episodes);
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool TieredMemory::isEmpty() const
+{
+    return m_core.isEmpty() && m_eras.isEmpty() && m_episodes.isEmpty();
+}
+
+void TieredMemory::addEpisode(const QString &text, const QDateTime &from, const QDateTime &to,
+                              const Tokenizer &tokenizer)
+{
+    m_episodes.append({text, from, to, tokenizer.countTokens(text)});
+}
+
+TieredMemory::Rollup TieredMemory::nextRollup(const Limits &limits) const
+{
+    Rollup rollup;
+    rollup.target = Level::Era;
+    rollup.sources = oldestOverflow(m_episodes, limits.episodeTokens);
+    if (!rollup.isNull())
+        return rollup;
+    rollup.target = Level::Core;
+    rollup.sources = oldestOverflow(m_eras, limits.eraTokens);
+    return rollup;
+}
+
+bool TieredMemory::applyRollup(const Rollup &rollup, const QString &summary,
+                               const Tokenizer &tokenizer)
+{
+    QList<Entry> &sources = rollup.target == Level::Era ? m_episodes : m_eras;
+    if (rollup.isNull() || !startsWith(sources, rollup.sources))
+        return false;
+    sources.remove(0, rollup.sources.size());
+
+    const int tokens = tokenizer.countTokens(summary);
+    if (rollup.target == Level::Era)
+    {
+        // Les épisodes sont tous plus récents que les ères : l'ère va à la fin.
+        m_eras.append({summary, rollup.sources.first().from, rollup.sources.last().to, tokens});
+    }
+    else
+    {
+        m_core = summary;
+        m_coreTokens = tokens;
+    }
+    return true;
+}
+
+QString TieredMemory::render(int budgetTokens) const
+{
+    // Le noyau toujours ; puis, du plus récent au plus ancien, les résumés
+    // tant qu'ils tiennent. On s'arrête au premier qui déborde : pas de trou
+    // dans la chronologie.
+    qint64 remaining = qint64(budgetTokens) - m_coreTokens;
+    qsizetype episodes = 0;
+    while (episodes < m_episodes.size() &&
+           m_episodes.at(m_episodes.size() - 1 - episodes).tokens <= remaining)
+        remaining -= m_episodes.at(m_episodes.size() - 1 - episodes++).tokens;
+    qsizetype eras = 0;
+    if (episodes == m_episodes.size())
+    {
+        while (eras < m_eras.size() && m_eras.at(m_eras.size() - 1 - eras).tokens <= remaining)
+            remaining -= m_eras.at(m_eras.size() - 1 - eras++).tokens;
+    }
+
+    QString text;
+    if (!m_core.isEmpty())
+        text += "## CORE PROFILE\n\n" + m_core + "\n\n";
+    if (eras > 0)
+    {
+        text += "## EARLIER PERIODS\n\n";
+        for (qsizetype i = m_eras.size() - eras; i < m_eras.size(); ++i)
+            text += "[" + period(m_eras.at(i)) + "] " + m_eras.at(i).text + "\n\n";
+    }
+    if (episodes > 0)
+    {
+        text += "## RECENT EPISODES\n\n";
+        for (qsizetype i = m_episodes.size() - episodes; i < m_episodes.size(); ++i)
+            text += "[" + period(m_episodes.at(i)) + "] " + m_episodes.at(i).text + "\n\n";
+    }
+    return text.trimmed();
+}
+// End Source File TieredMemory.cpp
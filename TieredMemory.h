@@ -0,0 +1,94 @@
+// Begin Source File TieredMemory.h
+#ifndef TIEREDMEMORY_H
+#define TIEREDMEMORY_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include "Tokenizer.h"
+
+// The long-term memory of a persona, in three levels.
+//
+// Every curation used to rewrite one monolithic summary: the whole memory
+// went back to the model with the culled messages, so each curation cost more
+// than the last, and every request carried the whole summary. The memory is
+// now layered:
+//   - episodes: one summary per curation, written from the culled messages
+//     only;
+//   - eras: when the episodes outgrow their budget, the oldest ones are merged
+//     into one era summary;
+//   - core: when the eras outgrow theirs, the oldest ones are folded into the
+//     core profile, kept short.
+// A curation thus re-summarizes only the level that overflowed (nextRollup),
+// and a request carries the core plus the most recent summaries that fit its
+// budget (render()); older ones stay searchable in the archive.
+//
+// Stored as JSON in <name>_memory.json; a plain-text memory from an older
+// version (<name>_memory.txt) is read as the core profile. Token counts are
+// computed once, when a summary is added.
+class TieredMemory
+{
+public:
+    struct Entry
+    {
+        QString text;
+        QDateTime from; // Premier et dernier message couverts
+        QDateTime to;
+        int tokens = 0;
+    };
+
+    enum class Level { Era, Core };
+
+    // Oldest summaries to merge into one summary of the next level up.
+    struct Rollup
+    {
+        Level target = Level::Era;
+        QList<Entry> sources;
+        bool isNull() const { return sources.isEmpty(); }
+    };
+
+    // "memory/*" settings, in tokens.
+    struct Limits
+    {
+        int episodeTokens = 4000; // Épisodes avant fusion en ère
+        int eraTokens = 4000;     // Ères avant fusion dans le noyau
+        int coreTokens = 1500;    // Taille visée du noyau
+        int requestTokens = 8000; // Mémoire jointe à chaque requête
+        static Limits fromSettings();
+    };
+
+    static TieredMemory fromJson(const QByteArray &json);
+    static TieredMemory fromLegacyText(const QString &text);
+    QByteArray toJson() const;
+
+    bool isEmpty() const;
+    QString core() const { return m_core; }
+    const QList<Entry> &eras() const { return m_eras; }
+    const QList<Entry> &episodes() const { return m_episodes; }
+
+    void addEpisode(const QString &text, const QDateTime &from, const QDateTime &to,
+                    const Tokenizer &tokenizer);
+
+    // The level to consolidate, if one exceeds its limit (episodes first).
+    Rollup nextRollup(const Limits &limits) const;
+
+    // Replaces the rollup sources with `summary`. Returns false, leaving the
+    // memory unchanged, if the sources are no longer the oldest entries of
+    // their level (memory rewritten meanwhile).
+    bool applyRollup(const Rollup &rollup, const QString &summary, const Tokenizer &tokenizer);
+
+    // Core profile, then the most recent eras and episodes whose tokens fit
+    // in `budgetTokens`, oldest first. Empty for an empty memory.
+    QString render(int budgetTokens) const;
+
+private:
+    QString m_core;
+    int m_coreTokens = 0;
+    QList<Entry> m_eras;
+    QList<Entry> m_episodes;
+};
+
+#endif // TIEREDMEMORY_H
+// End Source File TieredMemory.h
@@ -0,0 +1,68 @@
+// Begin Source File TokenLedger.cpp
+#include "TokenLedger.h"
+
+#include <algorithm>
+
+void TokenLedger::clear()
+{
+    m_sums = {0};
+    m_start = 0;
+}
+
+void TokenLedger::append(int weight)
+{
+    m_sums.append(m_sums.last() + qMax(weight, 0));
+}
+
+void TokenLedger::prepend(const QList<int> &weights)
+{
+    if (weights.isEmpty())
+        return;
+
+    QList<qint64> sums;
+    sums.reserve(weights.size() + size() + 1);
+    sums.append(0);
+    for (int weight : weights)
+        sums.append(sums.last() + qMax(weight, 0));
+    const qint64 shift = sums.last() - m_sums.at(m_start);
+    for (qsizetype i = m_start + 1; i < m_sums.size(); ++i)
+        sums.append(m_sums.at(i) + shift);
+    m_sums = std::move(sums);
+    m_start = 0;
+}
+
+void TokenLedger::removeFirst(qsizetype count)
+{
+    m_start += qBound<qsizetype>(0, count, size());
+    // Les sommes restent valables telles quelles (seules les différences
+    // comptent) ; on ne compacte que quand le préfixe mort domine.
+    if (m_start > size())
+    {
+        m_sums.remove(0, m_start);
+        m_start = 0;
+    }
+}
+
+void TokenLedger::removeLast()
+{
+    if (!isEmpty())
+        m_sums.removeLast();
+}
+
+void TokenLedger::setLast(int weight)
+{
+    if (!isEmpty())
+        m_sums.last() = m_sums.at(m_sums.size() - 2) + qMax(weight, 0);
+}
+
+qsizetype TokenLedger::countCovering(qint64 tokens) const
+{
+    if (tokens <= 0)
+        return 0;
+    const auto first = m_sums.cbegin() + m_start;
+    const auto it = std::lower_bound(first, m_sums.cend(), m_sums.at(m_start) + tokens);
+    if (it == m_sums.cend())
+        return size();
+    return it - first;
+}
+// End Source File TokenLedger.cpp
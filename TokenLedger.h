@@ -0,0 +1,46 @@
+// Begin Source File TokenLedger.h
+#ifndef TOKENLEDGER_H
+#define TOKENLEDGER_H
+
+#include <QList>
+
+// Running prefix sums of the token weights of a rolling context.
+//
+// ChatModel (its message list) and GroupChatModel (each participant's journal)
+// keep a ledger in step with the messages: the live-memory estimate is then
+// total(), and the curation cut point — the fewest oldest messages whose
+// weights cover the excess over the target — is one binary search instead of
+// a walk that re-estimated every message. Removing the culled head is O(1):
+// the dead prefix of the array is only dropped once it outgrows the live part.
+//
+// Weights must be non-negative (see MemoryCurator::weigh).
+class TokenLedger
+{
+public:
+    void clear();
+    void append(int weight);
+    // `weights` in message order, placed before the current first message.
+    void prepend(const QList<int> &weights);
+    void removeFirst(qsizetype count);
+    void removeLast();
+    void setLast(int weight);
+
+    qsizetype size() const { return m_sums.size() - 1 - m_start; }
+    bool isEmpty() const { return size() == 0; }
+    qint64 total() const { return sumFirst(size()); }
+    // Weight of the first `count` messages.
+    qint64 sumFirst(qsizetype count) const { return m_sums.at(m_start + count) - m_sums.at(m_start); }
+
+    // Smallest number of leading messages whose weights add up to at least
+    // `tokens` (0 if `tokens` <= 0, size() if even all of them fall short).
+    qsizetype countCovering(qint64 tokens) const;
+
+private:
+    // m_sums[i] = poids cumulé des i premiers éléments du tableau ; les
+    // m_start premiers éléments sont déjà retirés.
+    QList<qint64> m_sums{0};
+    qsizetype m_start = 0;
+};
+
+#endif // TOKENLEDGER_H
+// End Source File TokenLedger.h
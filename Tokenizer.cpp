@@ -0,0 +1,78 @@
+// Begin Source File Tokenizer.cpp
+#include "Tokenizer.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+#include "BpeTokenizer.h"
+
+namespace
+{
+// L'ancienne estimation : 1 token ≈ 4 caractères.
+class ApproximateTokenizer : public Tokenizer
+{
+public:
+    QString name() const override { return QStringLiteral("approx"); }
+    int countTokens(QStringView text) const override { return int(text.size() / 4); }
+};
+
+} // namespace
+
+std::shared_ptr<const Tokenizer> Tokenizer::approximate()
+{
+    static const std::shared_ptr<const Tokenizer> instance =
+        std::make_shared<ApproximateTokenizer>();
+    return instance;
+}
+
+QString Tokenizer::vocabularyDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+           "/TetherChats/tokenizers";
+}
+
+std::shared_ptr<const Tokenizer> Tokenizer::forName(const QString &name)
+{
+    if (name.isEmpty() || name == QLatin1String("approx"))
+        return approximate();
+
+    // Un vocabulaire pèse plusieurs Mo : chargé une fois, partagé par tous les
+    // interlocuteurs du même modèle. Les noms introuvables sont aussi retenus
+    // (approximate()) pour ne pas relire le disque à chaque persona.
+    static QMutex mutex;
+    static QHash<QString, std::shared_ptr<const Tokenizer>> loaded;
+    QMutexLocker locker(&mutex);
+    auto it = loaded.constFind(name);
+    if (it != loaded.constEnd())
+        return it.value();
+
+    std::shared_ptr<const Tokenizer> tokenizer;
+    const QString base = vocabularyDirectory() + "/" + name;
+    QString error;
+    if (QFile::exists(base + ".tiktoken"))
+        tokenizer = BpeTokenizer::load(name, base + ".tiktoken", BpeTokenizer::Format::Tiktoken,
+                                       &error);
+    else if (QFile::exists(base + ".vocab"))
+        tokenizer = BpeTokenizer::load(name, base + ".vocab", BpeTokenizer::Format::SentencePiece,
+                                       &error);
+    else
+        error = "no " + base + ".tiktoken or .vocab file";
+
+    if (!tokenizer)
+    {
+        qWarning() << "Tokenizer" << name << "unavailable (" << error
+                   << ") - falling back to the chars/4 estimate.";
+        tokenizer = approximate();
+    }
+    else
+    {
+        qDebug() << "Tokenizer" << name << "loaded.";
+    }
+    loaded.insert(name, tokenizer);
+    return tokenizer;
+}
+// End Source File Tokenizer.cpp
@@ -0,0 +1,43 @@
+// Begin Source File Tokenizer.h
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <QString>
+#include <QStringView>
+
+#include <memory>
+
+// Counts tokens the way a model does, for the curation accounting.
+//
+// The chars/4 estimate used everywhere before was badly off for French, code
+// and emoji, so the curation triggered too early or too late. Each model of
+// models.ini now names its tokenizer (`tokenizer=o200k_base`...); forName()
+// loads the matching vocabulary file from TetherChats/tokenizers/ once per
+// process and shares it between every interlocutor using that model:
+//   - <name>.tiktoken : tiktoken ranks ("base64-token rank" per line), as
+//                       published for cl100k_base / o200k_base;
+//   - <name>.vocab    : SentencePiece table ("piece<TAB>score" per line).
+// When no vocabulary is installed for a name, the chars/4 estimate is used
+// (approximate()), with one warning per name.
+//
+// Implementations are immutable once loaded, and countTokens() is safe to
+// call from any thread.
+class Tokenizer
+{
+public:
+    virtual ~Tokenizer() = default;
+
+    virtual QString name() const = 0;
+    virtual int countTokens(QStringView text) const = 0;
+
+    // Shared tokenizer for a models.ini name. Never null.
+    static std::shared_ptr<const Tokenizer> forName(const QString &name);
+    // The chars/4 estimate. Never null.
+    static std::shared_ptr<const Tokenizer> approximate();
+
+    // ~/Documents/TetherChats/tokenizers
+    static QString vocabularyDirectory();
+};
+
+#endif // TOKENIZER_H
+// End Source File Tokenizer.h
@@ -0,0 +1,263 @@
+// Begin Source File Tracer.cpp
+#include "Tracer.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QThread>
+
+#include <algorithm>
+#include <array>
+
+struct Tracer::Ring
+{
+    std::array<Event, kRingCapacity> events;
+    std::atomic<quint64> head{0};   // Nombre d'événements écrits depuis la création
+    std::atomic<quint64> floor{0};  // Premier événement gardé (clear())
+    std::atomic<bool> inUse{false}; // Tenu par un fil vivant
+    quint32 threadId = 0;
+};
+
+namespace
+{
+// Rend l'anneau du fil à sa fin, pour qu'un fil suivant le reprenne (les
+// fils du QThreadPool vont et viennent).
+struct RingLease
+{
+    std::atomic<bool> *inUse = nullptr;
+    ~RingLease()
+    {
+        if (inUse)
+            inUse->store(false, std::memory_order_release);
+    }
+};
+
+double percentile(const QList<double> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0;
+    const qsizetype i = qMin(sorted.size() - 1, qsizetype(p * double(sorted.size())));
+    return sorted.at(i);
+}
+} // namespace
+
+Tracer &Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+{
+    m_clock.start();
+    QSettings settings("Tether", "ChatApp");
+    m_enabled.store(settings.value("diagnostics/tracing", true).toBool(),
+                    std::memory_order_relaxed);
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    if (m_enabled.exchange(enabled, std::memory_order_relaxed) == enabled)
+        return;
+    QSettings settings("Tether", "ChatApp");
+    settings.setValue("diagnostics/tracing", enabled);
+}
+
+Tracer::Ring *Tracer::localRing()
+{
+    thread_local Ring *t_ring = nullptr;
+    thread_local RingLease t_lease;
+    if (t_ring)
+        return t_ring;
+
+    // Premier événement de ce fil : un anneau libéré, ou un nouveau
+    QMutexLocker locker(&m_ringsMutex);
+    Ring *ring = nullptr;
+    for (const std::unique_ptr<Ring> &candidate : m_rings)
+    {
+        bool expected = false;
+        if (candidate->inUse.compare_exchange_strong(expected, true))
+        {
+            ring = candidate.get();
+            break;
+        }
+    }
+    if (!ring)
+    {
+        m_rings.push_back(std::make_unique<Ring>());
+        ring = m_rings.back().get();
+        ring->inUse.store(true);
+    }
+
+    QThread *thread = QThread::currentThread();
+    QString threadName = thread->objectName();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        threadName = "GUI";
+    m_threadNames.append(threadName.isEmpty() ? QString("Thread %1").arg(m_threadNames.size() + 1)
+                                              : threadName);
+    ring->threadId = quint32(m_threadNames.size());
+
+    t_ring = ring;
+    t_lease.inUse = &ring->inUse;
+    return ring;
+}
+
+void Tracer::record(const Event &event)
+{
+    Ring *ring = localRing();
+    Event stamped = event;
+    stamped.threadId = ring->threadId;
+    // Un seul écrivain par anneau : l'emplacement est écrit, puis publié.
+    const quint64 head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head % kRingCapacity] = stamped;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::complete(const char *name, const char *category, qint64 startNs, qint64 durationNs)
+{
+    if (!isEnabled())
+        return;
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.startNs = startNs;
+    event.durationNs = qMax<qint64>(0, durationNs);
+    record(event);
+}
+
+void Tracer::counter(const char *name, qint64 value)
+{
+    if (!isEnabled())
+        return;
+    Event event;
+    event.name = name;
+    event.category = "counter";
+    event.startNs = nowNs();
+    event.value = value;
+    record(event);
+}
+
+QList<Tracer::Event> Tracer::snapshot() const
+{
+    QList<Event> events;
+    QMutexLocker locker(&m_ringsMutex);
+    for (const std::unique_ptr<Ring> &ring : m_rings)
+    {
+        const quint64 before = ring->head.load(std::memory_order_acquire);
+        const quint64 first =
+            qMax(ring->floor.load(std::memory_order_acquire),
+                 before > quint64(kRingCapacity) ? before - kRingCapacity : 0);
+        QList<Event> copied;
+        copied.reserve(qsizetype(before - first));
+        for (quint64 i = first; i < before; ++i)
+            copied.append(ring->events[i % kRingCapacity]);
+        // Emplacements réécrits pendant la copie (l'écrivain a pu entamer le
+        // suivant) : écartés
+        const quint64 after = ring->head.load(std::memory_order_acquire);
+        const quint64 valid = after + 1 > quint64(kRingCapacity) ? after + 1 - kRingCapacity : 0;
+        const qsizetype skip = qsizetype(qMin(before, qMax(first, valid)) - qMin(before, first));
+        events.append(copied.mid(skip));
+    }
+    std::sort(events.begin(), events.end(),
+              [](const Event &a, const Event &b) { return a.startNs < b.startNs; });
+    return events;
+}
+
+QList<Tracer::Stats> Tracer::statistics() const
+{
+    struct Accumulator
+    {
+        Stats stats;
+        QList<double> durations;
+    };
+    QHash<QByteArray, Accumulator> byName;
+    QList<QByteArray> order;
+    for (const Event &event : snapshot())
+    {
+        const QByteArray name(event.name);
+        auto it = byName.find(name);
+        if (it == byName.end())
+        {
+            it = byName.insert(name, Accumulator());
+            it->stats.name = QString::fromLatin1(name);
+            it->stats.category = QString::fromLatin1(event.category);
+            it->stats.isCounter = event.durationNs < 0;
+            order.append(name);
+        }
+        ++it->stats.count;
+        if (event.durationNs < 0)
+        {
+            it->stats.lastValue = event.value;
+        }
+        else
+        {
+            it->stats.lastMs = double(event.durationNs) / 1e6;
+            it->durations.append(it->stats.lastMs);
+        }
+    }
+
+    QList<Stats> result;
+    std::sort(order.begin(), order.end());
+    for (const QByteArray &name : order)
+    {
+        Accumulator &accumulator = byName[name];
+        std::sort(accumulator.durations.begin(), accumulator.durations.end());
+        accumulator.stats.p50Ms = percentile(accumulator.durations, 0.50);
+        accumulator.stats.p99Ms = percentile(accumulator.durations, 0.99);
+        accumulator.stats.maxMs =
+            accumulator.durations.isEmpty() ? 0 : accumulator.durations.last();
+        result.append(accumulator.stats);
+    }
+    return result;
+}
+
+QByteArray Tracer::chromeTrace() const
+{
+    const QList<Event> events = snapshot();
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    {
+        QMutexLocker locker(&m_ringsMutex);
+        for (qsizetype i = 0; i < m_threadNames.size(); ++i)
+            traceEvents.append(QJsonObject{{"name", "thread_name"},
+                                           {"ph", "M"},
+                                           {"pid", pid},
+                                           {"tid", i + 1},
+                                           {"args", QJsonObject{{"name", m_threadNames.at(i)}}}});
+    }
+    for (const Event &event : events)
+    {
+        QJsonObject object{{"name", QString::fromLatin1(event.name)},
+                           {"cat", QString::fromLatin1(event.category)},
+                           {"pid", pid},
+                           {"tid", qint64(event.threadId)},
+                           {"ts", double(event.startNs) / 1000.0}};
+        if (event.durationNs < 0)
+        {
+            object["ph"] = "C";
+            object["args"] = QJsonObject{{"value", event.value}};
+        }
+        else
+        {
+            object["ph"] = "X";
+            object["dur"] = double(event.durationNs) / 1000.0;
+        }
+        traceEvents.append(object);
+    }
+    return QJsonDocument(QJsonObject{{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}})
+        .toJson(QJsonDocument::Compact);
+}
+
+void Tracer::clear()
+{
+    // `head` n'appartient qu'à l'écrivain : on relève seulement le plancher.
+    QMutexLocker locker(&m_ringsMutex);
+    for (const std::unique_ptr<Ring> &ring : m_rings)
+        ring->floor.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+}
+// End Source File Tracer.cpp
@@ -0,0 +1,126 @@
+// Begin Source File Tracer.h
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Timings of the hot paths, for the Diagnostics tab and for offline analysis.
+//
+// qDebug() lines gave the duration of a few steps, scattered in the log.
+// Instrumented code now records events here instead:
+//   - spans: a name, a start and a duration (TraceScope around a block, or
+//     complete() for a span that crosses callbacks, such as a request);
+//   - counters: a name and a value at a point in time (counter()).
+// Names and categories are string literals: recording an event allocates
+// nothing and takes no lock. Each thread writes to its own ring buffer (the
+// last kRingCapacity events), registered on its first event; readers copy
+// the rings and drop the slots overwritten while they were reading.
+//
+// snapshot() gathers the events of every thread, statistics() sums them up
+// per name (the Diagnostics tab), and chromeTrace() writes them in the Chrome
+// trace-event format, to be opened in chrome://tracing or Perfetto.
+//
+// Recording is on by default; the "diagnostics/tracing" setting (false)
+// turns it off, and every call then returns after one relaxed atomic load.
+class Tracer
+{
+public:
+    static constexpr int kRingCapacity = 4096;
+
+    struct Event
+    {
+        const char *name = nullptr;
+        const char *category = nullptr;
+        qint64 startNs = 0;
+        qint64 durationNs = -1; // -1 : compteur (`value`)
+        qint64 value = 0;
+        quint32 threadId = 0;
+    };
+
+    // Span statistics per name (durations in ms), or last value of a counter.
+    struct Stats
+    {
+        QString name;
+        QString category;
+        bool isCounter = false;
+        int count = 0;
+        double lastMs = 0;
+        double p50Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+        qint64 lastValue = 0;
+    };
+
+    static Tracer &instance();
+
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    // Monotonic time of the events, in ns since the tracer was created.
+    qint64 nowNs() const { return m_clock.nsecsElapsed(); }
+
+    void complete(const char *name, const char *category, qint64 startNs, qint64 durationNs);
+    void counter(const char *name, qint64 value);
+
+    QList<Event> snapshot() const;
+    QList<Stats> statistics() const;
+    QByteArray chromeTrace() const;
+    // Forgets the recorded events (the rings stay registered).
+    void clear();
+
+private:
+    struct Ring;
+
+    Tracer();
+    Ring *localRing();
+    void record(const Event &event);
+
+    std::atomic<bool> m_enabled{true};
+    QElapsedTimer m_clock;
+    mutable QMutex m_ringsMutex; // Inscription des fils et lecture de la liste
+    std::vector<std::unique_ptr<Ring>> m_rings;
+    QList<QString> m_threadNames; // Indexé par threadId - 1
+};
+
+// Records the time spent in the enclosing block as a span.
+//     TraceScope scope("payload.build", "interlocutor");
+class TraceScope
+{
+public:
+    TraceScope(const char *name, const char *category)
+        : m_name(name)
+        , m_category(category)
+        , m_startNs(Tracer::instance().isEnabled() ? Tracer::instance().nowNs() : -1)
+    {
+    }
+    ~TraceScope() { close(); }
+
+    // Ends the span before the end of the block.
+    void close()
+    {
+        if (m_startNs < 0)
+            return;
+        Tracer &tracer = Tracer::instance();
+        tracer.complete(m_name, m_category, m_startNs, tracer.nowNs() - m_startNs);
+        m_startNs = -1;
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_name;
+    const char *m_category;
+    qint64 m_startNs;
+};
+
+#endif // TRACER_H
+// End Source File Tracer.h
@@ -0,0 +1,1567 @@
+// Begin Source File bench.cpp
+//
+// tether_bench — headless load generator for the hot paths of Tether.
+//
+// Runs ChatModel, GroupChatModel and the curation/persistence helpers without
+// QML, driven by DummyInterlocutor with a synthetic Profile (latency
+// distribution, reply size, token usage, error rate). For each history size
+// (1k, 10k, 100k messages by default) it reports the p50/p99 latency of:
+//   chat.loadChat       loadChat() until the whole journal is in the model
+//   chat.addMessage     sendMessage(): user message, typing indicator, request
+//   chat.reply          the model's replyReady() handler (reply appended)
+//   curation.cull       the curation trigger: cut point, head removal, request
+//   payload.buildCold   request body built from an empty HistoryPayloadCache
+//   payload.build       the same, one turn later (two messages added)
+//   journal.rewrite     cull of the journal head and its background compaction
+//   scanner.parse       whole journal mapped and parsed by JsonlScanner
+//   qjson.parse         the same through the former path (QTextStream line,
+//                       toUtf8, QJsonDocument, ChatMessage::fromJsonObject)
+//   group.load          GroupChatModel::setParticipants() until loaded
+//   group.turn          GroupChatModel's replyReady() handler (all journals)
+//   message.copy        detaching copy of the whole history (QList<ChatMessage>)
+//   message.copyPrevious the same with the former ChatMessage layout (QString
+//                       text and role, QDateTime, separate bools), for reference
+// All timings are GUI-thread wall times, in microseconds. Each run also reports
+// the bytes per message of both layouts ("messageBytes").
+//
+// The report (stdout, or --output) is meant to be kept and compared between
+// versions. Besides "runs" (the history sizes above), it has one section per
+// suite, all run by default (--suites picks some):
+//   history     the "runs" above
+//   tokenizers  BpeTokenizer throughput (MB/s of UTF-8 input) for cl100k_base,
+//               o200k_base and SentencePiece vocabularies, LRU cache cold
+//               (freshly loaded tokenizer) and warm (second pass); from
+//               --vocab-dir, or synthetic vocabularies flagged as such
+//   append      journal appends per second under each IoWorker sync policy
+//               ("message", "batched", "idle")
+//   recovery    crash-injection harness of the journal (see crashHarness)
+//   embeddings  EmbeddingStore recall@k against latency, flat scan and HNSW,
+//               over a synthetic store grown to --vector-sizes (see
+//               benchEmbeddings)
+//   retries     NetworkService retries and rate-limit pacing against a
+//               scripted loopback server (see benchRetries)
+// The exit status is 1 if a crash trial or a retry scenario fails, or if the
+// graph's recall falls below --min-recall.
+//
+// QStandardPaths test mode keeps the bench away from the user's settings and
+// Documents/TetherChats: everything is written to a temporary directory.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QHttpMultiPart>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <random>
+
+#include "BpeTokenizer.h"
+#include "ChatModel.h"
+#include "DummyInterlocutor.h"
+#include "EmbeddingStore.h"
+#include "GroupChatModel.h"
+#include "HistoryPayloadCache.h"
+#include "IoWorker.h"
+#include "JournalFile.h"
+#include "JsonlScanner.h"
+#include "MemoryCurator.h"
+#include "NetworkService.h"
+#include "Tracer.h"
+
+namespace
+{
+const int kWaitTimeoutMs = 300000;
+const int kNoCuration = INT_MAX; // Seuils hors d'atteinte : pas de curation spontanée
+
+bool g_verbose = false;
+
+void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &message)
+{
+    // Les modèles sont bavards en debug ; seuls les avertissements comptent ici.
+    if (!g_verbose && (type == QtDebugMsg || type == QtInfoMsg))
+        return;
+    QTextStream(stderr) << message << '\n';
+}
+
+// Latencies of one operation, in microseconds.
+class Samples
+{
+public:
+    void add(qint64 nanoseconds) { m_values.append(nanoseconds / 1000.0); }
+    bool isEmpty() const { return m_values.isEmpty(); }
+
+    double percentile(double p) const
+    {
+        QList<double> sorted = m_values;
+        std::sort(sorted.begin(), sorted.end());
+        const qsizetype rank = qsizetype(std::ceil(p * sorted.size()));
+        return sorted.at(qBound<qsizetype>(0, rank - 1, sorted.size() - 1));
+    }
+
+    QJsonObject toJson() const
+    {
+        double sum = 0;
+        for (double value : m_values)
+            sum += value;
+        return QJsonObject{{"samples", m_values.size()},
+                           {"p50Us", percentile(0.50)},
+                           {"p99Us", percentile(0.99)},
+                           {"meanUs", sum / m_values.size()},
+                           {"maxUs", *std::max_element(m_values.begin(), m_values.end())}};
+    }
+
+private:
+    QList<double> m_values;
+};
+
+struct Options
+{
+    QList<int> sizes{1000, 10000, 100000};
+    int samples = 200;     // Opérations rapides (addMessage, build, tours)
+    int loadSamples = 10;  // Opérations qui relisent ou réécrivent tout
+    int messageChars = 400;
+    QString vocabularyDirectory;
+    int appendMessages = 2000; // Ajouts mesurés par politique de synchronisation
+    int crashTrials = 200;
+    QList<int> vectorSizes{10000, 50000, 200000, 1000000}; // Magasins de vecteurs mesurés
+    int vectorDimension = 256;
+    int recallK = 10;
+    double minRecall = 0.9; // En deçà, le graphe HNSW est jugé insuffisant
+    QSet<QString> suites;   // Sections du rapport à produire
+    DummyInterlocutor::Profile profile;
+};
+
+// Runs the event loop until `done()`, re-checked at each `signal` of `sender`.
+template <typename Sender, typename Signal, typename Done>
+bool waitFor(const Sender *sender, Signal signal, Done done)
+{
+    if (done())
+        return true;
+    QEventLoop loop;
+    QObject::connect(sender, signal, &loop,
+                     [&loop, &done]()
+                     {
+                         if (done())
+                             loop.quit();
+                     });
+    QTimer::singleShot(kWaitTimeoutMs, &loop, &QEventLoop::quit);
+    loop.exec();
+    if (!done())
+    {
+        qWarning() << "tether_bench: timed out after" << kWaitTimeoutMs << "ms.";
+        return false;
+    }
+    return true;
+}
+
+// Times the replyReady() handlers that `connectModel` connects to `interlocutors`:
+// a first slot starts the clock, a last one stops it (direct connections run
+// in connection order).
+void timeReplies(const QList<Interlocutor *> &interlocutors,
+                 const std::function<void()> &connectModel, Samples &samples)
+{
+    auto clock = std::make_shared<QElapsedTimer>();
+    for (Interlocutor *interlocutor : interlocutors)
+    {
+        QObject::connect(interlocutor, &Interlocutor::replyReady, interlocutor,
+                         [clock](const InterlocutorReply &) { clock->start(); });
+    }
+    connectModel();
+    for (Interlocutor *interlocutor : interlocutors)
+    {
+        QObject::connect(interlocutor, &Interlocutor::replyReady, interlocutor,
+                         [clock, &samples](const InterlocutorReply &reply)
+                         {
+                             if (reply.kind == InterlocutorReply::Kind::NormalMessage)
+                                 samples.add(clock->nsecsElapsed());
+                         });
+    }
+}
+
+QString fillerText(int index, int chars)
+{
+    static const QString filler =
+        QStringLiteral("The quick brown fox jumps over the lazy dog while the bench counts. ");
+    const QString head = QString("Message #%1. ").arg(index);
+    return head + filler.repeated(chars / filler.size() + 1).left(qMax(0, chars - head.size()));
+}
+
+// `count` alternating user/assistant messages, weighted like live ones.
+QList<ChatMessage> syntheticHistory(int count, int chars)
+{
+    QList<ChatMessage> messages;
+    messages.reserve(count);
+    const QDateTime start = QDateTime::currentDateTime().addSecs(-count);
+    for (int i = 0; i < count; ++i)
+    {
+        const bool user = i % 2 == 0;
+        ChatMessage msg(user, fillerText(i, chars), start.addSecs(i), 0, 0,
+                        user ? "user" : "assistant");
+        MemoryCurator::weigh(msg, *Tokenizer::approximate());
+        messages.append(msg);
+    }
+    return messages;
+}
+
+bool copyJournal(const QString &from, const QString &to)
+{
+    JournalFile(to).remove();
+    IoWorker::instance().drain();
+    return QFile::copy(from, to) && QFile::copy(from + ".idx", to + ".idx");
+}
+
+// ChatMessage as it was before it became a compact record, kept only as the
+// reference of the message.copy microbenchmark.
+struct PreviousMessageLayout
+{
+    bool isLocalMessage = false;
+    QString text;
+    QByteArray rawText;
+    QDateTime timestamp;
+    int promptTokens = 0;
+    int completionTokens = 0;
+    QString role;
+    bool isError = false;
+    QString speaker;
+    int tokenWeight = -1;
+    int serverLatencyMs = -1;
+    double tokensPerSecond = 0.0;
+    bool isTypingIndicator = false;
+};
+
+// Même rôle partagé que l'ancien JsonlScanner : une allocation pour le texte
+// seulement.
+QList<PreviousMessageLayout> previousLayout(const QList<ChatMessage> &history)
+{
+    QList<PreviousMessageLayout> messages;
+    messages.reserve(history.size());
+    for (const ChatMessage &msg : history)
+    {
+        PreviousMessageLayout previous;
+        previous.isLocalMessage = msg.isLocalMessage();
+        previous.text = msg.text();
+        previous.timestamp = msg.timestamp();
+        previous.role = msg.role();
+        previous.tokenWeight = msg.tokenWeight();
+        messages.append(previous);
+    }
+    return messages;
+}
+
+// Same encoding as OpenAIInterlocutor's "input" items.
+QByteArray buildPayload(HistoryPayloadCache &cache, const QList<ChatMessage> &history)
+{
+    cache.begin(true);
+    for (const ChatMessage &msg : history)
+    {
+        cache.append(HistoryPayloadCache::keyOf(msg),
+                     [&msg]()
+                     {
+                         QJsonObject textObject;
+                         textObject["type"] = msg.isLocalMessage() ? "input_text" : "output_text";
+                         textObject["text"] = msg.text();
+                         QJsonObject item;
+                         item["role"] = msg.isLocalMessage() ? "user" : "assistant";
+                         item["content"] = QJsonArray{textObject};
+                         return HistoryPayloadCache::encodeObject(item);
+                     });
+    }
+    return cache.finish(QJsonObject{{"model", "bench"}}, QLatin1StringView("input"));
+}
+
+class Bench
+{
+public:
+    Bench(const Options &options, const QString &directory)
+        : m_options(options)
+        , m_directory(directory)
+    {
+    }
+
+    QJsonObject run(int size)
+    {
+        QTextStream(stderr) << "tether_bench: " << size << " messages...\n";
+        m_metrics = {};
+        m_history = syntheticHistory(size, m_options.messageChars);
+        m_seedPath = m_directory + QString("/seed_%1.jsonl").arg(size);
+        for (const ChatMessage &msg : std::as_const(m_history))
+            JournalFile(m_seedPath).append(msg);
+        IoWorker::instance().drain();
+
+        benchChatModel(size);
+        benchScanner();
+        benchPayload();
+        benchJournalRewrite(size);
+        benchGroup(size);
+        const QJsonObject messageBytes = benchMessages();
+
+        QJsonObject metrics;
+        for (auto it = m_metrics.cbegin(); it != m_metrics.cend(); ++it)
+        {
+            if (!it.value().isEmpty())
+                metrics[it.key()] = it.value().toJson();
+        }
+        m_history.clear();
+        return QJsonObject{
+            {"messages", size}, {"messageBytes", messageBytes}, {"metrics", metrics}};
+    }
+
+private:
+    void benchChatModel(int size)
+    {
+        const QString path = m_directory + QString("/chat_%1.jsonl").arg(size);
+        if (!copyJournal(m_seedPath, path))
+        {
+            qWarning() << "tether_bench: could not copy the journal to" << path;
+            return;
+        }
+
+        DummyInterlocutor interlocutor("Bench");
+        interlocutor.setProfile(m_options.profile);
+        DummyInterlocutor curator("BenchCurator");
+        DummyInterlocutor::Profile curatorProfile = m_options.profile;
+        curatorProfile.errorRate = 0; // Une curation ratée ne mesure rien
+        curatorProfile.replyChars = 300;
+        curator.setProfile(curatorProfile);
+
+        ChatModel model;
+        timeReplies({&interlocutor}, [&]() { model.setInterlocutor(&interlocutor); },
+                    m_metrics["chat.reply"]);
+        model.setCurator(&curator);
+        model.setCurationThresholds(kNoCuration, kNoCuration - 1);
+
+        // Chargement complet, relu chaque fois depuis le disque
+        for (int s = 0; s < m_options.loadSamples; ++s)
+        {
+            model.loadChat(QString());
+            QElapsedTimer clock;
+            clock.start();
+            model.loadChat(path);
+            if (!waitFor(&model, &ChatModel::isLoadingHistoryChanged,
+                         [&]() { return !model.isLoadingHistory(); }))
+                return;
+            m_metrics["chat.loadChat"].add(clock.nsecsElapsed());
+        }
+
+        for (int s = 0; s < m_options.samples; ++s)
+        {
+            QElapsedTimer clock;
+            clock.start();
+            model.sendMessage(fillerText(size + s, m_options.messageChars));
+            m_metrics["chat.addMessage"].add(clock.nsecsElapsed());
+            if (!waitFor(&model, &ChatModel::isWaitingForReplyChanged,
+                         [&]() { return !model.isWaitingForReply(); }))
+                return;
+        }
+
+        // Chaque curation coupe ~1 % du contexte vif ; le résumé (factice) est
+        // attendu avant la suivante.
+        for (int s = 0; s < m_options.loadSamples; ++s)
+        {
+            const int live = model.liveMemoryTokens();
+            bool finished = false;
+            QMetaObject::Connection done = QObject::connect(
+                &model, &ChatModel::curationFinished, [&finished](bool) { finished = true; });
+            QElapsedTimer clock;
+            clock.start();
+            model.setCurationThresholds(live, live - qMax(1, live / 100));
+            const qint64 elapsed = clock.nsecsElapsed();
+            const bool culled = model.liveMemoryTokens() < live;
+            if (culled)
+                waitFor(&model, &ChatModel::curationFinished, [&finished]() { return finished; });
+            QObject::disconnect(done);
+            model.setCurationThresholds(kNoCuration, kNoCuration - 1);
+            if (!culled)
+                break; // Fusion de mémoire encore en vol, ou plus rien à couper
+            m_metrics["curation.cull"].add(elapsed);
+        }
+        IoWorker::instance().drain();
+    }
+
+    // Lecture de tout le journal, hors modèle : les deux chemins de parsing
+    // seuls, sans lots ni thread.
+    void benchScanner()
+    {
+        for (int s = 0; s < m_options.loadSamples; ++s)
+        {
+            QElapsedTimer clock;
+            clock.start();
+            QList<ChatMessage> scanned;
+            QFile mappedFile(m_seedPath);
+            if (!mappedFile.open(QIODevice::ReadOnly))
+                return;
+            const qint64 size = mappedFile.size();
+            const char *bytes = reinterpret_cast<const char *>(mappedFile.map(0, size));
+            if (!bytes)
+                return;
+            for (qint64 from = 0; from < size;)
+            {
+                const void *newline = std::memchr(bytes + from, '\n', size_t(size - from));
+                const qint64 to = newline ? static_cast<const char *>(newline) - bytes : size;
+                ChatMessage message;
+                if (to > from && JsonlScanner::parseMessage(QByteArrayView(bytes + from, to - from),
+                                                            message))
+                    scanned.append(message);
+                from = to + 1;
+            }
+            m_metrics["scanner.parse"].add(clock.nsecsElapsed());
+
+            clock.start();
+            QList<ChatMessage> parsed;
+            QFile textFile(m_seedPath);
+            if (!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+                return;
+            QTextStream stream(&textFile);
+            while (!stream.atEnd())
+            {
+                const QJsonDocument doc = QJsonDocument::fromJson(stream.readLine().toUtf8());
+                if (doc.isObject())
+                    parsed.append(ChatMessage::fromJsonObject(doc.object()));
+            }
+            m_metrics["qjson.parse"].add(clock.nsecsElapsed());
+
+            if (scanned.size() != parsed.size())
+                qWarning() << "tether_bench: the scanner read" << scanned.size()
+                           << "messages, QJsonDocument" << parsed.size();
+        }
+    }
+
+    void benchPayload()
+    {
+        QList<ChatMessage> history = m_history;
+        HistoryPayloadCache cache;
+        for (int s = 0; s < m_options.loadSamples; ++s)
+        {
+            cache.clear();
+            QElapsedTimer clock;
+            clock.start();
+            const QByteArray body = buildPayload(cache, history);
+            m_metrics["payload.buildCold"].add(clock.nsecsElapsed());
+            Q_UNUSED(body);
+        }
+        const QList<ChatMessage> turns = syntheticHistory(2 * m_options.samples,
+                                                          m_options.messageChars);
+        for (int s = 0; s < m_options.samples; ++s)
+        {
+            history.append(turns.at(2 * s));
+            history.append(turns.at(2 * s + 1));
+            QElapsedTimer clock;
+            clock.start();
+            const QByteArray body = buildPayload(cache, history);
+            m_metrics["payload.build"].add(clock.nsecsElapsed());
+            Q_UNUSED(body);
+        }
+    }
+
+    void benchJournalRewrite(int size)
+    {
+        // Assez de records coupés pour déclencher la compaction (64 Kio morts)
+        const qint64 recordBytes = QFileInfo(m_seedPath).size() / qMax(1, size);
+        const int cullCount =
+            qMin(size - 1, qMax(size / 10, int(64 * 1024 / qMax<qint64>(1, recordBytes)) + 1));
+        for (int s = 0; s < m_options.loadSamples; ++s)
+        {
+            const QString path = m_directory + QString("/rewrite_%1_%2.jsonl").arg(size).arg(s);
+            if (!copyJournal(m_seedPath, path))
+            {
+                qWarning() << "tether_bench: could not copy the journal to" << path;
+                return;
+            }
+            QElapsedTimer clock;
+            clock.start();
+            JournalFile(path).cull(cullCount);
+            IoWorker::instance().drain();
+            QThreadPool::globalInstance()->waitForDone();
+            m_metrics["journal.rewrite"].add(clock.nsecsElapsed());
+            JournalFile(path).remove();
+        }
+        IoWorker::instance().drain();
+    }
+
+    void benchGroup(int size)
+    {
+        QSettings settings;
+        settings.setValue("duo/turnDelayMs", 0);
+        settings.setValue("duo/turnPolicy", int(GroupChatModel::TurnPolicy::RoundRobin));
+        settings.setValue("duo/parallelRounds", false);
+
+        GroupChatModel group;
+        group.setMaxTurns(m_options.samples);
+        const QStringList names{"BenchA", "BenchB"};
+        QList<Interlocutor *> interlocutors;
+        auto specs = [&]()
+        {
+            QList<GroupChatModel::ParticipantSpec> list;
+            interlocutors.clear();
+            for (const QString &name : names)
+            {
+                GroupChatModel::ParticipantSpec spec;
+                spec.name = name;
+                auto *interlocutor = new DummyInterlocutor(name);
+                interlocutor->setProfile(m_options.profile);
+                interlocutors.append(interlocutor);
+                spec.interlocutor = interlocutor;
+                spec.journalPath = m_directory + QString("/%1_%2.jsonl").arg(name).arg(size);
+                spec.memoryPath = m_directory + QString("/%1_%2_memory.json").arg(name).arg(size);
+                spec.curationTriggerTokens = kNoCuration;
+                spec.curationTargetTokens = kNoCuration - 1;
+                list.append(spec);
+            }
+            return list;
+        };
+        const QString transcriptPath =
+            m_directory + QString("/duo_%1.jsonl").arg(names.join("__"));
+
+        for (int s = 0; s < m_options.loadSamples; ++s)
+        {
+            for (const QString &name : names)
+            {
+                if (!copyJournal(m_seedPath,
+                                 m_directory + QString("/%1_%2.jsonl").arg(name).arg(size)))
+                    return;
+            }
+            const QList<GroupChatModel::ParticipantSpec> list = specs();
+            QElapsedTimer clock;
+            clock.start();
+            if (s + 1 < m_options.loadSamples)
+                group.setParticipants(list, transcriptPath);
+            else
+                timeReplies(interlocutors, [&]() { group.setParticipants(list, transcriptPath); },
+                            m_metrics["group.turn"]);
+            if (!waitFor(&group, &GroupChatModel::loadingChanged,
+                         [&]() { return !group.loading(); }))
+                return;
+            m_metrics["group.load"].add(clock.nsecsElapsed());
+        }
+
+        // Pause automatique au bout de --samples répliques (ou à la première erreur)
+        group.start();
+        waitFor(&group, &GroupChatModel::runningChanged, [&]() { return !group.running(); });
+        waitFor(&group, &GroupChatModel::busyChanged, [&]() { return !group.busy(); });
+        group.clearParticipants();
+        IoWorker::instance().drain();
+    }
+
+    // Coût d'une copie de l'historique (QList détachée : une copie par
+    // message) et octets par message, record et texte, des deux représentations.
+    QJsonObject benchMessages()
+    {
+        const QList<PreviousMessageLayout> previous = previousLayout(m_history);
+        for (int s = 0; s < m_options.loadSamples; ++s)
+        {
+            QElapsedTimer clock;
+            clock.start();
+            QList<ChatMessage> copy = m_history;
+            copy.detach();
+            m_metrics["message.copy"].add(clock.nsecsElapsed());
+
+            clock.start();
+            QList<PreviousMessageLayout> previousCopy = previous;
+            previousCopy.detach();
+            m_metrics["message.copyPrevious"].add(clock.nsecsElapsed());
+        }
+
+        qint64 textBytes = 0;
+        qint64 previousTextBytes = 0;
+        for (const ChatMessage &msg : std::as_const(m_history))
+            textBytes += msg.textBytes().size();
+        for (const PreviousMessageLayout &msg : previous)
+            previousTextBytes += msg.text.size() * qint64(sizeof(QChar));
+        const double count = qMax<double>(1, m_history.size());
+        return QJsonObject{{"record", qint64(sizeof(ChatMessage))},
+                           {"text", textBytes / count},
+                           {"previousRecord", qint64(sizeof(PreviousMessageLayout))},
+                           {"previousText", previousTextBytes / count}};
+    }
+
+    const Options m_options;
+    const QString m_directory;
+    QString m_seedPath;
+    QList<ChatMessage> m_history;
+    QMap<QString, Samples> m_metrics;
+};
+
+// Sections of the report, in the order they run.
+const QStringList kSuites{"history", "tokenizers", "append", "recovery", "embeddings", "retries"};
+
+QList<int> parseSizes(const QString &text)
+{
+    QList<int> sizes;
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts))
+    {
+        bool ok = false;
+        const int size = part.trimmed().toInt(&ok);
+        if (ok && size > 1)
+            sizes.append(size);
+    }
+    return sizes;
+}
+
+// Environ 1 Mo de texte mêlant anglais, français, code et emoji : les cas où
+// l'ancienne estimation chars/4 se trompait le plus.
+QString tokenizerCorpus()
+{
+    static const QStringList paragraphs{
+        QStringLiteral("The quick brown fox jumps over the lazy dog while the bench counts. "),
+        QStringLiteral("Le cœur a ses raisons que la raison ne connaît point ; "
+                       "ça s'écrit déjà à l'œil nu, n'est-ce pas ? "),
+        QStringLiteral("for (int i = 0; i < count; ++i) { total += values[i] * 2; }\n"),
+        QStringLiteral("Bravo 🎉🚀 — merci ! 👍 "),
+    };
+    QString corpus;
+    corpus.reserve(1100 * 1000);
+    for (int i = 0; corpus.size() < 1000 * 1000; ++i)
+        corpus += paragraphs.at(i % paragraphs.size()) + QString::number(i) + ' ';
+    return corpus;
+}
+
+// Vocabulaire de remplacement quand aucun fichier n'est installé : les 256
+// octets, puis tous les préfixes des mots du corpus (et leur forme précédée
+// d'un espace, ou de "▁"), du plus court au plus long pour que chaque token
+// soit atteignable par fusion. Sans valeur linguistique, mais la table et les
+// fusions ont la taille et le coût d'un vrai vocabulaire.
+QByteArray syntheticVocabulary(const QString &corpus, BpeTokenizer::Format format)
+{
+    QSet<QByteArray> seen;
+    QList<QByteArray> prefixes;
+    // "▁" : espace de SentencePiece
+    const QByteArray space = (format == BpeTokenizer::Format::Tiktoken)
+                                 ? QByteArray(" ")
+                                 : QByteArray("\xE2\x96\x81");
+    for (const QString &word : corpus.split(' ', Qt::SkipEmptyParts))
+    {
+        const QByteArray utf8 = word.toUtf8();
+        for (const QByteArray &form : {utf8, space + utf8})
+        {
+            for (qsizetype length = 2; length <= form.size(); ++length)
+            {
+                const QByteArray prefix = form.first(length);
+                if (!seen.contains(prefix))
+                {
+                    seen.insert(prefix);
+                    prefixes.append(prefix);
+                }
+            }
+        }
+    }
+    std::stable_sort(prefixes.begin(), prefixes.end(),
+                     [](const QByteArray &a, const QByteArray &b) { return a.size() < b.size(); });
+
+    QByteArray content;
+    int rank = 0;
+    auto add = [&](const QByteArray &token)
+    {
+        if (format == BpeTokenizer::Format::Tiktoken)
+            content += token.toBase64() + ' ' + QByteArray::number(rank++) + '\n';
+        else
+            content += token + '\t' + QByteArray::number(-rank++) + '\n';
+    };
+    if (format == BpeTokenizer::Format::SentencePiece)
+    {
+        content += "<unk>\t0\n";
+        ++rank;
+        for (int byte = 0; byte < 256; ++byte)
+        {
+            content += "<0x" + QByteArray::number(byte, 16).rightJustified(2, '0').toUpper() +
+                       ">\t0\n";
+            ++rank;
+        }
+    }
+    else
+    {
+        for (int byte = 0; byte < 256; ++byte)
+            add(QByteArray(1, char(byte)));
+    }
+    for (const QByteArray &prefix : std::as_const(prefixes))
+        add(prefix);
+    return content;
+}
+
+QJsonObject benchTokenizers(const Options &options, const QString &directory)
+{
+    struct Vocabulary
+    {
+        QString name;
+        BpeTokenizer::Format format;
+    };
+    QList<Vocabulary> vocabularies{{"cl100k_base", BpeTokenizer::Format::Tiktoken},
+                                   {"o200k_base", BpeTokenizer::Format::Tiktoken}};
+    // Tables SentencePiece installées, ou une synthétique
+    const QStringList pieces =
+        QDir(options.vocabularyDirectory).entryList({"*.vocab"}, QDir::Files, QDir::Name);
+    for (const QString &file : pieces)
+        vocabularies.append(
+            {QFileInfo(file).completeBaseName(), BpeTokenizer::Format::SentencePiece});
+    if (pieces.isEmpty())
+        vocabularies.append({"sentencepiece", BpeTokenizer::Format::SentencePiece});
+
+    const QString corpus = tokenizerCorpus();
+    const double megabytes = corpus.toUtf8().size() / 1e6;
+    QJsonObject results;
+    for (const Vocabulary &vocabulary : std::as_const(vocabularies))
+    {
+        const QString extension =
+            (vocabulary.format == BpeTokenizer::Format::Tiktoken) ? ".tiktoken" : ".vocab";
+        QString path = options.vocabularyDirectory + "/" + vocabulary.name + extension;
+        const bool synthetic = !QFile::exists(path);
+        if (synthetic)
+        {
+            path = directory + "/" + vocabulary.name + extension;
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+                file.write(syntheticVocabulary(corpus, vocabulary.format)) < 0)
+                continue;
+        }
+
+        QTextStream(stderr) << "tether_bench: tokenizer " << vocabulary.name << "...\n";
+        Samples cold;
+        Samples warm;
+        int tokens = 0;
+        for (int s = 0; s < options.loadSamples; ++s)
+        {
+            // Rechargé à chaque échantillon : cache LRU vide
+            QString error;
+            const std::shared_ptr<BpeTokenizer> tokenizer =
+                BpeTokenizer::load(vocabulary.name, path, vocabulary.format, &error);
+            if (!tokenizer)
+            {
+                qWarning() << "tether_bench: cannot load" << path << error;
+                break;
+            }
+            QElapsedTimer clock;
+            clock.start();
+            tokens = tokenizer->countTokens(corpus);
+            cold.add(clock.nsecsElapsed());
+            clock.start();
+            tokenizer->countTokens(corpus);
+            warm.add(clock.nsecsElapsed());
+        }
+        if (cold.isEmpty())
+            continue;
+        results[vocabulary.name] =
+            QJsonObject{{"vocabulary", synthetic ? "synthetic" : "file"},
+                        {"corpusMB", megabytes},
+                        {"tokens", tokens},
+                        {"coldMBps", megabytes / (cold.percentile(0.5) / 1e6)},
+                        {"warmMBps", megabytes / (warm.percentile(0.5) / 1e6)}};
+    }
+    return results;
+}
+
+// Journal appends per second under each IoWorker sync policy: `count`
+// JournalFile::append() from the GUI thread until the worker has committed
+// them all. The fsync that "batched" and "idle" defer past the last batch is
+// not part of the time, since nothing waits for it.
+QJsonObject benchAppend(const Options &options, const QString &directory)
+{
+    const QList<QPair<QString, IoWorker::SyncPolicy>> policies{
+        {"message", IoWorker::SyncPolicy::PerWrite},
+        {"batched", IoWorker::SyncPolicy::Batched},
+        {"idle", IoWorker::SyncPolicy::OnIdle}};
+    IoWorker &worker = IoWorker::instance();
+    const IoWorker::SyncPolicy initial = worker.syncPolicy();
+    const QList<ChatMessage> history =
+        syntheticHistory(options.appendMessages, options.messageChars);
+
+    QJsonObject results;
+    for (const auto &[name, policy] : policies)
+    {
+        QTextStream(stderr) << "tether_bench: append, sync policy \"" << name << "\"...\n";
+        worker.setSyncPolicy(policy);
+        const QString path = directory + "/append_" + name + ".jsonl";
+        QElapsedTimer clock;
+        clock.start();
+        for (const ChatMessage &msg : history)
+            JournalFile(path).append(msg);
+        worker.drain();
+        const double seconds = clock.nsecsElapsed() / 1e9;
+        results[name] = QJsonObject{{"messages", history.size()},
+                                    {"seconds", seconds},
+                                    {"msgsPerSec", history.size() / qMax(seconds, 1e-9)}};
+        JournalFile(path).remove();
+    }
+    worker.setSyncPolicy(initial);
+    return results;
+}
+
+// Texts of the live records of `path`, read back like JournalReader does.
+QStringList liveTexts(const QString &path)
+{
+    QFile file;
+    QList<qint64> offsets;
+    qint64 end = 0;
+    QStringList texts;
+    if (!JournalFile(path).openLive(file, offsets, end))
+        return texts;
+    for (qsizetype i = 0; i < offsets.size(); ++i)
+    {
+        const qint64 to = (i + 1 < offsets.size()) ? offsets.at(i + 1) : end;
+        if (!file.seek(offsets.at(i)))
+            break;
+        ChatMessage message;
+        if (JsonlScanner::parseMessage(file.read(to - offsets.at(i)).trimmed(), message))
+            texts.append(message.text());
+        else
+            texts.append(QString()); // Ligne illisible : compte comme un écart
+    }
+    return texts;
+}
+
+// Crash-injection harness of the journal recovery. Each trial writes a small
+// journal, moves its watermark, then damages one of the last records of a
+// copy, as a crash or a bad sector would, before the copy is opened for the
+// first time (the recovery pass of a restart):
+//   truncate  the journal is cut at a random byte of the record: it and the
+//             following ones are dropped, unless the cut only lost its '\n';
+//   corrupt   one byte of the record is changed: the CRC32C check rejects it
+//             and keeps every other record.
+// A trial fails if the live records read back differ from the expected ones,
+// which also covers the watermark (the first live record).
+QJsonObject crashHarness(const Options &options, const QString &directory)
+{
+    const int kRecords = 64;
+    const int kTail = 8; // Records exposés aux dégâts
+    QRandomGenerator random(options.profile.seed);
+    int failures = 0;
+    QMap<QString, int> trials;
+    QTextStream(stderr) << "tether_bench: " << options.crashTrials << " crash trials...\n";
+
+    for (int t = 0; t < options.crashTrials; ++t)
+    {
+        // Textes courts : le préfixe coupé ne déclenche jamais de compaction
+        const QList<ChatMessage> history = syntheticHistory(kRecords, 120);
+        const int culled = 1 + random.bounded(kRecords / 2);
+        const QString source = directory + QString("/crash_source_%1.jsonl").arg(t);
+        for (const ChatMessage &msg : history)
+            JournalFile(source).append(msg);
+        JournalFile(source).cull(culled);
+        IoWorker::instance().drain();
+
+        QFile journal(source);
+        const QByteArray bytes =
+            journal.open(QIODevice::ReadOnly) ? journal.readAll() : QByteArray();
+        journal.close();
+        QList<qint64> starts{0};
+        for (qsizetype i = bytes.indexOf('\n'); i >= 0 && i + 1 < bytes.size();
+             i = bytes.indexOf('\n', i + 1))
+            starts.append(i + 1);
+        // Copie jamais ouverte par ce processus : son premier accès la vérifie
+        const QString path = directory + QString("/crash_%1.jsonl").arg(t);
+        QFile damaged(path);
+        if (starts.size() != kRecords || !bytes.endsWith('\n') || !QFile::copy(source, path) ||
+            !QFile::copy(source + ".idx", path + ".idx") || !damaged.open(QIODevice::ReadWrite))
+        {
+            qWarning() << "tether_bench: cannot prepare crash trial" << t << "from" << source;
+            ++failures;
+            continue;
+        }
+        const int record = kRecords - 1 - random.bounded(kTail);
+        const qint64 lineStart = starts.at(record);
+        const qint64 lineEnd = ((record + 1 < kRecords) ? starts.at(record + 1) : bytes.size()) - 1;
+        const bool truncate = random.bounded(2) == 0;
+        QStringList expected;
+        for (int i = culled; i < kRecords; ++i)
+            expected.append(history.at(i).text());
+
+        if (truncate)
+        {
+            const qint64 cut = lineStart + random.bounded(int(lineEnd - lineStart + 1));
+            damaged.resize(cut);
+            // Seul le '\n' perdu : la ligne complète est gardée
+            expected = expected.mid(0, record - culled + (cut == lineEnd ? 1 : 0));
+        }
+        else
+        {
+            const qint64 at = lineStart + random.bounded(int(lineEnd - lineStart));
+            char byte = bytes.at(at);
+            do
+                byte = char(byte ^ (1 + random.bounded(255)));
+            while (byte == '\n' || byte == bytes.at(at));
+            damaged.seek(at);
+            damaged.write(&byte, 1);
+            expected.removeAt(record - culled);
+        }
+        damaged.close();
+
+        trials[truncate ? "truncate" : "corrupt"]++;
+        const QStringList live = liveTexts(path);
+        if (live != expected)
+        {
+            ++failures;
+            qWarning() << "tether_bench: crash trial" << t << (truncate ? "truncate" : "corrupt")
+                       << "record" << record << "- expected" << expected.size()
+                       << "live records, read" << live.size();
+        }
+        JournalFile(source).remove();
+        JournalFile(path).remove();
+    }
+    IoWorker::instance().drain();
+    return QJsonObject{{"trials", options.crashTrials},
+                       {"truncate", trials.value("truncate")},
+                       {"corrupt", trials.value("corrupt")},
+                       {"failures", failures}};
+}
+
+// Synthetic embeddings with the structure of real ones: points of a
+// low-dimensional latent space, grouped in clusters, spread over `dimension`
+// by a fixed random projection, plus a little noise. Uniform random vectors
+// would have no near neighbours at all and tell nothing about the recall.
+class VectorSource
+{
+public:
+    VectorSource(int dimension, quint32 seed)
+        : m_dimension(dimension)
+        , m_random(seed)
+    {
+        std::normal_distribution<float> normal;
+        m_projection.resize(kLatent * dimension);
+        for (float &x : m_projection)
+            x = normal(m_random);
+        m_centroids.resize(kClusters * kLatent);
+        for (float &x : m_centroids)
+            x = normal(m_random);
+    }
+
+    QList<float> next()
+    {
+        std::normal_distribution<float> spread(0.0f, 0.5f);
+        std::normal_distribution<float> noise(0.0f, 0.1f);
+        const float *centroid = m_centroids.constData() + m_random.bounded(kClusters) * kLatent;
+        float latent[kLatent];
+        for (int j = 0; j < kLatent; ++j)
+            latent[j] = centroid[j] + spread(m_random);
+        QList<float> vector(m_dimension);
+        for (int i = 0; i < m_dimension; ++i)
+        {
+            const float *row = m_projection.constData() + i * kLatent;
+            float x = noise(m_random);
+            for (int j = 0; j < kLatent; ++j)
+                x += row[j] * latent[j];
+            vector[i] = x;
+        }
+        return vector;
+    }
+
+private:
+    static const int kLatent = 32;
+    static const int kClusters = 256;
+    const int m_dimension;
+    QRandomGenerator m_random;
+    QList<float> m_projection; // m_dimension lignes de kLatent
+    QList<float> m_centroids;
+};
+
+// Recall@k against latency of EmbeddingStore, flat scan against HNSW. One
+// store grows through --vector-sizes; at each size the same queries (drawn
+// from the stored distribution, not stored themselves) go through
+// searchExact() — the flat scan, reference of the recall — and search(),
+// which switches to the graph from EmbeddingStore::kHnswMinVectors on.
+// "recallAtK" is the mean share of the exact top k found by search();
+// "acceptable" compares it with --min-recall once the graph is in use.
+QJsonObject benchEmbeddings(const Options &options, const QString &directory)
+{
+    if (options.vectorSizes.isEmpty())
+        return {};
+    const QString path = directory + "/bench_archive.jsonl.vec";
+    QFile::remove(path);
+    EmbeddingStore store(path, options.vectorDimension, "bench-synthetic");
+    if (!store.open())
+        return {};
+
+    VectorSource source(options.vectorDimension, options.profile.seed);
+    QList<QList<float>> queries;
+    for (int q = 0; q < options.samples; ++q)
+        queries.append(source.next());
+    const int k = options.recallK;
+
+    QJsonArray stores;
+    for (int size : std::as_const(options.vectorSizes))
+    {
+        QTextStream(stderr) << "tether_bench: embedding store, " << size << " vectors...\n";
+        QElapsedTimer build;
+        build.start();
+        while (store.size() < size)
+        {
+            // Par paquets, comme l'indexation de l'archive ; le graphe suit
+            QList<QList<float>> chunk;
+            const qsizetype count = qMin<qsizetype>(10000, size - store.size());
+            chunk.reserve(count);
+            for (qsizetype i = 0; i < count; ++i)
+                chunk.append(source.next());
+            if (!store.append(chunk))
+                return {};
+        }
+        const double buildSeconds = build.nsecsElapsed() / 1e9;
+
+        Samples flat;
+        Samples indexed;
+        double recall = 0;
+        for (const QList<float> &query : std::as_const(queries))
+        {
+            QElapsedTimer clock;
+            clock.start();
+            const QList<EmbeddingStore::Hit> exact = store.searchExact(query, k);
+            flat.add(clock.nsecsElapsed());
+            clock.start();
+            const QList<EmbeddingStore::Hit> found = store.search(query, k);
+            indexed.add(clock.nsecsElapsed());
+
+            QSet<qint32> expected;
+            for (const EmbeddingStore::Hit &hit : exact)
+                expected.insert(hit.id);
+            int matches = 0;
+            for (const EmbeddingStore::Hit &hit : found)
+                matches += expected.contains(hit.id) ? 1 : 0;
+            recall += exact.isEmpty() ? 1.0 : double(matches) / exact.size();
+        }
+        recall /= qMax<qsizetype>(1, queries.size());
+        const bool graph = store.size() >= EmbeddingStore::kHnswMinVectors;
+        QJsonObject search = indexed.toJson();
+        search["mode"] = graph ? "hnsw" : "flat";
+        stores.append(QJsonObject{{"vectors", store.size()},
+                                  {"buildSeconds", buildSeconds},
+                                  {"flat", flat.toJson()},
+                                  {"search", search},
+                                  {"recallAtK", recall},
+                                  {"acceptable", !graph || recall >= options.minRecall}});
+    }
+    store.clear();
+    QFile::remove(path);
+    return QJsonObject{{"dimension", options.vectorDimension},
+                       {"k", k},
+                       {"queries", queries.size()},
+                       {"minRecall", options.minRecall},
+                       {"hnswMinVectors", qint64(EmbeddingStore::kHnswMinVectors)},
+                       {"kernel", EmbeddingStore::kernelName()},
+                       {"stores", stores}};
+}
+
+void printSummary(const QJsonArray &runs)
+{
+    QTextStream out(stderr);
+    for (const QJsonValue &run : runs)
+    {
+        const QJsonObject bytes = run["messageBytes"].toObject();
+        out << "\n" << run["messages"].toInt() << " messages ("
+            << bytes["record"].toInt() << " + "
+            << QString::number(bytes["text"].toDouble(), 'f', 0) << " bytes per message, was "
+            << bytes["previousRecord"].toInt() << " + "
+            << QString::number(bytes["previousText"].toDouble(), 'f', 0) << ")\n";
+        const QJsonObject metrics = run["metrics"].toObject();
+        for (auto it = metrics.begin(); it != metrics.end(); ++it)
+        {
+            const QJsonObject m = it.value().toObject();
+            out << "  " << it.key().leftJustified(20) << " p50 "
+                << QString::number(m["p50Us"].toDouble(), 'f', 1).rightJustified(12) << " us   p99 "
+                << QString::number(m["p99Us"].toDouble(), 'f', 1).rightJustified(12) << " us   ("
+                << m["samples"].toInt() << " samples)\n";
+        }
+    }
+}
+void printTokenizers(const QJsonObject &tokenizers)
+{
+    QTextStream out(stderr);
+    if (!tokenizers.isEmpty())
+        out << "\nTokenizers (MB/s)\n";
+    for (auto it = tokenizers.begin(); it != tokenizers.end(); ++it)
+    {
+        const QJsonObject t = it.value().toObject();
+        out << "  " << it.key().leftJustified(20) << " cold "
+            << QString::number(t["coldMBps"].toDouble(), 'f', 2).rightJustified(9) << "   warm "
+            << QString::number(t["warmMBps"].toDouble(), 'f', 2).rightJustified(9)
+            << (t["vocabulary"].toString() == "synthetic" ? "   (synthetic vocabulary)\n" : "\n");
+    }
+}
+// HTTP response as the providers send it; `declaredLength` larger than the
+// body makes a reply cut short when the connection closes.
+QByteArray httpResponse(int status, const QList<QByteArray> &headers, const QByteArray &body,
+                        qint64 declaredLength = -1)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) +
+                          " Mock\r\nContent-Type: application/json\r\nConnection: close\r\n"
+                          "Content-Length: " +
+                          QByteArray::number(declaredLength < 0 ? body.size() : declaredLength) +
+                          "\r\n";
+    for (const QByteArray &header : headers)
+        response += header + "\r\n";
+    return response + "\r\n" + body;
+}
+
+// Loopback server of the retry scenarios: each request gets the next canned
+// response (then a plain 200) on its own connection, and its arrival time is
+// recorded. Unlike tether_mockserver and its random failure rates, the
+// sequence is fixed, so the delays between attempts can be checked.
+class ScriptedServer : public QTcpServer
+{
+public:
+    explicit ScriptedServer(const QList<QByteArray> &responses)
+        : m_responses(responses)
+    {
+        m_clock.start();
+        if (!listen(QHostAddress::LocalHost))
+            qWarning() << "tether_bench: cannot listen on the loopback:" << errorString();
+    }
+
+    QUrl url(const QString &path) const
+    {
+        return QUrl(QString("http://127.0.0.1:%1%2").arg(serverPort()).arg(path));
+    }
+
+    // Temps écoulé entre deux requêtes reçues, en ms
+    QList<qint64> gaps() const
+    {
+        QList<qint64> gaps;
+        for (qsizetype i = 1; i < m_arrivals.size(); ++i)
+            gaps.append(m_arrivals.at(i) - m_arrivals.at(i - 1));
+        return gaps;
+    }
+    int requests() const { return int(m_arrivals.size()); }
+
+protected:
+    void incomingConnection(qintptr descriptor) override
+    {
+        auto *socket = new QTcpSocket(this);
+        if (!socket->setSocketDescriptor(descriptor))
+        {
+            delete socket;
+            return;
+        }
+        auto buffer = std::make_shared<QByteArray>();
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket,
+                         [this, socket, buffer]()
+                         {
+                             *buffer += socket->readAll();
+                             const qsizetype headerEnd = buffer->indexOf("\r\n\r\n");
+                             if (headerEnd < 0)
+                                 return;
+                             qint64 length = 0;
+                             for (const QByteArray &line : buffer->left(headerEnd).split('\n'))
+                             {
+                                 if (line.toLower().startsWith("content-length:"))
+                                     length = line.mid(15).trimmed().toLongLong();
+                             }
+                             if (buffer->size() < headerEnd + 4 + length)
+                                 return;
+                             buffer->clear();
+                             m_arrivals.append(m_clock.elapsed());
+                             socket->write(m_responses.isEmpty()
+                                               ? httpResponse(200, {}, "{}")
+                                               : m_responses.takeFirst());
+                             socket->disconnectFromHost();
+                         });
+    }
+
+private:
+    QList<QByteArray> m_responses;
+    QElapsedTimer m_clock;
+    QList<qint64> m_arrivals;
+};
+
+// One request through NetworkService, as the interlocutors send it, until its
+// end. `upload`: a multipart file upload, never retried.
+QNetworkReply *sendScripted(const ScriptedServer &server, QObject *owner,
+                            const NetworkService::RetryPolicy &policy, bool upload = false)
+{
+    QNetworkRequest request(server.url(upload ? "/v1/files" : "/v1/responses"));
+    QNetworkReply *reply = nullptr;
+    if (upload)
+    {
+        auto *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+        QHttpPart part;
+        part.setHeader(QNetworkRequest::ContentDispositionHeader,
+                       "form-data; name=\"file\"; filename=\"notes.txt\"");
+        part.setBody("tether_bench");
+        multiPart->append(part);
+        reply = NetworkService::instance().post(request, multiPart, owner);
+    }
+    else
+    {
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        reply = NetworkService::instance().post(request, "{\"model\":\"bench\"}", owner,
+                                                NetworkService::Priority::Interactive, policy);
+    }
+    waitFor(reply, &QNetworkReply::finished, [reply]() { return reply->isFinished(); });
+    return reply;
+}
+
+// Retry and rate-limit scenarios of NetworkService against ScriptedServer:
+//   retry.429          429 with Retry-After: 1, then 200: one retry, after
+//                      the second asked for (the backoff alone would be 50 ms)
+//   retry.503          two 503 without Retry-After, then 200: exponential
+//                      backoff with jitter, [100, 200] then [200, 400] ms
+//   retry.tooLong      Retry-After beyond retryMaxMs: no retry, the 429 is
+//                      the answer
+//   rateLimit.pacing   200 saying the request quota is spent until 1 s: the
+//                      next request to the host waits for the reset
+//   noReplay.upload    503 on a file upload: not sent again (not idempotent)
+//   noReplay.stream    connection lost in the middle of a 200: the part
+//                      already passed on is not replayed
+// Delays are checked with a 10% margin below (coarse timers) and 500 ms
+// above.
+QJsonObject benchRetries()
+{
+    QTextStream(stderr) << "tether_bench: retry scenarios...\n";
+    QObject owner;
+    NetworkService::RetryPolicy policy;
+    policy.maxRetries = 4;
+    policy.baseDelayMs = 50;
+    policy.maxDelayMs = 30000;
+    auto within = [](qint64 gap, qint64 low, qint64 high)
+    { return gap >= low * 9 / 10 && gap <= high + 500; };
+
+    QJsonObject scenarios;
+    int failures = 0;
+    auto record = [&](const QString &name, const ScriptedServer &server, QNetworkReply *reply,
+                      bool passed)
+    {
+        QJsonArray gaps;
+        for (qint64 gap : server.gaps())
+            gaps.append(gap);
+        scenarios[name] = QJsonObject{
+            {"requests", server.requests()},
+            {"gapsMs", gaps},
+            {"status", reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt()},
+            {"error", reply->error() == QNetworkReply::NoError ? QString() : reply->errorString()},
+            {"passed", passed}};
+        if (!passed)
+        {
+            ++failures;
+            qWarning() << "tether_bench: retry scenario" << name << "failed:"
+                       << scenarios.value(name);
+        }
+    };
+    auto status = [](QNetworkReply *reply)
+    { return reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(); };
+
+    {
+        ScriptedServer server({httpResponse(429, {"Retry-After: 1"}, "{}")});
+        QNetworkReply *reply = sendScripted(server, &owner, policy);
+        record("retry.429", server, reply,
+               server.requests() == 2 && within(server.gaps().value(0), 1000, 1000) &&
+                   status(reply) == 200);
+    }
+    {
+        NetworkService::RetryPolicy backoff = policy;
+        backoff.baseDelayMs = 200;
+        ScriptedServer server({httpResponse(503, {}, "{}"), httpResponse(503, {}, "{}")});
+        QNetworkReply *reply = sendScripted(server, &owner, backoff);
+        record("retry.503", server, reply,
+               server.requests() == 3 && within(server.gaps().value(0), 100, 200) &&
+                   within(server.gaps().value(1), 200, 400) && status(reply) == 200);
+    }
+    {
+        NetworkService::RetryPolicy patient = policy;
+        patient.maxDelayMs = 5000;
+        ScriptedServer server({httpResponse(429, {"Retry-After: 60"}, "{}")});
+        QNetworkReply *reply = sendScripted(server, &owner, patient);
+        record("retry.tooLong", server, reply, server.requests() == 1 && status(reply) == 429);
+    }
+    {
+        ScriptedServer server({httpResponse(200,
+                                            {"x-ratelimit-limit-requests: 60",
+                                             "x-ratelimit-remaining-requests: 0",
+                                             "x-ratelimit-reset-requests: 1s"},
+                                            "{}")});
+        const bool first = status(sendScripted(server, &owner, policy)) == 200;
+        QNetworkReply *reply = sendScripted(server, &owner, policy);
+        record("rateLimit.pacing", server, reply,
+               first && server.requests() == 2 && within(server.gaps().value(0), 1000, 1000) &&
+                   status(reply) == 200);
+    }
+    {
+        ScriptedServer server({httpResponse(503, {}, "{}")});
+        QNetworkReply *reply = sendScripted(server, &owner, policy, true);
+        record("noReplay.upload", server, reply, server.requests() == 1 && status(reply) == 503);
+    }
+    {
+        ScriptedServer server({httpResponse(200, {}, QByteArray(64, ' '), 4096)});
+        QNetworkReply *reply = sendScripted(server, &owner, policy);
+        const qint64 delivered = reply->readAll().size();
+        record("noReplay.stream", server, reply,
+               server.requests() == 1 && delivered > 0 && reply->error() != QNetworkReply::NoError);
+    }
+    return QJsonObject{{"scenarios", scenarios}, {"failures", failures}};
+}
+
+// False if a store using the graph missed the recall threshold.
+bool printEmbeddings(const QJsonObject &embeddings)
+{
+    QTextStream out(stderr);
+    bool acceptable = true;
+    if (!embeddings.isEmpty())
+        out << "\nEmbedding store (recall@" << embeddings["k"].toInt() << ", "
+            << embeddings["kernel"].toString() << " kernel)\n";
+    for (const QJsonValue &value : embeddings["stores"].toArray())
+    {
+        const QJsonObject s = value.toObject();
+        const QJsonObject search = s["search"].toObject();
+        out << "  " << QString::number(s["vectors"].toInteger()).rightJustified(8)
+            << " vectors   flat p50 "
+            << QString::number(s["flat"].toObject()["p50Us"].toDouble(), 'f', 1).rightJustified(10)
+            << " us   " << search["mode"].toString() << " p50 "
+            << QString::number(search["p50Us"].toDouble(), 'f', 1).rightJustified(10)
+            << " us   recall " << QString::number(s["recallAtK"].toDouble(), 'f', 3)
+            << (s["acceptable"].toBool() ? "\n" : "   (below --min-recall)\n");
+        acceptable = acceptable && s["acceptable"].toBool();
+    }
+    return acceptable;
+}
+
+void printJournal(const QJsonObject &append, const QJsonObject &recovery)
+{
+    QTextStream out(stderr);
+    if (!append.isEmpty())
+        out << "\nJournal appends (msgs/s)\n";
+    for (auto it = append.begin(); it != append.end(); ++it)
+        out << "  " << it.key().leftJustified(20)
+            << QString::number(it.value().toObject()["msgsPerSec"].toDouble(), 'f', 0)
+                   .rightJustified(12)
+            << "\n";
+    if (!recovery.isEmpty())
+        out << "\nCrash recovery: " << recovery["failures"].toInt() << " failures in "
+            << recovery["trials"].toInt() << " trials (" << recovery["truncate"].toInt()
+            << " truncated, " << recovery["corrupt"].toInt() << " corrupted)\n";
+}
+void printRetries(const QJsonObject &retries)
+{
+    QTextStream out(stderr);
+    const QJsonObject scenarios = retries["scenarios"].toObject();
+    if (!scenarios.isEmpty())
+        out << "\nRetry scenarios\n";
+    for (auto it = scenarios.begin(); it != scenarios.end(); ++it)
+    {
+        const QJsonObject s = it.value().toObject();
+        QStringList gaps;
+        for (const QJsonValue &gap : s["gapsMs"].toArray())
+            gaps.append(QString::number(gap.toInteger()));
+        out << "  " << it.key().leftJustified(20) << (s["passed"].toBool() ? "ok    " : "FAILED")
+            << "  " << s["requests"].toInt() << " requests, status " << s["status"].toInt()
+            << (gaps.isEmpty() ? QString() : ", gaps " + gaps.join('/') + " ms") << "\n";
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName("Tether");
+    app.setApplicationName("tether_bench");
+    // Seul emprunt aux dossiers de l'utilisateur, en lecture : ses vocabulaires
+    const QString userVocabularies = Tokenizer::vocabularyDirectory();
+    QStandardPaths::setTestMode(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Latency benchmark of Tether's chat, curation and journal "
+                                     "hot paths (JSON report on stdout).");
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption("sizes", "History sizes, in messages.", "list",
+                                         "1000,10000,100000");
+    const QCommandLineOption samplesOption("samples", "Samples of the per-turn operations.", "n",
+                                           "200");
+    const QCommandLineOption loadSamplesOption(
+        "load-samples", "Samples of the whole-history operations (load, cull, rewrite).", "n",
+        "10");
+    const QCommandLineOption messageCharsOption("message-chars",
+                                                "Size of the synthetic messages.", "n", "400");
+    const QCommandLineOption latencyOption("latency-ms", "Median reply latency.", "ms", "0");
+    const QCommandLineOption spreadOption("latency-spread",
+                                          "Log-normal spread of the latency (0: fixed).", "sigma",
+                                          "0");
+    const QCommandLineOption replyCharsOption(
+        "reply-chars", "Size of the replies (0: the last message echoed).", "n", "400");
+    const QCommandLineOption inputTokensOption(
+        "input-tokens", "Input tokens reported per reply (-1: counted).", "n", "-1");
+    const QCommandLineOption outputTokensOption(
+        "output-tokens", "Output tokens reported per reply (-1: counted).", "n", "-1");
+    const QCommandLineOption errorRateOption("error-rate", "Share of failed requests.", "rate",
+                                             "0");
+    const QCommandLineOption seedOption("seed", "Random seed of the synthetic interlocutor.", "n",
+                                        "1");
+    const QCommandLineOption outputOption("output", "Write the JSON report to this file.", "path");
+    const QCommandLineOption traceOption(
+        "trace", "Write the spans recorded by the Tracer to this file (Chrome trace format).",
+        "path");
+    const QCommandLineOption vocabOption(
+        "vocab-dir", "Folder of the tokenizer vocabularies (.tiktoken, .vocab).", "path",
+        userVocabularies);
+    const QCommandLineOption appendOption(
+        "append-messages", "Journal appends timed under each sync policy.", "n", "2000");
+    const QCommandLineOption crashOption(
+        "crash-trials", "Truncated or corrupted journals checked by the recovery harness.", "n",
+        "200");
+    const QCommandLineOption vectorSizesOption(
+        "vector-sizes", "Sizes of the synthetic embedding store (recall@k vs latency).", "list",
+        "10000,50000,200000,1000000");
+    const QCommandLineOption vectorDimensionOption("vector-dim",
+                                                   "Dimension of the synthetic embeddings.", "n",
+                                                   "256");
+    const QCommandLineOption recallKOption("recall-k", "Hits compared for the recall.", "k", "10");
+    const QCommandLineOption minRecallOption(
+        "min-recall", "Lowest acceptable HNSW recall@k against the flat scan.", "rate", "0.9");
+    const QCommandLineOption suitesOption(
+        "suites", "Sections to run, among " + kSuites.join(',') + ".", "list", kSuites.join(','));
+    const QCommandLineOption verboseOption("verbose", "Keep the debug output of the models.");
+    parser.addOptions({sizesOption, samplesOption, loadSamplesOption, messageCharsOption,
+                       latencyOption, spreadOption, replyCharsOption, inputTokensOption,
+                       outputTokensOption, errorRateOption, seedOption, outputOption,
+                       traceOption, vocabOption, appendOption, crashOption, vectorSizesOption,
+                       vectorDimensionOption, recallKOption, minRecallOption, suitesOption,
+                       verboseOption});
+    parser.process(app);
+
+    Options options;
+    options.sizes = parseSizes(parser.value(sizesOption));
+    options.samples = qMax(1, parser.value(samplesOption).toInt());
+    options.loadSamples = qMax(1, parser.value(loadSamplesOption).toInt());
+    options.messageChars = qMax(16, parser.value(messageCharsOption).toInt());
+    options.profile.latencyMs = qMax(0, parser.value(latencyOption).toInt());
+    options.profile.latencySpread = parser.value(spreadOption).toDouble();
+    options.profile.replyChars = qMax(0, parser.value(replyCharsOption).toInt());
+    options.profile.inputTokens = parser.value(inputTokensOption).toInt();
+    options.profile.outputTokens = parser.value(outputTokensOption).toInt();
+    options.profile.errorRate = qBound(0.0, parser.value(errorRateOption).toDouble(), 1.0);
+    options.profile.seed = parser.value(seedOption).toUInt();
+    options.vocabularyDirectory = parser.value(vocabOption);
+    options.appendMessages = qMax(1, parser.value(appendOption).toInt());
+    options.crashTrials = qMax(0, parser.value(crashOption).toInt());
+    options.vectorSizes = parseSizes(parser.value(vectorSizesOption));
+    std::sort(options.vectorSizes.begin(), options.vectorSizes.end());
+    options.vectorDimension = qMax(8, parser.value(vectorDimensionOption).toInt());
+    options.recallK = qMax(1, parser.value(recallKOption).toInt());
+    options.minRecall = qBound(0.0, parser.value(minRecallOption).toDouble(), 1.0);
+    for (const QString &suite : parser.value(suitesOption).split(',', Qt::SkipEmptyParts))
+    {
+        if (kSuites.contains(suite.trimmed()))
+            options.suites.insert(suite.trimmed());
+        else
+            qWarning() << "tether_bench: unknown suite" << suite << "- expected one of" << kSuites;
+    }
+    g_verbose = parser.isSet(verboseOption);
+    qInstallMessageHandler(messageHandler);
+    if (options.sizes.isEmpty())
+    {
+        qWarning() << "tether_bench: no valid size in --sizes.";
+        return 1;
+    }
+    if (options.suites.isEmpty())
+    {
+        qWarning() << "tether_bench: no valid suite in --suites.";
+        return 1;
+    }
+
+    QTemporaryDir directory;
+    if (!directory.isValid())
+    {
+        qWarning() << "tether_bench: cannot create a temporary directory.";
+        return 1;
+    }
+
+    auto selected = [&options](const char *suite) { return options.suites.contains(suite); };
+    QJsonArray runs;
+    if (selected("history"))
+    {
+        Bench bench(options, directory.path());
+        for (int size : std::as_const(options.sizes))
+            runs.append(bench.run(size));
+    }
+    const QJsonObject tokenizers =
+        selected("tokenizers") ? benchTokenizers(options, directory.path()) : QJsonObject();
+    const QJsonObject append =
+        selected("append") ? benchAppend(options, directory.path()) : QJsonObject();
+    const QJsonObject recovery =
+        selected("recovery") ? crashHarness(options, directory.path()) : QJsonObject();
+    const QJsonObject embeddings =
+        selected("embeddings") ? benchEmbeddings(options, directory.path()) : QJsonObject();
+    const QJsonObject retries = selected("retries") ? benchRetries() : QJsonObject();
+    QThreadPool::globalInstance()->waitForDone();
+    IoWorker::instance().shutdown();
+
+    const DummyInterlocutor::Profile &p = options.profile;
+    QJsonArray suites;
+    for (const QString &suite : kSuites)
+    {
+        if (options.suites.contains(suite))
+            suites.append(suite);
+    }
+    const QJsonObject report{
+        {"benchmark", "tether_bench"},
+        {"qtVersion", qVersion()},
+        {"timestamp", QDateTime::currentDateTime().toString(Qt::ISODate)},
+        {"config",
+         QJsonObject{{"samples", options.samples},
+                     {"loadSamples", options.loadSamples},
+                     {"messageChars", options.messageChars},
+                     {"latencyMs", p.latencyMs},
+                     {"latencySpread", p.latencySpread},
+                     {"replyChars", p.replyChars},
+                     {"inputTokens", p.inputTokens},
+                     {"outputTokens", p.outputTokens},
+                     {"errorRate", p.errorRate},
+                     {"seed", qint64(p.seed)},
+                     {"suites", suites}}},
+        {"runs", runs},
+        {"tokenizers", tokenizers},
+        {"append", append},
+        {"recovery", recovery},
+        {"embeddings", embeddings},
+        {"retries", retries}};
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    printSummary(runs);
+    printTokenizers(tokenizers);
+    printJournal(append, recovery);
+    const bool recallAcceptable = printEmbeddings(embeddings);
+    printRetries(retries);
+    if (parser.isSet(traceOption))
+    {
+        // Les anneaux ne gardent que les derniers événements de chaque fil
+        QFile file(parser.value(traceOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+            file.write(Tracer::instance().chromeTrace()) < 0)
+        {
+            qWarning() << "tether_bench: cannot write" << file.fileName();
+            return 1;
+        }
+    }
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) < 0)
+        {
+            qWarning() << "tether_bench: cannot write" << file.fileName();
+            return 1;
+        }
+    }
+    else
+    {
+        QTextStream(stdout) << json;
+    }
+    const bool passed =
+        recovery["failures"].toInt() == 0 && retries["failures"].toInt() == 0 && recallAcceptable;
+    return passed ? 0 : 1;
+}
+// End Source File bench.cpp
@@ -4,9 +4,12 @@
 #include <QQmlContext>
 #include <QTimer>
 #include "ChatManager.h" // Inclure le nouveau manager
-#include "DuoChatModel.h"
+#include "Diagnostics.h"
+#include "GroupChatModel.h"
 #include "InterlocutorConfig.h"
+#include "IoWorker.h"
 #include "ManagedFile.h"
+#include "NetworkService.h"
 #include "settings.h"
 
 #define APP_NAME "TetherChat"
@@ -28,7 +31,7 @@ int main(int argc, char *argv[])
     // --- Enregistrement des types QML ---
     // Ces types doivent être connus de QML, mais on ne les crée pas depuis QML.
     qmlRegisterUncreatableType<ChatModel>(APP_NAME, MAJOR_VERSION, MINOR_VERSION, "ChatModel", "Cannot create ChatModel in QML.");
-    qmlRegisterUncreatableType<DuoChatModel>(APP_NAME, MAJOR_VERSION, MINOR_VERSION, "DuoChatModel", "Cannot create DuoChatModel in QML.");
+    qmlRegisterUncreatableType<GroupChatModel>(APP_NAME, MAJOR_VERSION, MINOR_VERSION, "GroupChatModel", "Cannot create GroupChatModel in QML.");
     qmlRegisterUncreatableType<Settings>(APP_NAME, MAJOR_VERSION, MINOR_VERSION , "Settings", "Cannot create Settings in QML.");
     // Pas besoin d'enregistrer ChatMessage s'il n'est utilisé que dans le modèle
     qmlRegisterType<InterlocutorConfig>(APP_NAME, MAJOR_VERSION, MINOR_VERSION, "InterlocutorConfig");
@@ -50,6 +53,14 @@ int main(int argc, char *argv[])
     ChatManager chatManager;
     engine.rootContext()->setContextProperty("_chatManager", &chatManager);
 
+    // File d'attente des requêtes (profondeur affichée dans l'en-tête)
+    engine.rootContext()->setContextProperty("_requestScheduler",
+                                             NetworkService::instance().scheduler());
+
+    // Onglet Diagnostics : mesures du Tracer
+    Diagnostics diagnostics;
+    engine.rootContext()->setContextProperty("_diagnostics", &diagnostics);
+
 
     QObject::connect(&settings, &Settings::retranslate, &app, [&engine, &settings]() {
         engine.retranslate();
@@ -83,6 +94,10 @@ int main(int argc, char *argv[])
         Qt::QueuedConnection);
     engine.load(url);
 
-    return app.exec();
+    const int status = app.exec();
+    // Écritures encore en file (journaux, mémoire, notes) : posées et
+    // synchronisées sur le disque avant de quitter.
+    IoWorker::instance().shutdown();
+    return status;
 }
 // End source file main.cpp
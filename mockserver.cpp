@@ -0,0 +1,731 @@
+// Begin Source File mockserver.cpp
+//
+// tether_mockserver — local stand-in for the providers' APIs.
+//
+// A plain HTTP/1.1 server (QTcpServer, keep-alive) that answers the routes
+// Tether calls, in each provider's wire format, so that the whole network
+// stack (NetworkService, RetryingReply, RequestScheduler, the interlocutors'
+// parsers) can be load-tested without network access:
+//   OpenAI     POST .../responses (JSON or SSE), .../responses/input_tokens,
+//              .../files (upload), DELETE .../files/<id>, .../embeddings
+//   DeepSeek   POST .../chat/completions (JSON or SSE, [DONE], usage chunk)
+//   Anthropic  POST .../messages (JSON or SSE: message_start ... message_stop)
+//   Google     POST .../models/<m>:generateContent, :streamGenerateContent
+//              (alt=sse), /upload/<v>/files, DELETE /<v>/files/<id>
+// Point Tether at it with the "network/endpointOverride" setting
+// ("http://127.0.0.1:8089"): the paths of the real endpoints select the
+// provider.
+//
+// Replies wait --latency-ms before the first byte, then stream their events
+// (or, for JSON replies, slices of the body) --drip-ms apart. --rate-429 and
+// --error-rate inject failures; --rpm makes the server announce, and enforce,
+// a per-minute request quota through the providers' rate-limit headers.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimeZone>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+
+namespace
+{
+struct Options
+{
+    int latencyMs = 200;   // Avant le premier octet
+    int dripMs = 30;       // Entre deux événements SSE, ou deux tranches d'un corps JSON
+    int chunkWords = 3;    // Mots par événement SSE
+    int replyWords = 80;   // Taille des réponses
+    double rate429 = 0;    // Part des requêtes refusées (429)
+    double errorRate = 0;  // Part des requêtes en erreur (500)
+    int retryAfterS = 1;   // Retry-After des 429
+    int requestsPerMinute = 0; // Quota annoncé et appliqué ; 0 : aucun
+    bool quiet = false;
+};
+
+enum class Route
+{
+    OpenAIResponses,
+    OpenAIInputTokens,
+    OpenAIUpload,
+    OpenAIDelete,
+    Embeddings,
+    DeepSeekChat,
+    AnthropicMessages,
+    GoogleGenerate,
+    GoogleUpload,
+    GoogleDelete,
+    Unknown
+};
+
+struct Request
+{
+    QByteArray method;
+    QUrl url;
+    QHash<QByteArray, QByteArray> headers; // Noms en minuscules
+    QByteArray body;
+};
+
+struct Response
+{
+    int status = 200;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    QByteArray body;       // Réponse JSON, écrite en tranches si --drip-ms
+    QList<QByteArray> events; // Réponse SSE (blocs "event:/data:" complets)
+    bool streamed = false;
+};
+
+const QStringList kWords = QStringLiteral(
+    "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor incididunt "
+    "ut labore et dolore magna aliqua ut enim ad minim veniam quis nostrud exercitation")
+                               .split(' ');
+
+QByteArray json(const QJsonObject &object)
+{
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+QByteArray sseEvent(const QByteArray &type, const QJsonObject &data)
+{
+    QByteArray event;
+    if (!type.isEmpty())
+        event += "event: " + type + "\n";
+    return event + "data: " + json(data) + "\n\n";
+}
+
+QByteArray reasonPhrase(int status)
+{
+    switch (status)
+    {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 411: return "Length Required";
+    case 429: return "Too Many Requests";
+    default: return "Internal Server Error";
+    }
+}
+
+Route routeOf(const Request &request)
+{
+    const QString path = request.url.path();
+    if (request.method == "DELETE")
+    {
+        if (path.contains("/files/"))
+            return path.startsWith("/v1beta") || path.startsWith("/v1alpha") ? Route::GoogleDelete
+                                                                            : Route::OpenAIDelete;
+        return Route::Unknown;
+    }
+    if (request.method != "POST")
+        return Route::Unknown;
+    if (path.startsWith("/upload/"))
+        return Route::GoogleUpload;
+    if (path.contains(":generateContent") || path.contains(":streamGenerateContent"))
+        return Route::GoogleGenerate;
+    if (path.endsWith("/responses/input_tokens"))
+        return Route::OpenAIInputTokens;
+    if (path.endsWith("/responses"))
+        return Route::OpenAIResponses;
+    if (path.endsWith("/files"))
+        return Route::OpenAIUpload;
+    if (path.endsWith("/embeddings"))
+        return Route::Embeddings;
+    if (path.endsWith("/chat/completions"))
+        return Route::DeepSeekChat;
+    if (path.endsWith("/messages"))
+        return Route::AnthropicMessages;
+    return Route::Unknown;
+}
+
+// The whole server: options, counters and the per-minute quota.
+class MockServer : public QTcpServer
+{
+public:
+    explicit MockServer(const Options &options)
+        : m_options(options)
+    {
+        m_window.start();
+    }
+
+    const Options &options() const { return m_options; }
+    int nextSerial() { return ++m_serial; }
+
+    // Compte la requête dans la minute en cours ; faux si le quota est épuisé.
+    bool admit()
+    {
+        if (m_window.elapsed() >= 60000)
+        {
+            m_window.restart();
+            m_requestsThisMinute = 0;
+        }
+        ++m_requestsThisMinute;
+        return m_options.requestsPerMinute <= 0 ||
+               m_requestsThisMinute <= m_options.requestsPerMinute;
+    }
+
+    void addRateLimitHeaders(Route route, Response &response) const
+    {
+        if (m_options.requestsPerMinute <= 0)
+            return;
+        const int limit = m_options.requestsPerMinute;
+        const int remaining = qMax(0, limit - m_requestsThisMinute);
+        const qint64 resetMs = qMax<qint64>(1, 60000 - m_window.elapsed());
+        if (route == Route::AnthropicMessages)
+        {
+            const QDateTime resetAt =
+                QDateTime::currentDateTimeUtc().addMSecs(resetMs).toTimeZone(QTimeZone::UTC);
+            response.headers.append({"anthropic-ratelimit-requests-limit",
+                                     QByteArray::number(limit)});
+            response.headers.append({"anthropic-ratelimit-requests-remaining",
+                                     QByteArray::number(remaining)});
+            response.headers.append({"anthropic-ratelimit-requests-reset",
+                                     resetAt.toString(Qt::ISODate).toLatin1()});
+        }
+        else
+        {
+            response.headers.append({"x-ratelimit-limit-requests", QByteArray::number(limit)});
+            response.headers.append({"x-ratelimit-remaining-requests",
+                                     QByteArray::number(remaining)});
+            response.headers.append({"x-ratelimit-reset-requests",
+                                     QByteArray::number(resetMs) + "ms"});
+        }
+    }
+
+    qint64 quotaResetSeconds() const { return qMax<qint64>(1, (60000 - m_window.elapsed()) / 1000); }
+
+protected:
+    void incomingConnection(qintptr descriptor) override;
+
+private:
+    const Options m_options;
+    int m_serial = 0;
+    QElapsedTimer m_window;
+    int m_requestsThisMinute = 0;
+};
+
+// One client connection: requests are answered one at a time, in order.
+class Connection : public QObject
+{
+public:
+    Connection(MockServer *server, QTcpSocket *socket)
+        : QObject(socket)
+        , m_server(server)
+        , m_socket(socket)
+    {
+        connect(socket, &QTcpSocket::readyRead, this, &Connection::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+
+private:
+    void onReadyRead()
+    {
+        m_buffer += m_socket->readAll();
+        processNext();
+    }
+
+    void processNext()
+    {
+        if (m_busy)
+            return;
+        Request request;
+        const int parsed = parse(request);
+        if (parsed == 0)
+            return;
+        m_busy = true;
+        m_clock.start();
+        if (parsed < 0)
+        {
+            Response response;
+            response.status = 411;
+            response.body = json({{"error", QJsonObject{{"message", "Chunked request bodies "
+                                                                    "are not supported."}}}});
+            m_keepAlive = false;
+            send(request, Route::Unknown, response);
+            return;
+        }
+        const Route route = routeOf(request);
+        QTimer::singleShot(m_server->options().latencyMs, this,
+                           [this, request, route]() { send(request, route, answer(request, route)); });
+    }
+
+    // 1 : une requête complète ; 0 : il manque des octets ; -1 : refusée.
+    int parse(Request &request)
+    {
+        const qsizetype headerEnd = m_buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0)
+            return 0;
+        const QList<QByteArray> lines = m_buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() < 2)
+        {
+            m_buffer.clear();
+            return 0;
+        }
+        for (qsizetype i = 1; i < lines.size(); ++i)
+        {
+            const qsizetype colon = lines.at(i).indexOf(':');
+            if (colon > 0)
+                request.headers.insert(lines.at(i).left(colon).trimmed().toLower(),
+                                       lines.at(i).mid(colon + 1).trimmed());
+        }
+        request.method = requestLine.at(0);
+        request.url = QUrl::fromEncoded("http://" + request.headers.value("host", "localhost") +
+                                        requestLine.at(1));
+        m_keepAlive = request.headers.value("connection").toLower() != "close";
+        if (request.headers.value("transfer-encoding").toLower().contains("chunked"))
+        {
+            m_buffer.clear();
+            return -1;
+        }
+        const qsizetype length = request.headers.value("content-length").toLongLong();
+        if (m_buffer.size() < headerEnd + 4 + length)
+            return 0;
+        request.body = m_buffer.mid(headerEnd + 4, length);
+        m_buffer.remove(0, headerEnd + 4 + length);
+        return 1;
+    }
+
+    Response answer(const Request &request, Route route)
+    {
+        const Options &options = m_server->options();
+        Response response;
+        const bool admitted = m_server->admit();
+        m_server->addRateLimitHeaders(route, response);
+
+        QRandomGenerator *random = QRandomGenerator::global();
+        if (!admitted || random->generateDouble() < options.rate429)
+        {
+            const qint64 wait = admitted ? options.retryAfterS : m_server->quotaResetSeconds();
+            response.status = 429;
+            response.headers.append({"retry-after", QByteArray::number(wait)});
+            response.body = errorBody(route, "rate_limit_error", "Rate limit reached (mock).");
+            return response;
+        }
+        if (random->generateDouble() < options.errorRate)
+        {
+            response.status = 500;
+            response.body = errorBody(route, "api_error", "Internal error (mock).");
+            return response;
+        }
+
+        const QJsonObject body = QJsonDocument::fromJson(request.body).object();
+        const int inputTokens = int(request.body.size() / 4);
+        const int serial = m_server->nextSerial();
+        switch (route)
+        {
+        case Route::OpenAIResponses:
+            openAIResponse(body.value("stream").toBool(), serial, inputTokens, response);
+            break;
+        case Route::OpenAIInputTokens:
+            response.body = json({{"object", "response.input_tokens"},
+                                  {"input_tokens", inputTokens}});
+            break;
+        case Route::OpenAIUpload:
+            response.body = json({{"id", QString("file-mock%1").arg(serial)},
+                                  {"object", "file"},
+                                  {"bytes", request.body.size()},
+                                  {"purpose", "assistants"}});
+            break;
+        case Route::OpenAIDelete:
+            response.body = json({{"id", request.url.path().section('/', -1)},
+                                  {"object", "file"},
+                                  {"deleted", true}});
+            break;
+        case Route::Embeddings:
+            response.body = embeddings(body, inputTokens);
+            break;
+        case Route::DeepSeekChat:
+            deepSeekResponse(body.value("stream").toBool(), serial, inputTokens, response);
+            break;
+        case Route::AnthropicMessages:
+            anthropicResponse(body.value("stream").toBool(), serial, inputTokens, response);
+            break;
+        case Route::GoogleGenerate:
+            googleResponse(request.url.path().contains(":streamGenerateContent"), serial,
+                           inputTokens, response);
+            break;
+        case Route::GoogleUpload:
+        {
+            QUrl uri = request.url;
+            uri.setPath("/v1beta/files/mock" + QString::number(serial));
+            uri.setQuery(QString());
+            response.body = json({{"file", QJsonObject{{"name", "files/mock" +
+                                                                    QString::number(serial)},
+                                                       {"uri", uri.toString()}}}});
+            break;
+        }
+        case Route::GoogleDelete:
+            response.body = "{}";
+            break;
+        case Route::Unknown:
+            response.status = 404;
+            response.body = errorBody(route, "not_found_error",
+                                      "No mock for " + request.method + " " +
+                                          request.url.path().toUtf8());
+            break;
+        }
+        return response;
+    }
+
+    static QByteArray errorBody(Route route, const QString &type, const QString &message)
+    {
+        if (route == Route::AnthropicMessages)
+            return json({{"type", "error"},
+                         {"error", QJsonObject{{"type", type}, {"message", message}}}});
+        return json({{"error", QJsonObject{{"type", type}, {"message", message}}}});
+    }
+
+    // Le texte de la réponse, découpé en fragments de --chunk-words mots.
+    QStringList replyChunks(int serial) const
+    {
+        const Options &options = m_server->options();
+        QStringList words{QString("Mock reply #%1:").arg(serial)};
+        for (int i = 0; i < options.replyWords; ++i)
+            words.append(kWords.at((serial + i) % kWords.size()));
+        QStringList chunks;
+        for (qsizetype i = 0; i < words.size(); i += qMax(1, options.chunkWords))
+        {
+            const QString chunk = words.mid(i, qMax(1, options.chunkWords)).join(' ');
+            chunks.append(i == 0 ? chunk : " " + chunk);
+        }
+        return chunks;
+    }
+
+    static int tokensOf(const QString &text) { return qMax(1, int(text.size() / 4)); }
+
+    void openAIResponse(bool stream, int serial, int inputTokens, Response &response) const
+    {
+        const QStringList chunks = replyChunks(serial);
+        const QString text = chunks.join(QString());
+        const int outputTokens = tokensOf(text);
+        const QJsonObject usage{{"input_tokens", inputTokens},
+                                {"output_tokens", outputTokens},
+                                {"total_tokens", inputTokens + outputTokens},
+                                {"input_tokens_details", QJsonObject{{"cached_tokens", 0}}}};
+        const QString id = QString("resp_mock%1").arg(serial);
+        const QJsonObject message{
+            {"type", "message"},
+            {"role", "assistant"},
+            {"content", QJsonArray{QJsonObject{{"type", "output_text"}, {"text", text}}}}};
+        const QJsonObject completed{{"id", id},
+                                    {"object", "response"},
+                                    {"status", "completed"},
+                                    {"output", QJsonArray{message}},
+                                    {"usage", usage}};
+        if (!stream)
+        {
+            response.body = json(completed);
+            return;
+        }
+        response.streamed = true;
+        response.events.append(sseEvent(
+            "response.created",
+            {{"type", "response.created"},
+             {"response", QJsonObject{{"id", id}, {"status", "in_progress"}}}}));
+        for (const QString &chunk : chunks)
+            response.events.append(sseEvent(
+                "response.output_text.delta",
+                {{"type", "response.output_text.delta"}, {"delta", chunk}}));
+        response.events.append(sseEvent("response.completed",
+                                        {{"type", "response.completed"}, {"response", completed}}));
+    }
+
+    void deepSeekResponse(bool stream, int serial, int inputTokens, Response &response) const
+    {
+        const QStringList chunks = replyChunks(serial);
+        const QString text = chunks.join(QString());
+        const int outputTokens = tokensOf(text);
+        const QJsonObject usage{{"prompt_tokens", inputTokens},
+                                {"completion_tokens", outputTokens},
+                                {"total_tokens", inputTokens + outputTokens},
+                                {"prompt_cache_hit_tokens", 0}};
+        const QString id = QString("chatcmpl-mock%1").arg(serial);
+        if (!stream)
+        {
+            response.body = json(
+                {{"id", id},
+                 {"object", "chat.completion"},
+                 {"choices",
+                  QJsonArray{QJsonObject{
+                      {"index", 0},
+                      {"message", QJsonObject{{"role", "assistant"}, {"content", text}}},
+                      {"finish_reason", "stop"}}}},
+                 {"usage", usage}});
+            return;
+        }
+        response.streamed = true;
+        for (const QString &chunk : chunks)
+            response.events.append(sseEvent(
+                {}, {{"id", id},
+                     {"object", "chat.completion.chunk"},
+                     {"choices", QJsonArray{QJsonObject{{"index", 0},
+                                                        {"delta", QJsonObject{{"content", chunk}}},
+                                                        {"finish_reason", QJsonValue()}}}}}));
+        response.events.append(sseEvent(
+            {}, {{"id", id},
+                 {"object", "chat.completion.chunk"},
+                 {"choices", QJsonArray{QJsonObject{
+                                 {"index", 0}, {"delta", QJsonObject()}, {"finish_reason", "stop"}}}}}));
+        response.events.append(sseEvent({}, {{"id", id},
+                                             {"object", "chat.completion.chunk"},
+                                             {"choices", QJsonArray()},
+                                             {"usage", usage}}));
+        response.events.append("data: [DONE]\n\n");
+    }
+
+    void anthropicResponse(bool stream, int serial, int inputTokens, Response &response) const
+    {
+        const QStringList chunks = replyChunks(serial);
+        const QString text = chunks.join(QString());
+        const int outputTokens = tokensOf(text);
+        const QString id = QString("msg_mock%1").arg(serial);
+        if (!stream)
+        {
+            response.body = json(
+                {{"id", id},
+                 {"type", "message"},
+                 {"role", "assistant"},
+                 {"content", QJsonArray{QJsonObject{{"type", "text"}, {"text", text}}}},
+                 {"stop_reason", "end_turn"},
+                 {"usage",
+                  QJsonObject{{"input_tokens", inputTokens}, {"output_tokens", outputTokens}}}});
+            return;
+        }
+        response.streamed = true;
+        response.events.append(sseEvent(
+            "message_start",
+            {{"type", "message_start"},
+             {"message",
+              QJsonObject{{"id", id},
+                          {"type", "message"},
+                          {"role", "assistant"},
+                          {"usage", QJsonObject{{"input_tokens", inputTokens},
+                                                {"output_tokens", 1}}}}}}));
+        response.events.append(sseEvent(
+            "content_block_start",
+            {{"type", "content_block_start"},
+             {"index", 0},
+             {"content_block", QJsonObject{{"type", "text"}, {"text", ""}}}}));
+        for (const QString &chunk : chunks)
+            response.events.append(sseEvent(
+                "content_block_delta",
+                {{"type", "content_block_delta"},
+                 {"index", 0},
+                 {"delta", QJsonObject{{"type", "text_delta"}, {"text", chunk}}}}));
+        response.events.append(
+            sseEvent("content_block_stop", {{"type", "content_block_stop"}, {"index", 0}}));
+        response.events.append(
+            sseEvent("message_delta", {{"type", "message_delta"},
+                                       {"delta", QJsonObject{{"stop_reason", "end_turn"}}},
+                                       {"usage", QJsonObject{{"output_tokens", outputTokens}}}}));
+        response.events.append(sseEvent("message_stop", {{"type", "message_stop"}}));
+    }
+
+    void googleResponse(bool stream, int serial, int inputTokens, Response &response) const
+    {
+        const QStringList chunks = replyChunks(serial);
+        const QString text = chunks.join(QString());
+        const int outputTokens = tokensOf(text);
+        const QJsonObject usage{{"promptTokenCount", inputTokens},
+                                {"candidatesTokenCount", outputTokens},
+                                {"totalTokenCount", inputTokens + outputTokens}};
+        auto candidate = [](const QString &part)
+        {
+            return QJsonObject{{"content", QJsonObject{{"role", "model"},
+                                                       {"parts", QJsonArray{QJsonObject{
+                                                                     {"text", part}}}}}}};
+        };
+        if (!stream)
+        {
+            QJsonObject only = candidate(text);
+            only["finishReason"] = "STOP";
+            response.body = json({{"candidates", QJsonArray{only}}, {"usageMetadata", usage}});
+            return;
+        }
+        response.streamed = true;
+        for (qsizetype i = 0; i < chunks.size(); ++i)
+        {
+            QJsonObject part = candidate(chunks.at(i));
+            QJsonObject event{{"candidates", QJsonArray{part}}};
+            if (i == chunks.size() - 1)
+            {
+                part["finishReason"] = "STOP";
+                event = {{"candidates", QJsonArray{part}}, {"usageMetadata", usage}};
+            }
+            response.events.append(sseEvent({}, event));
+        }
+    }
+
+    static QByteArray embeddings(const QJsonObject &body, int inputTokens)
+    {
+        QStringList inputs;
+        if (body.value("input").isArray())
+        {
+            for (const QJsonValue &value : body.value("input").toArray())
+                inputs.append(value.toString());
+        }
+        else
+        {
+            inputs.append(body.value("input").toString());
+        }
+        const int dimensions = qBound(1, body.value("dimensions").toInt(256), 4096);
+        QJsonArray data;
+        for (qsizetype i = 0; i < inputs.size(); ++i)
+        {
+            // Vecteur déterministe : le même texte donne le même plongement
+            QRandomGenerator generator(qHash(inputs.at(i)));
+            QJsonArray vector;
+            for (int d = 0; d < dimensions; ++d)
+                vector.append(generator.generateDouble() * 2 - 1);
+            data.append(QJsonObject{{"object", "embedding"}, {"index", i}, {"embedding", vector}});
+        }
+        return json({{"object", "list"},
+                     {"data", data},
+                     {"usage", QJsonObject{{"prompt_tokens", inputTokens},
+                                           {"total_tokens", inputTokens}}}});
+    }
+
+    void send(const Request &request, Route route, const Response &response)
+    {
+        QByteArray head = "HTTP/1.1 " + QByteArray::number(response.status) + " " +
+                          reasonPhrase(response.status) + "\r\n";
+        for (const auto &header : response.headers)
+            head += header.first + ": " + header.second + "\r\n";
+        head += m_keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+
+        // Morceaux à écrire, --drip-ms l'un après l'autre
+        auto pieces = std::make_shared<QList<QByteArray>>();
+        if (response.streamed)
+        {
+            head += "Content-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                    "Transfer-Encoding: chunked\r\n\r\n";
+            pieces->append(head);
+            for (const QByteArray &event : response.events)
+                pieces->append(QByteArray::number(event.size(), 16) + "\r\n" + event + "\r\n");
+            pieces->last() += "0\r\n\r\n";
+        }
+        else
+        {
+            head += "Content-Type: application/json\r\nContent-Length: " +
+                    QByteArray::number(response.body.size()) + "\r\n\r\n";
+            pieces->append(head);
+            const qsizetype slices = m_server->options().dripMs > 0 ? 8 : 1;
+            const qsizetype sliceSize = qMax<qsizetype>(1, (response.body.size() + slices - 1) /
+                                                               slices);
+            for (qsizetype at = 0; at < response.body.size(); at += sliceSize)
+                pieces->append(response.body.mid(at, sliceSize));
+        }
+
+        const QByteArray summary = request.method + " " + request.url.path().toUtf8() + " -> " +
+                                   QByteArray::number(response.status) +
+                                   (response.streamed ? " (SSE)" : "");
+        writePieces(pieces, summary);
+    }
+
+    void writePieces(std::shared_ptr<QList<QByteArray>> pieces, const QByteArray &summary)
+    {
+        if (m_socket->state() != QAbstractSocket::ConnectedState)
+            return; // Client parti (requête annulée) : le socket sera détruit
+        m_socket->write(pieces->takeFirst());
+        if (!pieces->isEmpty())
+        {
+            QTimer::singleShot(m_server->options().dripMs, this,
+                               [this, pieces, summary]() { writePieces(pieces, summary); });
+            return;
+        }
+        if (!m_server->options().quiet)
+            QTextStream(stdout) << summary << " in " << m_clock.elapsed() << " ms" << Qt::endl;
+        m_busy = false;
+        if (!m_keepAlive)
+        {
+            m_socket->disconnectFromHost();
+            return;
+        }
+        processNext();
+    }
+
+    MockServer *m_server;
+    QTcpSocket *m_socket;
+    QByteArray m_buffer;
+    QElapsedTimer m_clock;
+    bool m_busy = false;
+    bool m_keepAlive = true;
+};
+
+void MockServer::incomingConnection(qintptr descriptor)
+{
+    auto *socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(descriptor))
+    {
+        delete socket;
+        return;
+    }
+    new Connection(this, socket);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("tether_mockserver");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Local mock of the OpenAI, DeepSeek, Anthropic and Google APIs used by Tether. "
+        "Set network/endpointOverride to http://127.0.0.1:<port> to use it.");
+    parser.addHelpOption();
+    const QCommandLineOption portOption("port", "Port to listen on (127.0.0.1).", "port", "8089");
+    const QCommandLineOption latencyOption("latency-ms", "Delay before the first byte.", "ms",
+                                           "200");
+    const QCommandLineOption dripOption("drip-ms", "Delay between two SSE events or body slices.",
+                                        "ms", "30");
+    const QCommandLineOption chunkOption("chunk-words", "Words per SSE event.", "n", "3");
+    const QCommandLineOption wordsOption("reply-words", "Words per reply.", "n", "80");
+    const QCommandLineOption rate429Option("rate-429", "Share of requests refused with a 429.",
+                                           "rate", "0");
+    const QCommandLineOption retryAfterOption("retry-after", "Retry-After of the 429s, in seconds.",
+                                              "s", "1");
+    const QCommandLineOption errorRateOption("error-rate", "Share of requests failing with a 500.",
+                                             "rate", "0");
+    const QCommandLineOption rpmOption("rpm", "Requests per minute announced and enforced "
+                                              "(0: no limit).",
+                                       "n", "0");
+    const QCommandLineOption quietOption("quiet", "Do not log each request.");
+    parser.addOptions({portOption, latencyOption, dripOption, chunkOption, wordsOption,
+                       rate429Option, retryAfterOption, errorRateOption, rpmOption, quietOption});
+    parser.process(app);
+
+    Options options;
+    options.latencyMs = qMax(0, parser.value(latencyOption).toInt());
+    options.dripMs = qMax(0, parser.value(dripOption).toInt());
+    options.chunkWords = qMax(1, parser.value(chunkOption).toInt());
+    options.replyWords = qMax(1, parser.value(wordsOption).toInt());
+    options.rate429 = qBound(0.0, parser.value(rate429Option).toDouble(), 1.0);
+    options.retryAfterS = qMax(0, parser.value(retryAfterOption).toInt());
+    options.errorRate = qBound(0.0, parser.value(errorRateOption).toDouble(), 1.0);
+    options.requestsPerMinute = qMax(0, parser.value(rpmOption).toInt());
+    options.quiet = parser.isSet(quietOption);
+
+    MockServer server(options);
+    const quint16 port = quint16(parser.value(portOption).toUInt());
+    if (!server.listen(QHostAddress::LocalHost, port))
+    {
+        qWarning() << "tether_mockserver: cannot listen on port" << port << "-"
+                   << server.errorString();
+        return 1;
+    }
+    QTextStream(stdout) << "tether_mockserver listening on http://127.0.0.1:" << server.serverPort()
+                        << Qt::endl;
+    return app.exec();
+}
+// End Source File mockserver.cpp